@@ -50,11 +50,8 @@
 #warning "CPU_LOG_ID not defined, using LOG_DEFAULT by default"
 #endif
 
-#include "traps.h"
-
-#ifndef DRIVE_CPU
 #include "profiler.h"
-#endif
+#include "traps.h"
 
 #ifndef C64DTV
 /* The C64DTV can use different shadow registers for accu read/write. */
@@ -372,32 +369,40 @@
 #endif
 
 #if !defined(DRIVE_CPU)
-#define CHECK_PROFILE_INTERRUPT(dest_addr, handler)                        \
-do {                                                                   \
-        profile_int(dest_addr, handler, reg_sp + 1, CLK - profiling_clock_start); \
-} while (0)
+/* the computer CPU always tracks its call stack, so a profile started in
+   the middle of a program knows where it is */
+#define PROFILE_CALLSTACK_ACTIVE 1
+#else
+#define PROFILE_CALLSTACK_ACTIVE cpu_profiling[CALLER]
+#endif
 
-#define CHECK_PROFILE_JSR(dest_addr)     \
-    do {                                 \
-        profile_jsr(dest_addr, reg_pc, reg_sp); \
-} while (0)
+#define CHECK_PROFILE_INTERRUPT(dest_addr, handler)                                               \
+    do {                                                                                          \
+        if (PROFILE_CALLSTACK_ACTIVE) {                                                           \
+            profile_int(CALLER, dest_addr, handler, reg_sp + 1, CLK - profiling_clock_start);    \
+        }                                                                                         \
+    } while (0)
 
-#define CHECK_PROFILE_RTS()      \
-    do {                         \
-            profile_rtx(reg_sp); \
+#define CHECK_PROFILE_JSR(dest_addr)                            \
+    do {                                                        \
+        if (PROFILE_CALLSTACK_ACTIVE) {                         \
+            profile_jsr(CALLER, dest_addr, reg_pc, reg_sp);     \
+        }                                                       \
     } while (0)
 
-#define CHECK_PROFILE_RTI()          \
-        do {                             \
-            profile_rtx(reg_sp + 1); \
+#define CHECK_PROFILE_RTS()                 \
+    do {                                    \
+        if (PROFILE_CALLSTACK_ACTIVE) {     \
+            profile_rtx(CALLER, reg_sp);    \
+        }                                   \
     } while (0)
 
-#else
-#define CHECK_PROFILE_INTERRUPT(dest_addr, handler)
-#define CHECK_PROFILE_JSR(dest_addr)
-#define CHECK_PROFILE_RTS()
-#define CHECK_PROFILE_RTI()
-#endif
+#define CHECK_PROFILE_RTI()                     \
+    do {                                        \
+        if (PROFILE_CALLSTACK_ACTIVE) {         \
+            profile_rtx(CALLER, reg_sp + 1);    \
+        }                                       \
+    } while (0)
 
 #ifdef DEBUG
 #define TRACE_NMI(clk)                        \
@@ -2266,6 +2271,143 @@ static const uint8_t rewind_fetch_tab[] = {
 
 /* ------------------------------------------------------------------------ */
 
+/* Threaded dispatch
+
+   With compilers that support "labels as values", every opcode handler
+   ends by fetching the next opcode itself and jumping straight to its
+   handler through cpu_dispatch_table, instead of going back through the
+   instruction loop and the switch. This spreads the indirect jump over all
+   handlers, which the host branch predictor handles much better.
+
+   The handlers only do that while nothing else needs to happen before the
+   next instruction. Everything that does is already signalled in one of
+   two places, which CPU_SLOW_PATH_PENDING() tests:
+   - a due alarm, by the next pending alarm clock of the alarm context;
+   - interrupts, traps, the monitor and DMA, by the pending interrupt word
+     of the interrupt status;
+   plus a jammed CPU and profiling. When the slow path is pending, the
+   handler continues at cpu_slow_path at the top of the loop below, which
+   does the full checks.
+
+   The including file opts in by defining CPU_LOOP_CONDITION(), the
+   condition of the loop it includes this file in. It moves the work it
+   does after every instruction into CPU_INSTRUCTION_DONE. The switch is
+   used for every instruction when the including file doesn't opt in,
+   with other compilers, in DEBUG builds (for the instruction trace) or
+   when CPU_NO_THREADED_DISPATCH is defined. */
+
+#if defined(__GNUC__) && defined(CPU_LOOP_CONDITION) \
+    && !defined(DEBUG) && !defined(CPU_NO_THREADED_DISPATCH)
+#define CPU_THREADED_DISPATCH
+#endif
+
+#ifndef CPU_INSTRUCTION_DONE
+#define CPU_INSTRUCTION_DONE
+#endif
+
+/* start and end of the opcode fetch for the CPU history */
+#ifdef FEATURE_CPUMEMHISTORY
+#ifndef DRIVE_CPU
+#define CPU_HISTORY_FETCH_START()                               \
+    do {                                                        \
+        history_clk = maincpu_clk;                              \
+        memmap_state |= (MEMMAP_STATE_INSTR | MEMMAP_STATE_OPCODE); \
+    } while (0)
+#else
+#define CPU_HISTORY_FETCH_START() (history_clk = CLK)
+#endif
+
+/* If reg_pc >= bank_limit  then JSR (0x20) hasn't load p2 yet.
+   The earlier LOAD(reg_pc+2) hack can break stealing badly.
+   The fixing is now handled in JSR(). */
+#if !defined(DRIVE_CPU) && !defined(C64DTV)
+#define CPU_HISTORY_FETCH_END()                                                                 \
+    do {                                                                                        \
+        /* HACK to cope with FETCH_OPCODE optimization in x64 */                                \
+        if (((int)reg_pc) < bank_limit) {                                                       \
+            memmap_mark_read(reg_pc);                                                           \
+        }                                                                                       \
+        monitor_cpuhistory_store(history_clk, reg_pc, p0, p1, p2 >> 8, reg_a_read, reg_x_read,  \
+                                 reg_y_read, reg_sp, LOCAL_STATUS(), ORIGIN_MEMSPACE);          \
+        memmap_state &= ~(MEMMAP_STATE_INSTR | MEMMAP_STATE_OPCODE);                            \
+    } while (0)
+#elif !defined(DRIVE_CPU)
+#define CPU_HISTORY_FETCH_END()                                                                 \
+    do {                                                                                        \
+        monitor_cpuhistory_store(history_clk, reg_pc, p0, p1, p2 >> 8, reg_a_read, reg_x_read,  \
+                                 reg_y_read, reg_sp, LOCAL_STATUS(), ORIGIN_MEMSPACE);          \
+        memmap_state &= ~(MEMMAP_STATE_INSTR | MEMMAP_STATE_OPCODE);                            \
+    } while (0)
+#else
+#define CPU_HISTORY_FETCH_END()                                                                 \
+    monitor_cpuhistory_store(history_clk, reg_pc, p0, p1, p2 >> 8, reg_a_read, reg_x_read,      \
+                             reg_y_read, reg_sp, LOCAL_STATUS(), ORIGIN_MEMSPACE)
+#endif
+#else
+#define CPU_HISTORY_FETCH_START()
+#define CPU_HISTORY_FETCH_END()
+#endif
+
+#ifdef CPU_THREADED_DISPATCH
+
+#define CPU_OPCODE(op) case op: cpu_opcode_##op
+
+#define CPU_OPCODE_ROW(r)                                                                   \
+    &&cpu_opcode_##r##0, &&cpu_opcode_##r##1, &&cpu_opcode_##r##2, &&cpu_opcode_##r##3, \
+    &&cpu_opcode_##r##4, &&cpu_opcode_##r##5, &&cpu_opcode_##r##6, &&cpu_opcode_##r##7, \
+    &&cpu_opcode_##r##8, &&cpu_opcode_##r##9, &&cpu_opcode_##r##a, &&cpu_opcode_##r##b, \
+    &&cpu_opcode_##r##c, &&cpu_opcode_##r##d, &&cpu_opcode_##r##e, &&cpu_opcode_##r##f
+
+#define CPU_SLOW_PATH_PENDING()                                  \
+    (CPU_INT_STATUS->global_pending_int != IK_NONE               \
+     || CLK >= alarm_context_next_pending_clk(ALARM_CONTEXT)     \
+     || CPU_IS_JAMMED                                            \
+     || cpu_profiling[CALLER])
+
+/* End of an opcode handler: run the end of the instruction loop and the
+   start of the next iteration up to the alarm check, then either fetch and
+   dispatch the next opcode right here or take the slow path. This does the
+   same as the code at the top and bottom of the loop body below, in the
+   same order, minus what CPU_SLOW_PATH_PENDING() rules out. Used in place
+   of "break", so it must not be wrapped in do { } while (0). */
+#define CPU_OPCODE_DONE                                 \
+    if (!cpu_profiling[CALLER]) {                       \
+        CPU_INSTRUCTION_DONE                            \
+        if (!(CPU_LOOP_CONDITION())) {                  \
+            goto cpu_leave;                             \
+        }                                               \
+        CPU_REFRESH_CLK                                 \
+        CPU_CHECK_AND_RUN_ALTERNATE_CPU                 \
+        CPU_DELAY_CLK                                   \
+        if (CPU_SLOW_PATH_PENDING()) {                  \
+            goto cpu_slow_path;                         \
+        }                                               \
+        CPU_HISTORY_FETCH_START();                      \
+        profiling_clock_start = CLK;                    \
+        SET_LAST_ADDR(reg_pc);                          \
+        FETCH_OPCODE(opcode);                           \
+        lastop = p0;                                    \
+        CPU_HISTORY_FETCH_END();                        \
+        SET_LAST_OPCODE(p0);                            \
+        goto *cpu_dispatch_table[p0];                   \
+    }                                                   \
+    break
+
+#else /* !CPU_THREADED_DISPATCH */
+
+#define CPU_OPCODE(op) case op
+#define CPU_OPCODE_DONE break
+
+#endif /* CPU_THREADED_DISPATCH */
+
+#ifdef CHECK_AND_RUN_ALTERNATE_CPU
+#define CPU_CHECK_AND_RUN_ALTERNATE_CPU CHECK_AND_RUN_ALTERNATE_CPU
+#else
+#define CPU_CHECK_AND_RUN_ALTERNATE_CPU
+#endif
+
+/* ------------------------------------------------------------------------ */
+
 /* Here, the CPU is emulated. */
 
 {
@@ -2275,20 +2417,29 @@ static const uint8_t rewind_fetch_tab[] = {
 #warning "CPU_IS_JAMMED not defined, using default (internal)"
 #endif
     unsigned int tmpa; /* needed for some of the opcode macros */
-#if !defined(DRIVE_CPU)
-    CLOCK profiling_clock_start;
+    CLOCK profiling_clock_start = CLK;
+    /* opcode that made the CPU jam, see below */
+    static uint8_t lastop;
+#ifdef CPU_THREADED_DISPATCH
+    static const void * const cpu_dispatch_table[0x100] = {
+        CPU_OPCODE_ROW(0x0), CPU_OPCODE_ROW(0x1), CPU_OPCODE_ROW(0x2), CPU_OPCODE_ROW(0x3),
+        CPU_OPCODE_ROW(0x4), CPU_OPCODE_ROW(0x5), CPU_OPCODE_ROW(0x6), CPU_OPCODE_ROW(0x7),
+        CPU_OPCODE_ROW(0x8), CPU_OPCODE_ROW(0x9), CPU_OPCODE_ROW(0xa), CPU_OPCODE_ROW(0xb),
+        CPU_OPCODE_ROW(0xc), CPU_OPCODE_ROW(0xd), CPU_OPCODE_ROW(0xe), CPU_OPCODE_ROW(0xf)
+    };
 #endif
 
     /* handle 8502 fast mode refresh cycles */
     CPU_REFRESH_CLK
 
     /* handle any extra cpu switches */
-#ifdef CHECK_AND_RUN_ALTERNATE_CPU
-    CHECK_AND_RUN_ALTERNATE_CPU
-#endif
+    CPU_CHECK_AND_RUN_ALTERNATE_CPU
 
     CPU_DELAY_CLK
 
+#ifdef CPU_THREADED_DISPATCH
+cpu_slow_path:
+#endif
     PROCESS_ALARMS
 
     /* HACK: when the CPU is jammed, no interrupts are served, the only way
@@ -2313,9 +2464,7 @@ static const uint8_t rewind_fetch_tab[] = {
 
         pending_interrupt = CPU_INT_STATUS->global_pending_int;
         if (pending_interrupt != IK_NONE) {
-#if !defined(DRIVE_CPU)
             profiling_clock_start = CLK;
-#endif
 
             DO_INTERRUPT(pending_interrupt);
             if (!(CPU_INT_STATUS->global_pending_int & IK_IRQ)
@@ -2341,20 +2490,14 @@ static const uint8_t rewind_fetch_tab[] = {
 
 #ifdef FEATURE_CPUMEMHISTORY
         CLOCK history_clk;
-#ifndef DRIVE_CPU
-        history_clk = maincpu_clk;
-        memmap_state |= (MEMMAP_STATE_INSTR | MEMMAP_STATE_OPCODE);
-#else
-        history_clk = CLK;
-#endif
 #endif
 
-#if !defined(DRIVE_CPU)
+        CPU_HISTORY_FETCH_START();
+
         profiling_clock_start = CLK;
-        if (maincpu_profiling) {
-            profile_sample_start(reg_pc);
+        if (cpu_profiling[CALLER]) {
+            profile_sample_start(CALLER, reg_pc);
         }
-#endif
 
         SET_LAST_ADDR(reg_pc);
 
@@ -2366,35 +2509,16 @@ static const uint8_t rewind_fetch_tab[] = {
          * the value at the original jam location changed to a non-jam, for
          * whatever reason.
          */
-        {
-            static uint8_t lastop;
-            FETCH_OPCODE(opcode);
-            if (!CPU_IS_JAMMED) {
-                /* remember current opcode */
-                lastop = p0;
-            } else {
-                /* set opcode that made the cpu jam */
-                SET_OPCODE(lastop);
-            }
+        FETCH_OPCODE(opcode);
+        if (!CPU_IS_JAMMED) {
+            /* remember current opcode */
+            lastop = p0;
+        } else {
+            /* set opcode that made the cpu jam */
+            SET_OPCODE(lastop);
         }
 
-#ifdef FEATURE_CPUMEMHISTORY
-#ifndef DRIVE_CPU
-#ifndef C64DTV
-        /* HACK to cope with FETCH_OPCODE optimization in x64 */
-        if (((int)reg_pc) < bank_limit) {
-            memmap_mark_read(reg_pc);
-        }
-#endif
-#endif
-        /* If reg_pc >= bank_limit  then JSR (0x20) hasn't load p2 yet.
-           The earlier LOAD(reg_pc+2) hack can break stealing badly.
-           The fixing is now handled in JSR(). */
-        monitor_cpuhistory_store(history_clk, reg_pc, p0, p1, p2 >> 8, reg_a_read, reg_x_read, reg_y_read, reg_sp, LOCAL_STATUS(), ORIGIN_MEMSPACE);
-#ifndef DRIVE_CPU
-        memmap_state &= ~(MEMMAP_STATE_INSTR | MEMMAP_STATE_OPCODE);
-#endif
-#endif
+        CPU_HISTORY_FETCH_END();
 
 #ifdef DEBUG
 #ifdef DRIVE_CPU
@@ -2435,78 +2559,82 @@ static const uint8_t rewind_fetch_tab[] = {
 trap_skipped:
         SET_LAST_OPCODE(p0);
 
+#ifdef CPU_THREADED_DISPATCH
+        goto *cpu_dispatch_table[p0];
+#endif
+
         switch (p0) {
-            case 0x00:          /* BRK */
+            CPU_OPCODE(0x00):          /* BRK */
                 BRK();
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x01:          /* ORA ($nn,X) */
+            CPU_OPCODE(0x01):          /* ORA ($nn,X) */
                 ORA(LOAD_IND_X(p1), 1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x02:          /* JAM - also used for traps */
+            CPU_OPCODE(0x02):          /* JAM - also used for traps */
                 STATIC_ASSERT(TRAP_OPCODE == 0x02);
                 JAM_02();
-                break;
-
-            case 0x22:          /* JAM */
-            case 0x52:          /* JAM */
-            case 0x62:          /* JAM */
-            case 0x72:          /* JAM */
-            case 0x92:          /* JAM */
-            case 0xb2:          /* JAM */
-            case 0xd2:          /* JAM */
-            case 0xf2:          /* JAM */
+                CPU_OPCODE_DONE;
+
+            CPU_OPCODE(0x22):          /* JAM */
+            CPU_OPCODE(0x52):          /* JAM */
+            CPU_OPCODE(0x62):          /* JAM */
+            CPU_OPCODE(0x72):          /* JAM */
+            CPU_OPCODE(0x92):          /* JAM */
+            CPU_OPCODE(0xb2):          /* JAM */
+            CPU_OPCODE(0xd2):          /* JAM */
+            CPU_OPCODE(0xf2):          /* JAM */
 #ifndef C64DTV
-            case 0x12:          /* JAM */
-            case 0x32:          /* JAM */
-            case 0x42:          /* JAM */
+            CPU_OPCODE(0x12):          /* JAM */
+            CPU_OPCODE(0x32):          /* JAM */
+            CPU_OPCODE(0x42):          /* JAM */
 #endif
                 CPU_IS_JAMMED = 1;
                 REWIND_FETCH_OPCODE(CLK);
                 JAM();
-                break;
+                CPU_OPCODE_DONE;
 
 #ifdef C64DTV
             /* These opcodes are defined in c64/c64dtvcpu.c */
-            case 0x12:          /* BRA */
+            CPU_OPCODE(0x12):          /* BRA */
                 BRANCH(1, p1);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x32:          /* SAC */
+            CPU_OPCODE(0x32):          /* SAC */
                 SAC(p1);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x42:          /* SIR */
+            CPU_OPCODE(0x42):          /* SIR */
                 SIR(p1);
-                break;
+                CPU_OPCODE_DONE;
 #endif
 
-            case 0x03:          /* SLO ($nn,X) */
+            CPU_OPCODE(0x03):          /* SLO ($nn,X) */
                 LOAD_ZERO_DUMMY(p1);
                 CLK_ADD_DUMMY(CLK, 1);
                 SLO(LOAD_ZERO_ADDR(p1 + reg_x_read), 2, 2, LOAD_ABS, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x04:          /* NOOP $nn */
-            case 0x44:          /* NOOP $nn */
-            case 0x64:          /* NOOP $nn */
+            CPU_OPCODE(0x04):          /* NOOP $nn */
+            CPU_OPCODE(0x44):          /* NOOP $nn */
+            CPU_OPCODE(0x64):          /* NOOP $nn */
                 NOOP(1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x05:          /* ORA $nn */
+            CPU_OPCODE(0x05):          /* ORA $nn */
                 ORA(LOAD_ZERO(p1), 1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x06:          /* ASL $nn */
+            CPU_OPCODE(0x06):          /* ASL $nn */
                 ASL(p1, 2, LOAD_ZERO, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x07:          /* SLO $nn */
+            CPU_OPCODE(0x07):          /* SLO $nn */
                 SLO(p1, 0, 2, LOAD_ZERO, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x08:          /* PHP */
+            CPU_OPCODE(0x08):          /* PHP */
 #ifdef DRIVE_CPU
                 drivecpu_rotate();
                 if (drivecpu_byte_ready()) {
@@ -2515,285 +2643,285 @@ trap_skipped:
                 }
 #endif
                 PHP();
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x09:          /* ORA #$nn */
+            CPU_OPCODE(0x09):          /* ORA #$nn */
                 ORA(p1, 0, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x0a:          /* ASL A */
+            CPU_OPCODE(0x0a):          /* ASL A */
                 ASL_A();
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x0b:          /* ANC #$nn */
-            case 0x2b:          /* ANC #$nn */
+            CPU_OPCODE(0x0b):          /* ANC #$nn */
+            CPU_OPCODE(0x2b):          /* ANC #$nn */
                 ANC(p1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x0c:          /* NOOP $nnnn */
+            CPU_OPCODE(0x0c):          /* NOOP $nnnn */
                 NOOP_ABS();
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x0d:          /* ORA $nnnn */
+            CPU_OPCODE(0x0d):          /* ORA $nnnn */
                 ORA(LOAD(p2), 1, 3);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x0e:          /* ASL $nnnn */
+            CPU_OPCODE(0x0e):          /* ASL $nnnn */
                 ASL(p2, 3, LOAD_ABS, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x0f:          /* SLO $nnnn */
+            CPU_OPCODE(0x0f):          /* SLO $nnnn */
                 SLO(p2, 0, 3, LOAD_ABS, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x10:          /* BPL $nnnn */
+            CPU_OPCODE(0x10):          /* BPL $nnnn */
                 BRANCH(!LOCAL_SIGN(), p1);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x11:          /* ORA ($nn),Y */
+            CPU_OPCODE(0x11):          /* ORA ($nn),Y */
                 ORA(LOAD_IND_Y(p1), 1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x13:          /* SLO ($nn),Y */
+            CPU_OPCODE(0x13):          /* SLO ($nn),Y */
                 SLO_IND_Y(p1);
-                break;
-
-            case 0x14:          /* NOOP $nn,X */
-            case 0x34:          /* NOOP $nn,X */
-            case 0x54:          /* NOOP $nn,X */
-            case 0x74:          /* NOOP $nn,X */
-            case 0xd4:          /* NOOP $nn,X */
-            case 0xf4:          /* NOOP $nn,X */
+                CPU_OPCODE_DONE;
+
+            CPU_OPCODE(0x14):          /* NOOP $nn,X */
+            CPU_OPCODE(0x34):          /* NOOP $nn,X */
+            CPU_OPCODE(0x54):          /* NOOP $nn,X */
+            CPU_OPCODE(0x74):          /* NOOP $nn,X */
+            CPU_OPCODE(0xd4):          /* NOOP $nn,X */
+            CPU_OPCODE(0xf4):          /* NOOP $nn,X */
                 NOOP((NOOP_LOAD_ZERO_X(p1), CLK_NOOP_ZERO_X), 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x15:          /* ORA $nn,X */
+            CPU_OPCODE(0x15):          /* ORA $nn,X */
                 ORA(LOAD_ZERO_X(p1), CLK_ZERO_I2, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x16:          /* ASL $nn,X */
+            CPU_OPCODE(0x16):          /* ASL $nn,X */
                 LOAD_ZERO_DUMMY(p1);
                 CLK_ADD_DUMMY(CLK, 1);
                 ASL((p1 + reg_x_read) & 0xff, 2, LOAD_ZERO, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x17:          /* SLO $nn,X */
+            CPU_OPCODE(0x17):          /* SLO $nn,X */
                 LOAD_ZERO_DUMMY(p1);
                 CLK_ADD_DUMMY(CLK, 1);
                 SLO((p1 + reg_x_read) & 0xff, 0, 2, LOAD_ZERO, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x18:          /* CLC */
+            CPU_OPCODE(0x18):          /* CLC */
                 CLC();
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x19:          /* ORA $nnnn,Y */
+            CPU_OPCODE(0x19):          /* ORA $nnnn,Y */
                 ORA(LOAD_ABS_Y(p2), 1, 3);
-                break;
-
-            case 0x1a:          /* NOOP */
-            case 0x3a:          /* NOOP */
-            case 0x5a:          /* NOOP */
-            case 0x7a:          /* NOOP */
-            case 0xda:          /* NOOP */
-            case 0xfa:          /* NOOP */
+                CPU_OPCODE_DONE;
+
+            CPU_OPCODE(0x1a):          /* NOOP */
+            CPU_OPCODE(0x3a):          /* NOOP */
+            CPU_OPCODE(0x5a):          /* NOOP */
+            CPU_OPCODE(0x7a):          /* NOOP */
+            CPU_OPCODE(0xda):          /* NOOP */
+            CPU_OPCODE(0xfa):          /* NOOP */
                 NOOP_IMM(1);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x1b:          /* SLO $nnnn,Y */
+            CPU_OPCODE(0x1b):          /* SLO $nnnn,Y */
                 SLO(p2, 0, 3, LOAD_ABS_Y_RMW, STORE_ABS_Y_RMW, DUMMY_STORE_ABS_Y_RMW);
-                break;
-
-            case 0x1c:          /* NOOP $nnnn,X */
-            case 0x3c:          /* NOOP $nnnn,X */
-            case 0x5c:          /* NOOP $nnnn,X */
-            case 0x7c:          /* NOOP $nnnn,X */
-            case 0xdc:          /* NOOP $nnnn,X */
-            case 0xfc:          /* NOOP $nnnn,X */
+                CPU_OPCODE_DONE;
+
+            CPU_OPCODE(0x1c):          /* NOOP $nnnn,X */
+            CPU_OPCODE(0x3c):          /* NOOP $nnnn,X */
+            CPU_OPCODE(0x5c):          /* NOOP $nnnn,X */
+            CPU_OPCODE(0x7c):          /* NOOP $nnnn,X */
+            CPU_OPCODE(0xdc):          /* NOOP $nnnn,X */
+            CPU_OPCODE(0xfc):          /* NOOP $nnnn,X */
                 NOOP_ABS_X();
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x1d:          /* ORA $nnnn,X */
+            CPU_OPCODE(0x1d):          /* ORA $nnnn,X */
                 ORA(LOAD_ABS_X(p2), 1, 3);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x1e:          /* ASL $nnnn,X */
+            CPU_OPCODE(0x1e):          /* ASL $nnnn,X */
                 ASL(p2, 3, LOAD_ABS_X_RMW, STORE_ABS_X_RMW, DUMMY_STORE_ABS_X_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x1f:          /* SLO $nnnn,X */
+            CPU_OPCODE(0x1f):          /* SLO $nnnn,X */
                 SLO(p2, 0, 3, LOAD_ABS_X_RMW, STORE_ABS_X_RMW, DUMMY_STORE_ABS_X_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x20:          /* JSR $nnnn */
+            CPU_OPCODE(0x20):          /* JSR $nnnn */
                 JSR();
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x21:          /* AND ($nn,X) */
+            CPU_OPCODE(0x21):          /* AND ($nn,X) */
                 AND(LOAD_IND_X(p1), 1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x23:          /* RLA ($nn,X) */
+            CPU_OPCODE(0x23):          /* RLA ($nn,X) */
                 LOAD_ZERO_DUMMY(p1);
                 CLK_ADD_DUMMY(CLK, 1);
                 RLA(LOAD_ZERO_ADDR(p1 + reg_x_read), 2, 2, LOAD_ABS, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x24:          /* BIT $nn */
+            CPU_OPCODE(0x24):          /* BIT $nn */
                 BIT(LOAD_ZERO(p1), 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x25:          /* AND $nn */
+            CPU_OPCODE(0x25):          /* AND $nn */
                 AND(LOAD_ZERO(p1), 1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x26:          /* ROL $nn */
+            CPU_OPCODE(0x26):          /* ROL $nn */
                 ROL(p1, 2, LOAD_ZERO, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x27:          /* RLA $nn */
+            CPU_OPCODE(0x27):          /* RLA $nn */
                 RLA(p1, 0, 2, LOAD_ZERO, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x28:          /* PLP */
+            CPU_OPCODE(0x28):          /* PLP */
                 PLP();
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x29:          /* AND #$nn */
+            CPU_OPCODE(0x29):          /* AND #$nn */
                 AND(p1, 0, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x2a:          /* ROL A */
+            CPU_OPCODE(0x2a):          /* ROL A */
                 ROL_A();
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x2c:          /* BIT $nnnn */
+            CPU_OPCODE(0x2c):          /* BIT $nnnn */
                 BIT(LOAD(p2), 3);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x2d:          /* AND $nnnn */
+            CPU_OPCODE(0x2d):          /* AND $nnnn */
                 AND(LOAD(p2), 1, 3);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x2e:          /* ROL $nnnn */
+            CPU_OPCODE(0x2e):          /* ROL $nnnn */
                 ROL(p2, 3, LOAD_ABS, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x2f:          /* RLA $nnnn */
+            CPU_OPCODE(0x2f):          /* RLA $nnnn */
                 RLA(p2, 0, 3, LOAD_ABS, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x30:          /* BMI $nnnn */
+            CPU_OPCODE(0x30):          /* BMI $nnnn */
                 BRANCH(LOCAL_SIGN(), p1);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x31:          /* AND ($nn),Y */
+            CPU_OPCODE(0x31):          /* AND ($nn),Y */
                 AND(LOAD_IND_Y(p1), 1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x33:          /* RLA ($nn),Y */
+            CPU_OPCODE(0x33):          /* RLA ($nn),Y */
                 RLA_IND_Y(p1);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x35:          /* AND $nn,X */
+            CPU_OPCODE(0x35):          /* AND $nn,X */
                 AND(LOAD_ZERO_X(p1), CLK_ZERO_I2, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x36:          /* ROL $nn,X */
+            CPU_OPCODE(0x36):          /* ROL $nn,X */
                 LOAD_ZERO_DUMMY(p1);
                 CLK_ADD_DUMMY(CLK, 1);
                 ROL((p1 + reg_x_read) & 0xff, 2, LOAD_ZERO, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x37:          /* RLA $nn,X */
+            CPU_OPCODE(0x37):          /* RLA $nn,X */
                 LOAD_ZERO_DUMMY(p1);
                 CLK_ADD_DUMMY(CLK, 1);
                 RLA((p1 + reg_x_read) & 0xff, 0, 2, LOAD_ZERO, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x38:          /* SEC */
+            CPU_OPCODE(0x38):          /* SEC */
                 SEC();
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x39:          /* AND $nnnn,Y */
+            CPU_OPCODE(0x39):          /* AND $nnnn,Y */
                 AND(LOAD_ABS_Y(p2), 1, 3);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x3b:          /* RLA $nnnn,Y */
+            CPU_OPCODE(0x3b):          /* RLA $nnnn,Y */
                 RLA(p2, 0, 3, LOAD_ABS_Y_RMW, STORE_ABS_Y_RMW, DUMMY_STORE_ABS_Y_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x3d:          /* AND $nnnn,X */
+            CPU_OPCODE(0x3d):          /* AND $nnnn,X */
                 AND(LOAD_ABS_X(p2), 1, 3);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x3e:          /* ROL $nnnn,X */
+            CPU_OPCODE(0x3e):          /* ROL $nnnn,X */
                 ROL(p2, 3, LOAD_ABS_X_RMW, STORE_ABS_X_RMW, DUMMY_STORE_ABS_X_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x3f:          /* RLA $nnnn,X */
+            CPU_OPCODE(0x3f):          /* RLA $nnnn,X */
                 RLA(p2, 0, 3, LOAD_ABS_X_RMW, STORE_ABS_X_RMW, DUMMY_STORE_ABS_X_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x40:          /* RTI */
+            CPU_OPCODE(0x40):          /* RTI */
                 RTI();
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x41:          /* EOR ($nn,X) */
+            CPU_OPCODE(0x41):          /* EOR ($nn,X) */
                 EOR(LOAD_IND_X(p1), 1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x43:          /* SRE ($nn,X) */
+            CPU_OPCODE(0x43):          /* SRE ($nn,X) */
                 LOAD_ZERO_DUMMY(p1);
                 CLK_ADD_DUMMY(CLK, 1);
                 SRE(LOAD_ZERO_ADDR(p1 + reg_x_read), 2, 2, LOAD_ABS, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x45:          /* EOR $nn */
+            CPU_OPCODE(0x45):          /* EOR $nn */
                 EOR(LOAD_ZERO(p1), 1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x46:          /* LSR $nn */
+            CPU_OPCODE(0x46):          /* LSR $nn */
                 LSR(p1, 2, LOAD_ZERO, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x47:          /* SRE $nn */
+            CPU_OPCODE(0x47):          /* SRE $nn */
                 SRE(p1, 0, 2, LOAD_ZERO, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x48:          /* PHA */
+            CPU_OPCODE(0x48):          /* PHA */
                 PHA();
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x49:          /* EOR #$nn */
+            CPU_OPCODE(0x49):          /* EOR #$nn */
                 EOR(p1, 0, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x4a:          /* LSR A */
+            CPU_OPCODE(0x4a):          /* LSR A */
                 LSR_A();
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x4b:          /* ASR #$nn */
+            CPU_OPCODE(0x4b):          /* ASR #$nn */
                 ASR(p1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x4c:          /* JMP $nnnn */
+            CPU_OPCODE(0x4c):          /* JMP $nnnn */
                 JMP(p2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x4d:          /* EOR $nnnn */
+            CPU_OPCODE(0x4d):          /* EOR $nnnn */
                 EOR(LOAD(p2), 1, 3);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x4e:          /* LSR $nnnn */
+            CPU_OPCODE(0x4e):          /* LSR $nnnn */
                 LSR(p2, 3, LOAD_ABS, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x4f:          /* SRE $nnnn */
+            CPU_OPCODE(0x4f):          /* SRE $nnnn */
                 SRE(p2, 0, 3, LOAD_ABS, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x50:          /* BVC $nnnn */
+            CPU_OPCODE(0x50):          /* BVC $nnnn */
 #ifdef DRIVE_CPU
                 CLK_ADD(CLK, -1);
                 drivecpu_rotate();
@@ -2804,115 +2932,115 @@ trap_skipped:
                 CLK_ADD(CLK, 1);
 #endif
                 BRANCH(!LOCAL_OVERFLOW(), p1);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x51:          /* EOR ($nn),Y */
+            CPU_OPCODE(0x51):          /* EOR ($nn),Y */
                 EOR(LOAD_IND_Y(p1), 1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x53:          /* SRE ($nn),Y */
+            CPU_OPCODE(0x53):          /* SRE ($nn),Y */
                 SRE_IND_Y(p1);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x55:          /* EOR $nn,X */
+            CPU_OPCODE(0x55):          /* EOR $nn,X */
                 EOR(LOAD_ZERO_X(p1), CLK_ZERO_I2, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x56:          /* LSR $nn,X */
+            CPU_OPCODE(0x56):          /* LSR $nn,X */
                 LOAD_ZERO_DUMMY(p1);
                 CLK_ADD_DUMMY(CLK, 1);
                 LSR((p1 + reg_x_read) & 0xff, 2, LOAD_ZERO, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x57:          /* SRE $nn,X */
+            CPU_OPCODE(0x57):          /* SRE $nn,X */
                 LOAD_ZERO_DUMMY(p1);
                 CLK_ADD_DUMMY(CLK, 1);
                 SRE((p1 + reg_x_read) & 0xff, 0, 2, LOAD_ZERO, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x58:          /* CLI */
+            CPU_OPCODE(0x58):          /* CLI */
                 CLI();
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x59:          /* EOR $nnnn,Y */
+            CPU_OPCODE(0x59):          /* EOR $nnnn,Y */
                 EOR(LOAD_ABS_Y(p2), 1, 3);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x5b:          /* SRE $nnnn,Y */
+            CPU_OPCODE(0x5b):          /* SRE $nnnn,Y */
                 SRE(p2, 0, 3, LOAD_ABS_Y_RMW, STORE_ABS_Y_RMW, DUMMY_STORE_ABS_Y_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x5d:          /* EOR $nnnn,X */
+            CPU_OPCODE(0x5d):          /* EOR $nnnn,X */
                 EOR(LOAD_ABS_X(p2), 1, 3);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x5e:          /* LSR $nnnn,X */
+            CPU_OPCODE(0x5e):          /* LSR $nnnn,X */
                 LSR(p2, 3, LOAD_ABS_X_RMW, STORE_ABS_X_RMW, DUMMY_STORE_ABS_X_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x5f:          /* SRE $nnnn,X */
+            CPU_OPCODE(0x5f):          /* SRE $nnnn,X */
                 SRE(p2, 0, 3, LOAD_ABS_X_RMW, STORE_ABS_X_RMW, DUMMY_STORE_ABS_X_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x60:          /* RTS */
+            CPU_OPCODE(0x60):          /* RTS */
                 RTS();
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x61:          /* ADC ($nn,X) */
+            CPU_OPCODE(0x61):          /* ADC ($nn,X) */
                 ADC(LOAD_IND_X(p1), 1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x63:          /* RRA ($nn,X) */
+            CPU_OPCODE(0x63):          /* RRA ($nn,X) */
                 LOAD_ZERO_DUMMY(p1);
                 CLK_ADD_DUMMY(CLK, 1);
                 RRA(LOAD_ZERO_ADDR(p1 + reg_x_read), 2, 2, LOAD_ABS, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x65:          /* ADC $nn */
+            CPU_OPCODE(0x65):          /* ADC $nn */
                 ADC(LOAD_ZERO(p1), 1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x66:          /* ROR $nn */
+            CPU_OPCODE(0x66):          /* ROR $nn */
                 ROR(p1, 2, LOAD_ZERO, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x67:          /* RRA $nn */
+            CPU_OPCODE(0x67):          /* RRA $nn */
                 RRA(p1, 0, 2, LOAD_ZERO, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x68:          /* PLA */
+            CPU_OPCODE(0x68):          /* PLA */
                 PLA();
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x69:          /* ADC #$nn */
+            CPU_OPCODE(0x69):          /* ADC #$nn */
                 ADC(p1, 0, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x6a:          /* ROR A */
+            CPU_OPCODE(0x6a):          /* ROR A */
                 ROR_A();
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x6b:          /* ARR #$nn */
+            CPU_OPCODE(0x6b):          /* ARR #$nn */
                 ARR(p1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x6c:          /* JMP ($nnnn) */
+            CPU_OPCODE(0x6c):          /* JMP ($nnnn) */
                 JMP_IND();
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x6d:          /* ADC $nnnn */
+            CPU_OPCODE(0x6d):          /* ADC $nnnn */
                 ADC(LOAD(p2), 1, 3);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x6e:          /* ROR $nnnn */
+            CPU_OPCODE(0x6e):          /* ROR $nnnn */
                 ROR(p2, 3, LOAD_ABS, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x6f:          /* RRA $nnnn */
+            CPU_OPCODE(0x6f):          /* RRA $nnnn */
                 RRA(p2, 0, 3, LOAD_ABS, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x70:          /* BVS $nnnn */
+            CPU_OPCODE(0x70):          /* BVS $nnnn */
 #ifdef DRIVE_CPU
                 CLK_ADD(CLK, -1);
                 drivecpu_rotate();
@@ -2923,538 +3051,543 @@ trap_skipped:
                 CLK_ADD(CLK, 1);
 #endif
                 BRANCH(LOCAL_OVERFLOW(), p1);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x71:          /* ADC ($nn),Y */
+            CPU_OPCODE(0x71):          /* ADC ($nn),Y */
                 ADC(LOAD_IND_Y(p1), 1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x73:          /* RRA ($nn),Y */
+            CPU_OPCODE(0x73):          /* RRA ($nn),Y */
                 RRA_IND_Y(p1);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x75:          /* ADC $nn,X */
+            CPU_OPCODE(0x75):          /* ADC $nn,X */
                 ADC(LOAD_ZERO_X(p1), CLK_ZERO_I2, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x76:          /* ROR $nn,X */
+            CPU_OPCODE(0x76):          /* ROR $nn,X */
                 LOAD_ZERO_DUMMY(p1);
                 CLK_ADD_DUMMY(CLK, 1);
                 ROR((p1 + reg_x_read) & 0xff, 2, LOAD_ZERO, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x77:          /* RRA $nn,X */
+            CPU_OPCODE(0x77):          /* RRA $nn,X */
                 LOAD_ZERO_DUMMY(p1);
                 CLK_ADD_DUMMY(CLK, 1);
                 RRA((p1 + reg_x_read) & 0xff, 0, 2, LOAD_ZERO, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x78:          /* SEI */
+            CPU_OPCODE(0x78):          /* SEI */
                 SEI();
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x79:          /* ADC $nnnn,Y */
+            CPU_OPCODE(0x79):          /* ADC $nnnn,Y */
                 ADC(LOAD_ABS_Y(p2), 1, 3);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x7b:          /* RRA $nnnn,Y */
+            CPU_OPCODE(0x7b):          /* RRA $nnnn,Y */
                 RRA(p2, 0, 3, LOAD_ABS_Y_RMW, STORE_ABS_Y_RMW, DUMMY_STORE_ABS_Y_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x7d:          /* ADC $nnnn,X */
+            CPU_OPCODE(0x7d):          /* ADC $nnnn,X */
                 ADC(LOAD_ABS_X(p2), 1, 3);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x7e:          /* ROR $nnnn,X */
+            CPU_OPCODE(0x7e):          /* ROR $nnnn,X */
                 ROR(p2, 3, LOAD_ABS_X_RMW, STORE_ABS_X_RMW, DUMMY_STORE_ABS_X_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x7f:          /* RRA $nnnn,X */
+            CPU_OPCODE(0x7f):          /* RRA $nnnn,X */
                 RRA(p2, 0, 3, LOAD_ABS_X_RMW, STORE_ABS_X_RMW, DUMMY_STORE_ABS_X_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x80:          /* NOOP #$nn */
-            case 0x82:          /* NOOP #$nn */
-            case 0x89:          /* NOOP #$nn */
-            case 0xc2:          /* NOOP #$nn */
-            case 0xe2:          /* NOOP #$nn */
+            CPU_OPCODE(0x80):          /* NOOP #$nn */
+            CPU_OPCODE(0x82):          /* NOOP #$nn */
+            CPU_OPCODE(0x89):          /* NOOP #$nn */
+            CPU_OPCODE(0xc2):          /* NOOP #$nn */
+            CPU_OPCODE(0xe2):          /* NOOP #$nn */
                 NOOP_IMM(2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x81:          /* STA ($nn,X) */
+            CPU_OPCODE(0x81):          /* STA ($nn,X) */
                 STA((LOAD_ZERO_DUMMY(p1), LOAD_ZERO_ADDR(p1 + reg_x_read)), 3, 1, 2, STORE_ABS);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x83:          /* SAX ($nn,X) */
+            CPU_OPCODE(0x83):          /* SAX ($nn,X) */
                 SAX((LOAD_ZERO_DUMMY(p1), LOAD_ZERO_ADDR(p1 + reg_x_read)), 3, 1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x84:          /* STY $nn */
+            CPU_OPCODE(0x84):          /* STY $nn */
                 STY_ZERO(p1, 1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x85:          /* STA $nn */
+            CPU_OPCODE(0x85):          /* STA $nn */
                 STA_ZERO(p1, 1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x86:          /* STX $nn */
+            CPU_OPCODE(0x86):          /* STX $nn */
                 STX_ZERO(p1, 1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x87:          /* SAX $nn */
+            CPU_OPCODE(0x87):          /* SAX $nn */
                 SAX_ZERO(p1, 1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x88:          /* DEY */
+            CPU_OPCODE(0x88):          /* DEY */
                 DEY();
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x8a:          /* TXA */
+            CPU_OPCODE(0x8a):          /* TXA */
                 TXA();
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x8b:          /* ANE #$nn */
+            CPU_OPCODE(0x8b):          /* ANE #$nn */
                 ANE(p1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x8c:          /* STY $nnnn */
+            CPU_OPCODE(0x8c):          /* STY $nnnn */
                 STY(p2, 1, 3);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x8d:          /* STA $nnnn */
+            CPU_OPCODE(0x8d):          /* STA $nnnn */
                 STA(p2, 0, 1, 3, STORE_ABS);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x8e:          /* STX $nnnn */
+            CPU_OPCODE(0x8e):          /* STX $nnnn */
                 STX(p2, 1, 3);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x8f:          /* SAX $nnnn */
+            CPU_OPCODE(0x8f):          /* SAX $nnnn */
                 SAX(p2, 0, 1, 3);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x90:          /* BCC $nnnn */
+            CPU_OPCODE(0x90):          /* BCC $nnnn */
                 BRANCH(!LOCAL_CARRY(), p1);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x91:          /* STA ($nn),Y */
+            CPU_OPCODE(0x91):          /* STA ($nn),Y */
                 STA_IND_Y(p1);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x93:          /* SHA ($nn),Y */
+            CPU_OPCODE(0x93):          /* SHA ($nn),Y */
                 SHA_IND_Y(p1);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x94:          /* STY $nn,X */
+            CPU_OPCODE(0x94):          /* STY $nn,X */
                 STY_ZERO((LOAD_ZERO_DUMMY(p1), p1 + reg_x_read), CLK_ZERO_I_STORE, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x95:          /* STA $nn,X */
+            CPU_OPCODE(0x95):          /* STA $nn,X */
                 STA_ZERO((LOAD_ZERO_DUMMY(p1), p1 + reg_x_read), CLK_ZERO_I_STORE, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x96:          /* STX $nn,Y */
+            CPU_OPCODE(0x96):          /* STX $nn,Y */
                 STX_ZERO((LOAD_ZERO_DUMMY(p1), p1 + reg_y_read), CLK_ZERO_I_STORE, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x97:          /* SAX $nn,Y */
+            CPU_OPCODE(0x97):          /* SAX $nn,Y */
                 SAX((LOAD_ZERO_DUMMY(p1), (p1 + reg_y_read) & 0xff), 0, CLK_ZERO_I_STORE, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x98:          /* TYA */
+            CPU_OPCODE(0x98):          /* TYA */
                 TYA();
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x99:          /* STA $nnnn,Y */
+            CPU_OPCODE(0x99):          /* STA $nnnn,Y */
                 STA(p2, 0, CLK_ABS_I_STORE2, 3, STORE_ABS_Y);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x9a:          /* TXS */
+            CPU_OPCODE(0x9a):          /* TXS */
                 TXS();
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x9b:          /* SHS $nnnn,Y */
+            CPU_OPCODE(0x9b):          /* SHS $nnnn,Y */
 #ifdef C64DTV
                 NOOP_ABS_Y();
 #else
                 SHS_ABS_Y(p2);
 #endif
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x9c:          /* SHY $nnnn,X */
+            CPU_OPCODE(0x9c):          /* SHY $nnnn,X */
                 SHY_ABS_X(p2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x9d:          /* STA $nnnn,X */
+            CPU_OPCODE(0x9d):          /* STA $nnnn,X */
                 STA(p2, 0, CLK_ABS_I_STORE2, 3, STORE_ABS_X);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x9e:          /* SHX $nnnn,Y */
+            CPU_OPCODE(0x9e):          /* SHX $nnnn,Y */
                 SHX_ABS_Y(p2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0x9f:          /* SHA $nnnn,Y */
+            CPU_OPCODE(0x9f):          /* SHA $nnnn,Y */
                 SHA_ABS_Y(p2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xa0:          /* LDY #$nn */
+            CPU_OPCODE(0xa0):          /* LDY #$nn */
                 LDY(p1, 0, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xa1:          /* LDA ($nn,X) */
+            CPU_OPCODE(0xa1):          /* LDA ($nn,X) */
                 LDA(LOAD_IND_X(p1), 1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xa2:          /* LDX #$nn */
+            CPU_OPCODE(0xa2):          /* LDX #$nn */
                 LDX(p1, 0, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xa3:          /* LAX ($nn,X) */
+            CPU_OPCODE(0xa3):          /* LAX ($nn,X) */
                 LAX(LOAD_IND_X(p1), 1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xa4:          /* LDY $nn */
+            CPU_OPCODE(0xa4):          /* LDY $nn */
                 LDY(LOAD_ZERO(p1), 1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xa5:          /* LDA $nn */
+            CPU_OPCODE(0xa5):          /* LDA $nn */
                 LDA(LOAD_ZERO(p1), 1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xa6:          /* LDX $nn */
+            CPU_OPCODE(0xa6):          /* LDX $nn */
                 LDX(LOAD_ZERO(p1), 1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xa7:          /* LAX $nn */
+            CPU_OPCODE(0xa7):          /* LAX $nn */
                 LAX(LOAD_ZERO(p1), 1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xa8:          /* TAY */
+            CPU_OPCODE(0xa8):          /* TAY */
                 TAY();
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xa9:          /* LDA #$nn */
+            CPU_OPCODE(0xa9):          /* LDA #$nn */
                 LDA(p1, 0, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xaa:          /* TAX */
+            CPU_OPCODE(0xaa):          /* TAX */
                 TAX();
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xab:          /* LXA #$nn */
+            CPU_OPCODE(0xab):          /* LXA #$nn */
                 LXA(p1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xac:          /* LDY $nnnn */
+            CPU_OPCODE(0xac):          /* LDY $nnnn */
                 LDY(LOAD(p2), 1, 3);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xad:          /* LDA $nnnn */
+            CPU_OPCODE(0xad):          /* LDA $nnnn */
                 LDA(LOAD(p2), 1, 3);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xae:          /* LDX $nnnn */
+            CPU_OPCODE(0xae):          /* LDX $nnnn */
                 LDX(LOAD(p2), 1, 3);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xaf:          /* LAX $nnnn */
+            CPU_OPCODE(0xaf):          /* LAX $nnnn */
                 LAX(LOAD(p2), 1, 3);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xb0:          /* BCS $nnnn */
+            CPU_OPCODE(0xb0):          /* BCS $nnnn */
                 BRANCH(LOCAL_CARRY(), p1);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xb1:          /* LDA ($nn),Y */
+            CPU_OPCODE(0xb1):          /* LDA ($nn),Y */
                 LDA(LOAD_IND_Y_BANK(p1), 1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xb3:          /* LAX ($nn),Y */
+            CPU_OPCODE(0xb3):          /* LAX ($nn),Y */
                 LAX(LOAD_IND_Y(p1), 1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xb4:          /* LDY $nn,X */
+            CPU_OPCODE(0xb4):          /* LDY $nn,X */
                 LDY(LOAD_ZERO_X(p1), CLK_ZERO_I2, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xb5:          /* LDA $nn,X */
+            CPU_OPCODE(0xb5):          /* LDA $nn,X */
                 LDA(LOAD_ZERO_X(p1), CLK_ZERO_I2, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xb6:          /* LDX $nn,Y */
+            CPU_OPCODE(0xb6):          /* LDX $nn,Y */
                 LDX(LOAD_ZERO_Y(p1), CLK_ZERO_I2, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xb7:          /* LAX $nn,Y */
+            CPU_OPCODE(0xb7):          /* LAX $nn,Y */
                 LAX(LOAD_ZERO_Y(p1), CLK_ZERO_I2, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xb8:          /* CLV */
+            CPU_OPCODE(0xb8):          /* CLV */
                 CLV();
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xb9:          /* LDA $nnnn,Y */
+            CPU_OPCODE(0xb9):          /* LDA $nnnn,Y */
                 LDA(LOAD_ABS_Y(p2), 1, 3);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xba:          /* TSX */
+            CPU_OPCODE(0xba):          /* TSX */
                 TSX();
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xbb:          /* LAS $nnnn,Y */
+            CPU_OPCODE(0xbb):          /* LAS $nnnn,Y */
                 LAS(LOAD_ABS_Y(p2), 1, 3);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xbc:          /* LDY $nnnn,X */
+            CPU_OPCODE(0xbc):          /* LDY $nnnn,X */
                 LDY(LOAD_ABS_X(p2), 1, 3);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xbd:          /* LDA $nnnn,X */
+            CPU_OPCODE(0xbd):          /* LDA $nnnn,X */
                 LDA(LOAD_ABS_X(p2), 1, 3);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xbe:          /* LDX $nnnn,Y */
+            CPU_OPCODE(0xbe):          /* LDX $nnnn,Y */
                 LDX(LOAD_ABS_Y(p2), 1, 3);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xbf:          /* LAX $nnnn,Y */
+            CPU_OPCODE(0xbf):          /* LAX $nnnn,Y */
                 LAX(LOAD_ABS_Y(p2), 1, 3);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xc0:          /* CPY #$nn */
+            CPU_OPCODE(0xc0):          /* CPY #$nn */
                 CPY(p1, 0, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xc1:          /* CMP ($nn,X) */
+            CPU_OPCODE(0xc1):          /* CMP ($nn,X) */
                 CMP(LOAD_IND_X(p1), 1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xc3:          /* DCP ($nn,X) */
+            CPU_OPCODE(0xc3):          /* DCP ($nn,X) */
                 LOAD_ZERO_DUMMY(p1);
                 CLK_ADD_DUMMY(CLK, 1);
                 DCP(LOAD_ZERO_ADDR(p1 + reg_x_read), 2, 2, LOAD_ABS, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xc4:          /* CPY $nn */
+            CPU_OPCODE(0xc4):          /* CPY $nn */
                 CPY(LOAD_ZERO(p1), 1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xc5:          /* CMP $nn */
+            CPU_OPCODE(0xc5):          /* CMP $nn */
                 CMP(LOAD_ZERO(p1), 1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xc6:          /* DEC $nn */
+            CPU_OPCODE(0xc6):          /* DEC $nn */
                 DEC(p1, 2, LOAD_ZERO, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xc7:          /* DCP $nn */
+            CPU_OPCODE(0xc7):          /* DCP $nn */
                 DCP(p1, 0, 2, LOAD_ZERO, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xc8:          /* INY */
+            CPU_OPCODE(0xc8):          /* INY */
                 INY();
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xc9:          /* CMP #$nn */
+            CPU_OPCODE(0xc9):          /* CMP #$nn */
                 CMP(p1, 0, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xca:          /* DEX */
+            CPU_OPCODE(0xca):          /* DEX */
                 DEX();
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xcb:          /* SBX #$nn */
+            CPU_OPCODE(0xcb):          /* SBX #$nn */
                 SBX(p1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xcc:          /* CPY $nnnn */
+            CPU_OPCODE(0xcc):          /* CPY $nnnn */
                 CPY(LOAD(p2), 1, 3);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xcd:          /* CMP $nnnn */
+            CPU_OPCODE(0xcd):          /* CMP $nnnn */
                 CMP(LOAD(p2), 1, 3);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xce:          /* DEC $nnnn */
+            CPU_OPCODE(0xce):          /* DEC $nnnn */
                 DEC(p2, 3, LOAD_ABS, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xcf:          /* DCP $nnnn */
+            CPU_OPCODE(0xcf):          /* DCP $nnnn */
                 DCP(p2, 0, 3, LOAD_ABS, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xd0:          /* BNE $nnnn */
+            CPU_OPCODE(0xd0):          /* BNE $nnnn */
                 BRANCH(!LOCAL_ZERO(), p1);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xd1:          /* CMP ($nn),Y */
+            CPU_OPCODE(0xd1):          /* CMP ($nn),Y */
                 CMP(LOAD_IND_Y(p1), 1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xd3:          /* DCP ($nn),Y */
+            CPU_OPCODE(0xd3):          /* DCP ($nn),Y */
                 DCP_IND_Y(p1);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xd5:          /* CMP $nn,X */
+            CPU_OPCODE(0xd5):          /* CMP $nn,X */
                 CMP(LOAD_ZERO_X(p1), CLK_ZERO_I2, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xd6:          /* DEC $nn,X */
+            CPU_OPCODE(0xd6):          /* DEC $nn,X */
                 LOAD_ZERO_DUMMY(p1);
                 CLK_ADD_DUMMY(CLK, 1);
                 DEC((p1 + reg_x_read) & 0xff, 2, LOAD_ABS, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xd7:          /* DCP $nn,X */
+            CPU_OPCODE(0xd7):          /* DCP $nn,X */
                 LOAD_ZERO_DUMMY(p1);
                 CLK_ADD_DUMMY(CLK, 1);
                 DCP((p1 + reg_x_read) & 0xff, 0, 2, LOAD_ABS, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xd8:          /* CLD */
+            CPU_OPCODE(0xd8):          /* CLD */
                 CLD();
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xd9:          /* CMP $nnnn,Y */
+            CPU_OPCODE(0xd9):          /* CMP $nnnn,Y */
                 CMP(LOAD_ABS_Y(p2), 1, 3);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xdb:          /* DCP $nnnn,Y */
+            CPU_OPCODE(0xdb):          /* DCP $nnnn,Y */
                 DCP(p2, 0, 3, LOAD_ABS_Y_RMW, STORE_ABS_Y_RMW, DUMMY_STORE_ABS_Y_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xdd:          /* CMP $nnnn,X */
+            CPU_OPCODE(0xdd):          /* CMP $nnnn,X */
                 CMP(LOAD_ABS_X(p2), 1, 3);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xde:          /* DEC $nnnn,X */
+            CPU_OPCODE(0xde):          /* DEC $nnnn,X */
                 DEC(p2, 3, LOAD_ABS_X_RMW, STORE_ABS_X_RMW, DUMMY_STORE_ABS_X_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xdf:          /* DCP $nnnn,X */
+            CPU_OPCODE(0xdf):          /* DCP $nnnn,X */
                 DCP(p2, 0, 3, LOAD_ABS_X_RMW, STORE_ABS_X_RMW, DUMMY_STORE_ABS_X_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xe0:          /* CPX #$nn */
+            CPU_OPCODE(0xe0):          /* CPX #$nn */
                 CPX(p1, 0, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xe1:          /* SBC ($nn,X) */
+            CPU_OPCODE(0xe1):          /* SBC ($nn,X) */
                 SBC(LOAD_IND_X(p1), 1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xe3:          /* ISB ($nn,X) */
+            CPU_OPCODE(0xe3):          /* ISB ($nn,X) */
                 LOAD_ZERO_DUMMY(p1);
                 CLK_ADD_DUMMY(CLK, 1);
                 ISB(LOAD_ZERO_ADDR(p1 + reg_x_read), 2, 2, LOAD_ABS, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xe4:          /* CPX $nn */
+            CPU_OPCODE(0xe4):          /* CPX $nn */
                 CPX(LOAD_ZERO(p1), 1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xe5:          /* SBC $nn */
+            CPU_OPCODE(0xe5):          /* SBC $nn */
                 SBC(LOAD_ZERO(p1), 1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xe6:          /* INC $nn */
+            CPU_OPCODE(0xe6):          /* INC $nn */
                 INC(p1, 2, LOAD_ZERO, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xe7:          /* ISB $nn */
+            CPU_OPCODE(0xe7):          /* ISB $nn */
                 ISB(p1, 0, 2, LOAD_ZERO, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xe8:          /* INX */
+            CPU_OPCODE(0xe8):          /* INX */
                 INX();
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xe9:          /* SBC #$nn */
+            CPU_OPCODE(0xe9):          /* SBC #$nn */
                 SBC(p1, 0, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xea:          /* NOP */
+            CPU_OPCODE(0xea):          /* NOP */
                 NOP();
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xeb:          /* USBC #$nn (same as SBC) */
+            CPU_OPCODE(0xeb):          /* USBC #$nn (same as SBC) */
                 SBC(p1, 0, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xec:          /* CPX $nnnn */
+            CPU_OPCODE(0xec):          /* CPX $nnnn */
                 CPX(LOAD(p2), 1, 3);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xed:          /* SBC $nnnn */
+            CPU_OPCODE(0xed):          /* SBC $nnnn */
                 SBC(LOAD(p2), 1, 3);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xee:          /* INC $nnnn */
+            CPU_OPCODE(0xee):          /* INC $nnnn */
                 INC(p2, 3, LOAD_ABS, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xef:          /* ISB $nnnn */
+            CPU_OPCODE(0xef):          /* ISB $nnnn */
                 ISB(p2, 0, 3, LOAD_ABS, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xf0:          /* BEQ $nnnn */
+            CPU_OPCODE(0xf0):          /* BEQ $nnnn */
                 BRANCH(LOCAL_ZERO(), p1);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xf1:          /* SBC ($nn),Y */
+            CPU_OPCODE(0xf1):          /* SBC ($nn),Y */
                 SBC(LOAD_IND_Y(p1), 1, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xf3:          /* ISB ($nn),Y */
+            CPU_OPCODE(0xf3):          /* ISB ($nn),Y */
                 ISB_IND_Y(p1);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xf5:          /* SBC $nn,X */
+            CPU_OPCODE(0xf5):          /* SBC $nn,X */
                 SBC(LOAD_ZERO_X(p1), CLK_ZERO_I2, 2);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xf6:          /* INC $nn,X */
+            CPU_OPCODE(0xf6):          /* INC $nn,X */
                 LOAD_ZERO_DUMMY(p1);
                 CLK_ADD_DUMMY(CLK, 1);
                 INC((p1 + reg_x_read) & 0xff, 2, LOAD_ZERO, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xf7:          /* ISB $nn,X */
+            CPU_OPCODE(0xf7):          /* ISB $nn,X */
                 LOAD_ZERO_DUMMY(p1);
                 CLK_ADD_DUMMY(CLK, 1);
                 ISB((p1 + reg_x_read) & 0xff, 0, 2, LOAD_ZERO, STORE_ABS, DUMMY_STORE_ABS_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xf8:          /* SED */
+            CPU_OPCODE(0xf8):          /* SED */
                 SED();
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xf9:          /* SBC $nnnn,Y */
+            CPU_OPCODE(0xf9):          /* SBC $nnnn,Y */
                 SBC(LOAD_ABS_Y(p2), 1, 3);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xfb:          /* ISB $nnnn,Y */
+            CPU_OPCODE(0xfb):          /* ISB $nnnn,Y */
                 ISB(p2, 0, 3, LOAD_ABS_Y_RMW, STORE_ABS_Y_RMW, DUMMY_STORE_ABS_Y_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xfd:          /* SBC $nnnn,X */
+            CPU_OPCODE(0xfd):          /* SBC $nnnn,X */
                 SBC(LOAD_ABS_X(p2), 1, 3);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xfe:          /* INC $nnnn,X */
+            CPU_OPCODE(0xfe):          /* INC $nnnn,X */
                 INC(p2, 3, LOAD_ABS_X_RMW, STORE_ABS_X_RMW, DUMMY_STORE_ABS_X_RMW);
-                break;
+                CPU_OPCODE_DONE;
 
-            case 0xff:          /* ISB $nnnn,X */
+            CPU_OPCODE(0xff):          /* ISB $nnnn,X */
                 ISB(p2, 0, 3, LOAD_ABS_X_RMW, STORE_ABS_X_RMW, DUMMY_STORE_ABS_X_RMW);
-                break;
+                CPU_OPCODE_DONE;
         }
 
-#if !defined(DRIVE_CPU)
-        if (maincpu_profiling) {
-            profile_sample_finish(CLK - profiling_clock_start, 0 /* stolen_cycles */);
+        if (cpu_profiling[CALLER]) {
+            profile_sample_finish(CALLER, CLK - profiling_clock_start, 0 /* stolen_cycles */);
         }
-#endif
 
     }
+
+    CPU_INSTRUCTION_DONE
+
+#ifdef CPU_THREADED_DISPATCH
+cpu_leave:
+    ;
+#endif
 }
@@ -254,22 +254,22 @@
 #if !defined(DRIVE_CPU)
 #define CHECK_PROFILE_INTERRUPT(dest_addr, handler)                        \
     do {                                                                   \
-            profile_int(dest_addr, handler, reg_sp + 1, CLK - profiling_clock_start); \
+            profile_int(CALLER, dest_addr, handler, reg_sp + 1, CLK - profiling_clock_start); \
     } while (0)
 
 #define CHECK_PROFILE_JSR(dest_addr)     \
     do {                                 \
-            profile_jsr(dest_addr, reg_pc, reg_sp); \
+            profile_jsr(CALLER, dest_addr, reg_pc, reg_sp); \
     } while (0)
 
 #define CHECK_PROFILE_RTS()      \
     do {                         \
-            profile_rtx(reg_sp); \
+            profile_rtx(CALLER, reg_sp); \
     } while (0)
 
 #define CHECK_PROFILE_RTI()          \
     do {                             \
-            profile_rtx(reg_sp + 1); \
+            profile_rtx(CALLER, reg_sp + 1); \
     } while (0)
 
 #else
@@ -1768,8 +1768,8 @@ static const uint8_t fetch_tab[] = {
 #if !defined(DRIVE_CPU)
         profiling_clock_start = CLK;
         stolen_cycles = 0;
-        if (maincpu_profiling) {
-            profile_sample_start(reg_pc);
+        if (cpu_profiling[CALLER]) {
+            profile_sample_start(CALLER, reg_pc);
         }
 #endif
 
@@ -2774,8 +2774,8 @@ trap_skipped:
         }
 
 #if !defined(DRIVE_CPU)
-        if (maincpu_profiling) {
-            profile_sample_finish(CLK - profiling_clock_start - stolen_cycles, stolen_cycles);
+        if (cpu_profiling[CALLER]) {
+            profile_sample_finish(CALLER, CLK - profiling_clock_start - stolen_cycles, stolen_cycles);
         }
 #endif
 
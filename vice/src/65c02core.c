@@ -51,6 +51,7 @@
 #define CPU_STR "65(S)C02 CPU"
 #endif
 
+#include "profiler.h"
 #include "traps.h"
 
 /* To avoid 'magic' numbers, we will use the following defines. */
@@ -291,12 +292,42 @@
 #define TRACE_BRK()
 #endif
 
+/* Call stack tracking for the profiler, only done while the CPU is profiled. */
+#define CHECK_PROFILE_INTERRUPT(dest_addr, handler)                                           \
+    do {                                                                                      \
+        if (cpu_profiling[CALLER]) {                                                          \
+            profile_int(CALLER, dest_addr, handler, reg_sp + 1, CLK - profiling_clock_start); \
+        }                                                                                     \
+    } while (0)
+
+#define CHECK_PROFILE_JSR(dest_addr)                            \
+    do {                                                        \
+        if (cpu_profiling[CALLER]) {                            \
+            profile_jsr(CALLER, dest_addr, reg_pc, reg_sp);     \
+        }                                                       \
+    } while (0)
+
+#define CHECK_PROFILE_RTS()                 \
+    do {                                    \
+        if (cpu_profiling[CALLER]) {        \
+            profile_rtx(CALLER, reg_sp);    \
+        }                                   \
+    } while (0)
+
+#define CHECK_PROFILE_RTI()                     \
+    do {                                        \
+        if (cpu_profiling[CALLER]) {            \
+            profile_rtx(CALLER, reg_sp + 1);    \
+        }                                       \
+    } while (0)
+
 /* Perform the interrupts in `int_kind'.  If we have both NMI and IRQ,
    execute NMI. NMI can _not_ take over an in progress IRQ. */
 /* FIXME: LOCAL_STATUS() should check byte ready first.  */
 #define DO_INTERRUPT(int_kind)                                                                                \
     do {                                                                                                      \
         uint8_t ik = (int_kind);                                                                                 \
+        uint16_t handler_addr;                                                                                \
                                                                                                               \
         if (ik & (IK_IRQ | IK_IRQPEND | IK_NMI)) {                                                            \
             if ((ik & IK_NMI)                                                                                 \
@@ -320,7 +351,9 @@
                 CLK_ADD(CLK, 1);                                                                              \
                 LOCAL_SET_DECIMAL(0);                                                                         \
                 LOCAL_SET_INTERRUPT(1);                                                                       \
-                JUMP(LOAD_ADDR(0xfffa));                                                                      \
+                handler_addr = LOAD_ADDR(0xfffa);                                                             \
+                CHECK_PROFILE_INTERRUPT(handler_addr, 0xfffa);                                                \
+                JUMP(handler_addr);                                                                           \
                 SET_LAST_OPCODE(0);                                                                           \
                 CLK_ADD(CLK, 2);                                                                              \
             }                                                                                                 \
@@ -345,7 +378,9 @@
                 CLK_ADD(CLK, 1);                                                                              \
                 LOCAL_SET_DECIMAL(0);                                                                         \
                 LOCAL_SET_INTERRUPT(1);                                                                       \
-                JUMP(LOAD_ADDR(0xfffe));                                                                      \
+                handler_addr = LOAD_ADDR(0xfffe);                                                             \
+                CHECK_PROFILE_INTERRUPT(handler_addr, 0xfffe);                                                \
+                JUMP(handler_addr);                                                                           \
                 SET_LAST_OPCODE(0);                                                                           \
                 CLK_ADD(CLK, 2);                                                                              \
             }                                                                                                 \
@@ -364,7 +399,9 @@
                 cpu_reset();                                                                                  \
                 bank_start = bank_limit = 0; /* prevent caching */                                            \
                 LOCAL_SET_INTERRUPT(1);                                                                       \
-                JUMP(LOAD_ADDR(0xfffc));                                                                      \
+                handler_addr = LOAD_ADDR(0xfffc);                                                             \
+                CHECK_PROFILE_INTERRUPT(handler_addr, 0xfffc);                                                \
+                JUMP(handler_addr);                                                                           \
                 DMA_ON_RESET;                                                                                 \
             }                                                                                                 \
         }                                                                                                     \
@@ -711,21 +748,25 @@
         }                                              \
     } while (0)
 
-#define BRK()                    \
-    do {                         \
-        EXPORT_REGISTERS();      \
-        TRACE_BRK();             \
-        INC_PC(SIZE_2);          \
-        LOCAL_SET_BREAK(1);      \
-        PUSH(reg_pc >> 8);       \
-        PUSH(reg_pc & 0xff);     \
-        CLK_ADD(CLK, CYCLES_2);  \
-        PUSH(LOCAL_STATUS());    \
-        CLK_ADD(CLK, CYCLES_1);  \
-        LOCAL_SET_DECIMAL(0);    \
-        LOCAL_SET_INTERRUPT(1);  \
-        JUMP(LOAD_ADDR(0xfffe)); \
-        CLK_ADD(CLK, CYCLES_2);  \
+#define BRK()                                      \
+    do {                                           \
+        uint16_t tmp_addr;                         \
+                                                   \
+        EXPORT_REGISTERS();                        \
+        TRACE_BRK();                               \
+        INC_PC(SIZE_2);                            \
+        LOCAL_SET_BREAK(1);                        \
+        PUSH(reg_pc >> 8);                         \
+        PUSH(reg_pc & 0xff);                       \
+        CLK_ADD(CLK, CYCLES_2);                    \
+        PUSH(LOCAL_STATUS());                      \
+        CLK_ADD(CLK, CYCLES_1);                    \
+        LOCAL_SET_DECIMAL(0);                      \
+        LOCAL_SET_INTERRUPT(1);                    \
+        tmp_addr = LOAD_ADDR(0xfffe);              \
+        CHECK_PROFILE_INTERRUPT(tmp_addr, 0xfffe); \
+        JUMP(tmp_addr);                            \
+        CLK_ADD(CLK, CYCLES_2);                    \
     } while (0)
 
 #define CLC()               \
@@ -926,6 +967,7 @@
         PUSH((reg_pc) & 0xff);                 \
         tmp_addr = (p1 | (LOAD(reg_pc) << 8)); \
         CLK_ADD(CLK, CYCLES_1);                \
+        CHECK_PROFILE_JSR(tmp_addr);           \
         JUMP(tmp_addr);                        \
     } while (0)
 
@@ -1177,6 +1219,7 @@
     do {                             \
         uint16_t tmp;                    \
                                      \
+        CHECK_PROFILE_RTI();         \
         LOAD(reg_sp | 0x100);        \
         CLK_ADD(CLK, CYCLES_4);      \
         tmp = (uint16_t)PULL();          \
@@ -1190,6 +1233,7 @@
     do {                           \
         uint16_t tmp;                  \
                                    \
+        CHECK_PROFILE_RTS();       \
         LOAD(reg_sp | 0x100);      \
         CLK_ADD(CLK, CYCLES_3);    \
         tmp = PULL();              \
@@ -1600,6 +1644,8 @@
 /* Here, the CPU is emulated. */
 
 {
+    CLOCK profiling_clock_start = CLK;
+
     CPU_DELAY_CLK;
 
     PROCESS_ALARMS;
@@ -1615,6 +1661,7 @@
 
         pending_interrupt = CPU_INT_STATUS->global_pending_int;
         if (pending_interrupt != IK_NONE) {
+            profiling_clock_start = CLK;
             DO_INTERRUPT(pending_interrupt);
             if (!(CPU_INT_STATUS->global_pending_int & IK_IRQ)
                 && CPU_INT_STATUS->global_pending_int & IK_IRQPEND) {
@@ -1646,6 +1693,11 @@
         history_clk = CLK;
 #endif
 #endif
+        profiling_clock_start = CLK;
+        if (cpu_profiling[CALLER]) {
+            profile_sample_start(CALLER, reg_pc);
+        }
+
         SET_LAST_ADDR(reg_pc);
         FETCH_OPCODE(opcode);
 
@@ -2591,5 +2643,9 @@ trap_skipped:
                 BBS(BIT_7);
                 break;
         }
+
+        if (cpu_profiling[CALLER]) {
+            profile_sample_finish(CALLER, CLK - profiling_clock_start, 0 /* stolen_cycles */);
+        }
     }
 }
@@ -111,6 +111,7 @@ static void alarm_init(alarm_t *alarm, alarm_context_t *context,
     alarm->data = data;
 
     alarm->pending_idx = -1;      /* Not pending.  */
+    alarm->instrument_slot = -1;
 
     /* Add to the head of the alarm list of the alarm context.  */
     if (context->alarms == NULL) {
@@ -28,6 +28,7 @@
 #ifndef VICE_ALARM_H
 #define VICE_ALARM_H
 
+#include "instrument.h"
 #include "types.h"
 
 #define ALARM_CONTEXT_MAX_PENDING_ALARMS 0x100
@@ -52,6 +53,10 @@ struct alarm_s {
     /* Call data */
     void *data;
 
+    /* Slot of the alarm name in the instrumentation, -1 until the alarm has
+       been dispatched with the instrumentation enabled.  */
+    int instrument_slot;
+
     /* Link to the next and previous alarms in the list.  */
     struct alarm_s *next, *prev;
 };
@@ -140,6 +145,11 @@ inline static void alarm_context_dispatch(alarm_context_t *context,
     idx = context->next_pending_alarm_idx;
     alarm = context->pending_alarms[idx].alarm;
 
+    if (instrument_enabled) {
+        instrument_alarm_dispatch(alarm, offset);
+        return;
+    }
+
     (alarm->callback)(offset, alarm->data);
 }
 
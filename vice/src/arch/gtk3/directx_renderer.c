@@ -298,7 +298,8 @@ static void vice_directx_refresh_rect(video_canvas_t *canvas,
 
     CANVAS_UNLOCK();
 
-    video_canvas_render(canvas, backbuffer->pixel_data, w, h, xs, ys, xi, yi, backbuffer->width * 4);
+    /* the color conversion and CRT emulation are done on the render thread */
+    render_queue_capture_source(backbuffer, canvas, xs, ys, xi, yi, w, h);
 
     CANVAS_LOCK();
     render_queue_enqueue_for_display(context->render_queue, backbuffer);
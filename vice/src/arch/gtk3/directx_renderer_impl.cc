@@ -524,6 +524,12 @@ void vice_directx_impl_async_render(void *job_data, void *pool_data)
         return;
     }
 
+    /* Color conversion and CRT emulation, without blocking the emulation thread */
+    backbuffer = render_queue_dequeue_for_display(context->render_queue);
+    if (backbuffer) {
+        render_queue_render_source(context->render_queue, backbuffer);
+    }
+
     CANVAS_LOCK();
 
     if (context->resized) {
@@ -538,7 +544,6 @@ void vice_directx_impl_async_render(void *job_data, void *pool_data)
      * especially when the monitor is open and stepping through code.
      */
 
-    backbuffer = render_queue_dequeue_for_display(context->render_queue);
     if (backbuffer) {
         build_render_bitmap(context, backbuffer);
         render_queue_return_to_pool(context->render_queue, backbuffer);
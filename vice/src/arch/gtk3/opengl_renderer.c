@@ -209,6 +209,7 @@ static void on_widget_realized(GtkWidget *widget, gpointer data)
 
     glGenTextures(1, &context->current_frame_texture);
     glGenTextures(1, &context->previous_frame_texture);
+    context->current_frame = 0;
 
     vice_opengl_renderer_clear_current(context);
 
@@ -369,7 +370,8 @@ static void vice_opengl_refresh_rect(video_canvas_t *canvas,
 
     CANVAS_UNLOCK();
 
-    video_canvas_render(canvas, backbuffer->pixel_data, w, h, xs, ys, xi, yi, backbuffer->width * 4);
+    /* the color conversion and CRT emulation are done on the render thread */
+    render_queue_capture_source(backbuffer, canvas, xs, ys, xi, yi, w, h);
 
     CANVAS_LOCK();
     if (context->render_thread) {
@@ -494,6 +496,37 @@ static void vice_opengl_on_ui_frame_clock(GdkFrameClock *clock, video_canvas_t *
 #endif
 }
 
+/* Upload the rows of the backbuffer that changed since the frame held by the
+   current texture. Returns false if that isn't possible. */
+static bool update_frame_texture_rows(context_t *context, backbuffer_t *backbuffer)
+{
+    unsigned int row;
+    unsigned int first;
+
+    if (!backbuffer->dirty_valid
+        || backbuffer->dirty_base != context->current_frame
+        || backbuffer->width != context->current_frame_width
+        || backbuffer->height != context->current_frame_height) {
+        return false;
+    }
+
+    row = 0;
+    while (row < backbuffer->height) {
+        if (!backbuffer->dirty_rows[row]) {
+            row++;
+            continue;
+        }
+        first = row;
+        while (row < backbuffer->height && backbuffer->dirty_rows[row]) {
+            row++;
+        }
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, first, backbuffer->width, row - first,
+                        GL_RGBA, GL_UNSIGNED_BYTE,
+                        backbuffer->pixel_data + first * backbuffer->width * 4);
+    }
+    return true;
+}
+
 static void update_frame_textures(context_t *context, backbuffer_t *backbuffer)
 {
     /*
@@ -508,23 +541,29 @@ static void update_frame_textures(context_t *context, backbuffer_t *backbuffer)
         context->previous_frame_height      = context->current_frame_height;
         context->current_frame_texture      = swap_texture;
         context->current_interlace_field    = backbuffer->interlace_field;
+        context->current_frame              = 0;
     }
 
-    context->current_frame_width    = backbuffer->width;
-    context->current_frame_height   = backbuffer->height;
-    context->interlaced             = backbuffer->interlaced;
-    context->pixel_aspect_ratio     = backbuffer->pixel_aspect_ratio;
-
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, context->current_frame_texture);
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     glPixelStorei(GL_UNPACK_ROW_LENGTH, backbuffer->width);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, backbuffer->width, backbuffer->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, backbuffer->pixel_data);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    /* Only upload what changed if the texture holds the previous frame */
+    if (!update_frame_texture_rows(context, backbuffer)) {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, backbuffer->width, backbuffer->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, backbuffer->pixel_data);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
     glBindTexture(GL_TEXTURE_2D, 0);
+
+    context->current_frame          = backbuffer->frame;
+    context->current_frame_width    = backbuffer->width;
+    context->current_frame_height   = backbuffer->height;
+    context->interlaced             = backbuffer->interlaced;
+    context->pixel_aspect_ratio     = backbuffer->pixel_aspect_ratio;
 }
 
 static void legacy_render(video_canvas_t *canvas, float scale_x, float scale_y)
@@ -767,6 +806,14 @@ static void render(void *job_data, void *pool_data)
         return;
     }
 
+    CANVAS_UNLOCK();
+
+    /* Color conversion and CRT emulation, without blocking the emulation thread */
+    if (backbuffer) {
+        render_queue_render_source(context->render_queue, backbuffer);
+    }
+
+    CANVAS_LOCK();
     RENDER_LOCK();
 
     vice_opengl_renderer_make_current(context);
@@ -137,6 +137,8 @@ typedef struct vice_opengl_renderer_context_s {
 
     /** \brief The texture identifier for the GPU's copy of our  machine display. */
     GLuint current_frame_texture;
+    /** \brief The backbuffer frame held by current_frame_texture, 0 if unknown. */
+    unsigned int current_frame;
     unsigned int current_frame_width;
     unsigned int current_frame_height;
     bool interlaced;
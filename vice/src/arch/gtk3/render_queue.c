@@ -33,6 +33,8 @@
 #include <string.h>
 
 #include "lib.h"
+#include "video.h"
+#include "videoarch.h"
 #include "vsyncapi.h"
 
 #define LOCK() pthread_mutex_lock(&rq->lock)
@@ -58,10 +60,24 @@ typedef struct vice_render_queue_s {
 
     /** Allows discarding of late buffer returns */
     unsigned int backbuffer_generation;
+
+    /** Source and geometry of the last rendered frame, to find dirty rows */
+    backbuffer_t last;
+
+    /** Color table generation the last frame was rendered with */
+    unsigned int last_color_generation;
+
+    /** Sequence number of the last rendered frame, 0 if none */
+    unsigned int frame_counter;
 } render_queue_t;
 
 static void free_backbuffer(backbuffer_t *backbuffer) {
     lib_free(backbuffer->pixel_data);
+    lib_free(backbuffer->source_data);
+    if (backbuffer->source_snapshot) {
+        video_canvas_render_snapshot_free(backbuffer->source_snapshot);
+    }
+    lib_free(backbuffer->dirty_rows);
     lib_free(backbuffer);
 }
 
@@ -80,7 +96,7 @@ void *render_queue_create(void)
     /* Seed the pool with the maximum number of backbuffers */
     for (i = 0; i < RENDER_QUEUE_MAX_BACKBUFFERS; i++) {
 
-        bb = lib_malloc(sizeof(backbuffer_t));
+        bb = lib_calloc(1, sizeof(backbuffer_t));
         bb->pixel_data = lib_malloc(0);
         bb->pixel_data_size_bytes = 0;
         bb->width = 0;
@@ -110,6 +126,8 @@ void render_queue_destroy(void *render_queue)
         rq->render_queue_next = rq->render_queue_next % RENDER_QUEUE_MAX_BACKBUFFERS;
     }
 
+    lib_free(rq->last.source_data);
+
     pthread_mutex_destroy(&rq->lock);
     lib_free(render_queue);
 }
@@ -145,6 +163,8 @@ backbuffer_t *render_queue_get_from_pool(void *render_queue, int pixel_data_size
     bb->width = 0;
     bb->height = 0;
     bb->pixel_aspect_ratio = 0.0f;
+    bb->source_pending = false;
+    bb->dirty_valid = false;
 
     return bb;
 }
@@ -215,3 +235,156 @@ void render_queue_return_to_pool(void *render_queue, backbuffer_t *backbuffer)
 
     UNLOCK();
 }
+
+/** Make sure the backbuffer can hold a draw buffer copy of the requested size */
+static void reserve_source(backbuffer_t *backbuffer, unsigned int source_data_size_bytes)
+{
+    if (!backbuffer->source_snapshot) {
+        backbuffer->source_snapshot = video_canvas_render_snapshot_new();
+    }
+    if (backbuffer->source_data_size_bytes < source_data_size_bytes) {
+        lib_free(backbuffer->source_data);
+        backbuffer->source_data = lib_malloc(source_data_size_bytes);
+        backbuffer->source_data_size_bytes = source_data_size_bytes;
+    }
+    backbuffer->source_data_used_bytes = source_data_size_bytes;
+}
+
+/** Copy the palettized draw buffer and the render config of the canvas into
+ *  the backbuffer, render_queue_render_source() later does the (possibly very
+ *  expensive) color conversion and CRT emulation on the render thread.
+ *
+ *  Called on the emulation thread.
+ */
+void render_queue_capture_source(backbuffer_t *backbuffer, video_canvas_t *canvas,
+                                 unsigned int xs, unsigned int ys,
+                                 unsigned int xi, unsigned int yi,
+                                 unsigned int w, unsigned int h)
+{
+    reserve_source(backbuffer, video_canvas_draw_buffer_copy_size(canvas));
+    video_canvas_draw_buffer_copy(canvas, backbuffer->source_data, &backbuffer->source_pitch,
+                                  backbuffer->source_snapshot, w, h, xs, ys);
+    backbuffer->source_color_generation = canvas->videoconfig->color_tables.generation;
+    backbuffer->source_scaley = canvas->videoconfig->scaley;
+    backbuffer->source_xs = xs;
+    backbuffer->source_ys = ys;
+    backbuffer->source_xi = xi;
+    backbuffer->source_yi = yi;
+    backbuffer->source_w = w;
+    backbuffer->source_h = h;
+    backbuffer->source_pending = true;
+}
+
+/* Mark the rows of the backbuffer that are affected by a change in the draw
+   buffer. The CRT emulation mixes in the lines above and below a changed
+   line, so those are marked as well. */
+static void mark_dirty_rows(backbuffer_t *bb, int source_row)
+{
+    unsigned int scaley = bb->source_scaley;
+    int first, last, row;
+
+    first = (int)bb->source_yi + (source_row - 1 - (int)bb->source_ys) * (int)scaley;
+    last = (int)bb->source_yi + (source_row + 2 - (int)bb->source_ys) * (int)scaley;
+
+    if (first < 0) {
+        first = 0;
+    }
+    if (last > (int)bb->height) {
+        last = (int)bb->height;
+    }
+    for (row = first; row < last; row++) {
+        bb->dirty_rows[row] = 1;
+    }
+}
+
+/* Compare the draw buffer copy of a freshly rendered backbuffer with the one
+   of the previous frame, and hand over the copy to become the new previous
+   frame. */
+static void find_dirty_rows(render_queue_t *rq, backbuffer_t *bb)
+{
+    backbuffer_t *last = &rq->last;
+    unsigned int color_generation = bb->source_color_generation;
+    unsigned char *swap_data;
+    unsigned int swap_size;
+    unsigned int rows, row;
+
+    if (++rq->frame_counter == 0) {
+        rq->frame_counter = 1;
+    }
+    bb->frame = rq->frame_counter;
+    bb->dirty_base = last->frame;
+
+    bb->dirty_valid = last->frame != 0
+                      && !bb->interlaced
+                      && color_generation == rq->last_color_generation
+                      && bb->width == last->width
+                      && bb->height == last->height
+                      && bb->source_data_used_bytes == last->source_data_used_bytes
+                      && bb->source_pitch == last->source_pitch
+                      && bb->source_xs == last->source_xs
+                      && bb->source_ys == last->source_ys
+                      && bb->source_xi == last->source_xi
+                      && bb->source_yi == last->source_yi
+                      && bb->source_w == last->source_w
+                      && bb->source_h == last->source_h;
+
+    if (bb->dirty_valid) {
+        if (bb->dirty_rows_size < bb->height) {
+            lib_free(bb->dirty_rows);
+            bb->dirty_rows = lib_malloc(bb->height);
+            bb->dirty_rows_size = bb->height;
+        }
+        memset(bb->dirty_rows, 0, bb->height);
+
+        rows = bb->source_data_used_bytes / bb->source_pitch;
+        for (row = 0; row < rows; row++) {
+            if (memcmp(bb->source_data + row * bb->source_pitch,
+                       last->source_data + row * last->source_pitch,
+                       bb->source_pitch) != 0) {
+                mark_dirty_rows(bb, (int)row - DRAW_BUFFER_PADDING_LINES);
+            }
+        }
+    }
+
+    /* The copy of this frame becomes the reference for the next one */
+    swap_data = last->source_data;
+    swap_size = last->source_data_size_bytes;
+    *last = *bb;
+    last->pixel_data = NULL;
+    last->source_snapshot = NULL;
+    last->dirty_rows = NULL;
+    bb->source_data = swap_data;
+    bb->source_data_size_bytes = swap_size;
+    rq->last_color_generation = color_generation;
+}
+
+/** Render the pending draw buffer copy of a backbuffer into its pixel data.
+ *
+ * Called on the render thread, see video_canvas_render_copy(). Also works out
+ * which rows changed since the previously rendered frame, see backbuffer_t.
+ */
+void render_queue_render_source(void *render_queue, backbuffer_t *backbuffer)
+{
+    render_queue_t *rq = (render_queue_t *)render_queue;
+
+    if (!backbuffer->source_pending) {
+        backbuffer->dirty_valid = false;
+        return;
+    }
+
+    video_canvas_render_copy(backbuffer->source_snapshot,
+                             backbuffer->source_data,
+                             backbuffer->source_pitch,
+                             backbuffer->pixel_data,
+                             backbuffer->source_w,
+                             backbuffer->source_h,
+                             backbuffer->source_xs,
+                             backbuffer->source_ys,
+                             backbuffer->source_xi,
+                             backbuffer->source_yi,
+                             backbuffer->width * 4);
+
+    backbuffer->source_pending = false;
+
+    find_dirty_rows(rq, backbuffer);
+}
@@ -31,6 +31,9 @@
 
 #include <stdbool.h>
 
+struct video_canvas_s;
+struct video_render_snapshot_s;
+
 typedef struct {
     bool interlaced;
     int interlace_field;
@@ -39,6 +42,37 @@ typedef struct {
     unsigned int width;
     unsigned int height;
     float pixel_aspect_ratio;
+
+    /*
+     * Copy of the emulated draw buffer, rendered into pixel_data on the
+     * render thread. The CRT emulation and color conversion are done there
+     * so they don't eat into the emulation thread's frame budget.
+     */
+    bool source_pending;
+    struct video_render_snapshot_s *source_snapshot; /* render config and color tables */
+    unsigned int source_color_generation;
+    unsigned int source_scaley;
+    unsigned char *source_data;
+    unsigned int source_data_size_bytes;
+    unsigned int source_data_used_bytes;
+    unsigned int source_pitch;
+    unsigned int source_xs;
+    unsigned int source_ys;
+    unsigned int source_xi;
+    unsigned int source_yi;
+    unsigned int source_w;
+    unsigned int source_h;
+
+    /*
+     * Rows of pixel_data that differ from the frame rendered before this one.
+     * Renderers that still hold frame dirty_base can upload just those rows,
+     * otherwise (or if dirty_valid is false) the whole frame is needed.
+     */
+    unsigned int frame;
+    unsigned int dirty_base;
+    bool dirty_valid;
+    unsigned char *dirty_rows;
+    unsigned int dirty_rows_size;
 } backbuffer_t;
 
 void *render_queue_create(void);
@@ -50,4 +84,10 @@ unsigned int render_queue_length(void *render_queue);
 backbuffer_t *render_queue_dequeue_for_display(void *render_queue);
 void render_queue_return_to_pool(void *render_queue, backbuffer_t *backbuffer);
 
+void render_queue_capture_source(backbuffer_t *backbuffer, struct video_canvas_s *canvas,
+                                 unsigned int xs, unsigned int ys,
+                                 unsigned int xi, unsigned int yi,
+                                 unsigned int w, unsigned int h);
+void render_queue_render_source(void *render_queue, backbuffer_t *backbuffer);
+
 #endif /* #ifndef VICE_RENDER_QUEUE_H */
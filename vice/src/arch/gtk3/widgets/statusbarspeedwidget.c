@@ -40,6 +40,7 @@
 #include "basedialogs.h"
 #include "drive.h"
 #include "hotkeys.h"
+#include "instrument.h"
 #include "keyboard.h"
 #include "lib.h"
 #include "machine.h"
@@ -361,6 +362,7 @@ GtkWidget *statusbar_speed_widget_create(statusbar_speed_widget_state_t *state)
     state->last_shiftlock = -1;
     state->last_mode4080 = -1;
     state->last_diagnostic_pin = -1;
+    state->last_instrument_generation = 0;
 
     grid = gtk_grid_new();
     gtk_widget_set_valign(grid, GTK_ALIGN_START);
@@ -551,6 +553,7 @@ void statusbar_speed_widget_update(GtkWidget *widget,
     bool is_capslock = false;
     bool is_diagnostic_pin = false;
     int updev = userport_get_device();
+    unsigned int this_instrument_generation;
 
     if (machine_class == VICE_MACHINE_C128) {
         is_mode4080 = keyboard_custom_key_get(KBD_CUSTOM_4080);
@@ -575,6 +578,22 @@ void statusbar_speed_widget_update(GtkWidget *widget,
         state->last_cpu_int = this_cpu_int;
     }
 
+    /* When instrumenting, the cpu label gets the host time breakdown of the
+     * last second as tooltip. The generation changes once per second. */
+    this_instrument_generation = instrument_enabled ? instrument_get_generation() : 0;
+    if (state->last_instrument_generation != this_instrument_generation) {
+        char summary[4096];
+
+        grid = gtk_bin_get_child(GTK_BIN(widget));
+        label = gtk_grid_get_child_at(GTK_GRID(grid), 0, 0);
+        if (instrument_enabled && instrument_format_summary(summary, sizeof(summary))) {
+            gtk_widget_set_tooltip_text(label, summary);
+        } else {
+            gtk_widget_set_tooltip_text(label, NULL);
+        }
+        state->last_instrument_generation = this_instrument_generation;
+    }
+
     /* Somehow the last state gets out of sync when pressing Alt+W and clicking
      * the warp led, or when pressing Alt+P and clicking the pause led, nearly
      * simultaneously, so we don't check for changes but always rerender the
@@ -68,6 +68,7 @@
 #include "archdep_file_exists.h"
 #include "archdep_file_is_blockdev.h"
 #include "archdep_file_is_chardev.h"
+#include "archdep_file_mtime.h"
 #include "archdep_file_size.h"
 #include "archdep_filename_parameter.h"
 #include "archdep_fix_permissions.h"
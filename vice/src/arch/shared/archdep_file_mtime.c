@@ -0,0 +1,75 @@
+/** \file   archdep_file_mtime.c
+ * \brief   Get modification time of a file
+ *
+ * Used to detect changes to a file without reading its contents, for example
+ * to validate cached directory listings of disk and tape images.
+ */
+
+/*
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#include "vice.h"
+#include "archdep_defs.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "archdep_file_mtime.h"
+
+
+/** \brief  Get modification time and size of \a path
+ *
+ * The modification time is returned in nanoseconds since the epoch on systems
+ * that provide sub-second timestamps, in seconds scaled to nanoseconds on
+ * others. The value is only meant to be compared against earlier results of
+ * this function for the same file.
+ *
+ * \param[in]   path    pathname
+ * \param[out]  mtime   modification time (pass `NULL` to ignore)
+ * \param[out]  size    size of the file in bytes (pass `NULL` to ignore)
+ *
+ * \return  0 on success, -1 on failure
+ */
+int archdep_file_mtime(const char *path, uint64_t *mtime, uint64_t *size)
+{
+    struct stat statbuf;
+
+    if (stat(path, &statbuf) < 0) {
+        return -1;
+    }
+    if (mtime != NULL) {
+#if defined(MACOS_COMPILE)
+        *mtime = (uint64_t)statbuf.st_mtimespec.tv_sec * 1000000000U
+                 + (uint64_t)statbuf.st_mtimespec.tv_nsec;
+#elif defined(UNIX_COMPILE)
+        *mtime = (uint64_t)statbuf.st_mtim.tv_sec * 1000000000U
+                 + (uint64_t)statbuf.st_mtim.tv_nsec;
+#else
+        *mtime = (uint64_t)statbuf.st_mtime * 1000000000U;
+#endif
+    }
+    if (size != NULL) {
+        *size = (uint64_t)statbuf.st_size;
+    }
+    return 0;
+}
@@ -113,6 +113,39 @@ tick_t tick_now(void)
 }
 #endif
 
+#ifdef WINDOWS_COMPILE
+uint64_t tick_now_nano(void)
+{
+    LARGE_INTEGER time_now;
+
+    QueryPerformanceCounter(&time_now);
+
+    return (uint64_t)(time_now.QuadPart * ((double)NANO_PER_SECOND / timer_frequency.QuadPart));
+}
+
+#elif defined(MACOS_COMPILE)
+uint64_t tick_now_nano(void)
+{
+    return mach_absolute_time() * timebase_info.numer / timebase_info.denom;
+}
+
+#else
+uint64_t tick_now_nano(void)
+{
+    struct timespec now;
+
+#if defined(LINUX_COMPILE)
+    clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+#elif defined(FREEBSD_COMPILE)
+    clock_gettime(CLOCK_MONOTONIC_PRECISE, &now);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &now);
+#endif
+
+    return ((uint64_t)NANO_PER_SECOND * now.tv_sec) + now.tv_nsec;
+}
+#endif
+
 #ifdef WINDOWS_COMPILE
 static inline void sleep_impl(tick_t sleep_ticks)
 {
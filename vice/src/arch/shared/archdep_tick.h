@@ -56,6 +56,9 @@ tick_t tick_per_second(void);
 /* Get time in ticks. */
 tick_t tick_now(void);
 
+/* Get time in nanoseconds, for measurements finer than a tick. */
+uint64_t tick_now_nano(void);
+
 /* Get time in ticks, compensating for the +/- 1 tick that is possible on Windows. */
 tick_t tick_now_after(tick_t previous_tick);
 
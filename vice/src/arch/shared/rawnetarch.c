@@ -69,8 +69,9 @@
 #endif
 
 #ifdef UNIX_COMPILE
-/* On Unix, we implement an abstraction layer to support two rawnet drivers:
- * one based on libpcap, and one based on TUN/TAP.
+/* On Unix, we implement an abstraction layer to support several rawnet
+ * drivers: one based on libpcap, one based on TUN/TAP, and a loopback one
+ * which needs no network device at all.
  */
 
 /* Pointer to the rawnet driver in use. */
@@ -112,6 +113,9 @@ static int set_ethernet_driver(const char *name, void *param)
         rawnet_arch_driver = &rawnet_arch_driver_tuntap;
     }
 #endif
+    if (strcmp(name, rawnet_arch_driver_loopback.name) == 0) {
+        rawnet_arch_driver = &rawnet_arch_driver_loopback;
+    }
 
     if (rawnet_arch_driver != NULL) {
         util_string_set(&rawnet_arch_driver_name, rawnet_arch_driver->name);
@@ -400,6 +404,9 @@ static char *rawnetdrivernames[] = {
 #endif
 #ifdef HAVE_PCAP
     "pcap",
+#endif
+#ifdef UNIX_COMPILE
+    "loopback",
 #endif
     NULL
 };
@@ -411,6 +418,9 @@ static char *rawnetdriverdescs[] = {
 #endif
 #ifdef HAVE_PCAP
     "PCAP",
+#endif
+#ifdef UNIX_COMPILE
+    "loopback",
 #endif
     NULL
 };
@@ -418,18 +428,6 @@ static char *rawnetdriverdescs[] = {
 int rawnet_arch_enumdriver_open(void)
 {
     rawnetdriverindex = 0;
-    /* HACK! remove pcap from the list when its not available */
-#ifdef HAVE_PCAP
-    if (!archdep_rawnet_capability()) {
-#ifdef HAVE_TUNTAP
-        rawnetdrivernames[2] = NULL;
-        rawnetdriverdescs[2] = NULL;
-#else
-        rawnetdrivernames[1] = NULL;
-        rawnetdriverdescs[1] = NULL;
-#endif
-    }
-#endif
     return 1;
 }
 
@@ -439,6 +437,14 @@ int rawnet_arch_enumdriver(char **ppname, char **ppdescription)
     if (rawnetdriverindex >= 0) {
         name = rawnetdrivernames[rawnetdriverindex];
         desc = rawnetdriverdescs[rawnetdriverindex];
+#ifdef HAVE_PCAP
+        /* leave out pcap when its not available */
+        if (name != NULL && strcmp(name, "pcap") == 0 && !archdep_rawnet_capability()) {
+            rawnetdriverindex++;
+            name = rawnetdrivernames[rawnetdriverindex];
+            desc = rawnetdriverdescs[rawnetdriverindex];
+        }
+#endif
         if ((name == NULL) || (desc == NULL)) {
             rawnetdriverindex = -1;
             return 0;
@@ -0,0 +1,304 @@
+/** \file   rawnetarch_loopback.c
+ * \brief   Raw ethernet driver without a network device
+ *
+ * Frames transmitted by the emulation are received again. If the interface
+ * name is a capture file in pcap format instead of "loopback", the frames of
+ * the capture are received first, so the receive path can be tested and
+ * timed with recorded traffic.
+ */
+
+/*
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#include <stdint.h>
+
+#include "vice.h"
+
+#ifdef HAVE_RAWNET
+
+#include <stdio.h>
+#include <string.h>
+
+#include "lib.h"
+#include "log.h"
+#include "rawnetarch.h"
+
+#define LOOPBACK_NAME       "loopback"
+
+/* frames waiting to be received again */
+#define LOOPBACK_FRAMES     16
+#define LOOPBACK_FRAME_MAX  1536
+
+#define PCAP_MAGIC          0xa1b2c3d4
+#define PCAP_MAGIC_NS       0xa1b23c4d
+#define PCAP_LINKTYPE_ETHERNET  1
+
+typedef struct loopback_frame_s {
+    int len;
+    uint8_t data[LOOPBACK_FRAME_MAX];
+} loopback_frame_t;
+
+static loopback_frame_t *loop_frames = NULL;
+static unsigned int loop_head = 0;
+static unsigned int loop_count = 0;
+
+/* capture being replayed, and whether its byte order is the other one */
+static FILE *capture_file = NULL;
+static int capture_swapped = 0;
+
+static int enum_done = 0;
+
+static uint32_t capture_word(const uint8_t *p)
+{
+    if (capture_swapped) {
+        return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+    }
+    return ((uint32_t)p[3] << 24) | ((uint32_t)p[2] << 16) | ((uint32_t)p[1] << 8) | p[0];
+}
+
+static void capture_close(void)
+{
+    if (capture_file != NULL) {
+        fclose(capture_file);
+        capture_file = NULL;
+    }
+}
+
+static int capture_open(const char *filename)
+{
+    uint8_t header[24];
+    uint32_t magic;
+
+    capture_file = fopen(filename, "rb");
+    if (capture_file == NULL) {
+        log_message(rawnet_arch_log, "ERROR opening capture file '%s'.", filename);
+        return 0;
+    }
+    if (fread(header, 1, sizeof(header), capture_file) != sizeof(header)) {
+        log_message(rawnet_arch_log, "ERROR: capture file '%s' is too short.", filename);
+        capture_close();
+        return 0;
+    }
+    capture_swapped = 0;
+    magic = capture_word(header);
+    if (magic != PCAP_MAGIC && magic != PCAP_MAGIC_NS) {
+        capture_swapped = 1;
+        magic = capture_word(header);
+    }
+    if (magic != PCAP_MAGIC && magic != PCAP_MAGIC_NS) {
+        log_message(rawnet_arch_log, "ERROR: '%s' is not a pcap capture file.", filename);
+        capture_close();
+        return 0;
+    }
+    if (capture_word(header + 20) != PCAP_LINKTYPE_ETHERNET) {
+        log_message(rawnet_arch_log, "ERROR: capture file '%s' does not contain ethernet frames.", filename);
+        capture_close();
+        return 0;
+    }
+    return 1;
+}
+
+/* Read the next frame of the capture, returns its length or -1 at the end. */
+static int capture_read(uint8_t *buffer, int size)
+{
+    uint8_t header[16];
+    uint32_t len;
+
+    if (fread(header, 1, sizeof(header), capture_file) != sizeof(header)) {
+        return -1;
+    }
+    len = capture_word(header + 8);
+    if (len > 0x40000) {
+        /* broken record, there is no way to resynchronize */
+        return -1;
+    }
+    if (fread(buffer, 1, len < (uint32_t)size ? len : (uint32_t)size, capture_file)
+            != (len < (uint32_t)size ? len : (uint32_t)size)) {
+        return -1;
+    }
+    if (len > (uint32_t)size && fseek(capture_file, (long)(len - size), SEEK_CUR) != 0) {
+        return -1;
+    }
+    return (int)len;
+}
+
+/* ------------------------------------------------------------------------- */
+/*    the architecture-dependend functions                                   */
+
+static void rawnet_arch_loopback_pre_reset(void)
+{
+}
+
+static void rawnet_arch_loopback_post_reset(void)
+{
+}
+
+static int rawnet_arch_loopback_activate(const char *interface_name)
+{
+    if (interface_name != NULL && *interface_name && strcmp(interface_name, LOOPBACK_NAME) != 0) {
+        if (!capture_open(interface_name)) {
+            return 0;
+        }
+    }
+    loop_frames = lib_malloc(LOOPBACK_FRAMES * sizeof(loopback_frame_t));
+    loop_head = 0;
+    loop_count = 0;
+    return 1;
+}
+
+static void rawnet_arch_loopback_deactivate(void)
+{
+    capture_close();
+    lib_free(loop_frames);
+    loop_frames = NULL;
+}
+
+static void rawnet_arch_loopback_set_mac(const uint8_t mac[6])
+{
+}
+
+static void rawnet_arch_loopback_set_hashfilter(const uint32_t hash_mask[2])
+{
+}
+
+static void rawnet_arch_loopback_recv_ctl(int bBroadcast, int bIA, int bMulticast, int bCorrect, int bPromiscuous, int bIAHash)
+{
+}
+
+static void rawnet_arch_loopback_line_ctl(int bEnableTransmitter, int bEnableReceiver)
+{
+}
+
+static void rawnet_arch_loopback_transmit(int force, int onecoll, int inhibit_crc,
+                                          int tx_pad_dis, int txlength, uint8_t *txframe)
+{
+    loopback_frame_t *frame;
+
+    if (loop_frames == NULL || loop_count == LOOPBACK_FRAMES) {
+        /* nobody is listening fast enough, like on a real network */
+        return;
+    }
+    frame = &loop_frames[(loop_head + loop_count) % LOOPBACK_FRAMES];
+    if (txlength > LOOPBACK_FRAME_MAX) {
+        txlength = LOOPBACK_FRAME_MAX;
+    }
+    memcpy(frame->data, txframe, txlength);
+    frame->len = txlength;
+    loop_count++;
+}
+
+static int rawnet_arch_loopback_receive(uint8_t *pbuffer, int *plen, int  *phashed,
+        int *phash_index, int *prx_ok, int *pcorrect_mac, int *pbroadcast,
+        int *pcrc_error)
+{
+    int len = -1;
+
+    if (capture_file != NULL) {
+        len = capture_read(pbuffer, *plen);
+        if (len < 0) {
+            capture_close();
+        }
+    }
+    if (len < 0 && loop_count > 0) {
+        loopback_frame_t *frame = &loop_frames[loop_head];
+
+        len = frame->len;
+        memcpy(pbuffer, frame->data, len < *plen ? len : *plen);
+        loop_head = (loop_head + 1) % LOOPBACK_FRAMES;
+        loop_count--;
+    }
+    if (len < 0) {
+        return 0;
+    }
+
+#ifdef RAWNET_DEBUG_PKTDUMP
+    rawnet_arch_debug_output("Received frame: ", pbuffer, len < *plen ? len : *plen);
+#endif /* #ifdef RAWNET_DEBUG_PKTDUMP */
+
+    if (len & 1) {
+        /* This is needed by cs8900.c */
+        ++len;
+    }
+    *plen = len;
+
+    /* let the emulated chip decide whether it wants the frame */
+    *phashed = 0;
+    *phash_index = 0;
+    *pbroadcast = 0;
+    *pcorrect_mac = 0;
+    *pcrc_error = 0;
+    *prx_ok = 1;
+
+    return 1;
+}
+
+static int rawnet_arch_loopback_enumadapter_open(void)
+{
+    enum_done = 0;
+    return 1;
+}
+
+static int rawnet_arch_loopback_enumadapter(char **ppname, char **ppdescription)
+{
+    if (enum_done) {
+        return 0;
+    }
+    *ppname = lib_strdup(LOOPBACK_NAME);
+    *ppdescription = lib_strdup("Frames sent are received again");
+    enum_done = 1;
+    return 1;
+}
+
+static int rawnet_arch_loopback_enumadapter_close(void)
+{
+    return 1;
+}
+
+static char *rawnet_arch_loopback_get_standard_interface(void)
+{
+    return lib_strdup(LOOPBACK_NAME);
+}
+
+rawnet_arch_driver_t rawnet_arch_driver_loopback = {
+    "loopback",
+    rawnet_arch_loopback_pre_reset,
+    rawnet_arch_loopback_post_reset,
+    rawnet_arch_loopback_activate,
+    rawnet_arch_loopback_deactivate,
+    rawnet_arch_loopback_set_mac,
+    rawnet_arch_loopback_set_hashfilter,
+
+    rawnet_arch_loopback_recv_ctl,
+
+    rawnet_arch_loopback_line_ctl,
+
+    rawnet_arch_loopback_transmit,
+
+    rawnet_arch_loopback_receive,
+
+    rawnet_arch_loopback_enumadapter_open,
+    rawnet_arch_loopback_enumadapter,
+    rawnet_arch_loopback_enumadapter_close,
+
+    rawnet_arch_loopback_get_standard_interface
+};
+
+#endif /* #ifdef HAVE_RAWNET */
@@ -950,6 +950,12 @@ uint8_t mem_dma_read(uint16_t addr)
     return retval;
 }
 
+/* the RAM stores keep vicii.last_cpu_val and the cartridge RAM up to date */
+uint8_t *mem_dma_write_base(uint16_t addr)
+{
+    return NULL;
+}
+
 
 /* ------------------------------------------------------------------------- */
 
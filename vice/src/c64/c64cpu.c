@@ -131,6 +131,18 @@ static uint8_t memmap_mem_read_dummy(unsigned int addr)
 }
 #endif
 
+#ifndef FEATURE_CPUMEMHISTORY
+/* Data loads from the memory area the CPU is executing from, RAM or a
+   cartridge ROM bank for example, read it through the pointer the opcode
+   fetches use (see mem_mmu_translate()) instead of calling the read hook.
+   With watchpoints the hooks have to see every load. */
+#define LOAD(addr)                                                          \
+    ((((int)(addr)) >= bank_start && ((int)(addr)) < bank_limit             \
+      && !(monitor_mask[e_comp_space] & MI_WATCH))                          \
+     ? bank_base[(addr)]                                                    \
+     : (*_mem_read_tab_ptr[(addr) >> 8])((uint16_t)(addr)))
+#endif
+
 static void check_and_run_alternate_cpu(void)
 {
     cpmcart_check_and_run_z80();
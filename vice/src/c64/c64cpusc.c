@@ -29,6 +29,7 @@
 #include <stdio.h>
 
 #include "cpmcart.h"
+#include "instrument.h"
 #include "monitor.h"
 #include "vicii-cycle.h"
 
@@ -44,11 +45,27 @@ CLOCK maincpu_clk_limit = 0L;
 /* Mask: BA low */
 int maincpu_ba_low_flags = 0;
 
+/* The VIC-II cycle, measured as the video scope when instrumenting. */
+static inline int instrumented_vicii_cycle(void)
+{
+    int ba_low;
+
+    if (!instrument_enabled) {
+        return vicii_cycle();
+    }
+
+    instrument_enter(INSTRUMENT_VIDEO);
+    ba_low = vicii_cycle();
+    instrument_leave();
+
+    return ba_low;
+}
+
 #define CLK_INC()                                  \
     interrupt_delay();                             \
     maincpu_clk++;                                 \
     maincpu_ba_low_flags &= ~MAINCPU_BA_LOW_VICII; \
-    maincpu_ba_low_flags |= vicii_cycle()
+    maincpu_ba_low_flags |= instrumented_vicii_cycle()
 
 
 /* Skip cycle implementation */
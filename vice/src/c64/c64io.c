@@ -66,17 +66,17 @@ static unsigned int order = 0;
 
 /* ---------------------------------------------------------------------------------------------------------- */
 
-static io_source_list_t c64io_d000_head = { NULL, NULL, NULL };
-static io_source_list_t c64io_d100_head = { NULL, NULL, NULL };
-static io_source_list_t c64io_d200_head = { NULL, NULL, NULL };
-static io_source_list_t c64io_d300_head = { NULL, NULL, NULL };
-static io_source_list_t c64io_d400_head = { NULL, NULL, NULL };
-static io_source_list_t c64io_d500_head = { NULL, NULL, NULL };
-static io_source_list_t c64io_d600_head = { NULL, NULL, NULL };
-static io_source_list_t c64io_d700_head = { NULL, NULL, NULL };
-static io_source_list_t c64io_dd00_head = { NULL, NULL, NULL };
-static io_source_list_t c64io_de00_head = { NULL, NULL, NULL };
-static io_source_list_t c64io_df00_head = { NULL, NULL, NULL };
+static io_source_list_t c64io_d000_head = { NULL, NULL, NULL, NULL };
+static io_source_list_t c64io_d100_head = { NULL, NULL, NULL, NULL };
+static io_source_list_t c64io_d200_head = { NULL, NULL, NULL, NULL };
+static io_source_list_t c64io_d300_head = { NULL, NULL, NULL, NULL };
+static io_source_list_t c64io_d400_head = { NULL, NULL, NULL, NULL };
+static io_source_list_t c64io_d500_head = { NULL, NULL, NULL, NULL };
+static io_source_list_t c64io_d600_head = { NULL, NULL, NULL, NULL };
+static io_source_list_t c64io_d700_head = { NULL, NULL, NULL, NULL };
+static io_source_list_t c64io_dd00_head = { NULL, NULL, NULL, NULL };
+static io_source_list_t c64io_de00_head = { NULL, NULL, NULL, NULL };
+static io_source_list_t c64io_df00_head = { NULL, NULL, NULL, NULL };
 
 static void io_source_detach(io_source_detach_t *source)
 {
@@ -304,6 +304,12 @@ static inline uint8_t io_read(io_source_list_t *list, uint16_t addr)
 
     vicii_handle_pending_alarms_external(0);
 
+    /* a single device which is a window into its memory */
+    if (current != NULL && current->next == NULL && current->page != NULL
+        && addr >= current->device->start_address && addr <= current->device->end_address) {
+        return current->page[addr & current->device->address_mask];
+    }
+
     while (current) {
         if (current->device->read != NULL) {
             if ((addr >= current->device->start_address) && (addr <= current->device->end_address)) {
@@ -399,6 +405,12 @@ static inline void io_store(io_source_list_t *list, uint16_t addr, uint8_t value
 
     vicii_handle_pending_alarms_external_write();
 
+    if (current != NULL && current->next == NULL && current->page != NULL
+        && addr >= current->device->start_address && addr <= current->device->end_address) {
+        current->page[addr & current->device->address_mask] = value;
+        return;
+    }
+
     while (current) {
         if (current->device->store != NULL) {
             if (addr >= current->device->start_address && addr <= current->device->end_address) {
@@ -480,6 +492,7 @@ io_source_list_t *io_source_register(io_source_t *device)
     retval->previous = current;
     retval->device = device;
     retval->next = NULL;
+    retval->page = NULL;
     retval->device->order = order++;
 
     return retval;
@@ -508,6 +521,14 @@ void io_source_unregister(io_source_list_t *device)
     lib_free(device);
 }
 
+void io_source_set_page(io_source_list_t *device, uint8_t *page)
+{
+    assert(device != NULL);
+    assert(page == NULL || device->device->io_source_prio != IO_PRIO_LOW);
+
+    device->page = page;
+}
+
 void cartio_shutdown(void)
 {
     io_source_list_t *current;
@@ -569,6 +569,16 @@ uint8_t mem_dma_read(uint16_t addr)
     return _mem_read_tab_ptr[addr >> 8](addr);
 }
 
+/* only the plain RAM pages, the pages the VIC-II fetches from and the
+   memory hacks go through their store functions */
+uint8_t *mem_dma_write_base(uint16_t addr)
+{
+    if ((addr & 0xff00) != 0 && _mem_write_tab_ptr[addr >> 8] == ram_store) {
+        return mem_ram;
+    }
+    return NULL;
+}
+
 /* ------------------------------------------------------------------------- */
 
 /* Generic memory access.  */
@@ -561,6 +561,12 @@ uint8_t mem_dma_read(uint16_t addr)
     return _mem_read_tab_ptr[addr >> 8](addr);
 }
 
+/* the VIC-II is clocked for every DMA cycle, so there are no spans */
+uint8_t *mem_dma_write_base(uint16_t addr)
+{
+    return NULL;
+}
+
 
 /* ------------------------------------------------------------------------- */
 
@@ -38,6 +38,7 @@
 #define CARTRIDGE_INCLUDE_SLOTMAIN_API
 #include "c64cartsystem.h"
 #undef CARTRIDGE_INCLUDE_SLOTMAIN_API
+#include "c64cartmem.h"
 #include "c64mem.h"
 #include "cartio.h"
 #include "cartridge.h"
@@ -720,43 +721,549 @@ int cart_is_slotmain(int type)
     }
 }
 
-int cart_getid_slot0(void)
+/*
+    The hooks of the cartridges are resolved from the "Slot 0", "Slot 1" and
+    "IO Slot" cartridges on the list of expansion port devices and the type
+    of the "Main Slot" cartridge, so that bank switches, resets, freezes and
+    snapshots only visit the cartridges which are attached instead of testing
+    every supported one. Cartridges attach themselves through export_add()/
+    export_remove(), so the table is resolved again when the list of devices
+    or the main slot type changes. The list itself is used rather than the
+    *_cart_enabled() flags, as several cartridges only set those after they
+    registered.
+*/
+typedef void (*cart_hook_t)(void);
+typedef int (*cart_mmu_translate_slot0_t)(unsigned int addr, uint8_t **base, int *start, int *limit);
+typedef void (*cart_mmu_translate_t)(unsigned int addr, uint8_t **base, int *start, int *limit);
+typedef void (*cart_passthrough_changed_t)(export_t *export);
+
+#define CART_HOOKS_MAX_SLOT1    4
+#define CART_HOOKS_MAX_LIST     12
+#define CART_HOOKS_MAX_ATTACHED 16
+
+typedef struct cart_hook_slot1_s {
+    int type;
+    int (*active)(void);    /* NULL if the cartridge always takes part */
+    cart_mmu_translate_t mmu_translate;
+} cart_hook_slot1_t;
+
+typedef struct cart_hook_freeze_s {
+    int (*allowed)(void);
+    cart_hook_t freeze;
+} cart_hook_freeze_t;
+
+typedef struct cart_hook_list_s {
+    int num;
+    cart_hook_t hook[CART_HOOKS_MAX_LIST];
+} cart_hook_list_t;
+
+static struct {
+    int valid;
+    int cartridge_type;
+    unsigned int export_generation;
+
+    /* IDs of the attached cartridges in the order they registered, as
+       saved in snapshots */
+    int num_attached;
+    int attached[CART_HOOKS_MAX_ATTACHED];
+
+    int slot0_type;
+    cart_mmu_translate_slot0_t slot0_mmu_translate;
+    cart_passthrough_changed_t slot0_passthrough_changed;
+
+    /* in the order they take precedence */
+    int num_slot1;
+    cart_hook_slot1_t slot1[CART_HOOKS_MAX_SLOT1];
+    int num_slot1_freeze;
+    cart_hook_freeze_t slot1_freeze[CART_HOOKS_MAX_SLOT1];
+
+    /* in the order they are called, "back to front" */
+    cart_hook_list_t io_reset;
+    cart_hook_list_t slot1_reset;
+    cart_hook_list_t slot0_reset;
+    cart_hook_list_t io_powerup;
+    cart_hook_list_t slot1_powerup;
+
+    cart_mmu_translate_t slotmain_mmu_translate;
+    cart_hook_t slotmain_reset;
+    cart_hook_t slotmain_powerup;
+    cart_hook_t slotmain_freeze;
+    int (*slotmain_freeze_allowed)(void);
+} cart_hooks;
+
+static void cart_mmu_translate_none(unsigned int addr, uint8_t **base, int *start, int *limit)
+{
+    *base = NULL;
+    *start = 0;
+    *limit = 0;
+}
+
+/* these report whether they mapped anything, which the main slot ignores */
+static void cart_ltkernal_mmu_translate(unsigned int addr, uint8_t **base, int *start, int *limit)
+{
+    ltkernal_mmu_translate(addr, base, start, limit);
+}
+
+#ifdef HAVE_RAWNET
+static void cart_rrnetmk3_mmu_translate(unsigned int addr, uint8_t **base, int *start, int *limit)
+{
+    rrnetmk3_mmu_translate(addr, base, start, limit);
+}
+#endif
+
+static int cart_freeze_allowed_always(void)
+{
+    return 1;
+}
+
+static int cart_hooks_attached(int type)
 {
-    if (mmc64_cart_enabled()) {
-        return CARTRIDGE_MMC64;
+    export_list_t *e = export_query_list(NULL);
+
+    while (e != NULL) {
+        if ((int)e->device->cartid == type) {
+            return 1;
+        }
+        e = e->next;
     }
-    if (magicvoice_cart_enabled()) {
-        return CARTRIDGE_MAGIC_VOICE;
+    return 0;
+}
+
+static void cart_hooks_add(cart_hook_list_t *list, int type, cart_hook_t hook)
+{
+    if (cart_hooks_attached(type)) {
+        list->hook[list->num++] = hook;
     }
-    if (tpi_cart_enabled()) {
-        return CARTRIDGE_IEEE488;
+}
+
+static void cart_hooks_add_slot1(int type, int (*active)(void), cart_mmu_translate_t mmu_translate)
+{
+    cart_hook_slot1_t *hook;
+
+    if (cart_hooks_attached(type)) {
+        hook = &cart_hooks.slot1[cart_hooks.num_slot1++];
+        hook->type = type;
+        hook->active = active;
+        hook->mmu_translate = mmu_translate;
     }
-    if (ieeeflash64_cart_enabled()) {
-        return CARTRIDGE_IEEEFLASH64;
+}
+
+static void cart_hooks_add_slot1_freeze(int type, int (*allowed)(void), cart_hook_t freeze)
+{
+    cart_hook_freeze_t *hook;
+
+    if (cart_hooks_attached(type)) {
+        hook = &cart_hooks.slot1_freeze[cart_hooks.num_slot1_freeze++];
+        hook->allowed = allowed;
+        hook->freeze = freeze;
     }
-    if (ramlink_cart_enabled()) {
-        return CARTRIDGE_RAMLINK;
+}
+
+static int cart_hooks_set_slot0(int type, cart_mmu_translate_slot0_t mmu_translate,
+                                cart_passthrough_changed_t passthrough_changed)
+{
+    if (cart_hooks_attached(type)) {
+        cart_hooks.slot0_type = type;
+        cart_hooks.slot0_mmu_translate = mmu_translate;
+        cart_hooks.slot0_passthrough_changed = passthrough_changed;
+        return 1;
     }
-    return CARTRIDGE_NONE;
+    return 0;
 }
 
-int cart_getid_slot1(void)
+static cart_mmu_translate_t cart_mmu_translate_slotmain_handler(void)
 {
-    if (isepic_cart_active()) {
-        return CARTRIDGE_ISEPIC;
+    switch (mem_cartridge_type) {
+        case CARTRIDGE_ACTION_REPLAY4:
+        case CARTRIDGE_FINAL_III:
+        case CARTRIDGE_GENERIC_16KB:
+        case CARTRIDGE_GENERIC_8KB:
+        case CARTRIDGE_KCS_POWER:
+        case CARTRIDGE_SIMONS_BASIC:
+        case CARTRIDGE_ULTIMAX:
+            return generic_mmu_translate;
+        case CARTRIDGE_ATOMIC_POWER:
+            return atomicpower_mmu_translate;
+        case CARTRIDGE_EASYFLASH:
+            return easyflash_mmu_translate;
+        case CARTRIDGE_GMOD2:
+            return gmod2_mmu_translate;
+        case CARTRIDGE_GMOD3:
+            return gmod3_mmu_translate;
+        case CARTRIDGE_IDE64:
+            return ide64_mmu_translate;
+        case CARTRIDGE_LT_KERNAL:
+            return cart_ltkernal_mmu_translate;
+        case CARTRIDGE_MEGABYTER:
+            return megabyter_mmu_translate;
+        case CARTRIDGE_OCEAN:
+            return ocean_mmu_translate;
+        case CARTRIDGE_RETRO_REPLAY:
+            return retroreplay_mmu_translate;
+#ifdef HAVE_RAWNET
+        case CARTRIDGE_RRNETMK3:
+            return cart_rrnetmk3_mmu_translate;
+#endif
+        case CARTRIDGE_SUPER_SNAPSHOT_V5:
+            return supersnapshot_v5_mmu_translate;
+        case CARTRIDGE_EPYX_FASTLOAD: /* must go through roml_read to discharge capacitor */
+        case CARTRIDGE_ZIPPCODE48: /* must go through roml_read to discharge capacitor */
+            return cart_mmu_translate_none;
+        default:
+            /* banked ROM read by the generic handlers (magic desk, ocean 8k,
+               ...), or no mapping */
+            return cart_generic_mmu_translate_slotmain;
     }
-    if (expert_cart_enabled()) {
-        return CARTRIDGE_EXPERT;
+}
+
+static cart_hook_t cart_reset_slotmain_handler(void)
+{
+    switch (mem_cartridge_type) {
+        case CARTRIDGE_ACTION_REPLAY:
+            return actionreplay_reset;
+        case CARTRIDGE_ACTION_REPLAY2:
+            return actionreplay2_reset;
+        case CARTRIDGE_ACTION_REPLAY3:
+            return actionreplay3_reset;
+        case CARTRIDGE_ACTION_REPLAY4:
+            return actionreplay4_reset;
+        case CARTRIDGE_ATOMIC_POWER:
+            return atomicpower_reset;
+        case CARTRIDGE_BMPDATATURBO:
+            return bmpdataturbo_reset;
+        case CARTRIDGE_CAPTURE:
+            return capture_reset;
+        case CARTRIDGE_EPYX_FASTLOAD:
+            return epyxfastload_reset;
+        case CARTRIDGE_FORMEL64:
+            return formel64_reset;
+        case CARTRIDGE_FREEZE_FRAME_MK2:
+            return freezeframe2_reset;
+        case CARTRIDGE_FREEZE_MACHINE:
+            return freezemachine_reset;
+        case CARTRIDGE_GMOD2:
+            return gmod2_reset;
+        case CARTRIDGE_GMOD3:
+            return gmod3_reset;
+        case CARTRIDGE_HYPERBASIC:
+            return hyperbasic_reset;
+        case CARTRIDGE_IDE64:
+            return ide64_reset;
+        case CARTRIDGE_MAGIC_FORMEL:
+            return magicformel_reset;
+        case CARTRIDGE_MMC_REPLAY:
+            return mmcreplay_reset;
+        case CARTRIDGE_PARTNER64:
+            return partner64_reset;
+        case CARTRIDGE_PROFIDOS:
+            return profidos_reset;
+        case CARTRIDGE_REX_RAMFLOPPY:
+            return rexramfloppy_reset;
+        case CARTRIDGE_UC1:
+            return uc1_reset;
+        case CARTRIDGE_UC15:
+        case CARTRIDGE_UC2:
+            return uc2_reset;
+#ifdef HAVE_RAWNET
+        case CARTRIDGE_RRNETMK3:
+            return rrnetmk3_reset;
+#endif
+        case CARTRIDGE_RGCD:
+            return rgcd_reset;
+        case CARTRIDGE_RETRO_REPLAY:
+            return retroreplay_reset;
+        case CARTRIDGE_SUPER_EXPLODE_V5:
+            return se5_reset;
+        case CARTRIDGE_WARPSPEED:
+            return warpspeed_reset;
+        case CARTRIDGE_ZIPPCODE48:
+            return zippcode48_reset;
+        default:
+            return NULL;
     }
-    if (ramcart_cart_enabled()) {
-        return CARTRIDGE_RAMCART;
+}
+
+static cart_hook_t cart_powerup_slotmain_handler(void)
+{
+    switch (mem_cartridge_type) {
+        case CARTRIDGE_ACTION_REPLAY:
+            return actionreplay_powerup;
+        case CARTRIDGE_ATOMIC_POWER:
+            return atomicpower_powerup;
+        case CARTRIDGE_CAPTURE:
+            return capture_powerup;
+        case CARTRIDGE_EASYFLASH:
+            return easyflash_powerup;
+        case CARTRIDGE_KCS_POWER:
+            return kcs_powerup;
+        case CARTRIDGE_LT_KERNAL:
+            return ltkernal_powerup;
+        case CARTRIDGE_MAGIC_FORMEL:
+            return magicformel_powerup;
+        case CARTRIDGE_MAX_BASIC:
+            return maxbasic_powerup;
+        case CARTRIDGE_MMC_REPLAY:
+            return mmcreplay_powerup;
+        case CARTRIDGE_MULTIMAX:
+            return multimax_powerup;
+        case CARTRIDGE_PAGEFOX:
+            return pagefox_powerup;
+        case CARTRIDGE_PARTNER64:
+            return partner64_powerup;
+        case CARTRIDGE_RETRO_REPLAY:
+            return retroreplay_powerup;
+        case CARTRIDGE_SDBOX:
+            return sdbox_powerup;
+        case CARTRIDGE_SUPER_SNAPSHOT:
+            return supersnapshot_v4_powerup;
+        case CARTRIDGE_SUPER_SNAPSHOT_V5:
+            return supersnapshot_v5_powerup;
+        case CARTRIDGE_UC1:
+            return uc1_powerup;
+        case CARTRIDGE_UC2:
+        case CARTRIDGE_UC15:
+            return uc2_powerup;
+        default:
+            return NULL;
     }
-    if (dqbb_cart_enabled()) {
-        return CARTRIDGE_DQBB;
+}
+
+static cart_hook_t cart_freeze_slotmain_handler(void)
+{
+    switch (mem_cartridge_type) {
+        case CARTRIDGE_ACTION_REPLAY:
+            return actionreplay_freeze;
+        case CARTRIDGE_ACTION_REPLAY2:
+            return actionreplay2_freeze;
+        case CARTRIDGE_ACTION_REPLAY3:
+            return actionreplay3_freeze;
+        case CARTRIDGE_ACTION_REPLAY4:
+            return actionreplay4_freeze;
+        case CARTRIDGE_ATOMIC_POWER:
+            return atomicpower_freeze;
+        case CARTRIDGE_CAPTURE:
+            return capture_freeze;
+        case CARTRIDGE_DIASHOW_MAKER:
+            return dsm_freeze;
+        case CARTRIDGE_FINAL_I:
+            return final_v1_freeze;
+        case CARTRIDGE_FINAL_III:
+            return final_v3_freeze;
+        case CARTRIDGE_FINAL_PLUS:
+            return final_plus_freeze;
+        case CARTRIDGE_FREEZE_FRAME:
+            return freezeframe_freeze;
+        case CARTRIDGE_FREEZE_FRAME_MK2:
+            return freezeframe2_freeze;
+        case CARTRIDGE_FREEZE_MACHINE:
+            return freezemachine_freeze;
+        case CARTRIDGE_GAME_KILLER:
+            return gamekiller_freeze;
+        case CARTRIDGE_KCS_POWER:
+            return kcs_freeze;
+        case CARTRIDGE_LT_KERNAL:
+            return ltkernal_freeze;
+        case CARTRIDGE_MAGIC_FORMEL:
+            return magicformel_freeze;
+        case CARTRIDGE_MMC_REPLAY:
+            return mmcreplay_freeze;
+        case CARTRIDGE_PARTNER64:
+            return partner64_freeze;
+        case CARTRIDGE_RETRO_REPLAY:
+            return retroreplay_freeze;
+        case CARTRIDGE_SNAPSHOT64:
+            return snapshot64_freeze;
+        case CARTRIDGE_SUPER_SNAPSHOT:
+            return supersnapshot_v4_freeze;
+        case CARTRIDGE_SUPER_SNAPSHOT_V5:
+            return supersnapshot_v5_freeze;
+        default:
+            return NULL;
+    }
+}
+
+static int (*cart_freeze_allowed_slotmain_handler(void))(void)
+{
+    switch (mem_cartridge_type) {
+        case CARTRIDGE_ACTION_REPLAY4:
+        case CARTRIDGE_ACTION_REPLAY3:
+        case CARTRIDGE_ACTION_REPLAY2:
+        case CARTRIDGE_ACTION_REPLAY:
+        case CARTRIDGE_ATOMIC_POWER:
+        case CARTRIDGE_CAPTURE:
+        case CARTRIDGE_DIASHOW_MAKER:
+        case CARTRIDGE_FINAL_I:
+        case CARTRIDGE_FINAL_III:
+        case CARTRIDGE_FINAL_PLUS:
+        case CARTRIDGE_FREEZE_FRAME:
+        case CARTRIDGE_FREEZE_FRAME_MK2:
+        case CARTRIDGE_FREEZE_MACHINE:
+        case CARTRIDGE_GAME_KILLER:
+        case CARTRIDGE_KCS_POWER:
+        case CARTRIDGE_LT_KERNAL:
+        case CARTRIDGE_MAGIC_FORMEL:
+        case CARTRIDGE_PARTNER64:
+        case CARTRIDGE_SNAPSHOT64:
+        case CARTRIDGE_SUPER_SNAPSHOT:
+        case CARTRIDGE_SUPER_SNAPSHOT_V5:
+            return cart_freeze_allowed_always;
+        case CARTRIDGE_MMC_REPLAY:
+            return mmcreplay_freeze_allowed;
+        case CARTRIDGE_RETRO_REPLAY:
+            return retroreplay_freeze_allowed;
+        default:
+            return NULL;
+    }
+}
+
+static void cart_hooks_resolve_attached(void)
+{
+    export_list_t *e = export_query_list(NULL);
+    int last_cart = CARTRIDGE_NONE;
+
+    cart_hooks.num_attached = 0;
+    while (e != NULL) {
+        /* devices with several entries register them one after another */
+        if (last_cart != (int)e->device->cartid) {
+            last_cart = e->device->cartid;
+            if (cart_hooks.num_attached < CART_HOOKS_MAX_ATTACHED) {
+                cart_hooks.attached[cart_hooks.num_attached] = last_cart;
+            }
+            /* counts past the maximum, so the snapshot can refuse to save */
+            cart_hooks.num_attached++;
+        }
+        e = e->next;
+    }
+}
+
+static void cart_hooks_resolve(void)
+{
+    cart_hooks.valid = 1;
+    cart_hooks.cartridge_type = mem_cartridge_type;
+    cart_hooks.export_generation = export_generation;
+
+    cart_hooks_resolve_attached();
+
+    /* "Slot 0", only the first attached cartridge is used */
+    cart_hooks.slot0_type = CARTRIDGE_NONE;
+    cart_hooks.slot0_mmu_translate = NULL;
+    cart_hooks.slot0_passthrough_changed = NULL;
+    if (!cart_hooks_set_slot0(CARTRIDGE_MMC64, mmc64_mmu_translate, mmc64_passthrough_changed)
+        && !cart_hooks_set_slot0(CARTRIDGE_MAGIC_VOICE, magicvoice_mmu_translate, magicvoice_passthrough_changed)
+        && !cart_hooks_set_slot0(CARTRIDGE_IEEE488, tpi_mmu_translate, tpi_passthrough_changed)
+        && !cart_hooks_set_slot0(CARTRIDGE_IEEEFLASH64, ieeeflash64_mmu_translate, ieeeflash64_passthrough_changed)) {
+        cart_hooks_set_slot0(CARTRIDGE_RAMLINK, ramlink_mmu_translate, ramlink_passthrough_changed);
+    }
+
+    /* "Slot 1", the ISEPIC only takes part while its switch is on */
+    cart_hooks.num_slot1 = 0;
+    cart_hooks_add_slot1(CARTRIDGE_ISEPIC, isepic_cart_active, isepic_mmu_translate);
+    cart_hooks_add_slot1(CARTRIDGE_EXPERT, NULL, expert_mmu_translate);
+    cart_hooks_add_slot1(CARTRIDGE_RAMCART, NULL, ramcart_mmu_translate);
+    cart_hooks_add_slot1(CARTRIDGE_DQBB, NULL, dqbb_mmu_translate);
+
+    cart_hooks.num_slot1_freeze = 0;
+    cart_hooks_add_slot1_freeze(CARTRIDGE_EXPERT, expert_freeze_allowed, expert_freeze);
+    cart_hooks_add_slot1_freeze(CARTRIDGE_ISEPIC, isepic_freeze_allowed, isepic_freeze);
+
+    /* reset and powerup */
+    cart_hooks.io_reset.num = 0;
+    cart_hooks_add(&cart_hooks.io_reset, CARTRIDGE_DIGIMAX, digimax_reset);
+    cart_hooks_add(&cart_hooks.io_reset, CARTRIDGE_DS12C887RTC, ds12c887rtc_reset);
+    cart_hooks_add(&cart_hooks.io_reset, CARTRIDGE_GEORAM, georam_reset);
+#ifdef HAVE_MIDI
+    cart_hooks_add(&cart_hooks.io_reset, CARTRIDGE_MIDI_PASSPORT, midi_reset);
+    cart_hooks_add(&cart_hooks.io_reset, CARTRIDGE_MIDI_DATEL, midi_reset);
+    cart_hooks_add(&cart_hooks.io_reset, CARTRIDGE_MIDI_SEQUENTIAL, midi_reset);
+    cart_hooks_add(&cart_hooks.io_reset, CARTRIDGE_MIDI_NAMESOFT, midi_reset);
+    cart_hooks_add(&cart_hooks.io_reset, CARTRIDGE_MIDI_MAPLIN, midi_reset);
+#endif
+    cart_hooks_add(&cart_hooks.io_reset, CARTRIDGE_REU, reu_reset);
+    cart_hooks_add(&cart_hooks.io_reset, CARTRIDGE_SFX_SOUND_EXPANDER, sfx_soundexpander_reset);
+    cart_hooks_add(&cart_hooks.io_reset, CARTRIDGE_SFX_SOUND_SAMPLER, sfx_soundsampler_reset);
+#ifdef HAVE_RAWNET
+    cart_hooks_add(&cart_hooks.io_reset, CARTRIDGE_TFE, ethernetcart_reset);
+#endif
+#if defined(HAVE_RS232DEV) || defined(HAVE_RS232NET)
+    cart_hooks_add(&cart_hooks.io_reset, CARTRIDGE_TURBO232, aciacart_reset);
+#endif
+
+    cart_hooks.slot1_reset.num = 0;
+    cart_hooks_add(&cart_hooks.slot1_reset, CARTRIDGE_DQBB, dqbb_reset);
+    cart_hooks_add(&cart_hooks.slot1_reset, CARTRIDGE_EXPERT, expert_reset);
+    cart_hooks_add(&cart_hooks.slot1_reset, CARTRIDGE_RAMCART, ramcart_reset);
+    cart_hooks_add(&cart_hooks.slot1_reset, CARTRIDGE_ISEPIC, isepic_reset);
+
+    cart_hooks.slot0_reset.num = 0;
+    cart_hooks_add(&cart_hooks.slot0_reset, CARTRIDGE_IEEE488, tpi_reset);
+    cart_hooks_add(&cart_hooks.slot0_reset, CARTRIDGE_MAGIC_VOICE, magicvoice_reset);
+    cart_hooks_add(&cart_hooks.slot0_reset, CARTRIDGE_MMC64, mmc64_reset);
+    cart_hooks_add(&cart_hooks.slot0_reset, CARTRIDGE_IEEEFLASH64, ieeeflash64_reset);
+    cart_hooks_add(&cart_hooks.slot0_reset, CARTRIDGE_CPM, cpmcart_reset);
+
+    cart_hooks.io_powerup.num = 0;
+    cart_hooks_add(&cart_hooks.io_powerup, CARTRIDGE_GEORAM, georam_powerup);
+    cart_hooks_add(&cart_hooks.io_powerup, CARTRIDGE_REU, reu_powerup);
+
+    cart_hooks.slot1_powerup.num = 0;
+    cart_hooks_add(&cart_hooks.slot1_powerup, CARTRIDGE_DQBB, dqbb_powerup);
+    cart_hooks_add(&cart_hooks.slot1_powerup, CARTRIDGE_EXPERT, expert_powerup);
+    cart_hooks_add(&cart_hooks.slot1_powerup, CARTRIDGE_ISEPIC, isepic_powerup);
+
+    /* "Main Slot" */
+    cart_hooks.slotmain_mmu_translate = cart_mmu_translate_slotmain_handler();
+    cart_hooks.slotmain_reset = cart_reset_slotmain_handler();
+    cart_hooks.slotmain_powerup = cart_powerup_slotmain_handler();
+    cart_hooks.slotmain_freeze = cart_freeze_slotmain_handler();
+    cart_hooks.slotmain_freeze_allowed = cart_freeze_allowed_slotmain_handler();
+}
+
+inline static void cart_hooks_update(void)
+{
+    if (!cart_hooks.valid
+        || cart_hooks.cartridge_type != mem_cartridge_type
+        || cart_hooks.export_generation != export_generation) {
+        cart_hooks_resolve();
+    }
+}
+
+static void cart_hooks_call(const cart_hook_list_t *list)
+{
+    int i;
+
+    for (i = 0; i < list->num; i++) {
+        list->hook[i]();
+    }
+}
+
+int cart_getid_slot0(void)
+{
+    cart_hooks_update();
+    return cart_hooks.slot0_type;
+}
+
+int cart_getid_slot1(void)
+{
+    int i;
+
+    cart_hooks_update();
+    for (i = 0; i < cart_hooks.num_slot1; i++) {
+        if (cart_hooks.slot1[i].active == NULL || cart_hooks.slot1[i].active()) {
+            return cart_hooks.slot1[i].type;
+        }
     }
     return CARTRIDGE_NONE;
 }
 
+/* called by c64cartmem.c:cart_passthrough_changed */
+void cart_passthrough_changed_slot0(export_t *passthrough)
+{
+    cart_hooks_update();
+    if (cart_hooks.slot0_passthrough_changed != NULL) {
+        cart_hooks.slot0_passthrough_changed(passthrough);
+    }
+}
+
 /* ------------------------------------------------------------------------- */
 
 /*
@@ -2393,162 +2900,21 @@ void cartridge_reset(void)
 
     cart_reset_memptr();
 
+    cart_hooks_update();
+
     /* "IO Slot" */
-    if (digimax_cart_enabled()) {
-        digimax_reset();
-    }
-    if (ds12c887rtc_cart_enabled()) {
-        ds12c887rtc_reset();
-    }
-    if (georam_cart_enabled()) {
-        georam_reset();
-    }
-#ifdef HAVE_MIDI
-    if (c64_midi_cart_enabled()) {
-        midi_reset();
-    }
-#endif
-    if (reu_cart_enabled()) {
-        reu_reset();
-    }
-    if (sfx_soundexpander_cart_enabled()) {
-        sfx_soundexpander_reset();
-    }
-    if (sfx_soundsampler_cart_enabled()) {
-        sfx_soundsampler_reset();
-    }
-#ifdef HAVE_RAWNET
-    if (ethernetcart_cart_enabled()) {
-        ethernetcart_reset();
+    cart_hooks_call(&cart_hooks.io_reset);
+    /* "Main Slot" */
+    if (cart_hooks.slotmain_reset != NULL) {
+        cart_hooks.slotmain_reset();
     }
-#endif
-#if defined(HAVE_RS232DEV) || defined(HAVE_RS232NET)
-    if (aciacart_cart_enabled()) {
-        aciacart_reset();
-    }
-#endif
-    /* "Main Slot" */
-    switch (mem_cartridge_type) {
-        case CARTRIDGE_ACTION_REPLAY:
-            actionreplay_reset();
-            break;
-        case CARTRIDGE_ACTION_REPLAY2:
-            actionreplay2_reset();
-            break;
-        case CARTRIDGE_ACTION_REPLAY3:
-            actionreplay3_reset();
-            break;
-        case CARTRIDGE_ACTION_REPLAY4:
-            actionreplay4_reset();
-            break;
-        case CARTRIDGE_ATOMIC_POWER:
-            atomicpower_reset();
-            break;
-        case CARTRIDGE_BMPDATATURBO:
-            bmpdataturbo_reset();
-            break;
-        case CARTRIDGE_CAPTURE:
-            capture_reset();
-            break;
-        case CARTRIDGE_EPYX_FASTLOAD:
-            epyxfastload_reset();
-            break;
-        case CARTRIDGE_FORMEL64:
-            formel64_reset();
-            break;
-        case CARTRIDGE_FREEZE_FRAME_MK2:
-            freezeframe2_reset();
-            break;
-        case CARTRIDGE_FREEZE_MACHINE:
-            freezemachine_reset();
-            break;
-        case CARTRIDGE_GMOD2:
-            gmod2_reset();
-            break;
-        case CARTRIDGE_GMOD3:
-            gmod3_reset();
-            break;
-        case CARTRIDGE_HYPERBASIC:
-            hyperbasic_reset();
-            break;
-        case CARTRIDGE_IDE64:
-            ide64_reset();
-            break;
-        case CARTRIDGE_MAGIC_FORMEL:
-            magicformel_reset();
-            break;
-        case CARTRIDGE_MMC_REPLAY:
-            mmcreplay_reset();
-            break;
-        case CARTRIDGE_PARTNER64:
-            partner64_reset();
-            break;
-        case CARTRIDGE_PROFIDOS:
-            profidos_reset();
-            break;
-        case CARTRIDGE_REX_RAMFLOPPY:
-            rexramfloppy_reset();
-            break;
-        case CARTRIDGE_UC1:
-            uc1_reset();
-            break;
-        case CARTRIDGE_UC15:
-        case CARTRIDGE_UC2:
-            uc2_reset();
-            break;
-#ifdef HAVE_RAWNET
-        case CARTRIDGE_RRNETMK3:
-            rrnetmk3_reset();
-            break;
-#endif
-        case CARTRIDGE_RGCD:
-            rgcd_reset();
-            break;
-        case CARTRIDGE_RETRO_REPLAY:
-            retroreplay_reset();
-            break;
-        case CARTRIDGE_SUPER_EXPLODE_V5:
-            se5_reset();
-            break;
-        case CARTRIDGE_WARPSPEED:
-            warpspeed_reset();
-            break;
-        case CARTRIDGE_ZIPPCODE48:
-            zippcode48_reset();
-            break;
-    }
-    /* "Slot 1" */
-    if (dqbb_cart_enabled()) {
-        dqbb_reset();
-    }
-    if (expert_cart_enabled()) {
-        expert_reset();
-    }
-    if (ramcart_cart_enabled()) {
-        ramcart_reset();
-    }
-    if (isepic_cart_enabled()) {
-        isepic_reset();
-    }
-    /* "Slot 0" */
-    if (tpi_cart_enabled()) {
-        tpi_reset();
-    }
-    if (magicvoice_cart_enabled()) {
-        magicvoice_reset();
-    }
-    if (mmc64_cart_enabled()) {
-        mmc64_reset();
-    }
-    if (ieeeflash64_cart_enabled()) {
-        ieeeflash64_reset();
-    }
-    if (cpmcart_cart_enabled()) {
-        cpmcart_reset();
-    }
-
-    if (machine_class == VICE_MACHINE_C128) {
-        c128cartridge->reset();
+    /* "Slot 1" */
+    cart_hooks_call(&cart_hooks.slot1_reset);
+    /* "Slot 0" */
+    cart_hooks_call(&cart_hooks.slot0_reset);
+
+    if (machine_class == VICE_MACHINE_C128) {
+        c128cartridge->reset();
     }
 }
 
@@ -2560,13 +2926,10 @@ void cartridge_reset(void)
 */
 void cartridge_powerup(void)
 {
+    cart_hooks_update();
+
     /* "IO Slot" */
-    if (georam_cart_enabled()) {
-        georam_powerup();
-    }
-    if (reu_cart_enabled()) {
-        reu_powerup();
-    }
+    cart_hooks_call(&cart_hooks.io_powerup);
 
     if (machine_class == VICE_MACHINE_C128) {
         c128cartridge->powerup();
@@ -2575,162 +2938,22 @@ void cartridge_powerup(void)
     /* "Main Slot" */
     memset(export_ram0, 0xff, C64CART_RAM_LIMIT);
 
-    switch (mem_cartridge_type) {
-        case CARTRIDGE_ACTION_REPLAY:
-            actionreplay_powerup();
-            break;
-        case CARTRIDGE_ATOMIC_POWER:
-            atomicpower_powerup();
-            break;
-        case CARTRIDGE_CAPTURE:
-            capture_powerup();
-            break;
-        case CARTRIDGE_EASYFLASH:
-            easyflash_powerup();
-            break;
-        case CARTRIDGE_KCS_POWER:
-            kcs_powerup();
-            break;
-        case CARTRIDGE_LT_KERNAL:
-            ltkernal_powerup();
-            break;
-        case CARTRIDGE_MAGIC_FORMEL:
-            magicformel_powerup();
-            break;
-        case CARTRIDGE_MAX_BASIC:
-            maxbasic_powerup();
-            break;
-        case CARTRIDGE_MMC_REPLAY:
-            mmcreplay_powerup();
-            break;
-        case CARTRIDGE_MULTIMAX:
-            multimax_powerup();
-            break;
-        case CARTRIDGE_PAGEFOX:
-            pagefox_powerup();
-            break;
-        case CARTRIDGE_PARTNER64:
-            partner64_powerup();
-            break;
-        case CARTRIDGE_RETRO_REPLAY:
-            retroreplay_powerup();
-            break;
-        case CARTRIDGE_SDBOX:
-            sdbox_powerup();
-            break;
-        case CARTRIDGE_SUPER_SNAPSHOT:
-            supersnapshot_v4_powerup();
-            break;
-        case CARTRIDGE_SUPER_SNAPSHOT_V5:
-            supersnapshot_v5_powerup();
-            break;
-        case CARTRIDGE_UC1:
-            uc1_powerup();
-            break;
-        case CARTRIDGE_UC2:
-        case CARTRIDGE_UC15:
-            uc2_powerup();
-            break;
+    if (cart_hooks.slotmain_powerup != NULL) {
+        cart_hooks.slotmain_powerup();
     }
 
     /* "Slot 1" */
-    if (dqbb_cart_enabled()) {
-        dqbb_powerup();
-    }
-    if (expert_cart_enabled()) {
-        expert_powerup();
-    }
-    if (isepic_cart_enabled()) {
-        isepic_powerup();
-    }
+    cart_hooks_call(&cart_hooks.slot1_powerup);
 }
 
 /* ------------------------------------------------------------------------- */
 
 /* called by cart_nmi_alarm_triggered, after an alarm occured */
-static void cart_freeze(int type)
+static void cart_freeze(cart_hook_t freeze)
 {
-    DBG(("CART: freeze (type:%d)", type));
-    switch (type) {
-        /* "Slot 0" (no freezer carts) */
-        /* "Slot 1" */
-        case CARTRIDGE_EXPERT:
-            expert_freeze();
-            break;
-        case CARTRIDGE_ISEPIC:
-            isepic_freeze();
-            break;
-        /* "IO Slot" (no freezer carts) */
-        /* "Main Slot" */
-        case CARTRIDGE_ACTION_REPLAY:
-            actionreplay_freeze();
-            break;
-        case CARTRIDGE_ACTION_REPLAY2:
-            actionreplay2_freeze();
-            break;
-        case CARTRIDGE_ACTION_REPLAY3:
-            actionreplay3_freeze();
-            break;
-        case CARTRIDGE_ACTION_REPLAY4:
-            actionreplay4_freeze();
-            break;
-        case CARTRIDGE_ATOMIC_POWER:
-            atomicpower_freeze();
-            break;
-        case CARTRIDGE_CAPTURE:
-            capture_freeze();
-            break;
-        case CARTRIDGE_DIASHOW_MAKER:
-            dsm_freeze();
-            break;
-        case CARTRIDGE_FINAL_I:
-            final_v1_freeze();
-            break;
-        case CARTRIDGE_FINAL_III:
-            final_v3_freeze();
-            break;
-        case CARTRIDGE_FINAL_PLUS:
-            final_plus_freeze();
-            break;
-        case CARTRIDGE_FREEZE_FRAME:
-            freezeframe_freeze();
-            break;
-        case CARTRIDGE_FREEZE_FRAME_MK2:
-            freezeframe2_freeze();
-            break;
-        case CARTRIDGE_FREEZE_MACHINE:
-            freezemachine_freeze();
-            break;
-        case CARTRIDGE_GAME_KILLER:
-            gamekiller_freeze();
-            break;
-        case CARTRIDGE_KCS_POWER:
-            kcs_freeze();
-            break;
-        case CARTRIDGE_LT_KERNAL:
-            ltkernal_freeze();
-            break;
-        case CARTRIDGE_MAGIC_FORMEL:
-            magicformel_freeze();
-            break;
-        case CARTRIDGE_MMC_REPLAY:
-            mmcreplay_freeze();
-            break;
-        case CARTRIDGE_PARTNER64:
-            partner64_freeze();
-            break;
-        case CARTRIDGE_RETRO_REPLAY:
-            retroreplay_freeze();
-            break;
-        case CARTRIDGE_SNAPSHOT64:
-            snapshot64_freeze();
-            break;
-        case CARTRIDGE_SUPER_SNAPSHOT:
-            supersnapshot_v4_freeze();
-            break;
-        case CARTRIDGE_SUPER_SNAPSHOT_V5:
-            supersnapshot_v5_freeze();
-            break;
+    DBG(("CART: freeze"));
+    if (freeze != NULL) {
+        freeze();
     }
     if (machine_class == VICE_MACHINE_C128) {
         c128cartridge->freeze();
@@ -2740,68 +2963,41 @@ static void cart_freeze(int type)
 /* called by cart_nmi_alarm_triggered */
 void cart_nmi_alarm(CLOCK offset, void *data)
 {
+    int i;
+
+    cart_hooks_update();
+
     /* "Slot 0" (no freezer carts) */
     /* "Slot 1" */
-    if (expert_freeze_allowed()) {
-        cart_freeze(CARTRIDGE_EXPERT);
-    }
-    if (isepic_freeze_allowed()) {
-        cart_freeze(CARTRIDGE_ISEPIC);
+    for (i = 0; i < cart_hooks.num_slot1_freeze; i++) {
+        if (cart_hooks.slot1_freeze[i].allowed()) {
+            cart_freeze(cart_hooks.slot1_freeze[i].freeze);
+        }
     }
     /* "I/O Slot" (no freezer carts) */
     /* "Main Slot" */
-    cart_freeze(cart_getid_slotmain());
+    cart_freeze(cart_hooks.slotmain_freeze);
 }
 
 /* called by the UI when the freeze button is pressed */
 int cart_freeze_allowed(void)
 {
-    int maintype = cart_getid_slotmain();
+    int i;
+
+    cart_hooks_update();
+
     /* "Slot 0" (no freezer carts) */
     /* "Slot 1" */
-    if (expert_freeze_allowed()) {
-        return 1;
-    }
-    if (isepic_freeze_allowed()) {
-        return 1;
+    for (i = 0; i < cart_hooks.num_slot1_freeze; i++) {
+        if (cart_hooks.slot1_freeze[i].allowed()) {
+            return 1;
+        }
     }
 
     /* "Main Slot" */
-    switch (maintype) {
-        case CARTRIDGE_ACTION_REPLAY4:
-        case CARTRIDGE_ACTION_REPLAY3:
-        case CARTRIDGE_ACTION_REPLAY2:
-        case CARTRIDGE_ACTION_REPLAY:
-        case CARTRIDGE_ATOMIC_POWER:
-        case CARTRIDGE_CAPTURE:
-        case CARTRIDGE_DIASHOW_MAKER:
-        case CARTRIDGE_FINAL_I:
-        case CARTRIDGE_FINAL_III:
-        case CARTRIDGE_FINAL_PLUS:
-        case CARTRIDGE_FREEZE_FRAME:
-        case CARTRIDGE_FREEZE_FRAME_MK2:
-        case CARTRIDGE_FREEZE_MACHINE:
-        case CARTRIDGE_GAME_KILLER:
-        case CARTRIDGE_KCS_POWER:
-        case CARTRIDGE_LT_KERNAL:
-        case CARTRIDGE_MAGIC_FORMEL:
-            return 1;
-        case CARTRIDGE_MMC_REPLAY:
-            if (mmcreplay_freeze_allowed()) {
-                return 1;
-            }
-            break;
-        case CARTRIDGE_PARTNER64:
-            return 1;
-        case CARTRIDGE_RETRO_REPLAY:
-            if (retroreplay_freeze_allowed()) {
-                return 1;
-            }
-            break;
-        case CARTRIDGE_SNAPSHOT64:
-        case CARTRIDGE_SUPER_SNAPSHOT:
-        case CARTRIDGE_SUPER_SNAPSHOT_V5:
-            return 1;
+    if (cart_hooks.slotmain_freeze_allowed != NULL
+        && cart_hooks.slotmain_freeze_allowed()) {
+        return 1;
     }
 
     if (machine_class == VICE_MACHINE_C128) {
@@ -3159,6 +3355,7 @@ void cartridge_mmu_translate(unsigned int addr, uint8_t **base, int *start, int
 {
     /* DBG(("CARTHOOKS: cartridge_mmu_translate(%x)",addr)); */
     int res = CART_READ_THROUGH;
+    int i;
 #if 0
     /* disable all the mmu translation stuff for testing */
     *base = NULL;
@@ -3166,25 +3363,11 @@ void cartridge_mmu_translate(unsigned int addr, uint8_t **base, int *start, int
     *limit = 0;
     return;
 #endif
+    cart_hooks_update();
+
     /* "Slot 0" */
-    if (mmc64_cart_enabled()) {
-        if ((res = mmc64_mmu_translate(addr, base, start, limit)) == CART_READ_VALID) {
-            return;
-        }
-    } else if (magicvoice_cart_enabled()) {
-        if ((res = magicvoice_mmu_translate(addr, base, start, limit)) == CART_READ_VALID) {
-            return;
-        }
-    } else if (tpi_cart_enabled()) {
-        if ((res = tpi_mmu_translate(addr, base, start, limit)) == CART_READ_VALID) {
-            return;
-        }
-    } else if (ieeeflash64_cart_enabled()) {
-        if ((res = ieeeflash64_mmu_translate(addr, base, start, limit)) == CART_READ_VALID) {
-            return;
-        }
-    } else if (ramlink_cart_enabled()) {
-        if ((res = ramlink_mmu_translate(addr, base, start, limit)) == CART_READ_VALID) {
+    if (cart_hooks.slot0_mmu_translate != NULL) {
+        if ((res = cart_hooks.slot0_mmu_translate(addr, base, start, limit)) == CART_READ_VALID) {
             return;
         }
     }
@@ -3200,74 +3383,15 @@ void cartridge_mmu_translate(unsigned int addr, uint8_t **base, int *start, int
     }
 
     /* continue with "Slot 1" */
-    if (isepic_cart_active()) {
-        isepic_mmu_translate(addr, base, start, limit);
-        return;
-    }
-    if (expert_cart_enabled()) {
-        expert_mmu_translate(addr, base, start, limit);
-        return;
-    }
-    if (ramcart_cart_enabled()) {
-        ramcart_mmu_translate(addr, base, start, limit);
-        return;
-    }
-    if (dqbb_cart_enabled()) {
-        dqbb_mmu_translate(addr, base, start, limit);
-        return;
+    for (i = 0; i < cart_hooks.num_slot1; i++) {
+        if (cart_hooks.slot1[i].active == NULL || cart_hooks.slot1[i].active()) {
+            cart_hooks.slot1[i].mmu_translate(addr, base, start, limit);
+            return;
+        }
     }
 
     /* continue with "Main Slot" */
-    switch (mem_cartridge_type) {
-        case CARTRIDGE_ACTION_REPLAY4:
-        case CARTRIDGE_FINAL_III:
-        case CARTRIDGE_GENERIC_16KB:
-        case CARTRIDGE_GENERIC_8KB:
-        case CARTRIDGE_KCS_POWER:
-        case CARTRIDGE_SIMONS_BASIC:
-        case CARTRIDGE_ULTIMAX:
-            generic_mmu_translate(addr, base, start, limit);
-            return;
-        case CARTRIDGE_ATOMIC_POWER:
-            atomicpower_mmu_translate(addr, base, start, limit);
-            return;
-        case CARTRIDGE_EASYFLASH:
-            easyflash_mmu_translate(addr, base, start, limit);
-            return;
-        case CARTRIDGE_GMOD2:
-            gmod2_mmu_translate(addr, base, start, limit);
-            return;
-        case CARTRIDGE_GMOD3:
-            gmod3_mmu_translate(addr, base, start, limit);
-            return;
-        case CARTRIDGE_IDE64:
-            ide64_mmu_translate(addr, base, start, limit);
-            return;
-        case CARTRIDGE_LT_KERNAL:
-            ltkernal_mmu_translate(addr, base, start, limit);
-            return;
-        case CARTRIDGE_MEGABYTER:
-            megabyter_mmu_translate(addr, base, start, limit);
-            return;
-        case CARTRIDGE_RETRO_REPLAY:
-            retroreplay_mmu_translate(addr, base, start, limit);
-            return;
-#ifdef HAVE_RAWNET
-        case CARTRIDGE_RRNETMK3:
-            rrnetmk3_mmu_translate(addr, base, start, limit);
-            return;
-#endif
-        case CARTRIDGE_SUPER_SNAPSHOT_V5:
-            supersnapshot_v5_mmu_translate(addr, base, start, limit);
-            return;
-        case CARTRIDGE_EPYX_FASTLOAD: /* must go through roml_read to discharge capacitor */
-        case CARTRIDGE_ZIPPCODE48: /* must go through roml_read to discharge capacitor */
-        default:
-            *base = NULL;
-            *start = 0;
-            *limit = 0;
-            return;
-    }
+    cart_hooks.slotmain_mmu_translate(addr, base, start, limit);
 }
 
 /* ------------------------------------------------------------------------- */
@@ -3276,7 +3400,7 @@ void cartridge_mmu_translate(unsigned int addr, uint8_t **base, int *start, int
     Snapshot reading and writing
 */
 
-#define C64CART_DUMP_MAX_CARTS  16
+#define C64CART_DUMP_MAX_CARTS  CART_HOOKS_MAX_ATTACHED
 
 #define C64CART_DUMP_VER_MAJOR   0
 #define C64CART_DUMP_VER_MINOR   1
@@ -3289,26 +3413,15 @@ int cartridge_snapshot_write_modules(struct snapshot_s *s)
     uint8_t i;
     uint8_t number_of_carts = 0;
     int cart_ids[C64CART_DUMP_MAX_CARTS];
-    int last_cart = CARTRIDGE_NONE;
-
-    memset(cart_ids, 0, sizeof(cart_ids));
 
     /* Find out which carts are attached */
-    {
-        export_list_t *e = export_query_list(NULL);
-
-        while (e != NULL) {
-            if (number_of_carts == C64CART_DUMP_MAX_CARTS) {
-                DBG(("CART snapshot save: active carts > max (%i)", number_of_carts));
-                return -1;
-            }
-            if (last_cart != (int)e->device->cartid) {
-                last_cart = e->device->cartid;
-                cart_ids[number_of_carts++] = last_cart;
-            }
-            e = e->next;
-        }
+    cart_hooks_update();
+    if (cart_hooks.num_attached > C64CART_DUMP_MAX_CARTS) {
+        DBG(("CART snapshot save: active carts > max (%i)", cart_hooks.num_attached));
+        return -1;
     }
+    number_of_carts = (uint8_t)cart_hooks.num_attached;
+    memcpy(cart_ids, cart_hooks.attached, number_of_carts * sizeof(cart_ids[0]));
 
     m = snapshot_module_create(s, SNAP_MODULE_NAME,
                                C64CART_DUMP_VER_MAJOR, C64CART_DUMP_VER_MINOR);
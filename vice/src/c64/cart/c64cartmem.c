@@ -40,6 +40,7 @@
 #include "cartio.h"
 #include "cartridge.h"
 #include "crt.h"
+#include "export.h"
 #include "log.h"
 #include "machine.h"
 #include "maincpu.h"
@@ -328,26 +329,7 @@ void cart_passthrough_changed(void)
     export.ultimax_phi1 = export_passthrough.ultimax_phi1;
     export.ultimax_phi2 = export_passthrough.ultimax_phi2;
 
-    switch (cart_getid_slot0()) {
-        case CARTRIDGE_MMC64:
-            mmc64_passthrough_changed(&export_passthrough);
-            break;
-        case CARTRIDGE_MAGIC_VOICE:
-            magicvoice_passthrough_changed(&export_passthrough);
-            break;
-        case CARTRIDGE_IEEE488:
-            tpi_passthrough_changed(&export_passthrough);
-            break;
-        case CARTRIDGE_IEEEFLASH64:
-            ieeeflash64_passthrough_changed(&export_passthrough);
-            break;
-        case CARTRIDGE_RAMLINK:
-            ramlink_passthrough_changed(&export_passthrough);
-            break;
-        default:
-            /* no slot 0 cartridge */
-            break;
-    }
+    cart_passthrough_changed_slot0(&export_passthrough);
 }
 #endif
 
@@ -527,12 +509,19 @@ void cart_config_changed_slotmain(uint8_t mode_phi1, uint8_t mode_phi2, unsigned
 */
 void cart_romhbank_set_slotmain(unsigned int bank)
 {
-    romh_bank = (int)bank;
+    if (romh_bank != (int)bank) {
+        romh_bank = (int)bank;
+        /* the CPU may be reading the old bank through a cached pointer */
+        maincpu_resync_limits();
+    }
 }
 
 void cart_romlbank_set_slotmain(unsigned int bank)
 {
-    roml_bank = (int)bank;
+    if (roml_bank != (int)bank) {
+        roml_bank = (int)bank;
+        maincpu_resync_limits();
+    }
 }
 
 /*
@@ -620,80 +609,142 @@ void cart_romlbank_set_slotmain(unsigned int bank)
 */
 
 
+static uint8_t roml_open_bus_read(uint16_t addr)
+{
+    DBG(("CARTMEM: BUG! ROML open bus read (addr %04x)\n", addr));
+    return vicii_read_phi1();
+}
+
+static uint8_t romh_open_bus_read(uint16_t addr)
+{
+    DBG(("CARTMEM: BUG! ROMH open bus read (addr %04x)\n", addr));
+    return vicii_read_phi1();
+}
+
+static read_func_ptr_t roml_read_slotmain_handler(void);
+static read_func_ptr_t romh_read_slotmain_handler(void);
+static read_func_ptr_t ultimax_romh_read_hirom_slotmain_handler(void);
+
+/*
+    The ROM read handlers of the "Main Slot" only depend on the type of the
+    cartridge, so they are resolved once instead of switching on the type for
+    every access. As long as no "Slot 0" or "Slot 1" cartridge is enabled,
+    which may take an access or pass it on, ROML/ROMH reads go straight to
+    them. The handlers are resolved again when the cartridge type or the list
+    of expansion port devices changes.
+*/
+static struct {
+    int cartridge_type;
+    unsigned int export_generation;
+    int slot0_slot1_enabled;
+    read_func_ptr_t roml_read;
+    read_func_ptr_t romh_read;
+    read_func_ptr_t ultimax_romh_read_hirom;
+} cart_resolved = { CARTRIDGE_NONE, 0, 0, NULL, NULL, NULL };
+
+static void cart_resolve_handlers(void)
+{
+    cart_resolved.cartridge_type = mem_cartridge_type;
+    cart_resolved.export_generation = export_generation;
+
+    cart_resolved.slot0_slot1_enabled = mmc64_cart_enabled()
+                                        || magicvoice_cart_enabled()
+                                        || tpi_cart_enabled()
+                                        || ieeeflash64_cart_enabled()
+                                        || ramlink_cart_enabled()
+                                        || isepic_cart_enabled()
+                                        || expert_cart_enabled()
+                                        || ramcart_cart_enabled()
+                                        || dqbb_cart_enabled();
+
+    cart_resolved.roml_read = roml_read_slotmain_handler();
+    cart_resolved.romh_read = romh_read_slotmain_handler();
+    cart_resolved.ultimax_romh_read_hirom = ultimax_romh_read_hirom_slotmain_handler();
+}
+
+inline static void cart_resolved_update(void)
+{
+    if (cart_resolved.roml_read == NULL
+        || cart_resolved.cartridge_type != mem_cartridge_type
+        || cart_resolved.export_generation != export_generation) {
+        cart_resolve_handlers();
+    }
+}
+
 /* ROML read - mapped to 8000 in 8k,16k,ultimax */
-static uint8_t roml_read_slotmain(uint16_t addr)
+static read_func_ptr_t roml_read_slotmain_handler(void)
 {
     /* "Main Slot" */
     switch (mem_cartridge_type) {
         case CARTRIDGE_ACTION_REPLAY:
-            return actionreplay_roml_read(addr);
+            return actionreplay_roml_read;
         case CARTRIDGE_ACTION_REPLAY2:
-            return actionreplay2_roml_read(addr);
+            return actionreplay2_roml_read;
         case CARTRIDGE_ACTION_REPLAY3:
-            return actionreplay3_roml_read(addr);
+            return actionreplay3_roml_read;
         case CARTRIDGE_ATOMIC_POWER:
-            return atomicpower_roml_read(addr);
+            return atomicpower_roml_read;
         case CARTRIDGE_EASYFLASH:
-            return easyflash_roml_read(addr);
+            return easyflash_roml_read;
         case CARTRIDGE_EPYX_FASTLOAD:
-            return epyxfastload_roml_read(addr);
+            return epyxfastload_roml_read;
         case CARTRIDGE_FINAL_I:
-            return final_v1_roml_read(addr);
+            return final_v1_roml_read;
         case CARTRIDGE_FINAL_PLUS:
-            return final_plus_roml_read(addr);
+            return final_plus_roml_read;
         case CARTRIDGE_FREEZE_FRAME_MK2:
-            return freezeframe2_roml_read(addr);
+            return freezeframe2_roml_read;
         case CARTRIDGE_FREEZE_MACHINE:
-            return freezemachine_roml_read(addr);
+            return freezemachine_roml_read;
         case CARTRIDGE_GMOD2:
-            return gmod2_roml_read(addr);
+            return gmod2_roml_read;
         case CARTRIDGE_GMOD3:
-            return gmod3_roml_read(addr);
+            return gmod3_roml_read;
         case CARTRIDGE_IDE64:
-            return ide64_rom_read(addr);
+            return ide64_rom_read;
         case CARTRIDGE_KINGSOFT:
-            return kingsoft_roml_read(addr);
+            return kingsoft_roml_read;
         case CARTRIDGE_LT_KERNAL:
-            return ltkernal_roml_read(addr);
+            return ltkernal_roml_read;
         case CARTRIDGE_MAX_BASIC:
-            return maxbasic_roml_read(addr);
+            return maxbasic_roml_read;
         case CARTRIDGE_MEGABYTER:
-            return megabyter_roml_read(addr);
+            return megabyter_roml_read;
         case CARTRIDGE_MMC_REPLAY:
-            return mmcreplay_roml_read(addr);
+            return mmcreplay_roml_read;
         case CARTRIDGE_MULTIMAX:
-            return multimax_roml_read(addr);
+            return multimax_roml_read;
         case CARTRIDGE_PAGEFOX:
-            return pagefox_roml_read(addr);
+            return pagefox_roml_read;
         case CARTRIDGE_PARTNER64:
-            return partner64_roml_read(addr);
+            return partner64_roml_read;
         case CARTRIDGE_RETRO_REPLAY:
-            return retroreplay_roml_read(addr);
+            return retroreplay_roml_read;
         case CARTRIDGE_UC1:
-            return uc1_roml_read(addr);
+            return uc1_roml_read;
         case CARTRIDGE_UC15:
         case CARTRIDGE_UC2:
-            return uc2_roml_read(addr);
+            return uc2_roml_read;
         case CARTRIDGE_REX_RAMFLOPPY:
-            return rexramfloppy_roml_read(addr);
+            return rexramfloppy_roml_read;
 #ifdef HAVE_RAWNET
         case CARTRIDGE_RRNETMK3:
-            return rrnetmk3_roml_read(addr);
+            return rrnetmk3_roml_read;
 #endif
         case CARTRIDGE_STARDOS:
-            return stardos_roml_read(addr);
+            return stardos_roml_read;
         case CARTRIDGE_SNAPSHOT64:
-            return snapshot64_roml_read(addr);
+            return snapshot64_roml_read;
         case CARTRIDGE_SUPER_SNAPSHOT:
-            return supersnapshot_v4_roml_read(addr);
+            return supersnapshot_v4_roml_read;
         case CARTRIDGE_SUPER_SNAPSHOT_V5:
-            return supersnapshot_v5_roml_read(addr);
+            return supersnapshot_v5_roml_read;
         case CARTRIDGE_SUPER_EXPLODE_V5:
-            return se5_roml_read(addr);
+            return se5_roml_read;
         case CARTRIDGE_ZAXXON:
-            return zaxxon_roml_read(addr);
+            return zaxxon_roml_read;
         case CARTRIDGE_ZIPPCODE48:
-            return zippcode48_roml_read(addr);
+            return zippcode48_roml_read;
         case CARTRIDGE_CAPTURE:
         case CARTRIDGE_EXOS:
         case CARTRIDGE_FORMEL64:
@@ -701,14 +752,14 @@ static uint8_t roml_read_slotmain(uint16_t addr)
         case CARTRIDGE_MAGIC_FORMEL: /* ? */
         case CARTRIDGE_PROFIDOS:
             /* fake ultimax hack */
-            return mem_read_without_ultimax(addr);
+            return mem_read_without_ultimax;
         case CARTRIDGE_ACTION_REPLAY4:
         case CARTRIDGE_FINAL_III:
         case CARTRIDGE_FREEZE_FRAME:
         default: /* use default cartridge */
-            return generic_roml_read(addr);
+            return generic_roml_read;
         case CARTRIDGE_CRT: /* invalid */
-            DBG(("CARTMEM: BUG! invalid type %d for main cart (addr %04x)\n", mem_cartridge_type, addr));
+            DBG(("CARTMEM: BUG! invalid type %d for main cart\n", mem_cartridge_type));
             break;
         case CARTRIDGE_NONE:
             /* RAMLINK operates as ULTIMAX when the address is > $e000, but
@@ -717,14 +768,49 @@ static uint8_t roml_read_slotmain(uint16_t addr)
                 to hack it here.
                 So when RAMLINK is enabled, pass whatever is "default". */
             if (ramlink_cart_enabled()) {
-                return mem_read_without_ultimax(addr);
+                return mem_read_without_ultimax;
             }
             break;
     }
 
-    /* open bus */
-    DBG(("CARTMEM: BUG! ROML open bus read (addr %04x)\n", addr));
-    return vicii_read_phi1();
+    return roml_open_bus_read;
+}
+
+static uint8_t roml_read_slotmain(uint16_t addr)
+{
+    cart_resolved_update();
+    return cart_resolved.roml_read(addr);
+}
+
+/* MMU translation for the "Main Slot" cartridges without one of their own.
+   If the ROM area of addr is read by the generic handlers, the CPU can read
+   the current bank directly. */
+void cart_generic_mmu_translate_slotmain(unsigned int addr, uint8_t **base, int *start, int *limit)
+{
+    cart_resolved_update();
+
+    switch (addr & 0xe000) {
+        case 0x8000:
+            if (cart_resolved.roml_read == generic_roml_read) {
+                generic_mmu_translate(addr, base, start, limit);
+                return;
+            }
+            break;
+        case 0xa000:
+        case 0xe000:
+            if (cart_resolved.romh_read == generic_romh_read
+                && cart_resolved.ultimax_romh_read_hirom == generic_romh_read) {
+                generic_mmu_translate(addr, base, start, limit);
+                return;
+            }
+            break;
+        default:
+            break;
+    }
+
+    *base = NULL;
+    *start = 0;
+    *limit = 0;
 }
 
 /* ROML read - mapped to 8000 in 8k,16k,ultimax */
@@ -755,6 +841,11 @@ uint8_t roml_read(uint16_t addr)
     uint8_t value;
 /*    DBG(("CARTMEM roml_read (addr %04x)\n", addr)); */
 
+    cart_resolved_update();
+    if (!cart_resolved.slot0_slot1_enabled) {
+        return cart_resolved.roml_read(addr);
+    }
+
     /* "Slot 0" */
 
     if (mmc64_cart_enabled()) {
@@ -902,73 +993,73 @@ void roml_store(uint16_t addr, uint8_t value)
    most carts that use romh_read also need to use ultimax_romh_read_hirom
    below. carts that map an "external kernal" wrap to ram_read here.
 */
-static uint8_t romh_read_slotmain(uint16_t addr)
+static read_func_ptr_t romh_read_slotmain_handler(void)
 {
     /* "Main Slot" */
     switch (mem_cartridge_type) {
         case CARTRIDGE_ACTION_REPLAY2:
-            return actionreplay2_romh_read(addr);
+            return actionreplay2_romh_read;
         case CARTRIDGE_ACTION_REPLAY3:
-            return actionreplay3_romh_read(addr);
+            return actionreplay3_romh_read;
         case CARTRIDGE_ATOMIC_POWER:
-            return atomicpower_romh_read(addr);
+            return atomicpower_romh_read;
         case CARTRIDGE_CAPTURE:
-            return capture_romh_read(addr);
+            return capture_romh_read;
         case CARTRIDGE_EASYFLASH:
-            return easyflash_romh_read(addr);
+            return easyflash_romh_read;
         case CARTRIDGE_FINAL_I:
-            return final_v1_romh_read(addr);
+            return final_v1_romh_read;
         case CARTRIDGE_FINAL_PLUS:
-            return final_plus_romh_read(addr);
+            return final_plus_romh_read;
         case CARTRIDGE_FORMEL64:
-            return formel64_romh_read(addr);
+            return formel64_romh_read;
         case CARTRIDGE_IDE64:
-            return ide64_rom_read(addr);
+            return ide64_rom_read;
         case CARTRIDGE_KINGSOFT:
-            return kingsoft_romh_read(addr);
+            return kingsoft_romh_read;
         case CARTRIDGE_LT_KERNAL:
-            return ltkernal_romh_read(addr);
+            return ltkernal_romh_read;
         case CARTRIDGE_MAGIC_FORMEL:
-            return magicformel_romh_read(addr);
+            return magicformel_romh_read;
         case CARTRIDGE_MAX_BASIC:
-            return maxbasic_romh_read(addr);
+            return maxbasic_romh_read;
         case CARTRIDGE_MMC_REPLAY:
-            return mmcreplay_romh_read(addr);
+            return mmcreplay_romh_read;
         case CARTRIDGE_MULTIMAX:
-            return multimax_romh_read(addr);
+            return multimax_romh_read;
         case CARTRIDGE_OCEAN:
-            return ocean_romh_read(addr);
+            return ocean_romh_read;
         case CARTRIDGE_PAGEFOX:
-            return pagefox_romh_read(addr);
+            return pagefox_romh_read;
         case CARTRIDGE_PARTNER64:
-            return partner64_romh_read(addr);
+            return partner64_romh_read;
         case CARTRIDGE_RETRO_REPLAY:
-            return retroreplay_romh_read(addr);
+            return retroreplay_romh_read;
         case CARTRIDGE_UC1:
-            return uc1_romh_read(addr);
+            return uc1_romh_read;
         case CARTRIDGE_UC15:
         case CARTRIDGE_UC2:
-            return uc2_romh_read(addr);
+            return uc2_romh_read;
         case CARTRIDGE_SNAPSHOT64:
-            return snapshot64_romh_read(addr);
+            return snapshot64_romh_read;
         case CARTRIDGE_EXOS:
         case CARTRIDGE_GMOD2:
         case CARTRIDGE_STARDOS:
         case CARTRIDGE_PROFIDOS:
             /* fake ultimax hack, read from ram */
-            return ram_read(addr);
+            return ram_read;
         case CARTRIDGE_GMOD3:
-            return gmod3_romh_read(addr);
-        /* return mem_read_without_ultimax(addr); */
+            return gmod3_romh_read;
+        /* return mem_read_without_ultimax; */
         case CARTRIDGE_ACTION_REPLAY4:
         case CARTRIDGE_FINAL_III:
         case CARTRIDGE_FREEZE_FRAME:
         case CARTRIDGE_FREEZE_FRAME_MK2:
         case CARTRIDGE_FREEZE_MACHINE:
         default: /* use default cartridge */
-            return generic_romh_read(addr);
+            return generic_romh_read;
         case CARTRIDGE_CRT: /* invalid */
-            DBG(("CARTMEM: BUG! invalid type %d for main cart (addr %04x)\n", mem_cartridge_type, addr));
+            DBG(("CARTMEM: BUG! invalid type %d for main cart\n", mem_cartridge_type));
             break;
         case CARTRIDGE_NONE:
             /* RAMLINK operates as ULTIMAX when the address is > $e000, but
@@ -977,14 +1068,18 @@ static uint8_t romh_read_slotmain(uint16_t addr)
                 to hack it here.
                 So when RAMLINK is enabled, pass whatever is "default". */
             if (ramlink_cart_enabled()) {
-                return mem_read_without_ultimax(addr);
+                return mem_read_without_ultimax;
             }
             break;
     }
 
-    /* open bus */
-    DBG(("CARTMEM: BUG! ROMH open bus read (addr %04x)\n", addr));
-    return vicii_read_phi1();
+    return romh_open_bus_read;
+}
+
+static uint8_t romh_read_slotmain(uint16_t addr)
+{
+    cart_resolved_update();
+    return cart_resolved.romh_read(addr);
 }
 
 static uint8_t romh_read_slot1(uint16_t addr)
@@ -1010,6 +1105,11 @@ uint8_t romh_read(uint16_t addr)
     uint8_t value;
     /* DBG(("ultimax r e000: %04x\n", addr)); */
 
+    cart_resolved_update();
+    if (!cart_resolved.slot0_slot1_enabled) {
+        return cart_resolved.romh_read(addr);
+    }
+
     /* "Slot 0" */
     if (magicvoice_cart_enabled()) {
         if ((res = magicvoice_romh_read(addr, &value)) == CART_READ_VALID) {
@@ -1042,73 +1142,73 @@ uint8_t romh_read(uint16_t addr)
    that map an "external kernal" _only_ use this one, and wrap to
    ram_read in romh_read.
 */
-static uint8_t ultimax_romh_read_hirom_slotmain(uint16_t addr)
+static read_func_ptr_t ultimax_romh_read_hirom_slotmain_handler(void)
 {
     /* "Main Slot" */
     switch (mem_cartridge_type) {
         case CARTRIDGE_ACTION_REPLAY2:
-            return actionreplay2_romh_read(addr);
+            return actionreplay2_romh_read;
         case CARTRIDGE_ACTION_REPLAY3:
-            return actionreplay3_romh_read(addr);
+            return actionreplay3_romh_read;
         case CARTRIDGE_ATOMIC_POWER:
-            return atomicpower_romh_read(addr);
+            return atomicpower_romh_read;
         case CARTRIDGE_CAPTURE:
-            return capture_romh_read(addr);
+            return capture_romh_read;
         case CARTRIDGE_EASYFLASH:
-            return easyflash_romh_read(addr);
+            return easyflash_romh_read;
         case CARTRIDGE_EXOS:
-            return exos_romh_read_hirom(addr);
+            return exos_romh_read_hirom;
         case CARTRIDGE_FINAL_I:
-            return final_v1_romh_read(addr);
+            return final_v1_romh_read;
         case CARTRIDGE_FINAL_PLUS:
-            return final_plus_romh_read(addr);
+            return final_plus_romh_read;
         case CARTRIDGE_FORMEL64:
-            return formel64_romh_read_hirom(addr);
+            return formel64_romh_read_hirom;
         case CARTRIDGE_IDE64:
-            return ide64_rom_read(addr);
+            return ide64_rom_read;
         case CARTRIDGE_KINGSOFT:
-            return kingsoft_romh_read(addr);
+            return kingsoft_romh_read;
         case CARTRIDGE_LT_KERNAL:
-            return ltkernal_romh_read(addr);
+            return ltkernal_romh_read;
         case CARTRIDGE_MAGIC_FORMEL:
-            return magicformel_romh_read_hirom(addr);
+            return magicformel_romh_read_hirom;
         case CARTRIDGE_MAX_BASIC:
-            return maxbasic_romh_read(addr);
+            return maxbasic_romh_read;
         case CARTRIDGE_MMC_REPLAY:
-            return mmcreplay_romh_read(addr);
+            return mmcreplay_romh_read;
         case CARTRIDGE_MULTIMAX:
-            return multimax_romh_read(addr);
+            return multimax_romh_read;
         case CARTRIDGE_OCEAN:
-            return ocean_romh_read(addr);
+            return ocean_romh_read;
         case CARTRIDGE_PARTNER64:
-            return partner64_romh_read(addr);
+            return partner64_romh_read;
         case CARTRIDGE_PROFIDOS:
-            return profidos_romh_read_hirom(addr);
+            return profidos_romh_read_hirom;
         case CARTRIDGE_RETRO_REPLAY:
-            return retroreplay_romh_read(addr);
+            return retroreplay_romh_read;
         case CARTRIDGE_UC1:
-            return uc1_romh_read(addr);
+            return uc1_romh_read;
         case CARTRIDGE_UC15:
         case CARTRIDGE_UC2:
-            return uc2_romh_read(addr);
+            return uc2_romh_read;
         case CARTRIDGE_SNAPSHOT64:
-            return snapshot64_romh_read(addr);
+            return snapshot64_romh_read;
         case CARTRIDGE_STARDOS:
-            return stardos_romh_read(addr);
+            return stardos_romh_read;
         case CARTRIDGE_GMOD2:
             /* ultimax only enabled on writes */
-            return mem_read_without_ultimax(addr);
+            return mem_read_without_ultimax;
         case CARTRIDGE_GMOD3:
-            return gmod3_romh_read(addr);
+            return gmod3_romh_read;
         case CARTRIDGE_ACTION_REPLAY4:
         case CARTRIDGE_FINAL_III:
         case CARTRIDGE_FREEZE_FRAME:
         case CARTRIDGE_FREEZE_FRAME_MK2:
         case CARTRIDGE_FREEZE_MACHINE:
         default: /* use default cartridge */
-            return generic_romh_read(addr);
+            return generic_romh_read;
         case CARTRIDGE_CRT: /* invalid */
-            DBG(("CARTMEM: BUG! invalid type %d for main cart (addr %04x)\n", mem_cartridge_type, addr));
+            DBG(("CARTMEM: BUG! invalid type %d for main cart\n", mem_cartridge_type));
             break;
         case CARTRIDGE_NONE:
             /* RAMLINK operates as ULTIMAX when the address is > $e000, but
@@ -1117,14 +1217,18 @@ static uint8_t ultimax_romh_read_hirom_slotmain(uint16_t addr)
                 to hack it here.
                 So when RAMLINK is enabled, pass whatever is "default". */
             if (ramlink_cart_enabled()) {
-                return mem_read_without_ultimax(addr);
+                return mem_read_without_ultimax;
             }
             break;
     }
 
-    /* open bus */
-    DBG(("CARTMEM: BUG! ROMH open bus read (addr %04x)\n", addr));
-    return vicii_read_phi1();
+    return romh_open_bus_read;
+}
+
+static uint8_t ultimax_romh_read_hirom_slotmain(uint16_t addr)
+{
+    cart_resolved_update();
+    return cart_resolved.ultimax_romh_read_hirom(addr);
 }
 
 static uint8_t ultimax_romh_read_hirom_slot1(uint16_t addr)
@@ -1150,6 +1254,11 @@ uint8_t ultimax_romh_read_hirom(uint16_t addr)
     uint8_t value;
     /* DBG(("ultimax r e000: %04x\n", addr)); */
 
+    cart_resolved_update();
+    if (!cart_resolved.slot0_slot1_enabled) {
+        return cart_resolved.ultimax_romh_read_hirom(addr);
+    }
+
     /* "Slot 0" */
     res = CART_READ_THROUGH;
     if (magicvoice_cart_enabled()) {
@@ -38,6 +38,9 @@ uint8_t roml_read(uint16_t addr);
 void roml_store(uint16_t addr, uint8_t value);
 uint8_t romh_read(uint16_t addr);
 uint8_t ultimax_romh_read_hirom(uint16_t addr);
+
+/* used by cartridge_mmu_translate() */
+void cart_generic_mmu_translate_slotmain(unsigned int addr, uint8_t **base, int *start, int *limit);
 void romh_store(uint16_t addr, uint8_t value);
 void roml_no_ultimax_store(uint16_t addr, uint8_t value);
 void raml_no_ultimax_store(uint16_t addr, uint8_t value);
@@ -42,6 +42,7 @@
       postfix (_slot0, _slot1, _slotmain, _slotio)
 */
 
+#include "c64cart.h"
 #include "types.h"
 
 /* from c64cart.c */
@@ -157,5 +158,6 @@ void cart_port_config_changed_slotmain(void);
 #endif /* CARTRIDGE_INCLUDE_SLOTMAIN_API */
 
 void cart_passthrough_changed(void);
+void cart_passthrough_changed_slot0(export_t *passthrough); /* from c64carthooks.c */
 
 #endif
@@ -498,23 +498,36 @@ void dqbb_reset(void)
     }
 }
 
+/* The RAM of the current bank is visible wherever the ROML/ROMH hooks would
+   read it, see dqbb_roml_read() and dqbb_romh_read(). $a000 is only ROMH in
+   16k game mode, in ultimax mode it is open. In C128 mode the cartridge is
+   not translated. */
 void dqbb_mmu_translate(unsigned int addr, uint8_t **base, int *start, int *limit)
 {
-    /* FIXME: this doesn't incorporate the banking, nor C128 */
-#if 0
-    switch (addr & 0xf000) {
-        case 0xb000:
-        case 0xa000:
-        case 0x9000:
+    uint8_t *bank_ram = dqbb_ram + (dqbb_bank * 0x4000);
+
+    switch (addr & 0xe000) {
         case 0x8000:
-            *base = dqbb_ram - 0x8000;
+            *base = bank_ram - 0x8000;
             *start = 0x8000;
-            *limit = 0xbffd;
+            *limit = 0x9ffd;
+            return;
+        case 0xa000:
+            if (!dqbb_off && (dqbb_mode_switch || dqbb_exrom) && dqbb_game) {
+                *base = bank_ram + 0x2000 - 0xa000;
+                *start = 0xa000;
+                *limit = 0xbffd;
+                return;
+            }
+            break;
+        case 0xe000:
+            *base = bank_ram + 0x2000 - 0xe000;
+            *start = 0xe000;
+            *limit = 0xfffd;
             return;
         default:
             break;
     }
-#endif
     *base = NULL;
     *start = 0;
     *limit = 0;
@@ -30,6 +30,11 @@
 #include <stdio.h>
 #include <string.h>
 
+#ifdef USE_VICE_THREAD
+#include <pthread.h>
+#endif
+
+#include "alarm.h"
 #include "archdep.h"
 #define CARTRIDGE_INCLUDE_SLOTMAIN_API
 #include "c64cartsystem.h"
@@ -38,6 +43,7 @@
 #include "cartio.h"
 #include "cartridge.h"
 #include "cmdline.h"
+#include "crc32.h"
 #include "crt.h"
 #include "easyflash.h"
 #include "export.h"
@@ -387,6 +393,571 @@ int easyflash_cmdline_options_init(void)
     return cmdline_register_options(cmdline_options);
 }
 
+/* ---------------------------------------------------------------------*/
+/*    incremental write back                                            */
+
+/*
+ * With EasyFlashWriteCRT enabled, the chips changed by the flash core are
+ * written back into the image file on their own, shortly after the program
+ * stopped writing, and on a thread of their own if VICE is built with
+ * threads. The image is only rewritten as a whole when a chip has to be
+ * added to a CRT file, and then via a temporary file.
+ *
+ * The chips of a write back are first written to a journal next to the
+ * image, which is removed once the image is complete. A journal left behind
+ * by a crash is written to the image when it is attached next time.
+ *
+ * Chips are numbered like the rawcart layout, bank * 2 for ROML and
+ * bank * 2 + 1 for ROMH, so chip n is found at n * 0x2000 in rawcart.
+ */
+#define EASYFLASH_N_CHIPS       (EASYFLASH_N_BANKS * 2)
+#define EASYFLASH_CHIP_SIZE     0x2000
+
+/* emulated cycles (about a second) between the first write to the flash
+   and writing back the changed chips, so a save is written in one go */
+#define EASYFLASH_WRITE_BACK_DELAY  1000000
+
+/* journal: magic, records of chip number, data and crc32 of the data, then
+   the end marker and the number of records */
+#define EASYFLASH_JOURNAL_MAGIC "EFJ1"
+#define EASYFLASH_JOURNAL_END   0xff
+
+typedef struct easyflash_write_back_s {
+    char *filename;
+    char *journal_name;
+    int filetype;
+
+    /* owned by the writer */
+    FILE *fd;
+    long offset[EASYFLASH_N_CHIPS]; /* of the chip data, -1 if not in the file */
+    uint8_t *image;                 /* the chips as they are written */
+    int batch[EASYFLASH_N_CHIPS];
+
+    /* shared with the emulation */
+    uint8_t *staging;
+    uint8_t pending[EASYFLASH_N_CHIPS];
+    int num_pending;
+    int optimize;                   /* EasyFlashOptimizeCRT of the pending chips */
+    int busy;
+    int error;
+#ifdef USE_VICE_THREAD
+    int quit;
+    int thread_started;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t work_cond;
+    pthread_cond_t done_cond;
+#endif
+} easyflash_write_back_t;
+
+#ifdef USE_VICE_THREAD
+#define WB_LOCK(w)      pthread_mutex_lock(&(w)->lock)
+#define WB_UNLOCK(w)    pthread_mutex_unlock(&(w)->lock)
+#else
+#define WB_LOCK(w)
+#define WB_UNLOCK(w)
+#endif
+
+static easyflash_write_back_t *easyflash_wb = NULL;
+static alarm_t *easyflash_wb_alarm = NULL;
+static int easyflash_wb_alarm_pending = 0;
+
+static int chip_is_empty(const uint8_t *data)
+{
+    int i;
+
+    for (i = 0; i < EASYFLASH_CHIP_SIZE; i++) {
+        if (data[i] != 0xff) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Find the chips in the image file. */
+static int write_back_scan(easyflash_write_back_t *wb)
+{
+    crt_chip_header_t chip;
+    crt_header_t header;
+    FILE *fd;
+    long pos;
+    int i;
+
+    for (i = 0; i < EASYFLASH_N_CHIPS; i++) {
+        wb->offset[i] = -1;
+    }
+
+    if (wb->filetype == CARTRIDGE_FILETYPE_BIN) {
+        fd = fopen(wb->filename, MODE_READ);
+        if (fd == NULL) {
+            return -1;
+        }
+        /* util_file_load() skipped a load address if there was one */
+        pos = (fseek(fd, 0, SEEK_END) == 0) ? ftell(fd) - EASYFLASH_N_CHIPS * EASYFLASH_CHIP_SIZE : -1;
+        fclose(fd);
+        if (pos != 0 && pos != 2) {
+            return -1;
+        }
+        for (i = 0; i < EASYFLASH_N_CHIPS; i++) {
+            wb->offset[i] = pos + i * EASYFLASH_CHIP_SIZE;
+        }
+        return 0;
+    }
+
+    fd = crt_open(wb->filename, &header);
+    if (fd == NULL) {
+        return -1;
+    }
+    while (crt_read_chip_header(&chip, fd) == 0) {
+        pos = ftell(fd);
+        if (chip.bank >= EASYFLASH_N_BANKS) {
+            break;
+        }
+        if (chip.size == 0x2000) {
+            wb->offset[chip.bank * 2 + ((chip.start & 0x2000) ? 1 : 0)] = pos;
+        } else if (chip.size == 0x4000) {
+            wb->offset[chip.bank * 2] = pos;
+            wb->offset[chip.bank * 2 + 1] = pos + 0x2000;
+        }
+        if (fseek(fd, (long)chip.size + (long)chip.skip, SEEK_CUR) != 0) {
+            break;
+        }
+    }
+    fclose(fd);
+    return 0;
+}
+
+static int write_back_open(easyflash_write_back_t *wb)
+{
+    if (wb->fd == NULL) {
+        if (write_back_scan(wb) < 0) {
+            return -1;
+        }
+        wb->fd = fopen(wb->filename, MODE_READ_WRITE);
+        if (wb->fd == NULL) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void write_back_close(easyflash_write_back_t *wb)
+{
+    if (wb->fd != NULL) {
+        fclose(wb->fd);
+        wb->fd = NULL;
+    }
+}
+
+static int write_back_journal(easyflash_write_back_t *wb, int num)
+{
+    uint8_t record[5];
+    FILE *fd;
+    int i;
+
+    fd = fopen(wb->journal_name, MODE_WRITE);
+    if (fd == NULL) {
+        return -1;
+    }
+    if (fwrite(EASYFLASH_JOURNAL_MAGIC, 4, 1, fd) < 1) {
+        goto fail;
+    }
+    for (i = 0; i < num; i++) {
+        uint8_t *data = wb->image + wb->batch[i] * EASYFLASH_CHIP_SIZE;
+
+        record[0] = (uint8_t)wb->batch[i];
+        crc32_to_le(record + 1, crc32_buf((const char *)data, EASYFLASH_CHIP_SIZE));
+        if (fwrite(record, 1, 1, fd) < 1
+            || fwrite(data, EASYFLASH_CHIP_SIZE, 1, fd) < 1
+            || fwrite(record + 1, 4, 1, fd) < 1) {
+            goto fail;
+        }
+    }
+    record[0] = EASYFLASH_JOURNAL_END;
+    record[1] = (uint8_t)num;
+    if (fwrite(record, 2, 1, fd) < 1) {
+        goto fail;
+    }
+    return fclose(fd) == 0 ? 0 : -1;
+
+fail:
+    fclose(fd);
+    return -1;
+}
+
+/* Write the whole image to a new file which then replaces the old one. */
+static int write_back_rewrite(easyflash_write_back_t *wb, int optimize)
+{
+    crt_chip_header_t chip;
+    char *tmp_name;
+    FILE *fd;
+    long offset[EASYFLASH_N_CHIPS];
+    int i;
+
+    tmp_name = util_concat(wb->filename, ".tmp", NULL);
+    fd = crt_create(tmp_name, CARTRIDGE_EASYFLASH, 1, 0, STRING_EASYFLASH);
+    if (fd == NULL) {
+        lib_free(tmp_name);
+        return -1;
+    }
+
+    chip.type = 2;
+    chip.size = EASYFLASH_CHIP_SIZE;
+    for (i = 0; i < EASYFLASH_N_CHIPS; i++) {
+        uint8_t *data = wb->image + i * EASYFLASH_CHIP_SIZE;
+
+        offset[i] = -1;
+        if (optimize && chip_is_empty(data)) {
+            continue;
+        }
+        chip.bank = (uint16_t)(i >> 1);
+        chip.start = (i & 1) ? 0xa000 : 0x8000;
+        offset[i] = ftell(fd) + 0x10;
+        if (crt_write_chip(data, &chip, fd) != 0) {
+            fclose(fd);
+            archdep_remove(tmp_name);
+            lib_free(tmp_name);
+            return -1;
+        }
+    }
+    if (fclose(fd) != 0) {
+        archdep_remove(tmp_name);
+        lib_free(tmp_name);
+        return -1;
+    }
+
+    write_back_close(wb);
+    /* rename() does not replace existing files everywhere */
+    if (archdep_rename(tmp_name, wb->filename) != 0
+        && (archdep_remove(wb->filename) != 0 || archdep_rename(tmp_name, wb->filename) != 0)) {
+        lib_free(tmp_name);
+        return -1;
+    }
+    lib_free(tmp_name);
+
+    memcpy(wb->offset, offset, sizeof(offset));
+    wb->fd = fopen(wb->filename, MODE_READ_WRITE);
+    return wb->fd != NULL ? 0 : -1;
+}
+
+/* Write the pending chips to the image. Called without the lock held, on
+   the writer thread if there is one. */
+static void write_back_process(easyflash_write_back_t *wb)
+{
+    int i, num = 0, rewrite = 0, optimize, result;
+
+    WB_LOCK(wb);
+    for (i = 0; i < EASYFLASH_N_CHIPS; i++) {
+        if (wb->pending[i]) {
+            memcpy(wb->image + i * EASYFLASH_CHIP_SIZE, wb->staging + i * EASYFLASH_CHIP_SIZE, EASYFLASH_CHIP_SIZE);
+            wb->pending[i] = 0;
+            wb->batch[num++] = i;
+        }
+    }
+    wb->num_pending = 0;
+    optimize = wb->optimize;
+    WB_UNLOCK(wb);
+
+    if (num == 0) {
+        return;
+    }
+
+    result = write_back_open(wb);
+    if (result == 0) {
+        int n = 0;
+
+        /* a chip which is not in the file yet only has to be added if it
+           is not empty */
+        for (i = 0; i < num; i++) {
+            int c = wb->batch[i];
+
+            if (wb->offset[c] >= 0) {
+                wb->batch[n++] = c;
+            } else if (!chip_is_empty(wb->image + c * EASYFLASH_CHIP_SIZE)) {
+                rewrite = 1;
+            }
+        }
+        if (rewrite) {
+            result = write_back_rewrite(wb, optimize);
+        } else if (n > 0) {
+            result = write_back_journal(wb, n);
+            for (i = 0; i < n && result == 0; i++) {
+                int c = wb->batch[i];
+
+                if (fseek(wb->fd, wb->offset[c], SEEK_SET) != 0
+                    || fwrite(wb->image + c * EASYFLASH_CHIP_SIZE, EASYFLASH_CHIP_SIZE, 1, wb->fd) < 1) {
+                    result = -1;
+                }
+            }
+            if (result == 0 && fflush(wb->fd) == 0) {
+                archdep_remove(wb->journal_name);
+            } else {
+                result = -1;
+            }
+        }
+    }
+
+    if (result < 0) {
+        WB_LOCK(wb);
+        if (!wb->error) {
+            log_error(LOG_DEFAULT, "EF: could not write back to '%s', it will be saved as a whole on detach.", wb->filename);
+        }
+        wb->error = 1;
+        WB_UNLOCK(wb);
+    }
+}
+
+#ifdef USE_VICE_THREAD
+static void *write_back_thread(void *arg)
+{
+    easyflash_write_back_t *wb = arg;
+
+    pthread_mutex_lock(&wb->lock);
+    while (!wb->quit) {
+        if (wb->num_pending > 0) {
+            wb->busy = 1;
+            pthread_mutex_unlock(&wb->lock);
+            write_back_process(wb);
+            pthread_mutex_lock(&wb->lock);
+            wb->busy = 0;
+            pthread_cond_broadcast(&wb->done_cond);
+        } else {
+            pthread_cond_wait(&wb->work_cond, &wb->lock);
+        }
+    }
+    pthread_mutex_unlock(&wb->lock);
+    return NULL;
+}
+#endif
+
+/* Wait until the writer is done with everything collected so far. */
+static void write_back_wait(easyflash_write_back_t *wb)
+{
+#ifdef USE_VICE_THREAD
+    pthread_mutex_lock(&wb->lock);
+    while (wb->busy || wb->num_pending > 0) {
+        pthread_cond_wait(&wb->done_cond, &wb->lock);
+    }
+    pthread_mutex_unlock(&wb->lock);
+#endif
+}
+
+/* Hand the chips changed since the last call to the writer. */
+static void write_back_collect(easyflash_write_back_t *wb)
+{
+    int i, num = 0;
+
+    WB_LOCK(wb);
+    for (i = 0; i < EASYFLASH_N_CHIPS; i++) {
+        flash040_context_t *flash = (i & 1) ? easyflash_state_high : easyflash_state_low;
+
+        if (flash040core_clear_dirty_bank(flash, (unsigned int)(i >> 1))) {
+            memcpy(wb->staging + i * EASYFLASH_CHIP_SIZE, flash->flash_data + (i >> 1) * EASYFLASH_CHIP_SIZE, EASYFLASH_CHIP_SIZE);
+            if (!wb->pending[i]) {
+                wb->pending[i] = 1;
+                wb->num_pending++;
+            }
+            num++;
+        }
+    }
+    wb->optimize = easyflash_crt_optimize;
+    WB_UNLOCK(wb);
+
+    if (num == 0) {
+        return;
+    }
+#ifdef USE_VICE_THREAD
+    if (!wb->thread_started) {
+        wb->thread_started = (pthread_create(&wb->thread, NULL, write_back_thread, wb) == 0);
+    }
+    if (wb->thread_started) {
+        pthread_mutex_lock(&wb->lock);
+        pthread_cond_signal(&wb->work_cond);
+        pthread_mutex_unlock(&wb->lock);
+        return;
+    }
+#endif
+    write_back_process(wb);
+}
+
+/* Write a journal left behind by a crash to the image and to rawcart. */
+static void write_back_replay(easyflash_write_back_t *wb, uint8_t *rawcart)
+{
+    uint8_t magic[4], record[5];
+    FILE *fd;
+    int num = 0, complete = 0, i;
+
+    fd = fopen(wb->journal_name, MODE_READ);
+    if (fd == NULL) {
+        return;
+    }
+
+    if (fread(magic, 4, 1, fd) == 1 && memcmp(magic, EASYFLASH_JOURNAL_MAGIC, 4) == 0) {
+        while (num < EASYFLASH_N_CHIPS && fread(record, 1, 1, fd) == 1) {
+            if (record[0] == EASYFLASH_JOURNAL_END) {
+                complete = (fread(record, 1, 1, fd) == 1 && record[0] == num);
+                break;
+            }
+            if (record[0] >= EASYFLASH_N_CHIPS
+                || fread(wb->staging + num * EASYFLASH_CHIP_SIZE, EASYFLASH_CHIP_SIZE, 1, fd) < 1
+                || fread(record + 1, 4, 1, fd) < 1
+                || crc32_from_le(record + 1) != crc32_buf((const char *)(wb->staging + num * EASYFLASH_CHIP_SIZE), EASYFLASH_CHIP_SIZE)) {
+                break;
+            }
+            wb->batch[num++] = record[0];
+        }
+    }
+    fclose(fd);
+
+    if (!complete) {
+        /* the crash came before the image was touched */
+        log_warning(LOG_DEFAULT, "EF: discarding incomplete journal '%s'.", wb->journal_name);
+        archdep_remove(wb->journal_name);
+        return;
+    }
+
+    if (write_back_open(wb) == 0) {
+        for (i = 0; i < num; i++) {
+            int c = wb->batch[i];
+            uint8_t *data = wb->staging + i * EASYFLASH_CHIP_SIZE;
+
+            memcpy(rawcart + c * EASYFLASH_CHIP_SIZE, data, EASYFLASH_CHIP_SIZE);
+            if (wb->offset[c] < 0
+                || fseek(wb->fd, wb->offset[c], SEEK_SET) != 0
+                || fwrite(data, EASYFLASH_CHIP_SIZE, 1, wb->fd) < 1) {
+                wb->error = 1;
+            }
+        }
+        if (fflush(wb->fd) != 0) {
+            wb->error = 1;
+        }
+    } else {
+        wb->error = 1;
+    }
+
+    if (wb->error) {
+        /* keep the journal, the chips are in rawcart and will be saved with
+           the whole image on detach */
+        log_error(LOG_DEFAULT, "EF: could not write journal '%s' back to the image.", wb->journal_name);
+    } else {
+        log_message(LOG_DEFAULT, "EF: recovered %d chips from journal '%s'.", num, wb->journal_name);
+        archdep_remove(wb->journal_name);
+    }
+}
+
+static void write_back_alarm_handler(CLOCK offset, void *data)
+{
+    alarm_unset(easyflash_wb_alarm);
+    easyflash_wb_alarm_pending = 0;
+
+    if (easyflash_wb == NULL) {
+        return;
+    }
+    write_back_collect(easyflash_wb);
+
+    /* an erase in progress changes the flash later on */
+    if (easyflash_state_low->flash_state != easyflash_state_low->flash_base_state
+        || easyflash_state_high->flash_state != easyflash_state_high->flash_base_state) {
+        alarm_set(easyflash_wb_alarm, maincpu_clk + EASYFLASH_WRITE_BACK_DELAY);
+        easyflash_wb_alarm_pending = 1;
+    }
+}
+
+static void easyflash_write_back_schedule(void)
+{
+    if (easyflash_wb != NULL && easyflash_crt_write && !easyflash_wb_alarm_pending) {
+        alarm_set(easyflash_wb_alarm, maincpu_clk + EASYFLASH_WRITE_BACK_DELAY);
+        easyflash_wb_alarm_pending = 1;
+    }
+}
+
+static void easyflash_write_back_open(const char *filename, int filetype, uint8_t *rawcart)
+{
+    easyflash_write_back_t *wb = lib_calloc(1, sizeof(easyflash_write_back_t));
+
+    wb->filename = lib_strdup(filename);
+    wb->journal_name = util_concat(filename, ".journal", NULL);
+    wb->filetype = filetype;
+    wb->image = lib_malloc(EASYFLASH_N_CHIPS * EASYFLASH_CHIP_SIZE);
+    wb->staging = lib_malloc(EASYFLASH_N_CHIPS * EASYFLASH_CHIP_SIZE);
+#ifdef USE_VICE_THREAD
+    pthread_mutex_init(&wb->lock, NULL);
+    pthread_cond_init(&wb->work_cond, NULL);
+    pthread_cond_init(&wb->done_cond, NULL);
+#endif
+
+    write_back_replay(wb, rawcart);
+    memcpy(wb->image, rawcart, EASYFLASH_N_CHIPS * EASYFLASH_CHIP_SIZE);
+
+    if (easyflash_wb_alarm == NULL) {
+        easyflash_wb_alarm = alarm_new(maincpu_alarm_context, "EasyFlashWriteBack", write_back_alarm_handler, NULL);
+    }
+    easyflash_wb = wb;
+}
+
+/* Write back all changes, returns -1 if the image could not be written
+   incrementally. */
+static int easyflash_write_back_flush(void)
+{
+    int error;
+
+    if (easyflash_wb == NULL) {
+        return -1;
+    }
+    write_back_collect(easyflash_wb);
+    write_back_wait(easyflash_wb);
+
+    WB_LOCK(easyflash_wb);
+    error = easyflash_wb->error;
+    WB_UNLOCK(easyflash_wb);
+
+    return error ? -1 : 0;
+}
+
+/* The image is about to be saved as a whole, find its chips again before
+   the next write back. */
+static void easyflash_write_back_reset(const char *filename)
+{
+    if (easyflash_wb != NULL && filename != NULL && strcmp(filename, easyflash_wb->filename) == 0) {
+        write_back_wait(easyflash_wb);
+        write_back_close(easyflash_wb);
+        archdep_remove(easyflash_wb->journal_name);
+        easyflash_wb->error = 0;
+    }
+}
+
+static void easyflash_write_back_close(void)
+{
+    easyflash_write_back_t *wb = easyflash_wb;
+
+    if (wb == NULL) {
+        return;
+    }
+    if (easyflash_wb_alarm != NULL) {
+        alarm_unset(easyflash_wb_alarm);
+        easyflash_wb_alarm_pending = 0;
+    }
+#ifdef USE_VICE_THREAD
+    if (wb->thread_started) {
+        pthread_mutex_lock(&wb->lock);
+        wb->quit = 1;
+        pthread_cond_signal(&wb->work_cond);
+        pthread_mutex_unlock(&wb->lock);
+        pthread_join(wb->thread, NULL);
+    }
+    pthread_mutex_destroy(&wb->lock);
+    pthread_cond_destroy(&wb->work_cond);
+    pthread_cond_destroy(&wb->done_cond);
+#endif
+    write_back_close(wb);
+    lib_free(wb->filename);
+    lib_free(wb->journal_name);
+    lib_free(wb->image);
+    lib_free(wb->staging);
+    lib_free(wb);
+    easyflash_wb = NULL;
+}
+
 /* ---------------------------------------------------------------------*/
 
 uint8_t easyflash_roml_read(uint16_t addr)
@@ -397,6 +968,7 @@ uint8_t easyflash_roml_read(uint16_t addr)
 void easyflash_roml_store(uint16_t addr, uint8_t value)
 {
     flash040core_store(easyflash_state_low, (easyflash_register_00 * 0x2000) + (addr & 0x1fff), value);
+    easyflash_write_back_schedule();
 }
 
 uint8_t easyflash_romh_read(uint16_t addr)
@@ -407,6 +979,7 @@ uint8_t easyflash_romh_read(uint16_t addr)
 void easyflash_romh_store(uint16_t addr, uint8_t value)
 {
     flash040core_store(easyflash_state_high, (easyflash_register_00 * 0x2000) + (addr & 0x1fff), value);
+    easyflash_write_back_schedule();
 }
 
 void easyflash_mmu_translate(unsigned int addr, uint8_t **base, int *start, int *limit)
@@ -537,7 +1110,11 @@ int easyflash_bin_attach(const char *filename, uint8_t *rawcart)
     }
 
     easyflash_filetype = CARTRIDGE_FILETYPE_BIN;
-    return easyflash_common_attach(filename);
+    if (easyflash_common_attach(filename) < 0) {
+        return -1;
+    }
+    easyflash_write_back_open(filename, easyflash_filetype, rawcart);
+    return 0;
 }
 
 int easyflash_crt_attach(FILE *fd, uint8_t *rawcart, const char *filename)
@@ -572,7 +1149,11 @@ int easyflash_crt_attach(FILE *fd, uint8_t *rawcart, const char *filename)
     }
 
     easyflash_filetype = CARTRIDGE_FILETYPE_CRT;
-    return easyflash_common_attach(filename);
+    if (easyflash_common_attach(filename) < 0) {
+        return -1;
+    }
+    easyflash_write_back_open(filename, easyflash_filetype, rawcart);
+    return 0;
 }
 
 void easyflash_detach(void)
@@ -580,6 +1161,7 @@ void easyflash_detach(void)
     if (easyflash_crt_write) {
         easyflash_flush_image();
     }
+    easyflash_write_back_close();
     flash040core_shutdown(easyflash_state_low);
     flash040core_shutdown(easyflash_state_high);
     lib_free(easyflash_state_low);
@@ -596,6 +1178,9 @@ void easyflash_detach(void)
 int easyflash_flush_image(void)
 {
     if (easyflash_filename != NULL) {
+        if (easyflash_write_back_flush() == 0) {
+            return 0;
+        }
         if (easyflash_filetype == CARTRIDGE_FILETYPE_BIN) {
             return easyflash_bin_save(easyflash_filename);
         } else if (easyflash_filetype == CARTRIDGE_FILETYPE_CRT) {
@@ -617,6 +1202,7 @@ int easyflash_bin_save(const char *filename)
         return -1;
     }
 
+    easyflash_write_back_reset(filename);
     fd = fopen(filename, MODE_WRITE);
 
     if (fd == NULL) {
@@ -644,6 +1230,7 @@ int easyflash_crt_save(const char *filename)
     uint8_t *data;
     int bank;
 
+    easyflash_write_back_reset(filename);
     fd = crt_create(filename, CARTRIDGE_EASYFLASH, 1, 0, STRING_EASYFLASH);
 
     if (fd == NULL) {
@@ -187,6 +187,16 @@ int georam_cart_enabled(void)
     return georam_enabled;
 }
 
+/* Let the I/O dispatch access the current window directly. Must be called
+   whenever the window registers or the RAM change. */
+static void georam_update_page(void)
+{
+    if (georam_io1_list_item != NULL) {
+        io_source_set_page(georam_io1_list_item,
+                           georam_ram ? &georam_ram[(georam[1] * 16384) + (georam[0] * 256)] : NULL);
+    }
+}
+
 static uint8_t georam_io1_read(uint16_t addr)
 {
     uint8_t retval;
@@ -223,6 +233,7 @@ static void georam_io2_store(uint16_t addr, uint8_t byte)
         }
         georam[0] = byte;
     }
+    georam_update_page();
 }
 
 static int georam_dump(void)
@@ -285,6 +296,7 @@ static int georam_activate(void)
                 return -1;
             }
             log_message(georam_log, "Creating GEORAM image %s.", georam_filename);
+            georam_update_page();
             return 0;
         }
         log_message(georam_log, "Reading GEORAM image %s.", georam_filename);
@@ -312,6 +324,7 @@ static int georam_deactivate(void)
     lib_free(georam_ram);
     georam_ram = NULL;
     old_georam_ram_size = 0;
+    georam_update_page();
 
     return 0;
 }
@@ -354,6 +367,7 @@ static int set_georam_enabled(int value, void *param)
         }
         georam_io1_list_item = io_source_register(&georam_io1_device);
         georam_io2_list_item = io_source_register(&georam_io2_device);
+        georam_update_page();
         georam_enabled = 1;
     }
     return 0;
@@ -545,6 +559,7 @@ void georam_reset(void)
 {
     georam[0] = 0;
     georam[1] = 0;
+    georam_update_page();
 }
 
 void georam_detach(void)
@@ -711,6 +726,7 @@ int georam_read_snapshot_module(snapshot_t *s)
     if (SMR_BA(m, georam, sizeof(georam)) < 0 || SMR_BA(m, georam_ram, georam_size) < 0) {
         goto fail;
     }
+    georam_update_page();
 
     snapshot_module_close(m);
     georam_enabled = 1;
@@ -151,6 +151,26 @@ uint8_t ocean_romh_read(uint16_t addr)
     return roml_banks[(addr & 0x1fff) + (roml_bank << 13)];
 }
 
+void ocean_mmu_translate(unsigned int addr, uint8_t **base, int *start, int *limit)
+{
+    switch (addr & 0xe000) {
+        case 0xa000:
+            *base = &roml_banks[roml_bank << 13] - 0xa000;
+            *start = 0xa000;
+            *limit = 0xbffd;
+            break;
+        case 0x8000:
+            *base = &roml_banks[roml_bank << 13] - 0x8000;
+            *start = 0x8000;
+            *limit = 0x9ffd;
+            break;
+        default:
+            *base = NULL;
+            *start = 0;
+            *limit = 0;
+    }
+}
+
 void ocean_config_init(void)
 {
     ocean_io1_store((uint16_t)0xde00, 0);
@@ -38,6 +38,7 @@ int ocean_crt_attach(FILE *fd, uint8_t *rawcart);
 void ocean_detach(void);
 
 uint8_t ocean_romh_read(uint16_t addr);
+void ocean_mmu_translate(unsigned int addr, uint8_t **base, int *start, int *limit);
 
 struct snapshot_s;
 
@@ -43,6 +43,7 @@
 #include "lib.h"
 #include "log.h"
 #include "machine.h"
+#include "maincpu.h"
 #include "mem.h"
 #include "monitor.h"
 #include "ram.h"
@@ -218,6 +219,16 @@ int ramcart_cart_enabled(void)
     return ramcart_enabled;
 }
 
+/* Let the I/O dispatch access the current window directly. Must be called
+   whenever the window registers or the RAM change. */
+static void ramcart_update_page(void)
+{
+    if (ramcart_io2_list_item != NULL) {
+        io_source_set_page(ramcart_io2_list_item,
+                           ramcart_ram ? &ramcart_ram[((ramcart[1] & 1) << 16) + (ramcart[0] * 256)] : NULL);
+    }
+}
+
 static uint8_t ramcart_io1_peek(uint16_t addr)
 {
     return ramcart[addr];
@@ -248,6 +259,11 @@ static void ramcart_io1_store(uint16_t addr, uint8_t byte)
     if (addr == 0) {
         ramcart[0] = byte;
     }
+    ramcart_update_page();
+    if (ramcart_readonly && ramcart_size_kb == 128) {
+        /* the CPU may be executing from the old window at $8000 */
+        maincpu_resync_limits();
+    }
 }
 
 static uint8_t ramcart_io2_read(uint16_t addr)
@@ -331,6 +347,7 @@ static int ramcart_activate(void)
                     return -1;
                 }
                 log_message(ramcart_log, "Creating RAMCART image %s.", ramcart_filename);
+                ramcart_update_page();
                 return 0;
             }
         }
@@ -359,6 +376,7 @@ static int ramcart_deactivate(void)
     lib_free(ramcart_ram);
     ramcart_ram = NULL;
     old_ramcart_ram_size = 0;
+    ramcart_update_page();
 
     return 0;
 }
@@ -377,6 +395,7 @@ static int set_ramcart_enabled(int value, void *param)
         }
         ramcart_io1_list_item = io_source_register(&ramcart_io1_device);
         ramcart_io2_list_item = io_source_register(&ramcart_io2_device);
+        ramcart_update_page();
         ramcart_enabled = 1;
         if (machine_class == VICE_MACHINE_C128) {
             ramcart_exrom_check();
@@ -587,6 +606,7 @@ void ramcart_reset(void)
 {
     ramcart[0] = 0;
     ramcart[1] = 0;
+    ramcart_update_page();
 }
 
 void ramcart_config_setup(uint8_t *rawcart)
@@ -780,6 +800,7 @@ int ramcart_snapshot_read_module(snapshot_t *s)
         ramcart_enabled = 0;
         return -1;
     }
+    ramcart_update_page();
 
     return 0;
 
@@ -56,6 +56,7 @@
 #include "machine.h"
 #include "maincpu.h"
 #include "mem.h"
+#include "monitor.h"
 #include "ram.h"
 #include "resources.h"
 #include "snapshot.h"
@@ -1223,6 +1224,290 @@ static void reu_dma_update_regs(uint16_t host_addr, unsigned int reu_addr, int l
     }
 }
 
+/*! \brief find how many bytes of a DMA operation fit before the next alarm
+  A span of the transfer can be done without going through the alarm and
+  memory dispatch for every byte, if no alarm becomes due during it and the
+  host memory can be accessed directly.
+
+  \param len
+    The remaining transfer length of the operation
+
+  \param cycles
+    The number of cycles each byte takes
+
+  \return
+    The number of bytes that can be transferred before an alarm is due,
+    or 0 if the next byte has to be done the slow way.
+
+  \remark
+    On x64sc the VIC-II is clocked for every DMA cycle, so there is no
+    such span.
+*/
+static int reu_dma_span_max(int len, int cycles)
+{
+    CLOCK next_alarm_clk;
+    CLOCK free_cycles;
+
+    if (reu_ba.enabled || (monitor_mask[e_comp_space] & MI_WATCH)) {
+        return 0;
+    }
+
+    /* the alarms are handled after the clock is incremented for a byte */
+    next_alarm_clk = alarm_context_next_pending_clk(maincpu_alarm_context);
+    if (next_alarm_clk <= maincpu_clk + 1) {
+        return 0;
+    }
+    free_cycles = next_alarm_clk - maincpu_clk - 1;
+    if (free_cycles / (CLOCK)cycles < (CLOCK)len) {
+        len = (int)(free_cycles / (CLOCK)cycles);
+    }
+    return len;
+}
+
+/*! \brief find how many bytes of a DMA operation can be read in one go
+  The host memory of the span is read directly, the same way the CPU
+  fetches opcodes.
+
+  \param host_addr
+    The host (computer) address where the span starts
+
+  \param host_step
+    The increment to use for the host address; must be either 0 or 1
+
+  \param span
+    The span found by reu_dma_span_max()
+
+  \param host_base
+    Set to the base pointer the host memory of the span can be read through
+
+  \return
+    The number of bytes that can be read in one go, or 0 if the next byte
+    has to be done the slow way.
+*/
+static int reu_dma_host_read_span(uint16_t host_addr, int host_step, int span, uint8_t **host_base)
+{
+    uint8_t *base;
+    int start, limit;
+
+    if (span <= 0) {
+        return 0;
+    }
+
+    /* Pages 0 and 1 are left to mem_dma_read(): $00/$01 is the CPU port,
+       page 0 goes through zero_read_dma() and on the C128 both pages may
+       come from another RAM bank than the one mem_mmu_translate() returns. */
+    if (host_addr < 0x200) {
+        return 0;
+    }
+    mem_mmu_translate(host_addr, &base, &start, &limit);
+    if (base == NULL || host_addr < start || host_addr >= limit) {
+        return 0;
+    }
+    if (host_step && (limit - host_addr) < span) {
+        span = limit - host_addr;
+    }
+    /* nor may the span wrap around into them */
+    if (host_step && (0x10000 - host_addr) < span) {
+        span = 0x10000 - host_addr;
+    }
+
+    /* The last byte is left to mem_dma_read() as well, so the state the
+       read handlers leave behind, like vicii.last_cpu_val on the C128, is
+       the same as after reading byte by byte. Nothing can look at it in
+       between, as no alarm is due during the span. */
+    span--;
+
+    *host_base = base;
+    return span;
+}
+
+/*! \brief find how many bytes of a DMA operation can be written in one go
+  The span only covers pages that mem_dma_write_base() maps to plain RAM,
+  I/O and the pages with side effects are written byte by byte.
+
+  \param host_addr
+    The host (computer) address where the span starts
+
+  \param host_step
+    The increment to use for the host address; must be either 0 or 1
+
+  \param span
+    The span found by reu_dma_span_max()
+
+  \param host_base
+    Set to the base pointer the host memory of the span can be written through
+
+  \return
+    The number of bytes that can be written in one go, or 0 if the next
+    byte has to be done the slow way.
+*/
+static int reu_dma_host_write_span(uint16_t host_addr, int host_step, int span, uint8_t **host_base)
+{
+    uint8_t *base;
+    unsigned int end;
+
+    /* pages 0 and 1 are left to mem_dma_store(), as for reading */
+    if (span <= 0 || host_addr < 0x200) {
+        return 0;
+    }
+    base = mem_dma_write_base(host_addr);
+    if (base == NULL) {
+        return 0;
+    }
+    if (host_step) {
+        /* the following pages as long as they map to the same RAM */
+        end = (host_addr | 0xffu) + 1;
+        while (end - host_addr < (unsigned int)span && end < 0x10000
+               && mem_dma_write_base((uint16_t)end) == base) {
+            end += 0x100;
+        }
+        if (end - host_addr < (unsigned int)span) {
+            span = (int)(end - host_addr);
+        }
+    }
+
+    *host_base = base;
+    return span;
+}
+
+/*! \brief check if a span of REU addresses maps to one block of REU RAM
+
+  \param reu_addr
+    The REU address where the span starts
+
+  \param len
+    The length of the span, the REU address incrementing by 1
+
+  \return
+    The offset of the span in reu_ram, or -1 if it wraps around or is not
+    completely backed up by DRAM.
+*/
+static int reu_contiguous_ram(unsigned int reu_addr, int len)
+{
+    unsigned int offset = reu_addr & (rec_options.dram_wrap_around - 1);
+
+    if ((reu_addr & 0x0007ffff) + (unsigned int)len - 1 < rec_options.wrap_around
+        && offset + (unsigned int)len <= rec_options.dram_wrap_around
+        && offset + (unsigned int)len <= rec_options.not_backedup_addresses) {
+        return (int)offset;
+    }
+    return -1;
+}
+
+/*! \brief copy a span found by reu_dma_host_read_span() from the host to the REU
+
+  \return
+    The last byte copied
+*/
+static uint8_t reu_dma_host_to_reu_span(const uint8_t *host_base, uint16_t *host_addr, unsigned int *reu_addr, int host_step, int reu_step, int span)
+{
+    uint16_t host = *host_addr;
+    unsigned int reu = *reu_addr;
+    uint8_t value;
+    int offset;
+
+    if (reu_step && (offset = reu_contiguous_ram(reu, span)) >= 0) {
+        if (host_step) {
+            memcpy(reu_ram + offset, host_base + host, (size_t)span);
+        } else {
+            memset(reu_ram + offset, host_base[host], (size_t)span);
+        }
+        value = host_base[host + (host_step ? span - 1 : 0)];
+        *host_addr = (host + (host_step ? span : 0)) & 0xffff;
+        *reu_addr = increment_reu_with_wrap_around(reu + (unsigned int)span - 1, 1);
+        return value;
+    }
+
+    do {
+        value = host_base[host];
+        store_to_reu(reu, value);
+        host = (host + host_step) & 0xffff;
+        reu = increment_reu_with_wrap_around(reu, reu_step);
+    } while (--span);
+
+    *host_addr = host;
+    *reu_addr = reu;
+    return value;
+}
+
+/*! \brief copy a span found by reu_dma_host_write_span() from the REU to the host
+
+  \return
+    The last byte copied
+*/
+static uint8_t reu_dma_reu_to_host_span(uint8_t *host_base, uint16_t *host_addr, unsigned int *reu_addr, int host_step, int reu_step, int span)
+{
+    uint16_t host = *host_addr;
+    unsigned int reu = *reu_addr;
+    uint8_t value;
+    int offset;
+
+    if (reu_step && (offset = reu_contiguous_ram(reu, span)) >= 0) {
+        if (host_step) {
+            memcpy(host_base + host, reu_ram + offset, (size_t)span);
+        } else {
+            host_base[host] = reu_ram[offset + span - 1];
+        }
+        value = reu_ram[offset + span - 1];
+        *host_addr = (host + (host_step ? span : 0)) & 0xffff;
+        *reu_addr = increment_reu_with_wrap_around(reu + (unsigned int)span - 1, 1);
+        return value;
+    }
+
+    do {
+        /* the bus latch is what reads beyond the DRAM return */
+        floating_bus_value = value = read_from_reu(reu);
+        host_base[host] = value;
+        host = (host + host_step) & 0xffff;
+        reu = increment_reu_with_wrap_around(reu, reu_step);
+    } while (--span);
+
+    *host_addr = host;
+    *reu_addr = reu;
+    return value;
+}
+
+/*! \brief swap a span that is both readable and writable through host_base */
+static void reu_dma_swap_span(uint8_t *host_base, uint16_t *host_addr, unsigned int *reu_addr, int host_step, int reu_step, int span)
+{
+    uint16_t host = *host_addr;
+    unsigned int reu = *reu_addr;
+    uint8_t value_from_reu;
+
+    do {
+        value_from_reu = read_from_reu(reu);
+        store_to_reu(reu, host_base[host]);
+        host_base[host] = value_from_reu;
+        host = (host + host_step) & 0xffff;
+        reu = increment_reu_with_wrap_around(reu, reu_step);
+    } while (--span);
+
+    *host_addr = host;
+    *reu_addr = reu;
+}
+
+/*! \brief compare a span found by reu_dma_host_read_span() up to the first difference
+
+  \return
+    The number of equal bytes at the start of the span
+*/
+static int reu_dma_compare_span(const uint8_t *host_base, uint16_t *host_addr, unsigned int *reu_addr, int host_step, int reu_step, int span)
+{
+    uint16_t host = *host_addr;
+    unsigned int reu = *reu_addr;
+    int equal = 0;
+
+    while (equal < span && host_base[host] == read_from_reu(reu)) {
+        host = (host + host_step) & 0xffff;
+        reu = increment_reu_with_wrap_around(reu, reu_step);
+        equal++;
+    }
+
+    *host_addr = host;
+    *reu_addr = reu;
+    return equal;
+}
+
 /*! \brief DMA operation writing from the host to the REU
 
   \param host_addr
@@ -1243,6 +1528,8 @@ static void reu_dma_update_regs(uint16_t host_addr, unsigned int reu_addr, int l
 static void reu_dma_host_to_reu(uint16_t host_addr, unsigned int reu_addr, int host_step, int reu_step, int len)
 {
     uint8_t value;
+    uint8_t *host_base;
+    int span;
     DEBUG_LOG(DEBUG_LEVEL_TRANSFER_HIGH_LEVEL, (reu_log, "copy ext $%05X %s<= main $%04X%s, $%04X (%d) bytes.",
                                                 reu_addr, reu_step ? "" : "(fixed) ", host_addr, host_step ? "" : " (fixed)", len, len));
 
@@ -1251,6 +1538,14 @@ static void reu_dma_host_to_reu(uint16_t host_addr, unsigned int reu_addr, int h
     assert(len >= 1);
 
     while (len) {
+        span = reu_dma_host_read_span(host_addr, host_step, reu_dma_span_max(len, 1), &host_base);
+        if (span > 0) {
+            value = reu_dma_host_to_reu_span(host_base, &host_addr, &reu_addr, host_step, reu_step, span);
+            maincpu_clk += span;
+            len -= span;
+            continue;
+        }
+
         nonsc_reu_clk_inc_pre();
         machine_handle_pending_alarms(0);
         value = mem_dma_read(host_addr);
@@ -1288,6 +1583,8 @@ static void reu_dma_host_to_reu(uint16_t host_addr, unsigned int reu_addr, int h
 static void reu_dma_reu_to_host(uint16_t host_addr, unsigned int reu_addr, int host_step, int reu_step, int len)
 {
     uint8_t value;
+    uint8_t *host_base;
+    int span;
     DEBUG_LOG(DEBUG_LEVEL_TRANSFER_HIGH_LEVEL, (reu_log, "copy ext $%05X %s=> main $%04X%s, $%04X (%d) bytes.",
                                                 reu_addr, reu_step ? "" : "(fixed) ", host_addr, host_step ? "" : " (fixed)", len, len));
 
@@ -1296,6 +1593,14 @@ static void reu_dma_reu_to_host(uint16_t host_addr, unsigned int reu_addr, int h
     assert(len >= 1);
 
     while (len) {
+        span = reu_dma_host_write_span(host_addr, host_step, reu_dma_span_max(len, 1), &host_base);
+        if (span > 0) {
+            floating_bus_value = reu_dma_reu_to_host_span(host_base, &host_addr, &reu_addr, host_step, reu_step, span);
+            maincpu_clk += span;
+            len -= span;
+            continue;
+        }
+
         DEBUG_LOG(DEBUG_LEVEL_TRANSFER_LOW_LEVEL, (reu_log, "Transferring byte: %x from ext $%05X to main $%04X.", reu_ram[reu_addr % reu_size], reu_addr, host_addr));
         nonsc_reu_clk_inc_pre();
         /* after a transfer from REU to host, the last (pre)fetched value from valid
@@ -1342,6 +1647,9 @@ static void reu_dma_swap(uint16_t host_addr, unsigned int reu_addr, int host_ste
 {
     uint8_t value_from_reu;
     uint8_t value_from_c64;
+    uint8_t *host_base;
+    uint8_t *host_write_base;
+    int span;
     DEBUG_LOG(DEBUG_LEVEL_TRANSFER_HIGH_LEVEL, (reu_log, "swap ext $%05X %s<=> main $%04X%s, $%04X (%d) bytes.",
                                                 reu_addr, reu_step ? "" : "(fixed) ", host_addr, host_step ? "" : " (fixed)", len, len));
 
@@ -1350,6 +1658,16 @@ static void reu_dma_swap(uint16_t host_addr, unsigned int reu_addr, int host_ste
     assert(len >= 1);
 
     while (len) {
+        /* two cycles per byte, the host memory has to be RAM both ways */
+        span = reu_dma_host_read_span(host_addr, host_step, reu_dma_span_max(len, 2), &host_base);
+        span = reu_dma_host_write_span(host_addr, host_step, span, &host_write_base);
+        if (span > 0 && host_write_base == host_base) {
+            reu_dma_swap_span(host_base, &host_addr, &reu_addr, host_step, reu_step, span);
+            maincpu_clk += 2 * (CLOCK)span;
+            len -= span;
+            continue;
+        }
+
         value_from_reu = read_from_reu(reu_addr);
         nonsc_reu_clk_inc_pre();
         machine_handle_pending_alarms(0);
@@ -1394,6 +1712,8 @@ static void reu_dma_compare(uint16_t host_addr, unsigned int reu_addr, int host_
 {
     uint8_t value_from_reu;
     uint8_t value_from_c64;
+    uint8_t *host_base;
+    int span;
 
     uint8_t new_status_or_mask = 0;
 
@@ -1410,6 +1730,17 @@ static void reu_dma_compare(uint16_t host_addr, unsigned int reu_addr, int host_
     /* rec.status &= ~ (REU_REG_R_STATUS_VERIFY_ERROR | REU_REG_R_STATUS_END_OF_BLOCK); */
 
     while (len) {
+        span = reu_dma_host_read_span(host_addr, host_step, reu_dma_span_max(len, 1), &host_base);
+        if (span > 0) {
+            /* the equal bytes are done here, a difference the slow way */
+            span = reu_dma_compare_span(host_base, &host_addr, &reu_addr, host_step, reu_step, span);
+            maincpu_clk += span;
+            len -= span;
+            if (span > 0) {
+                continue;
+            }
+        }
+
         nonsc_reu_clk_inc_pre();
         machine_handle_pending_alarms(0);
         value_from_reu = read_from_reu(reu_addr);
@@ -290,7 +290,7 @@ static int rrnetmk3_dump(void)
 
 /* ---------------------------------------------------------------------*/
 
-int rrnetmk3_roml_read(uint16_t addr)
+uint8_t rrnetmk3_roml_read(uint16_t addr)
 {
     if (!rrnetmk3_biossel) {
         return rrnetmk3_bios[(addr & 0x1fff) + rrnetmk3_bios_offset];
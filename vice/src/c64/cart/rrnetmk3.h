@@ -38,7 +38,7 @@
 
 int rrnetmk3_cart_enabled(void);
 void rrnetmk3_config_init(void);
-int rrnetmk3_roml_read(uint16_t addr);
+uint8_t rrnetmk3_roml_read(uint16_t addr);
 int rrnetmk3_roml_store(uint16_t addr, uint8_t byte);
 int rrnetmk3_peek_mem(export_t *export, uint16_t addr, uint8_t *value);
 
@@ -267,6 +267,7 @@ typedef struct io_source_list_s {
     struct io_source_list_s *previous;
     io_source_t *device;
     struct io_source_list_s *next;
+    uint8_t *page; /*!< memory read and written by the device, see io_source_set_page() */
 } io_source_list_t;
 
 typedef struct io_source_detach_s {
@@ -280,6 +281,14 @@ typedef struct io_source_detach_s {
 io_source_list_t *io_source_register(io_source_t *device);
 void io_source_unregister(io_source_list_t *device);
 
+/* Devices whose range is a plain window into their memory, like the RAM page
+   of the GEORAM, can give the I/O dispatch a pointer to the current window.
+   As long as no other device shares the range, reads and writes then access
+   page[addr & address_mask] without calling the device. The device has to
+   set the pointer again whenever its window moves, and NULL to go back to
+   its callbacks. Used by the C64/C128 and VIC-20 I/O dispatch. */
+void io_source_set_page(io_source_list_t *device, uint8_t *page);
+
 void cartio_shutdown(void);
 
 void c64io_vicii_init(void);
@@ -45,6 +45,9 @@
 
 export_list_t cbm2export_head = { NULL, NULL, NULL };
 
+/* changes whenever a device is added or removed */
+unsigned int export_generation = 0;
+
 export_list_t *export_query_list(export_list_t *item)
 {
     if (item) {
@@ -109,6 +112,7 @@ int export_add(const export_resource_t *export_res)
     newentry->previous = current;
     newentry->device = (export_resource_t *)export_res;
     newentry->next = NULL;
+    export_generation++;
 
     return 0;
 }
@@ -133,6 +137,7 @@ int export_remove(const export_resource_t *export_res)
                     current->next->previous = prev;
                 }
                 lib_free(current);
+                export_generation++;
                 return 0;
             }
         }
@@ -65,14 +65,14 @@ static unsigned int order = 0;
 
 /* ---------------------------------------------------------------------------------------------------------- */
 
-static io_source_list_t cbm2io_d800_head = { NULL, NULL, NULL };
-static io_source_list_t cbm2io_d900_head = { NULL, NULL, NULL };
-static io_source_list_t cbm2io_da00_head = { NULL, NULL, NULL };
-static io_source_list_t cbm2io_db00_head = { NULL, NULL, NULL };
-static io_source_list_t cbm2io_dc00_head = { NULL, NULL, NULL };
-static io_source_list_t cbm2io_dd00_head = { NULL, NULL, NULL };
-static io_source_list_t cbm2io_de00_head = { NULL, NULL, NULL };
-static io_source_list_t cbm2io_df00_head = { NULL, NULL, NULL };
+static io_source_list_t cbm2io_d800_head = { NULL, NULL, NULL, NULL };
+static io_source_list_t cbm2io_d900_head = { NULL, NULL, NULL, NULL };
+static io_source_list_t cbm2io_da00_head = { NULL, NULL, NULL, NULL };
+static io_source_list_t cbm2io_db00_head = { NULL, NULL, NULL, NULL };
+static io_source_list_t cbm2io_dc00_head = { NULL, NULL, NULL, NULL };
+static io_source_list_t cbm2io_dd00_head = { NULL, NULL, NULL, NULL };
+static io_source_list_t cbm2io_de00_head = { NULL, NULL, NULL, NULL };
+static io_source_list_t cbm2io_df00_head = { NULL, NULL, NULL, NULL };
 
 static void io_source_detach(io_source_detach_t *source)
 {
@@ -463,6 +463,7 @@ io_source_list_t *io_source_register(io_source_t *device)
     retval->previous = current;
     retval->device = device;
     retval->next = NULL;
+    retval->page = NULL;
     retval->device->order = order++;
 
     return retval;
@@ -37,6 +37,7 @@
 #include "archdep.h"
 #include "log.h"
 #include "ata.h"
+#include "blockio.h"
 #include "snapshot.h"
 #include "types.h"
 #include "util.h"
@@ -79,6 +80,7 @@ struct ata_drive_s {
     int bufp;
     uint8_t *buffer;
     FILE *file;
+    blockio_t *bio;
     char *filename;
     char *myname;
     ata_drive_geometry_t geometry;
@@ -247,13 +249,24 @@ static int seek_sector(ata_drive_t *drv)
     drv->busy |= 2;
     alarm_set(drv->head_alarm, maincpu_clk + (CLOCK)(abs(drv->pos - lba) * drv->seek_time / drv->geometry.size));
     ata_change_power_mode(drv, 0xff);
-    if (archdep_fseeko(drv->file, (off_t)lba * drv->sector_size, SEEK_SET)) {
-        drv->error = drv->atapi ? 0x54 : ATA_IDNF;
-    }
     drv->pos = lba;
     return drv->error;
 }
 
+/* Let the following sectors of a read load while the first one is being
+   transferred. */
+static void prefetch_sectors(ata_drive_t *drv)
+{
+    int count = drv->sector_count_internal;
+
+    if (!count && !drv->atapi) {
+        count = 256;
+    }
+    if (drv->lookahead && count > 1) {
+        blockio_prefetch(drv->bio, drv->pos + 1, count - 1);
+    }
+}
+
 static void debug_addr(ata_drive_t *drv, char *cmd)
 {
     if (drv->lbamode && drv->lba) {
@@ -282,12 +295,7 @@ static int read_sector(ata_drive_t *drv)
         return drv->error;
     }
 
-    clearerr(drv->file);
-    if (fread(drv->buffer, drv->sector_size, 1, drv->file) != 1) {
-        memset(drv->buffer, 0, drv->sector_size);
-    }
-
-    if (ferror(drv->file)) {
+    if (blockio_read(drv->bio, drv->pos, drv->buffer) < 0) {
         ata_set_command_block(drv);
         drv->error = drv->atapi ? 0x54 : (ATA_UNC | ATA_ABRT);
         drv->cmd = 0x00;
@@ -324,21 +332,13 @@ static int write_sector(ata_drive_t *drv)
         return drv->error;
     }
 
-    if (fwrite(drv->buffer, 1, drv->sector_size, drv->file) != (size_t)drv->sector_size) {
+    if (blockio_write(drv->bio, drv->pos, drv->buffer, !drv->wcache) < 0) {
         ata_set_command_block(drv);
         drv->error = drv->atapi ? 0x54 : (ATA_UNC | ATA_ABRT);
         drv->cmd = 0x00;
     } else {
         drv->pos++;
     }
-
-    if (!drv->wcache) {
-        if (fflush(drv->file)) {
-            ata_set_command_block(drv);
-            drv->error = drv->atapi ? 0x54 : (ATA_UNC | ATA_ABRT);
-            drv->cmd = 0x00;
-        }
-    }
     return drv->error;
 }
 
@@ -537,6 +537,7 @@ ata_drive_t *ata_init(int drive)
     drv->myname = lib_msprintf("ATA%d", drive);
     drv->log = log_open(drv->myname);
     drv->file = NULL;
+    drv->bio = NULL;
     drv->filename = NULL;
     drv->buffer = lib_malloc(2048);
     drv->slave = drive & 1;
@@ -593,6 +594,7 @@ static void ata_execute_command(ata_drive_t *drv, uint8_t value)
                 return;
             }
             drv->cmd = 0x20;
+            prefetch_sectors(drv);
             read_sector(drv);
             return;
         case 0x30:
@@ -616,6 +618,7 @@ static void ata_execute_command(ata_drive_t *drv, uint8_t value)
             if (seek_sector(drv)) {
                 return;
             }
+            prefetch_sectors(drv);
             do {
                 read_sector(drv);
             } while (!drv->error && --drv->sector_count_internal);
@@ -726,7 +729,7 @@ static void ata_execute_command(ata_drive_t *drv, uint8_t value)
             }
             debug((drv->log, "FLUSH CACHE"));
             if (drv->file) {
-                if (fflush(drv->file)) {
+                if (blockio_flush(drv->bio)) {
                     drv->error = drv->atapi ? 0x54 : (ATA_UNC | ATA_ABRT);
                 }
             }
@@ -831,7 +834,7 @@ static void ata_execute_command(ata_drive_t *drv, uint8_t value)
                     debug((drv->log, "SET DISABLE WRITE CACHE"));
                     drv->wcache = 0;
                     if (drv->file) {
-                        fflush(drv->file);
+                        blockio_flush(drv->bio);
                     }
                     return;
                 case 0x99:
@@ -1019,6 +1022,7 @@ static void atapi_packet_execute_command(ata_drive_t *drv)
                 return;
             }
             drv->cmd = 0x28;
+            prefetch_sectors(drv);
             read_sector(drv);
             return;
         case 0x2a:
@@ -1193,7 +1197,7 @@ void ata_register_store(ata_drive_t *drv, uint16_t addr, uint16_t value)
                                     drv->bufp = 0;
                                     return;
                                 }
-                                if (!drv->file || fflush(drv->file)) {
+                                if (!drv->file || (!drv->wcache && blockio_flush(drv->bio))) {
                                     drv->error = drv->atapi ? 0x54 : (ATA_UNC | ATA_ABRT);
                                     break;
                                 }
@@ -1258,6 +1262,8 @@ void ata_register_store(ata_drive_t *drv, uint16_t addr, uint16_t value)
 void ata_image_attach(ata_drive_t *drv, char *filename, ata_drive_type_t type, ata_drive_geometry_t geometry)
 {
     if (drv->file != NULL) {
+        blockio_close(drv->bio);
+        drv->bio = NULL;
         fclose(drv->file);
         drv->file = NULL;
     }
@@ -1307,6 +1313,7 @@ void ata_image_attach(ata_drive_t *drv, char *filename, ata_drive_type_t type, a
     }
 
     if (drv->file) {
+        drv->bio = blockio_open(drv->file, drv->sector_size, drv->filename);
         if (drv->atapi) {
             log_message(drv->log, "Attached `%s' %u sectors total.",
                     drv->filename, (unsigned int)drv->geometry.size);
@@ -1327,6 +1334,8 @@ void ata_image_attach(ata_drive_t *drv, char *filename, ata_drive_type_t type, a
 void ata_image_detach(ata_drive_t *drv)
 {
     if (drv->file != NULL) {
+        blockio_close(drv->bio);
+        drv->bio = NULL;
         fclose(drv->file);
         drv->file = NULL;
         log_message(drv->log, "Detached.");
@@ -1356,6 +1365,17 @@ int ata_register_dump(ata_drive_t *drv)
     mon_out("LBA high:     %02x\n", ata_register_peek(drv, 5));
     mon_out("Device:       %02x\n", ata_register_peek(drv, 6));
     mon_out("Status:       %02x\n", ata_register_peek(drv, 7));
+    if (drv->bio) {
+        blockio_stats_t stats;
+
+        blockio_get_stats(drv->bio, &stats);
+        mon_out("Image reads:  %"PRIu64" (%"PRIu64" cached, %"PRIu64" read ahead)\n",
+                stats.reads, stats.read_hits, stats.read_ahead);
+        mon_out("Image writes: %"PRIu64" (%"PRIu64" written back, %"PRIu64" flushes)\n",
+                stats.writes, stats.write_backs, stats.flushes);
+        mon_out("I/O errors:   %"PRIu64"\n", stats.errors);
+        mon_out("I/O waits:    %"PRIu64" ms\n", stats.wait_ns / 1000000);
+    }
 
     return 0;
 }
@@ -1378,7 +1398,6 @@ int ata_snapshot_write_module(ata_drive_t *drv, snapshot_t *s)
     CLOCK spindle_clk = CLOCK_MAX;
     CLOCK head_clk = CLOCK_MAX;
     CLOCK standby_clk = CLOCK_MAX;
-    off_t pos = 0;
 
     m = snapshot_module_create(s, drv->myname,
                                CART_DUMP_VER_MAJOR, CART_DUMP_VER_MINOR);
@@ -1395,12 +1414,6 @@ int ata_snapshot_write_module(ata_drive_t *drv, snapshot_t *s)
     if (drv->standby) {
         standby_clk = drv->standby_alarm->context->pending_alarms[drv->standby_alarm->pending_idx].clk;
     }
-    if (drv->file) {
-        pos = archdep_ftello(drv->file);
-        if (pos < 0) {
-            pos = 0;
-        }
-    }
 
     SMW_STR(m, drv->filename);
     SMW_DW(m, drv->type);
@@ -1425,7 +1438,7 @@ int ata_snapshot_write_module(ata_drive_t *drv, snapshot_t *s)
     SMW_B(m, (uint8_t)drv->heads);
     SMW_B(m, (uint8_t)drv->sectors);
     SMW_DW(m, drv->pos);
-    SMW_DW(m, (uint32_t)(pos / drv->sector_size));
+    SMW_DW(m, (uint32_t)(drv->file ? drv->pos : 0)); /* was the file position */
     SMW_B(m, (uint8_t)drv->wcache);
     SMW_B(m, (uint8_t)drv->lookahead);
     SMW_B(m, (uint8_t)drv->busy);
@@ -1566,9 +1579,6 @@ int ata_snapshot_read_module(ata_drive_t *drv, snapshot_t *s)
         alarm_unset(drv->standby_alarm);
     }
 
-    if (drv->file) {
-        archdep_fseeko(drv->file, (off_t)pos * drv->sector_size, SEEK_SET);
-    }
     if (!drv->atapi) { /* atapi supports disc change events */
         drv->readonly = 1; /* make sure for ata that there's no filesystem corruption */
     }
@@ -0,0 +1,878 @@
+/*
+ * blockio.c - Cached block I/O for hard disk and memory card images.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#include "vice.h"
+
+/* required for off_t on some platforms */
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include "archdep.h"
+#include "blockio.h"
+#include "cmdline.h"
+#include "lib.h"
+#include "log.h"
+#include "resources.h"
+#include "types.h"
+
+#ifdef USE_VICE_THREAD
+#include <pthread.h>
+#endif
+
+/* most blocks moved by a single fread() or fwrite() */
+#define BLOCKIO_BATCH       32
+
+/* blocks loaded ahead of a sequential read */
+#define BLOCKIO_READAHEAD   64
+
+/* largest allowed cache, in KiB */
+#define BLOCKIO_CACHE_MAX   65536
+
+#define BLOCKIO_EMPTY       0
+#define BLOCKIO_LOADING     1   /* being read by the other thread */
+#define BLOCKIO_VALID       2
+
+typedef struct blockio_slot_s {
+    uint32_t lba;
+    int state;
+    int dirty;
+    int hnext;          /* next slot of the hash bucket, or of the free list */
+    int lprev, lnext;   /* LRU list, most recently used first */
+    int dprev, dnext;   /* dirty list, oldest first */
+} blockio_slot_t;
+
+struct blockio_s {
+    FILE *file;
+    char *name;
+    unsigned int block_size;
+
+    /* no cache at all if 0, everything goes straight to the file then */
+    unsigned int num_slots;
+    blockio_slot_t *slots;
+    uint8_t *data;
+    int *hash;
+    unsigned int hash_mask;
+    int free_head;
+    int lru_head, lru_tail;
+    int dirty_head, dirty_tail;
+    unsigned int dirty_count;
+    unsigned int readahead;
+
+    /* sequential read detection */
+    uint32_t last_lba;
+    int sequential;
+
+    /* pending read ahead for the worker */
+    uint32_t ra_lba;
+    unsigned int ra_count;
+
+    int write_error;
+
+    uint8_t *io_buffer;     /* BLOCKIO_BATCH blocks for the emulation side */
+    uint8_t *block_buffer;  /* one block for the partial byte accesses */
+
+    blockio_stats_t stats;
+
+#ifdef USE_VICE_THREAD
+    /* lock protects everything above, file_lock the file. Whoever needs
+       both takes file_lock while holding lock and then releases lock, so
+       the writes reach the file in the order they left the cache. */
+    pthread_mutex_t lock;
+    pthread_mutex_t file_lock;
+    pthread_cond_t work_cond;
+    pthread_cond_t done_cond;
+    pthread_t thread;
+    int thread_running;
+    int thread_stop;
+    unsigned int writes_in_flight;
+    uint8_t *worker_buffer;
+#endif
+};
+
+#ifdef USE_VICE_THREAD
+#define BIO_LOCK(b)         pthread_mutex_lock(&(b)->lock)
+#define BIO_UNLOCK(b)       pthread_mutex_unlock(&(b)->lock)
+#define BIO_FILE_LOCK(b)    pthread_mutex_lock(&(b)->file_lock)
+#define BIO_FILE_UNLOCK(b)  pthread_mutex_unlock(&(b)->file_lock)
+#define BIO_SIGNAL(b)       pthread_cond_signal(&(b)->work_cond)
+#define BIO_DONE(b)         pthread_cond_broadcast(&(b)->done_cond)
+#else
+#define BIO_LOCK(b)
+#define BIO_UNLOCK(b)
+#define BIO_FILE_LOCK(b)
+#define BIO_FILE_UNLOCK(b)
+#define BIO_SIGNAL(b)
+#define BIO_DONE(b)
+#endif
+
+static log_t blockio_log = LOG_DEFAULT;
+
+/* value of the "BlockCacheSize" resource, in KiB */
+static int blockio_cache_size = 4096;
+
+/* ------------------------------------------------------------------------- */
+
+static int io_read(blockio_t *bio, uint32_t lba, uint8_t *buffer, unsigned int count)
+{
+    size_t size = (size_t)count * bio->block_size;
+    size_t got;
+
+    clearerr(bio->file);
+    if (archdep_fseeko(bio->file, (off_t)lba * bio->block_size, SEEK_SET) != 0) {
+        return -1;
+    }
+    got = fread(buffer, 1, size, bio->file);
+    if (got < size) {
+        memset(buffer + got, 0, size - got);
+    }
+    return ferror(bio->file) ? -1 : 0;
+}
+
+static int io_write(blockio_t *bio, uint32_t lba, const uint8_t *buffer, unsigned int count)
+{
+    size_t size = (size_t)count * bio->block_size;
+
+    if (archdep_fseeko(bio->file, (off_t)lba * bio->block_size, SEEK_SET) != 0) {
+        return -1;
+    }
+    return fwrite(buffer, 1, size, bio->file) == size ? 0 : -1;
+}
+
+/* ------------------------------------------------------------------------- */
+/*    cache bookkeeping, all with lock held                                  */
+
+static inline uint8_t *slot_data(blockio_t *bio, int s)
+{
+    return bio->data + (size_t)s * bio->block_size;
+}
+
+static inline unsigned int slot_bucket(blockio_t *bio, uint32_t lba)
+{
+    return (lba * 2654435761u) & bio->hash_mask;
+}
+
+static int slot_lookup(blockio_t *bio, uint32_t lba)
+{
+    int s = bio->hash[slot_bucket(bio, lba)];
+
+    while (s >= 0 && bio->slots[s].lba != lba) {
+        s = bio->slots[s].hnext;
+    }
+    return s;
+}
+
+static void lru_unlink(blockio_t *bio, int s)
+{
+    blockio_slot_t *slot = &bio->slots[s];
+
+    if (slot->lprev >= 0) {
+        bio->slots[slot->lprev].lnext = slot->lnext;
+    } else {
+        bio->lru_head = slot->lnext;
+    }
+    if (slot->lnext >= 0) {
+        bio->slots[slot->lnext].lprev = slot->lprev;
+    } else {
+        bio->lru_tail = slot->lprev;
+    }
+}
+
+static void lru_push(blockio_t *bio, int s)
+{
+    bio->slots[s].lprev = -1;
+    bio->slots[s].lnext = bio->lru_head;
+    if (bio->lru_head >= 0) {
+        bio->slots[bio->lru_head].lprev = s;
+    } else {
+        bio->lru_tail = s;
+    }
+    bio->lru_head = s;
+}
+
+static void lru_touch(blockio_t *bio, int s)
+{
+    if (bio->lru_head != s) {
+        lru_unlink(bio, s);
+        lru_push(bio, s);
+    }
+}
+
+static void dirty_mark(blockio_t *bio, int s)
+{
+    blockio_slot_t *slot = &bio->slots[s];
+
+    if (slot->dirty) {
+        return;
+    }
+    slot->dirty = 1;
+    slot->dnext = -1;
+    slot->dprev = bio->dirty_tail;
+    if (bio->dirty_tail >= 0) {
+        bio->slots[bio->dirty_tail].dnext = s;
+    } else {
+        bio->dirty_head = s;
+    }
+    bio->dirty_tail = s;
+    bio->dirty_count++;
+}
+
+static void dirty_clear(blockio_t *bio, int s)
+{
+    blockio_slot_t *slot = &bio->slots[s];
+
+    if (!slot->dirty) {
+        return;
+    }
+    if (slot->dprev >= 0) {
+        bio->slots[slot->dprev].dnext = slot->dnext;
+    } else {
+        bio->dirty_head = slot->dnext;
+    }
+    if (slot->dnext >= 0) {
+        bio->slots[slot->dnext].dprev = slot->dprev;
+    } else {
+        bio->dirty_tail = slot->dprev;
+    }
+    slot->dirty = 0;
+    bio->dirty_count--;
+}
+
+static void hash_remove(blockio_t *bio, int s)
+{
+    int *link = &bio->hash[slot_bucket(bio, bio->slots[s].lba)];
+
+    while (*link != s) {
+        link = &bio->slots[*link].hnext;
+    }
+    *link = bio->slots[s].hnext;
+}
+
+/* Get a slot for lba in the loading state, evicting the least recently
+   used clean block if needed. Returns -1 if every block is dirty or
+   being loaded. */
+static int slot_alloc(blockio_t *bio, uint32_t lba)
+{
+    unsigned int bucket;
+    int s = bio->free_head;
+
+    if (s >= 0) {
+        bio->free_head = bio->slots[s].hnext;
+    } else {
+        s = bio->lru_tail;
+        while (s >= 0 && (bio->slots[s].state != BLOCKIO_VALID || bio->slots[s].dirty)) {
+            s = bio->slots[s].lprev;
+        }
+        if (s < 0) {
+            return -1;
+        }
+        hash_remove(bio, s);
+        lru_unlink(bio, s);
+    }
+
+    bucket = slot_bucket(bio, lba);
+    bio->slots[s].lba = lba;
+    bio->slots[s].state = BLOCKIO_LOADING;
+    bio->slots[s].dirty = 0;
+    bio->slots[s].hnext = bio->hash[bucket];
+    bio->hash[bucket] = s;
+    lru_push(bio, s);
+    return s;
+}
+
+static void slot_drop(blockio_t *bio, int s)
+{
+    dirty_clear(bio, s);
+    hash_remove(bio, s);
+    lru_unlink(bio, s);
+    bio->slots[s].state = BLOCKIO_EMPTY;
+    bio->slots[s].hnext = bio->free_head;
+    bio->free_head = s;
+}
+
+/* Wait until lba is not being loaded by the other thread any more, returns
+   its slot or -1. */
+static int slot_lookup_wait(blockio_t *bio, uint32_t lba)
+{
+    int s = slot_lookup(bio, lba);
+
+#ifdef USE_VICE_THREAD
+    if (s >= 0 && bio->slots[s].state == BLOCKIO_LOADING) {
+        uint64_t start = tick_now_nano();
+
+        do {
+            pthread_cond_wait(&bio->done_cond, &bio->lock);
+            s = slot_lookup(bio, lba);
+        } while (s >= 0 && bio->slots[s].state == BLOCKIO_LOADING);
+        bio->stats.wait_ns += tick_now_nano() - start;
+    }
+#endif
+    return s;
+}
+
+/* ------------------------------------------------------------------------- */
+/*    transfers, called with lock held, which is released during the I/O    */
+
+/* Load up to max blocks from lba into the cache, stopping at the first one
+   which is already there. Returns the number of blocks loaded, the first
+   of them is also left in buffer, or -1 on a read error. */
+static int load_run(blockio_t *bio, uint32_t lba, unsigned int max, uint8_t *buffer)
+{
+    int run[BLOCKIO_BATCH];
+    unsigned int n = 0, i;
+    int result;
+
+    if (max > BLOCKIO_BATCH) {
+        max = BLOCKIO_BATCH;
+    }
+    while (n < max && lba + n >= lba && slot_lookup(bio, lba + n) < 0) {
+        int s = slot_alloc(bio, lba + n);
+
+        if (s < 0) {
+            break;
+        }
+        run[n++] = s;
+    }
+    if (n == 0) {
+        return 0;
+    }
+
+    BIO_UNLOCK(bio);
+    BIO_FILE_LOCK(bio);
+    result = io_read(bio, lba, buffer, n);
+    BIO_FILE_UNLOCK(bio);
+    BIO_LOCK(bio);
+
+    for (i = 0; i < n; i++) {
+        if (result < 0) {
+            slot_drop(bio, run[i]);
+        } else {
+            memcpy(slot_data(bio, run[i]), buffer + (size_t)i * bio->block_size, bio->block_size);
+            bio->slots[run[i]].state = BLOCKIO_VALID;
+        }
+    }
+    BIO_DONE(bio);
+
+    if (result < 0) {
+        bio->stats.errors++;
+        return -1;
+    }
+    return (int)n;
+}
+
+/* Write back the oldest dirty block together with the dirty blocks which
+   directly follow it. */
+static void write_back_run(blockio_t *bio, uint8_t *buffer)
+{
+    uint32_t lba;
+    unsigned int n = 0;
+    int s = bio->dirty_head;
+    int result;
+
+    if (s < 0) {
+        return;
+    }
+    lba = bio->slots[s].lba;
+    do {
+        memcpy(buffer + (size_t)n * bio->block_size, slot_data(bio, s), bio->block_size);
+        dirty_clear(bio, s);
+        n++;
+        s = slot_lookup(bio, lba + n);
+    } while (n < BLOCKIO_BATCH && s >= 0 && bio->slots[s].dirty);
+
+#ifdef USE_VICE_THREAD
+    bio->writes_in_flight++;
+#endif
+    BIO_FILE_LOCK(bio);
+    BIO_UNLOCK(bio);
+    result = io_write(bio, lba, buffer, n);
+    BIO_FILE_UNLOCK(bio);
+    BIO_LOCK(bio);
+#ifdef USE_VICE_THREAD
+    bio->writes_in_flight--;
+#endif
+
+    bio->stats.write_backs += n;
+    if (result < 0) {
+        if (!bio->write_error) {
+            log_error(blockio_log, "%s: cannot write block %u.", bio->name, (unsigned int)lba);
+        }
+        bio->write_error = 1;
+        bio->stats.errors++;
+    }
+    BIO_DONE(bio);
+}
+
+#ifdef USE_VICE_THREAD
+static void *blockio_thread(void *arg)
+{
+    blockio_t *bio = arg;
+
+    BIO_LOCK(bio);
+    while (!bio->thread_stop) {
+        if (bio->ra_count > 0) {
+            uint32_t lba = bio->ra_lba;
+            int n;
+
+            if (slot_lookup(bio, lba) >= 0) {
+                bio->ra_lba++;
+                bio->ra_count--;
+                continue;
+            }
+            n = load_run(bio, lba, bio->ra_count, bio->worker_buffer);
+            if (n > 0) {
+                bio->stats.read_ahead += n;
+            }
+            if (bio->ra_lba != lba) {
+                /* the emulation asked for something else meanwhile */
+                continue;
+            }
+            if (n <= 0 || (unsigned int)n >= bio->ra_count) {
+                bio->ra_count = 0;
+            } else {
+                bio->ra_lba += n;
+                bio->ra_count -= n;
+            }
+        } else if (bio->dirty_count > 0) {
+            write_back_run(bio, bio->worker_buffer);
+        } else {
+            pthread_cond_wait(&bio->work_cond, &bio->lock);
+        }
+    }
+    BIO_UNLOCK(bio);
+
+    return NULL;
+}
+#endif
+
+/* ------------------------------------------------------------------------- */
+
+blockio_t *blockio_open(FILE *file, unsigned int block_size, const char *name)
+{
+    blockio_t *bio;
+    unsigned int i, hash_size;
+
+    if (blockio_log == LOG_DEFAULT) {
+        blockio_log = log_open("BlockIO");
+    }
+
+    bio = lib_calloc(1, sizeof(blockio_t));
+    bio->file = file;
+    bio->name = lib_strdup(name ? name : "image");
+    bio->block_size = block_size;
+    bio->io_buffer = lib_malloc(BLOCKIO_BATCH * block_size);
+    bio->block_buffer = lib_malloc(block_size);
+    bio->last_lba = UINT32_MAX;
+
+    bio->num_slots = (unsigned int)(((uint64_t)blockio_cache_size * 1024) / block_size);
+    if (bio->num_slots < 4 * BLOCKIO_BATCH) {
+        /* too small to be of any use */
+        bio->num_slots = 0;
+        return bio;
+    }
+
+    bio->readahead = bio->num_slots / 4;
+    if (bio->readahead > BLOCKIO_READAHEAD) {
+        bio->readahead = BLOCKIO_READAHEAD;
+    }
+    bio->slots = lib_malloc(bio->num_slots * sizeof(blockio_slot_t));
+    bio->data = lib_malloc((size_t)bio->num_slots * block_size);
+    for (hash_size = 1; hash_size < bio->num_slots; hash_size <<= 1) {
+    }
+    bio->hash = lib_malloc(hash_size * sizeof(int));
+    bio->hash_mask = hash_size - 1;
+    for (i = 0; i < hash_size; i++) {
+        bio->hash[i] = -1;
+    }
+    for (i = 0; i < bio->num_slots; i++) {
+        bio->slots[i].state = BLOCKIO_EMPTY;
+        bio->slots[i].dirty = 0;
+        bio->slots[i].hnext = (i + 1 < bio->num_slots) ? (int)(i + 1) : -1;
+    }
+    bio->free_head = 0;
+    bio->lru_head = bio->lru_tail = -1;
+    bio->dirty_head = bio->dirty_tail = -1;
+
+#ifdef USE_VICE_THREAD
+    pthread_mutex_init(&bio->lock, NULL);
+    pthread_mutex_init(&bio->file_lock, NULL);
+    pthread_cond_init(&bio->work_cond, NULL);
+    pthread_cond_init(&bio->done_cond, NULL);
+    bio->worker_buffer = lib_malloc(BLOCKIO_BATCH * block_size);
+    if (pthread_create(&bio->thread, NULL, blockio_thread, bio) == 0) {
+        bio->thread_running = 1;
+    } else {
+        log_warning(blockio_log, "%s: could not create I/O thread, reading ahead disabled.", bio->name);
+    }
+#endif
+
+    return bio;
+}
+
+int blockio_close(blockio_t *bio)
+{
+    int result;
+
+    if (bio == NULL) {
+        return 0;
+    }
+
+#ifdef USE_VICE_THREAD
+    if (bio->thread_running) {
+        BIO_LOCK(bio);
+        bio->thread_stop = 1;
+        BIO_SIGNAL(bio);
+        BIO_UNLOCK(bio);
+        pthread_join(bio->thread, NULL);
+    }
+#endif
+
+    result = blockio_flush(bio);
+
+#ifdef USE_VICE_THREAD
+    if (bio->num_slots > 0) {
+        pthread_mutex_destroy(&bio->lock);
+        pthread_mutex_destroy(&bio->file_lock);
+        pthread_cond_destroy(&bio->work_cond);
+        pthread_cond_destroy(&bio->done_cond);
+    }
+    lib_free(bio->worker_buffer);
+#endif
+    lib_free(bio->slots);
+    lib_free(bio->data);
+    lib_free(bio->hash);
+    lib_free(bio->io_buffer);
+    lib_free(bio->block_buffer);
+    lib_free(bio->name);
+    lib_free(bio);
+
+    return result;
+}
+
+int blockio_read(blockio_t *bio, uint32_t lba, uint8_t *buffer)
+{
+    uint64_t start;
+    int result = 0;
+    int s;
+
+    if (bio->num_slots == 0) {
+        bio->stats.reads++;
+        start = tick_now_nano();
+        result = io_read(bio, lba, buffer, 1);
+        bio->stats.wait_ns += tick_now_nano() - start;
+        if (result < 0) {
+            bio->stats.errors++;
+        }
+        return result;
+    }
+
+    BIO_LOCK(bio);
+    bio->stats.reads++;
+    s = slot_lookup_wait(bio, lba);
+    if (s >= 0) {
+        memcpy(buffer, slot_data(bio, s), bio->block_size);
+        lru_touch(bio, s);
+        bio->stats.read_hits++;
+    } else {
+        unsigned int count = 1;
+        int n;
+
+#ifndef USE_VICE_THREAD
+        /* nobody loads ahead, so read a run of blocks at once */
+        if (lba == bio->last_lba + 1) {
+            count = bio->readahead;
+        }
+#endif
+        start = tick_now_nano();
+        n = load_run(bio, lba, count, bio->io_buffer);
+        if (n > 0) {
+            memcpy(buffer, bio->io_buffer, bio->block_size);
+            bio->stats.read_ahead += n - 1;
+        } else if (n < 0) {
+            result = -1;
+        } else {
+            /* the cache is full of dirty blocks, go around it */
+            BIO_UNLOCK(bio);
+            BIO_FILE_LOCK(bio);
+            result = io_read(bio, lba, buffer, 1);
+            BIO_FILE_UNLOCK(bio);
+            BIO_LOCK(bio);
+            if (result < 0) {
+                bio->stats.errors++;
+            }
+        }
+        bio->stats.wait_ns += tick_now_nano() - start;
+    }
+
+    bio->sequential = (lba == bio->last_lba + 1);
+    bio->last_lba = lba;
+#ifdef USE_VICE_THREAD
+    if (bio->sequential && bio->thread_running) {
+        bio->ra_lba = lba + 1;
+        bio->ra_count = bio->readahead;
+        BIO_SIGNAL(bio);
+    }
+#endif
+    BIO_UNLOCK(bio);
+
+    return result;
+}
+
+int blockio_write(blockio_t *bio, uint32_t lba, const uint8_t *buffer, int write_through)
+{
+    uint64_t start;
+    int result;
+    int s;
+
+    if (bio->num_slots == 0) {
+        bio->stats.writes++;
+        start = tick_now_nano();
+        result = io_write(bio, lba, buffer, 1);
+        if (write_through && fflush(bio->file)) {
+            result = -1;
+        }
+        bio->stats.write_backs++;
+        bio->stats.wait_ns += tick_now_nano() - start;
+        if (result < 0) {
+            bio->stats.errors++;
+        }
+        return result;
+    }
+
+    BIO_LOCK(bio);
+    bio->stats.writes++;
+    s = slot_lookup_wait(bio, lba);
+    if (s < 0) {
+        s = slot_alloc(bio, lba);
+        if (s < 0) {
+            write_back_run(bio, bio->io_buffer);
+            s = slot_alloc(bio, lba);
+        }
+    }
+
+    if (s < 0 || write_through) {
+        if (s >= 0) {
+            memcpy(slot_data(bio, s), buffer, bio->block_size);
+            bio->slots[s].state = BLOCKIO_VALID;
+            dirty_clear(bio, s);
+            lru_touch(bio, s);
+        }
+        start = tick_now_nano();
+        BIO_FILE_LOCK(bio);
+        BIO_UNLOCK(bio);
+        result = io_write(bio, lba, buffer, 1);
+        if (write_through && fflush(bio->file)) {
+            result = -1;
+        }
+        BIO_FILE_UNLOCK(bio);
+        BIO_LOCK(bio);
+        bio->stats.write_backs++;
+        bio->stats.wait_ns += tick_now_nano() - start;
+        if (result < 0) {
+            bio->stats.errors++;
+            bio->write_error = 1;
+        }
+    } else {
+        memcpy(slot_data(bio, s), buffer, bio->block_size);
+        bio->slots[s].state = BLOCKIO_VALID;
+        dirty_mark(bio, s);
+        lru_touch(bio, s);
+#ifdef USE_VICE_THREAD
+        if (bio->thread_running) {
+            BIO_SIGNAL(bio);
+        }
+#endif
+        /* don't let the dirty blocks take over the cache */
+        if (bio->dirty_count > bio->num_slots / 2) {
+            start = tick_now_nano();
+            write_back_run(bio, bio->io_buffer);
+            bio->stats.wait_ns += tick_now_nano() - start;
+        }
+    }
+
+    result = bio->write_error ? -1 : 0;
+    bio->write_error = 0;
+    BIO_UNLOCK(bio);
+
+    return result;
+}
+
+int blockio_flush(blockio_t *bio)
+{
+    uint64_t start = tick_now_nano();
+    int result;
+
+    if (bio->num_slots == 0) {
+        bio->stats.flushes++;
+        result = fflush(bio->file) ? -1 : 0;
+        bio->stats.wait_ns += tick_now_nano() - start;
+        return result;
+    }
+
+    BIO_LOCK(bio);
+    bio->stats.flushes++;
+    while (bio->dirty_count > 0) {
+        write_back_run(bio, bio->io_buffer);
+    }
+#ifdef USE_VICE_THREAD
+    while (bio->writes_in_flight > 0) {
+        pthread_cond_wait(&bio->done_cond, &bio->lock);
+    }
+#endif
+    result = bio->write_error ? -1 : 0;
+    bio->write_error = 0;
+    BIO_FILE_LOCK(bio);
+    BIO_UNLOCK(bio);
+    if (fflush(bio->file)) {
+        result = -1;
+    }
+    BIO_FILE_UNLOCK(bio);
+
+    bio->stats.wait_ns += tick_now_nano() - start;
+    return result;
+}
+
+void blockio_prefetch(blockio_t *bio, uint32_t lba, unsigned int count)
+{
+#ifdef USE_VICE_THREAD
+    if (bio->num_slots == 0 || !bio->thread_running) {
+        return;
+    }
+    if (count > bio->readahead) {
+        count = bio->readahead;
+    }
+    BIO_LOCK(bio);
+    bio->ra_lba = lba;
+    bio->ra_count = count;
+    BIO_SIGNAL(bio);
+    BIO_UNLOCK(bio);
+#endif
+}
+
+int blockio_read_bytes(blockio_t *bio, uint64_t offset, uint8_t *buffer, size_t size)
+{
+    while (size > 0) {
+        uint32_t lba = (uint32_t)(offset / bio->block_size);
+        size_t skip = (size_t)(offset % bio->block_size);
+        size_t len = bio->block_size - skip;
+
+        if (len > size) {
+            len = size;
+        }
+        if (len == bio->block_size) {
+            if (blockio_read(bio, lba, buffer) < 0) {
+                return -1;
+            }
+        } else {
+            if (blockio_read(bio, lba, bio->block_buffer) < 0) {
+                return -1;
+            }
+            memcpy(buffer, bio->block_buffer + skip, len);
+        }
+        offset += len;
+        buffer += len;
+        size -= len;
+    }
+    return 0;
+}
+
+int blockio_write_bytes(blockio_t *bio, uint64_t offset, const uint8_t *buffer, size_t size, int write_through)
+{
+    int result = 0;
+
+    while (size > 0) {
+        uint32_t lba = (uint32_t)(offset / bio->block_size);
+        size_t skip = (size_t)(offset % bio->block_size);
+        size_t len = bio->block_size - skip;
+
+        if (len > size) {
+            len = size;
+        }
+        if (len == bio->block_size) {
+            if (blockio_write(bio, lba, buffer, write_through) < 0) {
+                result = -1;
+            }
+        } else {
+            if (blockio_read(bio, lba, bio->block_buffer) < 0) {
+                return -1;
+            }
+            memcpy(bio->block_buffer + skip, buffer, len);
+            if (blockio_write(bio, lba, bio->block_buffer, write_through) < 0) {
+                result = -1;
+            }
+        }
+        offset += len;
+        buffer += len;
+        size -= len;
+    }
+    return result;
+}
+
+void blockio_get_stats(blockio_t *bio, blockio_stats_t *stats)
+{
+    if (bio->num_slots == 0) {
+        *stats = bio->stats;
+        return;
+    }
+    BIO_LOCK(bio);
+    *stats = bio->stats;
+    BIO_UNLOCK(bio);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static int set_blockio_cache_size(int val, void *param)
+{
+    if (val < 0 || val > BLOCKIO_CACHE_MAX) {
+        return -1;
+    }
+    blockio_cache_size = val;
+    return 0;
+}
+
+static const resource_int_t resources_int[] = {
+    { "BlockCacheSize", 4096, RES_EVENT_NO, NULL,
+      &blockio_cache_size, set_blockio_cache_size, NULL },
+    RESOURCE_INT_LIST_END
+};
+
+int blockio_resources_init(void)
+{
+    return resources_register_int(resources_int);
+}
+
+static const cmdline_option_t cmdline_options[] =
+{
+    { "-blockcachesize", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
+      NULL, NULL, "BlockCacheSize", NULL,
+      "<KiB>", "Size of the block cache of hard disk and memory card images (0: no cache)" },
+    CMDLINE_LIST_END
+};
+
+int blockio_cmdline_options_init(void)
+{
+    return cmdline_register_options(cmdline_options);
+}
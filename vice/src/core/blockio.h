@@ -0,0 +1,78 @@
+/*
+ * blockio.h - Cached block I/O for hard disk and memory card images.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_BLOCKIO_H
+#define VICE_BLOCKIO_H
+
+#include <stdio.h>
+
+#include "types.h"
+
+/*
+ * A block cache in front of an image file. Blocks read in sequence are
+ * loaded ahead and written blocks are kept until they are written back,
+ * both on a worker thread if VICE is built with threads, so that the
+ * emulation rarely has to wait for the host file system. The size of the
+ * cache is set by the BlockCacheSize resource when the image is opened.
+ *
+ * Reads beyond the end of the image return zeros, like the plain fread()
+ * based code did. A failed write back is reported by the next write or
+ * flush.
+ */
+typedef struct blockio_s blockio_t;
+
+typedef struct blockio_stats_s {
+    uint64_t reads;         /* blocks read by the emulation */
+    uint64_t read_hits;     /* reads served from the cache */
+    uint64_t read_ahead;    /* blocks loaded before they were asked for */
+    uint64_t writes;        /* blocks written by the emulation */
+    uint64_t write_backs;   /* blocks written to the image */
+    uint64_t flushes;
+    uint64_t errors;        /* failed reads and writes of the image */
+    uint64_t wait_ns;       /* host time the emulation waited for the image */
+} blockio_stats_t;
+
+/* The file stays owned by the caller, it must not be used directly while
+   the cache is open. */
+blockio_t *blockio_open(FILE *file, unsigned int block_size, const char *name);
+/* Writes back and frees the cache, returns -1 if writing back failed. */
+int blockio_close(blockio_t *bio);
+
+int blockio_read(blockio_t *bio, uint32_t lba, uint8_t *buffer);
+int blockio_write(blockio_t *bio, uint32_t lba, const uint8_t *buffer, int write_through);
+int blockio_flush(blockio_t *bio);
+
+/* The emulation is about to read count blocks from lba, start loading them
+   while the emulated drive is still busy. */
+void blockio_prefetch(blockio_t *bio, uint32_t lba, unsigned int count);
+
+/* Byte granular access for devices which are not addressed in blocks. */
+int blockio_read_bytes(blockio_t *bio, uint64_t offset, uint8_t *buffer, size_t size);
+int blockio_write_bytes(blockio_t *bio, uint64_t offset, const uint8_t *buffer, size_t size, int write_through);
+
+void blockio_get_stats(blockio_t *bio, blockio_stats_t *stats);
+
+int blockio_resources_init(void);
+int blockio_cmdline_options_init(void);
+
+#endif
@@ -43,6 +43,7 @@
 #include "lib.h"
 #include "log.h"
 #include "monitor.h"
+#include "rawnet.h"
 #include "rawnetarch.h"
 #include "resources.h"
 #include "snapshot.h"
@@ -358,7 +359,7 @@ void cs8900_reset(void)
     assert(cs8900);
     assert(cs8900_packetpage);
 
-    rawnet_arch_pre_reset();
+    rawnet_pre_reset();
 
     /* initialize visible IO register and PacketPage registers */
     memset(cs8900, 0, CS8900_COUNT_IO_REGISTER);
@@ -420,7 +421,7 @@ void cs8900_reset(void)
     cs8900_set_transmitter(0);
     cs8900_set_receiver(0);
 
-    rawnet_arch_post_reset();
+    rawnet_post_reset();
 
     log_message(cs8900_log, "CS8900a rev.D reset");
 }
@@ -459,7 +460,7 @@ int cs8900_activate(const char *net_interface)
     log_message(cs8900_log, "\tcs8900 at $%08X, cs8900_packetpage at $%08X", cs8900, cs8900_packetpage);
 #endif
 
-    if (!rawnet_arch_activate(net_interface)) {
+    if (!rawnet_activate(net_interface)) {
         lib_free(cs8900_packetpage);
         lib_free(cs8900);
         cs8900 = NULL;
@@ -480,7 +481,7 @@ int cs8900_deactivate(void)
 
     assert(cs8900 && cs8900_packetpage);
 
-    rawnet_arch_deactivate();
+    rawnet_deactivate();
 
     lib_free(cs8900);
     cs8900 = NULL;
@@ -655,7 +656,7 @@ static uint16_t cs8900_receive(void)
 
         ready = 1;  /* assume we will find a good frame */
 
-        newframe = rawnet_arch_receive(buffer, &len, &hashed, &hash_index, &rx_ok, &correct_mac, &broadcast, &crc_error);
+        newframe = rawnet_receive(buffer, &len, &hashed, &hash_index, &rx_ok, &correct_mac, &broadcast, &crc_error);
 
         assert((len & 1) == 0); /* length has to be even! */
 
@@ -774,7 +775,7 @@ static void cs8900_write_tx_buffer(uint8_t value, int odd_address)
         /* full frame transmitted? */
         if (tx_count == tx_length) {
 #ifdef RAWNET_DEBUG_FRAMES
-            log_message(cs8900_log, "rawnet_arch_transmit() called with:                 length=%4u and buffer %s", tx_length, debug_outbuffer(tx_length, &cs8900_packetpage[CS8900_PP_ADDR_TX_FRAMELOC]));
+            log_message(cs8900_log, "rawnet_transmit() called with:                 length=%4u and buffer %s", tx_length, debug_outbuffer(tx_length, &cs8900_packetpage[CS8900_PP_ADDR_TX_FRAMELOC]));
 #endif
 
             if (!tx_enabled) {
@@ -784,7 +785,7 @@ static void cs8900_write_tx_buffer(uint8_t value, int odd_address)
             } else {
                 /* send frame */
                 uint16_t txcmd = GET_PP_16(CS8900_PP_ADDR_CC_TXCMD);
-                rawnet_arch_transmit(
+                rawnet_transmit(
                     txcmd & 0x0100 ? 1 : 0,   /* FORCE: Delete waiting frames in transmit buffer */
                     txcmd & 0x0200 ? 1 : 0,   /* ONECOLL: Terminate after just one collision */
                     txcmd & 0x1000 ? 1 : 0,   /* INHIBITCRC: Do not append CRC to the transmission */
@@ -917,7 +918,7 @@ static void cs8900_sideeffects_write_pp(uint16_t ppaddress, int odd_address)
                 log_message(cs8900_log, "setup receiver: broadcast=%s mac=%s multicast=%s correct=%s promiscuous=%s hashfilter=%s",
                             on_off_str(cs8900_recv_broadcast), on_off_str(cs8900_recv_mac), on_off_str(cs8900_recv_multicast), on_off_str(cs8900_recv_correct), on_off_str(cs8900_recv_promiscuous), on_off_str(cs8900_recv_hashfilter));
 
-                rawnet_arch_recv_ctl(cs8900_recv_broadcast, cs8900_recv_mac, cs8900_recv_multicast, cs8900_recv_correct, cs8900_recv_promiscuous, cs8900_recv_hashfilter);
+                rawnet_recv_ctl(cs8900_recv_broadcast, cs8900_recv_mac, cs8900_recv_multicast, cs8900_recv_correct, cs8900_recv_promiscuous, cs8900_recv_hashfilter);
             }
             break;
         case CS8900_PP_ADDR_CC_LINECTL:
@@ -926,7 +927,7 @@ static void cs8900_sideeffects_write_pp(uint16_t ppaddress, int odd_address)
                 int enable_rx = (content & 0x0040) == 0x0040;
 
                 if ((enable_tx != tx_enabled) || (enable_rx != rx_enabled)) {
-                    rawnet_arch_line_ctl(enable_tx, enable_rx);
+                    rawnet_line_ctl(enable_tx, enable_rx);
                     cs8900_set_transmitter(enable_tx);
                     cs8900_set_receiver(enable_rx);
 
@@ -1015,7 +1016,7 @@ static void cs8900_sideeffects_write_pp(uint16_t ppaddress, int odd_address)
                 *p &= ~(0xFF << pos); /* clear out relevant bits */
                 *p |= GET_PP_8(ppaddress + odd_address) << pos;
 
-                rawnet_arch_set_hashfilter(cs8900_hash_mask);
+                rawnet_set_hashfilter(cs8900_hash_mask);
 
 #if 0
                 if (odd_address && (ppaddress == CS8900_PP_ADDR_LOG_ADDR_FILTER + 6)) {
@@ -1030,7 +1031,7 @@ static void cs8900_sideeffects_write_pp(uint16_t ppaddress, int odd_address)
         case CS8900_PP_ADDR_MAC_ADDR + 4:
             /* the MAC address has been changed */
             cs8900_ia_mac[ppaddress - CS8900_PP_ADDR_MAC_ADDR + odd_address] = GET_PP_8(ppaddress + odd_address);
-            rawnet_arch_set_mac(cs8900_ia_mac);
+            rawnet_set_mac(cs8900_ia_mac);
             if (odd_address && (ppaddress == CS8900_PP_ADDR_MAC_ADDR + 4)) {
                 log_message(cs8900_log, "set MAC address: %02x:%02x:%02x:%02x:%02x:%02x",
                             cs8900_ia_mac[0], cs8900_ia_mac[1], cs8900_ia_mac[2], cs8900_ia_mac[3], cs8900_ia_mac[4], cs8900_ia_mac[5]);
@@ -1613,6 +1614,13 @@ int cs8900_dump(void)
     mon_out("Package Page Ptr: $%04X (autoincrement %s)\n",
             (unsigned int)(cs8900_packetpage_ptr & PP_PTR_ADDR_MASK),
             (cs8900_packetpage_ptr & PP_PTR_AUTO_INCR_FLAG) != 0 ? "enabled" : "disabled");
+    if (cs8900) {
+        rawnet_stats_t stats;
+
+        rawnet_get_stats(&stats);
+        mon_out("Frames received: %lu (in %lu batches), sent: %lu, dropped: %lu\n",
+                stats.rx_frames, stats.rx_batches, stats.tx_frames, stats.tx_dropped);
+    }
     return 0;
 }
 
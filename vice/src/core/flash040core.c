@@ -110,12 +110,23 @@ static const flash_types_t flash_types[FLASH040_TYPE_NUM] = {
 
 inline static int flash_magic_1(flash040_context_t *flash040_context, unsigned int addr)
 {
-    return ((addr & flash_types[flash040_context->flash_type].magic_1_mask) == flash_types[flash040_context->flash_type].magic_1_addr);
+    return ((addr & flash040_context->magic_1_mask) == flash040_context->magic_1_addr);
 }
 
 inline static int flash_magic_2(flash040_context_t *flash040_context, unsigned int addr)
 {
-    return ((addr & flash_types[flash040_context->flash_type].magic_2_mask) == flash_types[flash040_context->flash_type].magic_2_addr);
+    return ((addr & flash040_context->magic_2_mask) == flash040_context->magic_2_addr);
+}
+
+inline static void flash_mark_dirty(flash040_context_t *flash040_context, unsigned int addr, unsigned int size)
+{
+    unsigned int bank = addr >> FLASH040_DIRTY_BANK_SHIFT;
+    unsigned int last = (addr + size - 1) >> FLASH040_DIRTY_BANK_SHIFT;
+
+    for (; bank <= last; bank++) {
+        flash040_context->dirty_banks[bank >> 3] |= (uint8_t)(1 << (bank & 7));
+    }
+    flash040_context->flash_dirty = 1;
 }
 
 inline static void flash_clear_erase_mask(flash040_context_t *flash040_context)
@@ -158,14 +169,14 @@ inline static void flash_erase_sector(flash040_context_t *flash040_context, unsi
 
     FLASH_DEBUG(("Erasing 0x%x - 0x%x", sector_addr, sector_addr + sector_size - 1));
     memset(&(flash040_context->flash_data[sector_addr]), 0xff, sector_size);
-    flash040_context->flash_dirty = 1;
+    flash_mark_dirty(flash040_context, sector_addr, sector_size);
 }
 
 inline static void flash_erase_chip(flash040_context_t *flash040_context)
 {
     FLASH_DEBUG(("Erasing chip"));
     memset(flash040_context->flash_data, 0xff, flash_types[flash040_context->flash_type].size);
-    flash040_context->flash_dirty = 1;
+    flash_mark_dirty(flash040_context, 0, flash_types[flash040_context->flash_type].size);
 }
 
 inline static int flash_program_byte(flash040_context_t *flash040_context, unsigned int addr, uint8_t byte)
@@ -176,7 +187,7 @@ inline static int flash_program_byte(flash040_context_t *flash040_context, unsig
     FLASH_DEBUG(("Programming 0x%05x with 0x%02x (%02x->%02x)", addr, byte, old_data, old_data & byte));
     flash040_context->program_byte = byte;
     flash040_context->flash_data[addr] = new_data;
-    flash040_context->flash_dirty = 1;
+    flash_mark_dirty(flash040_context, addr, 1);
 
     return (new_data == byte) ? 1 : 0;
 }
@@ -466,6 +477,18 @@ uint8_t flash040core_peek(flash040_context_t *flash040_context, unsigned int add
     return flash040_context->flash_data[addr];
 }
 
+int flash040core_clear_dirty_bank(flash040_context_t *flash040_context, unsigned int bank)
+{
+    uint8_t *mask = &flash040_context->dirty_banks[bank >> 3];
+    uint8_t bit = (uint8_t)(1 << (bank & 7));
+
+    if (*mask & bit) {
+        *mask &= (uint8_t)~bit;
+        return 1;
+    }
+    return 0;
+}
+
 void flash040core_reset(flash040_context_t *flash040_context)
 {
     FLASH_DEBUG(("Reset"));
@@ -488,6 +511,11 @@ void flash040core_init(struct flash040_context_s *flash040_context,
     flash040_context->program_byte = 0;
     flash_clear_erase_mask(flash040_context);
     flash040_context->flash_dirty = 0;
+    memset(flash040_context->dirty_banks, 0, FLASH040_DIRTY_MASK_SIZE);
+    flash040_context->magic_1_addr = flash_types[type].magic_1_addr;
+    flash040_context->magic_2_addr = flash_types[type].magic_2_addr;
+    flash040_context->magic_1_mask = flash_types[type].magic_1_mask;
+    flash040_context->magic_2_mask = flash_types[type].magic_2_mask;
     flash040_context->erase_alarm = alarm_new(alarm_context, "Flash040Alarm", erase_alarm_handler, flash040_context);
 }
 
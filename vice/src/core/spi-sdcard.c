@@ -32,6 +32,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "blockio.h"
 #include "log.h"
 #include "snapshot.h"
 #include "spi-sdcard.h"
@@ -63,6 +64,10 @@
 #define MMC_CARD_INSERTED      0
 #define MMC_CARD_NOTINSERTED   1
 
+/* largest block size supported, READ_BL_LEN of a standard capacity card
+   is at most 2048 bytes */
+#define MMC_BLOCK_SIZE_MAX     2048
+
 #define MMC_SPIMODE_READ       1
 #define MMC_SPIMODE_WRITE      0
 
@@ -95,9 +100,12 @@ static int mmc_card_rw = 0;
 
 /* Image file */
 static FILE *mmc_image_file = NULL;
+static blockio_t *mmc_image_bio = NULL;
 
 /* Pointer inside image */
 static sd_addr_t mmc_image_pointer;
+static uint8_t mmc_write_buffer[MMC_BLOCK_SIZE_MAX];
+static sd_addr_t mmc_write_address;
 
 /* write sequence counter */
 static unsigned int mmc_write_sequence;
@@ -614,11 +622,21 @@ static void mmc_execute_cmd(void)
             log_debug(LOG_DEFAULT, "CMD16-AAAA Set Block Size received");
 #endif
             mmc_card_state = MMC_CARD_IDLE;
-            mmc_block_size =
-                mmc_cmd_buffer[5] +
-                (mmc_cmd_buffer[4] * 0x100) +
-                (mmc_cmd_buffer[3] * 0x10000) +
-                (mmc_cmd_buffer[2] * 0x1000000);
+            {
+                uint32_t block_size =
+                    mmc_cmd_buffer[5] +
+                    (mmc_cmd_buffer[4] * 0x100) +
+                    (mmc_cmd_buffer[3] * 0x10000) +
+                    (mmc_cmd_buffer[2] * 0x1000000);
+
+                /* a real card rejects the command, keeping the old size */
+                if (block_size == 0 || block_size > MMC_BLOCK_SIZE_MAX) {
+                    log_error(LOG_DEFAULT, "SD card: block size %u not supported, keeping %u.",
+                              (unsigned int)block_size, (unsigned int)mmc_block_size);
+                } else {
+                    mmc_block_size = block_size;
+                }
+            }
             break;
         case 0x51:
 #ifdef DEBUG_MMC
@@ -635,29 +653,20 @@ static void mmc_execute_cmd(void)
 #endif
                     mmc_card_state = MMC_CARD_DUMMY_READ;
                 } else {
+                    uint8_t readbuf[MMC_BLOCK_SIZE_MAX];
 #ifdef DEBUG_MMC
                     log_debug(LOG_DEFAULT, "Address: %08x", mmc_current_address_pointer);
+                    log_debug(LOG_DEFAULT, "Buffering: %08x", mmc_current_address_pointer);
 #endif
-                    if (fseek(mmc_image_file, mmc_current_address_pointer, SEEK_SET) != 0) {
+                    if (blockio_read_bytes(mmc_image_bio, mmc_current_address_pointer, readbuf, mmc_block_size) < 0) {
                         mmc_card_state = MMC_CARD_DUMMY_READ;
                     } else {
-                        uint8_t readbuf[0x1000];    /* FIXME */
+                        mmc_read_buffer_readptr = 0;
+                        mmc_read_buffer_writeptr = 0;
+                        mmc_read_buffer_set(readbuf, mmc_block_size);
 #ifdef DEBUG_MMC
-                        log_debug(LOG_DEFAULT, "Buffering: %08x", mmc_current_address_pointer);
-#endif
-                        fseek(mmc_image_file, mmc_current_address_pointer, SEEK_SET);
-                        if (!feof(mmc_image_file)) {
-                            if (fread(readbuf, 1, mmc_block_size, mmc_image_file) > 0) {
-                                mmc_read_buffer_readptr = 0;
-                                mmc_read_buffer_writeptr = 0;
-                                mmc_read_buffer_set(readbuf, mmc_block_size);
-#ifdef DEBUG_MMC
-                                log_debug(LOG_DEFAULT, "Buffered: %02x %02x", readbuf[0], readbuf[1]);
+                        log_debug(LOG_DEFAULT, "Buffered: %02x %02x", readbuf[0], readbuf[1]);
 #endif
-                            } else {
-                                /* FIXME: handle error */
-                            }
-                        }
                     }
                 }
             } else {
@@ -681,6 +690,7 @@ static void mmc_execute_cmd(void)
 #endif
                 } else {
                     mmc_write_sequence = 0;
+                    mmc_write_address = mmc_current_address_pointer;
                     mmc_card_state = MMC_CARD_WRITE;
                 }
             } else {
@@ -801,14 +811,18 @@ static void mmc_write_to_mmc(uint8_t value)
             }
             break;
         case 1:
+            /* CMD16 keeps mmc_block_size within the buffer */
             if (mmc_card_state == MMC_CARD_WRITE) {
-                if (fwrite(&value, 1, 1, mmc_image_file) != 1) {
-                    LOG(("could not write to mmc image file"));
-                    /* FIXME: handle error */
-                }
+                mmc_write_buffer[mmc_image_pointer] = value;
             }
             mmc_image_pointer++;
             if (mmc_image_pointer == mmc_block_size) {
+                if (mmc_card_state == MMC_CARD_WRITE) {
+                    if (blockio_write_bytes(mmc_image_bio, mmc_write_address,
+                                            mmc_write_buffer, mmc_block_size, 0) < 0) {
+                        log_error(LOG_DEFAULT, "SD card: could not write to image file.");
+                    }
+                }
                 mmc_write_sequence++;
             }
             break;
@@ -872,6 +886,7 @@ int mmc_open_card_image(char *name, int rw)
         spi_mmc_set_card_inserted(MMC_CARD_INSERTED);
         LOG(("opened sd card image (rw): %s", mmc_image_filename));
     }
+    mmc_image_bio = blockio_open(mmc_image_file, 512, mmc_image_filename);
     mmc_card_rw = rw;
     return 0;
 }
@@ -880,6 +895,8 @@ void mmc_close_card_image(void)
 {
     /* unmount mmc cart image */
     if (mmc_image_file != NULL) {
+        blockio_close(mmc_image_bio);
+        mmc_image_bio = NULL;
         fclose(mmc_image_file);
         mmc_image_file = NULL;
         spi_mmc_set_card_inserted(MMC_CARD_NOTINSERTED);
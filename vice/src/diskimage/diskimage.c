@@ -670,6 +670,29 @@ int disk_image_read_sector(const disk_image_t *image, uint8_t *buf, const disk_a
     return rc;
 }
 
+/** \brief  Read \a count consecutive sectors of a track in one go
+ *
+ * This is an optimization for bulk readers like the directory lister, there
+ * is no fallback to single sector reads: when the image type or layout does
+ * not allow reading the range at once, -1 is returned and the caller is
+ * expected to use disk_image_read_sector() instead.
+ *
+ * \param[in]   image   disk image
+ * \param[out]  buf     buffer of at least \a count * 256 bytes
+ * \param[in]   dadr    track and sector of the first sector
+ * \param[in]   count   number of sectors
+ *
+ * \return  0 on success, -1 on failure
+ */
+int disk_image_read_sectors(const disk_image_t *image, uint8_t *buf,
+                            const disk_addr_t *dadr, unsigned int count)
+{
+    if (image->device == DISK_IMAGE_DEVICE_FS) {
+        return fsimage_read_sectors(image, buf, dadr, count);
+    }
+    return -1;
+}
+
 int disk_image_write_sector(disk_image_t *image, const uint8_t *buf, const disk_addr_t *dadr)
 {
     int rc = 0;
@@ -428,6 +428,54 @@ int fsimage_dxx_read_sector(const disk_image_t *image, uint8_t *buf, const disk_
     }
 }
 
+/** \brief  Read \a count consecutive sectors in a single I/O operation
+ *
+ * Only plain sector dumps are handled here: images with an error map or with
+ * GCR data attached need per-sector handling and are rejected, as are ranges
+ * that are not stored contiguously in the image.
+ *
+ * \param[in]   image   disk image
+ * \param[out]  buf     buffer of at least \a count * 256 bytes
+ * \param[in]   dadr    track and sector of the first sector
+ * \param[in]   count   number of sectors to read
+ *
+ * \return  0 on success, -1 when the range cannot be read in one go
+ */
+int fsimage_dxx_read_sectors(const disk_image_t *image, uint8_t *buf,
+                             const disk_addr_t *dadr, unsigned int count)
+{
+    int first;
+    int last;
+    long offset;
+    fsimage_t *fsimage = image->media.fsimage;
+
+    if (count == 0 || image->gcr != NULL || fsimage->error_info.map != NULL) {
+        return -1;
+    }
+
+    first = disk_image_check_sector(image, dadr->track, dadr->sector);
+    last = disk_image_check_sector(image, dadr->track, dadr->sector + count - 1);
+    if (first < 0 || last < 0 || (unsigned int)(last - first) != count - 1) {
+        return -1;
+    }
+
+    offset = first * 256;
+
+#ifdef HAVE_X64_IMAGE
+    if (image->type == DISK_IMAGE_TYPE_X64) {
+        offset += X64_HEADER_LENGTH;
+    }
+#endif
+
+    if (util_fpread(fsimage->fd, buf, 256 * count, offset) < 0) {
+        log_error(fsimage_dxx_log,
+                  "Error reading T:%u S:%u-%u from disk image.",
+                  dadr->track, dadr->sector, dadr->sector + count - 1);
+        return -1;
+    }
+    return 0;
+}
+
 int fsimage_dxx_write_sector(disk_image_t *image, const uint8_t *buf, const disk_addr_t *dadr)
 {
     int sectors;
@@ -41,6 +41,8 @@ int fsimage_dxx_write_half_track(disk_image_t *image, unsigned int half_track,
                                  const struct disk_track_s *raw);
 int fsimage_dxx_read_sector(const struct disk_image_s *image, uint8_t *buf,
                             const struct disk_addr_s *dadr);
+int fsimage_dxx_read_sectors(const struct disk_image_s *image, uint8_t *buf,
+                             const struct disk_addr_s *dadr, unsigned int count);
 int fsimage_dxx_write_sector(struct disk_image_s *image, const uint8_t *buf,
                              const struct disk_addr_s *dadr);
 
@@ -238,6 +238,39 @@ int fsimage_read_sector(const disk_image_t *image, uint8_t *buf, const disk_addr
     }
 }
 
+int fsimage_read_sectors(const disk_image_t *image, uint8_t *buf,
+                         const disk_addr_t *dadr, unsigned int count)
+{
+    fsimage_t *fsimage;
+
+    fsimage = image->media.fsimage;
+
+    if (fsimage == NULL || fsimage->fd == NULL) {
+        return -1;
+    }
+
+    switch (image->type) {
+        case DISK_IMAGE_TYPE_D64:
+        case DISK_IMAGE_TYPE_D67:
+        case DISK_IMAGE_TYPE_D71:
+        case DISK_IMAGE_TYPE_D81:
+        case DISK_IMAGE_TYPE_D80:
+        case DISK_IMAGE_TYPE_D82:
+#ifdef HAVE_X64_IMAGE
+        case DISK_IMAGE_TYPE_X64:
+#endif
+        case DISK_IMAGE_TYPE_D1M:
+        case DISK_IMAGE_TYPE_D2M:
+        case DISK_IMAGE_TYPE_D4M:
+        case DISK_IMAGE_TYPE_DHD:
+        case DISK_IMAGE_TYPE_D90:
+            return fsimage_dxx_read_sectors(image, buf, dadr, count);
+        default:
+            /* GCR based images have no linear sector layout */
+            return -1;
+    }
+}
+
 int fsimage_write_sector(disk_image_t *image, const uint8_t *buf,
                          const disk_addr_t *dadr)
 {
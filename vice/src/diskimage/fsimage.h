@@ -57,6 +57,8 @@ int fsimage_open(struct disk_image_s *image);
 int fsimage_close(struct disk_image_s *image);
 int fsimage_read_sector(const struct disk_image_s *image, uint8_t *buf,
                         const struct disk_addr_s *dadr);
+int fsimage_read_sectors(const struct disk_image_s *image, uint8_t *buf,
+                         const struct disk_addr_s *dadr, unsigned int count);
 int fsimage_write_sector(struct disk_image_s *image, const uint8_t *buf,
                          const struct disk_addr_s *dadr);
 off_t fsimage_size(const disk_image_t *image);
@@ -61,6 +61,7 @@
 #include "gcr.h"
 #include "iecbus.h"
 #include "iecdrive.h"
+#include "instrument.h"
 #include "lib.h"
 #include "log.h"
 #include "machine-drive.h"
@@ -990,12 +991,25 @@ int drive_num_leds(unsigned int dnr)
 
 void drive_cpu_execute_one(diskunit_context_t *drv, CLOCK clk_value)
 {
+    int instrumented = instrument_enabled;
+    CLOCK clk_start = 0;
+
+    if (instrumented) {
+        clk_start = *(drv->clk_ptr);
+        instrument_enter_drive(drv->mynumber);
+    }
+
     if (drv->type == DRIVE_TYPE_2000 || drv->type == DRIVE_TYPE_4000 ||
         drv->type == DRIVE_TYPE_CMDHD) {
         drivecpu65c02_execute(drv, clk_value);
     } else {
         drivecpu_execute(drv, clk_value);
     }
+
+    if (instrumented) {
+        instrument_add_drive_cycles(drv->mynumber, *(drv->clk_ptr) - clk_start);
+        instrument_leave();
+    }
 }
 
 void drive_cpu_execute_all(CLOCK clk_value)
@@ -390,7 +390,8 @@ void drivecpu_execute(diskunit_context_t *drv, CLOCK clk_value)
     }
 
     /* Run drive CPU emulation until the stop_clk clock has been reached. */
-    while (*drv->clk_ptr < cpu->stop_clk) {
+#define CPU_LOOP_CONDITION() (*drv->clk_ptr < cpu->stop_clk)
+    while (CPU_LOOP_CONDITION()) {
 /* Include the 6502/6510 CPU emulation core.  */
 #define CPU_LOG_ID (drv->log)
 /* #define ANE_LOG_LEVEL ane_log_level */
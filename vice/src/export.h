@@ -52,6 +52,10 @@ void export_dump(void);
 int export_add(const export_resource_t *export_res);
 int export_remove(const export_resource_t *export_res);
 
+/* incremented by export_add() and export_remove(), so users can cache what
+   they derive from the list of devices */
+extern unsigned int export_generation;
+
 int export_resources_init(void);
 
 #endif
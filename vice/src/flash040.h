@@ -68,6 +68,12 @@ typedef enum flash040_state_s flash040_state_t;
 
 #define FLASH040_ERASE_MASK_SIZE 8
 
+/* Changes are tracked per 8 KiB bank, which is also the chip size of most
+   flash cartridge images. 1024 banks cover the largest (8 MiB) chip. */
+#define FLASH040_DIRTY_BANK_SHIFT   13
+#define FLASH040_DIRTY_BANK_SIZE    (1 << FLASH040_DIRTY_BANK_SHIFT)
+#define FLASH040_DIRTY_MASK_SIZE    128
+
 typedef struct flash040_context_s {
     uint8_t *flash_data;
     flash040_state_t flash_state;
@@ -76,6 +82,13 @@ typedef struct flash040_context_s {
     uint8_t program_byte;
     uint8_t erase_mask[FLASH040_ERASE_MASK_SIZE];
     int flash_dirty;
+    uint8_t dirty_banks[FLASH040_DIRTY_MASK_SIZE];
+
+    /* command addresses of the type, decoded once by flash040core_init() */
+    unsigned int magic_1_addr;
+    unsigned int magic_2_addr;
+    unsigned int magic_1_mask;
+    unsigned int magic_2_mask;
 
     flash040_type_t flash_type;
 
@@ -98,6 +111,11 @@ uint8_t flash040core_read(struct flash040_context_s *flash040_context,
 uint8_t flash040core_peek(struct flash040_context_s *flash040_context,
                           unsigned int addr);
 
+/* Returns whether the bank was changed since the last call, and clears its
+   flag. flash_dirty is left alone for the code saving the whole image. */
+int flash040core_clear_dirty_bank(struct flash040_context_s *flash040_context,
+                                  unsigned int bank);
+
 struct snapshot_s;
 
 int flash040core_snapshot_write_module(struct snapshot_s *s,
@@ -99,6 +99,58 @@ static int circular_check(unsigned int track, unsigned int sector)
     return 0;
 }
 
+/* The directory of most images lives on a single track, so instead of going
+   through vdrive once per directory block the whole directory track is read
+   into memory with a single access to the image.  Blocks outside of that
+   track (or images that can't be read in one go, like G64) still use the
+   regular sector reads. */
+
+static uint8_t *dir_track_buffer = NULL;
+static unsigned int dir_track_buffer_size;
+static unsigned int dir_track;
+static unsigned int dir_track_sectors;
+
+static void dir_track_read(vdrive_t *vdrive, unsigned int track)
+{
+    int max_sectors;
+
+    dir_track = track;
+    dir_track_sectors = 0;
+
+    max_sectors = vdrive_get_max_sectors(vdrive, track);
+    if (max_sectors <= 0) {
+        return;
+    }
+
+    if (dir_track_buffer_size < (unsigned int)max_sectors * 256) {
+        dir_track_buffer_size = (unsigned int)max_sectors * 256;
+        dir_track_buffer = lib_realloc(dir_track_buffer, dir_track_buffer_size);
+    }
+
+    if (vdrive_read_sectors(vdrive, dir_track_buffer, track, 0,
+                            (unsigned int)max_sectors) == 0) {
+        dir_track_sectors = (unsigned int)max_sectors;
+    }
+}
+
+static int dir_read_sector(vdrive_t *vdrive, uint8_t *buffer,
+                           unsigned int track, unsigned int sector)
+{
+    if (track == dir_track && sector < dir_track_sectors) {
+        memcpy(buffer, dir_track_buffer + sector * 256, 256);
+        return 0;
+    }
+    return vdrive_read_sector(vdrive, buffer, track, sector);
+}
+
+static void dir_track_free(void)
+{
+    lib_free(dir_track_buffer);
+    dir_track_buffer = NULL;
+    dir_track_buffer_size = 0;
+    dir_track_sectors = 0;
+}
+
 image_contents_t *diskcontents_block_read(vdrive_t *vdrive, int part)
 {
     image_contents_t *contents;
@@ -140,16 +192,18 @@ image_contents_t *diskcontents_block_read(vdrive_t *vdrive, int part)
     contents->file_list = NULL;
 
     circular_check_init();
+    dir_track_read(vdrive, curr_track);
 
     while (1) {
         uint8_t *p;
         int j;
 
-        retval = vdrive_read_sector(vdrive, buffer, curr_track, curr_sector);
+        retval = dir_read_sector(vdrive, buffer, curr_track, curr_sector);
 
         if (retval != 0
             || circular_check(curr_track, curr_sector)) {
             circular_check_free();
+            dir_track_free();
             return contents;
         }
 
@@ -198,5 +252,6 @@ image_contents_t *diskcontents_block_read(vdrive_t *vdrive, int part)
     }
 
     circular_check_free();
+    dir_track_free();
     return contents;
 }
@@ -39,6 +39,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "archdep.h"
 #include "charset.h"
 #include "diskcontents.h"
 #include "imagecontents.h"
@@ -47,6 +48,16 @@
 #include "types.h"
 #include "util.h"
 
+#ifdef USE_VICE_THREAD
+#include <pthread.h>
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+#define CACHE_LOCK()    pthread_mutex_lock(&cache_lock)
+#define CACHE_UNLOCK()  pthread_mutex_unlock(&cache_lock)
+#else
+#define CACHE_LOCK()
+#define CACHE_UNLOCK()
+#endif
+
 
 /* ------------------------------------------------------------------------- */
 
@@ -349,3 +360,175 @@ char *image_contents_filename_by_number(image_contents_t *contents,
     return s;
 }
 
+
+
+/* ------------------------------------------------------------------------- */
+
+/*
+ * Image contents cache
+ *
+ * The file choosers call the contents readers for every image the user
+ * selects while browsing, and autostart reads the directory of the same image
+ * again before attaching it. Reading a directory means opening the image,
+ * reading the BAM and following the directory chain, so the results are kept
+ * in a small LRU cache keyed on the file name and the reader used, and
+ * validated against the modification time and size of the file.
+ */
+
+/** \brief  Number of entries in the image contents cache
+ */
+#define IMAGE_CONTENTS_CACHE_SIZE   256
+
+/** \brief  Image contents cache entry
+ */
+typedef struct image_contents_cache_entry_s {
+    char *path;                     /**< file name, NULL for unused entries */
+    read_contents_func_type reader; /**< reader used to obtain \a contents */
+    uint64_t mtime;                 /**< modification time of the file */
+    uint64_t size;                  /**< size of the file */
+    unsigned int stamp;             /**< last use, for LRU eviction */
+    image_contents_t *contents;     /**< contents, NULL if not an image */
+} image_contents_cache_entry_t;
+
+static image_contents_cache_entry_t cache[IMAGE_CONTENTS_CACHE_SIZE];
+static unsigned int cache_stamp = 0;
+
+
+/** \brief  Create a deep copy of \a contents
+ *
+ * \param[in]   contents    image contents object
+ *
+ * \return  new image contents object, free with image_contents_destroy()
+ */
+static image_contents_t *image_contents_dup(const image_contents_t *contents)
+{
+    image_contents_t *copy;
+    image_contents_file_list_t *node;
+    image_contents_file_list_t *lp = NULL;
+
+    copy = lib_malloc(sizeof *copy);
+    memcpy(copy, contents, sizeof *copy);
+    copy->file_list = NULL;
+
+    for (node = contents->file_list; node != NULL; node = node->next) {
+        image_contents_file_list_t *new_node = lib_malloc(sizeof *new_node);
+
+        memcpy(new_node, node, sizeof *new_node);
+        new_node->prev = lp;
+        new_node->next = NULL;
+        if (lp == NULL) {
+            copy->file_list = new_node;
+        } else {
+            lp->next = new_node;
+        }
+        lp = new_node;
+    }
+    return copy;
+}
+
+
+/** \brief  Release the resources held by a cache entry
+ *
+ * \param[in,out]   entry   cache entry
+ */
+static void cache_entry_clear(image_contents_cache_entry_t *entry)
+{
+    if (entry->path != NULL) {
+        lib_free(entry->path);
+        entry->path = NULL;
+    }
+    if (entry->contents != NULL) {
+        image_contents_destroy(entry->contents);
+        entry->contents = NULL;
+    }
+    entry->reader = NULL;
+}
+
+
+/** \brief  Read image contents using the cache
+ *
+ * Look up \a path in the cache and return a copy of the cached contents if
+ * the file didn't change since it was cached, otherwise call \a reader and
+ * store its result in the cache. Failed reads are cached as well, so browsing
+ * a directory with lots of non-image files doesn't keep trying to open them.
+ *
+ * \param[in]   path    path to image file
+ * \param[in]   reader  function to read the contents of \a path
+ *
+ * \return  image contents object, free with image_contents_destroy(), or
+ *          `NULL` when \a path couldn't be read by \a reader
+ */
+image_contents_t *image_contents_read_cached(const char *path,
+                                             read_contents_func_type reader)
+{
+    image_contents_cache_entry_t *entry;
+    image_contents_t *contents;
+    uint64_t mtime;
+    uint64_t size;
+    int i;
+
+    if (path == NULL || archdep_file_mtime(path, &mtime, &size) != 0) {
+        return reader(path);
+    }
+
+    CACHE_LOCK();
+    for (i = 0; i < IMAGE_CONTENTS_CACHE_SIZE; i++) {
+        entry = &cache[i];
+        if (entry->path != NULL
+                && entry->reader == reader
+                && strcmp(entry->path, path) == 0) {
+            if (entry->mtime == mtime && entry->size == size) {
+                entry->stamp = ++cache_stamp;
+                contents = NULL;
+                if (entry->contents != NULL) {
+                    contents = image_contents_dup(entry->contents);
+                }
+                CACHE_UNLOCK();
+                return contents;
+            }
+            /* stale */
+            cache_entry_clear(entry);
+            break;
+        }
+    }
+    CACHE_UNLOCK();
+
+    contents = reader(path);
+
+    CACHE_LOCK();
+    /* use a free entry, or evict the least recently used one */
+    entry = &cache[0];
+    for (i = 0; i < IMAGE_CONTENTS_CACHE_SIZE; i++) {
+        if (cache[i].path == NULL) {
+            entry = &cache[i];
+            break;
+        }
+        if (cache[i].stamp < entry->stamp) {
+            entry = &cache[i];
+        }
+    }
+    cache_entry_clear(entry);
+    entry->path = lib_strdup(path);
+    entry->reader = reader;
+    entry->mtime = mtime;
+    entry->size = size;
+    entry->stamp = ++cache_stamp;
+    entry->contents = contents != NULL ? image_contents_dup(contents) : NULL;
+    CACHE_UNLOCK();
+
+    return contents;
+}
+
+
+/** \brief  Free all entries in the image contents cache
+ */
+void image_contents_cache_shutdown(void)
+{
+    int i;
+
+    CACHE_LOCK();
+    for (i = 0; i < IMAGE_CONTENTS_CACHE_SIZE; i++) {
+        cache_entry_clear(&cache[i]);
+    }
+    CACHE_UNLOCK();
+}
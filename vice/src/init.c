@@ -34,6 +34,7 @@
 #include "debug.h"
 #include "drive.h"
 #include "initcmdline.h"
+#include "instrument.h"
 #include "keyboard.h"
 #include "log.h"
 #include "machine-bus.h"
@@ -120,6 +121,10 @@ int init_resources(void)
         init_resource_fail("vsync");
         return -1;
     }
+    if (instrument_resources_init() < 0) {
+        init_resource_fail("instrumentation");
+        return -1;
+    }
     if (sound_resources_init() < 0) {
         init_resource_fail("sound");
         return -1;
@@ -205,6 +210,10 @@ int init_cmdline_options(void)
         init_cmdline_options_fail("vsync");
         return -1;
     }
+    if (instrument_cmdline_options_init() < 0) {
+        init_cmdline_options_fail("instrumentation");
+        return -1;
+    }
     if (sound_cmdline_options_init() < 0) {
         init_cmdline_options_fail("sound");
         return -1;
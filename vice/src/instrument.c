@@ -0,0 +1,582 @@
+/*
+ * instrument.c - Host time instrumentation of the emulation.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "alarm.h"
+#include "archdep.h"
+#include "cmdline.h"
+#include "instrument.h"
+#include "lib.h"
+#include "machine.h"
+#include "maincpu.h"
+#include "resources.h"
+#include "types.h"
+#include "video.h"
+
+#ifdef USE_VICE_THREAD
+#   include <pthread.h>
+static pthread_mutex_t instrument_lock = PTHREAD_MUTEX_INITIALIZER;
+#   define INSTRUMENT_LOCK() pthread_mutex_lock(&instrument_lock)
+#   define INSTRUMENT_UNLOCK() pthread_mutex_unlock(&instrument_lock)
+#else
+#   define INSTRUMENT_LOCK()
+#   define INSTRUMENT_UNLOCK()
+#endif
+
+/* maximum nesting of scopes, deeper scopes are charged to the outer one */
+#define INSTRUMENT_STACK_DEPTH  32
+
+int instrument_enabled = 0;
+
+/* value of the "Instrumentation" resource, instrument_enabled follows it at
+   the next vsync, so the scope stack is only ever touched by the emulation
+   thread */
+static int instrument_resource = 0;
+
+static const char * const scope_names[INSTRUMENT_NUM_SCOPES] = {
+    "cpu",
+    "alarms",
+    "video",
+    "sound",
+    "drives",
+    "render",
+    "sleep",
+    "uilock"
+};
+
+/* open scopes, the innermost one is charged; the CPU loop at the bottom is
+   never left. The slot is the alarm slot or the drive unit, or -1. */
+typedef struct scope_entry_s {
+    instrument_scope_t scope;
+    int slot;
+} scope_entry_t;
+
+static scope_entry_t scope_stack[INSTRUMENT_STACK_DEPTH];
+static int scope_depth;
+
+/* scopes that were entered while the stack was full */
+static int scope_overflow;
+
+/* host time up to which the open scope has been charged */
+static uint64_t last_mark_ns;
+
+/* the second that is being collected, owned by the emulation thread */
+static instrument_second_t current;
+static uint64_t second_start_ns;
+static CLOCK second_start_clk;
+
+/* names of the alarms measured so far, the index is the slot cached in
+   alarm_t, kept when the instrumentation is restarted. Only the emulation
+   thread adds names, it does so under the lock as the UI reads them. */
+static char *alarm_names[INSTRUMENT_ALARM_SLOTS];
+static int num_alarm_names;
+
+/* ring of complete seconds, shared with the UI and protected by the lock */
+static instrument_second_t history[INSTRUMENT_HISTORY];
+static unsigned int history_next;
+static unsigned int history_generation;
+
+/* number of video chips whose render bands are kept, x128 has two */
+#define INSTRUMENT_RENDER_CHIPS 2
+
+/* render time of each band in the last frame rendered for a video chip, in
+   ticks. Written by the renderer, which may run on the render thread, and
+   protected by the lock. */
+typedef struct render_bands_s {
+    char chip_name[16];         /* empty for an unused entry */
+    unsigned int count;
+    unsigned int last[VIDEO_RENDER_BANDS_MAX];
+    unsigned int average[VIDEO_RENDER_BANDS_MAX];
+} render_bands_t;
+
+static render_bands_t render_bands[INSTRUMENT_RENDER_CHIPS];
+
+/* ------------------------------------------------------------------------- */
+
+static void instrument_reset(void)
+{
+    uint64_t now = tick_now_nano();
+
+    scope_stack[0].scope = INSTRUMENT_CPU;
+    scope_stack[0].slot = -1;
+    scope_depth = 0;
+    scope_overflow = 0;
+
+    memset(&current, 0, sizeof(current));
+    last_mark_ns = now;
+    second_start_ns = now;
+    second_start_clk = maincpu_clk;
+
+    INSTRUMENT_LOCK();
+    history_next = 0;
+    history_generation = 0;
+    memset(render_bands, 0, sizeof(render_bands));
+    INSTRUMENT_UNLOCK();
+}
+
+/* charge the time since the last mark to the innermost scope */
+static inline void charge(uint64_t now)
+{
+    uint64_t delta = now - last_mark_ns;
+    scope_entry_t *top = &scope_stack[scope_depth];
+
+    current.scope_ns[top->scope] += delta;
+    if (top->slot >= 0) {
+        if (top->scope == INSTRUMENT_ALARMS) {
+            current.alarm_ns[top->slot] += delta;
+        } else if (top->scope == INSTRUMENT_DRIVES) {
+            current.drive_ns[top->slot] += delta;
+        }
+    }
+    last_mark_ns = now;
+}
+
+static void push(instrument_scope_t scope, int slot)
+{
+    charge(tick_now_nano());
+
+    if (scope_depth < INSTRUMENT_STACK_DEPTH - 1) {
+        scope_depth++;
+        scope_stack[scope_depth].scope = scope;
+        scope_stack[scope_depth].slot = slot;
+    } else {
+        scope_overflow++;
+    }
+}
+
+void instrument_enter(instrument_scope_t scope)
+{
+    push(scope, -1);
+}
+
+void instrument_enter_drive(unsigned int unit)
+{
+    push(INSTRUMENT_DRIVES, unit < INSTRUMENT_DRIVE_UNITS ? (int)unit : -1);
+}
+
+void instrument_leave(void)
+{
+    charge(tick_now_nano());
+
+    /* a scope can be left without having been entered when the
+       instrumentation was switched on in between, never pop the CPU loop */
+    if (scope_overflow > 0) {
+        scope_overflow--;
+    } else if (scope_depth > 0) {
+        scope_depth--;
+    }
+}
+
+static int alarm_slot(const char *name)
+{
+    int i;
+
+    if (name == NULL) {
+        name = "(unnamed)";
+    }
+
+    for (i = 0; i < num_alarm_names; i++) {
+        if (strcmp(alarm_names[i], name) == 0) {
+            return i;
+        }
+    }
+    if (num_alarm_names < INSTRUMENT_ALARM_SLOTS - 1) {
+        char *copy = lib_strdup(name);
+
+        INSTRUMENT_LOCK();
+        alarm_names[num_alarm_names] = copy;
+        i = num_alarm_names++;
+        INSTRUMENT_UNLOCK();
+        return i;
+    }
+
+    /* shared by the alarms that did not get a slot of their own */
+    if (alarm_names[INSTRUMENT_ALARM_SLOTS - 1] == NULL) {
+        char *copy = lib_strdup("(other)");
+
+        INSTRUMENT_LOCK();
+        alarm_names[INSTRUMENT_ALARM_SLOTS - 1] = copy;
+        num_alarm_names = INSTRUMENT_ALARM_SLOTS;
+        INSTRUMENT_UNLOCK();
+    }
+    return INSTRUMENT_ALARM_SLOTS - 1;
+}
+
+void instrument_alarm_dispatch(alarm_t *alarm, CLOCK offset)
+{
+    int slot = alarm->instrument_slot;
+
+    if (slot < 0) {
+        slot = alarm_slot(alarm->name);
+        alarm->instrument_slot = slot;
+    }
+
+    current.alarm_calls[slot]++;
+    push(INSTRUMENT_ALARMS, slot);
+
+    /* the callback may destroy the alarm, don't touch it afterwards */
+    (alarm->callback)(offset, alarm->data);
+
+    instrument_leave();
+}
+
+void instrument_add_drive_cycles(unsigned int unit, CLOCK cycles)
+{
+    if (unit < INSTRUMENT_DRIVE_UNITS) {
+        current.drive_cycles[unit] += cycles;
+    }
+}
+
+/* Called every frame by the emulation thread. Applies a change of the
+   resource and closes the second when it is over. */
+void instrument_vsync(void)
+{
+    uint64_t now;
+
+    if (instrument_enabled != instrument_resource) {
+        if (instrument_resource) {
+            instrument_reset();
+        }
+        instrument_enabled = instrument_resource;
+        return;
+    }
+    if (!instrument_enabled) {
+        return;
+    }
+
+    now = tick_now_nano();
+    current.frames++;
+
+    if (now - second_start_ns < NANO_PER_SECOND) {
+        return;
+    }
+
+    charge(now);
+    current.wall_ns = now - second_start_ns;
+    current.maincpu_cycles = (maincpu_clk >= second_start_clk) ? maincpu_clk - second_start_clk : 0;
+
+    INSTRUMENT_LOCK();
+    history[history_next] = current;
+    history_next = (history_next + 1) % INSTRUMENT_HISTORY;
+    history_generation++;
+    INSTRUMENT_UNLOCK();
+
+    memset(&current, 0, sizeof(current));
+    second_start_ns = now;
+    second_start_clk = maincpu_clk;
+}
+
+/* ------------------------------------------------------------------------- */
+
+const char *instrument_scope_name(instrument_scope_t scope)
+{
+    if ((unsigned int)scope < INSTRUMENT_NUM_SCOPES) {
+        return scope_names[scope];
+    }
+    return "?";
+}
+
+const char *instrument_alarm_name(int slot)
+{
+    const char *name = NULL;
+
+    INSTRUMENT_LOCK();
+    if (slot >= 0 && slot < num_alarm_names) {
+        name = alarm_names[slot];
+    }
+    INSTRUMENT_UNLOCK();
+
+    /* names are never freed, so the pointer stays valid */
+    return name;
+}
+
+void instrument_render_bands(const char *chip_name, unsigned int count,
+                             const unsigned int *last, const unsigned int *average)
+{
+    render_bands_t *chip = NULL;
+    int i;
+
+    if (count > VIDEO_RENDER_BANDS_MAX) {
+        count = VIDEO_RENDER_BANDS_MAX;
+    }
+
+    INSTRUMENT_LOCK();
+    for (i = 0; i < INSTRUMENT_RENDER_CHIPS; i++) {
+        if (render_bands[i].chip_name[0] == 0
+            || strncmp(render_bands[i].chip_name, chip_name, sizeof(render_bands[i].chip_name) - 1) == 0) {
+            chip = &render_bands[i];
+            break;
+        }
+    }
+    if (chip != NULL) {
+        strncpy(chip->chip_name, chip_name, sizeof(chip->chip_name) - 1);
+        chip->count = count;
+        memcpy(chip->last, last, count * sizeof(chip->last[0]));
+        memcpy(chip->average, average, count * sizeof(chip->average[0]));
+    }
+    INSTRUMENT_UNLOCK();
+}
+
+bool instrument_get_last_second(instrument_second_t *second)
+{
+    bool valid;
+
+    INSTRUMENT_LOCK();
+    valid = history_generation > 0;
+    if (valid) {
+        *second = history[(history_next + INSTRUMENT_HISTORY - 1) % INSTRUMENT_HISTORY];
+    }
+    INSTRUMENT_UNLOCK();
+
+    return valid;
+}
+
+unsigned int instrument_get_generation(void)
+{
+    unsigned int generation;
+
+    INSTRUMENT_LOCK();
+    generation = history_generation;
+    INSTRUMENT_UNLOCK();
+
+    return generation;
+}
+
+/* number of alarms listed in the summary */
+#define SUMMARY_ALARMS  5
+
+bool instrument_format_summary(char *buffer, size_t size)
+{
+    instrument_second_t second;
+    double wall_ms;
+    size_t len;
+    int top[SUMMARY_ALARMS];
+    int num_top = 0;
+    int i, j;
+
+    if (size == 0) {
+        return false;
+    }
+    buffer[0] = 0;
+
+    if (!instrument_get_last_second(&second) || second.wall_ns == 0) {
+        return false;
+    }
+    wall_ms = second.wall_ns / 1000000.0;
+
+    len = (size_t)snprintf(buffer, size, "%u frames, %"PRIu64" cycles in %.1f ms",
+                           second.frames, (uint64_t)second.maincpu_cycles, wall_ms);
+
+    for (i = 0; i < INSTRUMENT_NUM_SCOPES && len < size; i++) {
+        len += (size_t)snprintf(buffer + len, size - len, "\n%-8s %7.1f ms %5.1f%%",
+                                scope_names[i], second.scope_ns[i] / 1000000.0,
+                                100.0 * second.scope_ns[i] / second.wall_ns);
+    }
+
+    /* the most expensive alarms, by insertion into a short sorted list */
+    INSTRUMENT_LOCK();
+    for (i = 0; i < num_alarm_names; i++) {
+        if (second.alarm_ns[i] == 0) {
+            continue;
+        }
+        for (j = num_top; j > 0 && second.alarm_ns[top[j - 1]] < second.alarm_ns[i]; j--) {
+            if (j < SUMMARY_ALARMS) {
+                top[j] = top[j - 1];
+            }
+        }
+        if (j < SUMMARY_ALARMS) {
+            top[j] = i;
+            if (num_top < SUMMARY_ALARMS) {
+                num_top++;
+            }
+        }
+    }
+    for (i = 0; i < num_top && len < size; i++) {
+        len += (size_t)snprintf(buffer + len, size - len, "\n  %-22s %7.1f ms %6u calls",
+                                alarm_names[top[i]], second.alarm_ns[top[i]] / 1000000.0,
+                                second.alarm_calls[top[i]]);
+    }
+    INSTRUMENT_UNLOCK();
+
+    for (i = 0; i < INSTRUMENT_DRIVE_UNITS && len < size; i++) {
+        if (second.drive_cycles[i] != 0 || second.drive_ns[i] != 0) {
+            len += (size_t)snprintf(buffer + len, size - len, "\n  drive %-16d %7.1f ms %"PRIu64" cycles",
+                                    i + 8, second.drive_ns[i] / 1000000.0,
+                                    (uint64_t)second.drive_cycles[i]);
+        }
+    }
+
+    INSTRUMENT_LOCK();
+    for (i = 0; i < INSTRUMENT_RENDER_CHIPS && render_bands[i].chip_name[0] != 0; i++) {
+        for (j = 0; j < (int)render_bands[i].count && len < size; j++) {
+            len += (size_t)snprintf(buffer + len, size - len, "\n  %s band %-12d %7.2f ms last %7.2f ms avg",
+                                    render_bands[i].chip_name, j,
+                                    render_bands[i].last[j] * 1000.0 / TICK_PER_SECOND,
+                                    render_bands[i].average[j] * 1000.0 / TICK_PER_SECOND);
+        }
+    }
+    INSTRUMENT_UNLOCK();
+
+    return true;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void json_string(FILE *fp, const char *s)
+{
+    fputc('"', fp);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') {
+            fputc('\\', fp);
+            fputc(*s, fp);
+        } else if ((unsigned char)*s < 0x20) {
+            fprintf(fp, "\\u%04x", (unsigned int)(unsigned char)*s);
+        } else {
+            fputc(*s, fp);
+        }
+    }
+    fputc('"', fp);
+}
+
+/* Write the ring of seconds, oldest first. Times are in microseconds. */
+int instrument_export_json(const char *filename)
+{
+    instrument_second_t *seconds;
+    const char *names[INSTRUMENT_ALARM_SLOTS];
+    unsigned int count, first, n;
+    int num_names;
+    FILE *fp;
+    int i;
+
+    fp = fopen(filename, MODE_WRITE_TEXT);
+    if (fp == NULL) {
+        return -1;
+    }
+
+    seconds = lib_malloc(sizeof(history));
+
+    INSTRUMENT_LOCK();
+    count = history_generation < INSTRUMENT_HISTORY ? history_generation : INSTRUMENT_HISTORY;
+    first = (history_next + INSTRUMENT_HISTORY - count) % INSTRUMENT_HISTORY;
+    for (n = 0; n < count; n++) {
+        seconds[n] = history[(first + n) % INSTRUMENT_HISTORY];
+    }
+    num_names = num_alarm_names;
+    memcpy(names, alarm_names, sizeof(names));
+    INSTRUMENT_UNLOCK();
+
+    fprintf(fp, "{\n  \"machine\": ");
+    json_string(fp, machine_name);
+    fprintf(fp, ",\n  \"unit\": \"us\",\n  \"seconds\": [");
+
+    for (n = 0; n < count; n++) {
+        instrument_second_t *s = &seconds[n];
+        int first_field;
+
+        fprintf(fp, "%s\n    {\n", n ? "," : "");
+        fprintf(fp, "      \"wall\": %"PRIu64",\n", s->wall_ns / 1000);
+        fprintf(fp, "      \"frames\": %u,\n", s->frames);
+        fprintf(fp, "      \"maincpu_cycles\": %"PRIu64",\n", (uint64_t)s->maincpu_cycles);
+
+        fprintf(fp, "      \"scopes\": {");
+        for (i = 0; i < INSTRUMENT_NUM_SCOPES; i++) {
+            fprintf(fp, "%s \"%s\": %"PRIu64, i ? "," : "", scope_names[i], s->scope_ns[i] / 1000);
+        }
+        fprintf(fp, " },\n");
+
+        fprintf(fp, "      \"alarms\": {");
+        first_field = 1;
+        for (i = 0; i < num_names; i++) {
+            if (s->alarm_calls[i] == 0) {
+                continue;
+            }
+            fprintf(fp, "%s\n        ", first_field ? "" : ",");
+            json_string(fp, names[i]);
+            fprintf(fp, ": { \"time\": %"PRIu64", \"calls\": %u }",
+                    s->alarm_ns[i] / 1000, s->alarm_calls[i]);
+            first_field = 0;
+        }
+        fprintf(fp, "%s},\n", first_field ? " " : "\n      ");
+
+        fprintf(fp, "      \"drives\": {");
+        first_field = 1;
+        for (i = 0; i < INSTRUMENT_DRIVE_UNITS; i++) {
+            if (s->drive_cycles[i] == 0 && s->drive_ns[i] == 0) {
+                continue;
+            }
+            fprintf(fp, "%s \"%d\": { \"time\": %"PRIu64", \"cycles\": %"PRIu64" }",
+                    first_field ? "" : ",", i + 8, s->drive_ns[i] / 1000,
+                    (uint64_t)s->drive_cycles[i]);
+            first_field = 0;
+        }
+        fprintf(fp, " }\n    }");
+    }
+    fprintf(fp, "%s]\n}\n", count ? "\n  " : "");
+
+    lib_free(seconds);
+
+    if (fclose(fp) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* May be called from any thread, instrument_vsync() applies the change. */
+static int set_instrument_enabled(int val, void *param)
+{
+    instrument_resource = val ? 1 : 0;
+    return 0;
+}
+
+static const resource_int_t resources_int[] = {
+    { "Instrumentation", 0, RES_EVENT_NO, NULL,
+      &instrument_resource, set_instrument_enabled, NULL },
+    RESOURCE_INT_LIST_END
+};
+
+int instrument_resources_init(void)
+{
+    return resources_register_int(resources_int);
+}
+
+static const cmdline_option_t cmdline_options[] =
+{
+    { "-instrument", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "Instrumentation", (resource_value_t)1,
+      NULL, "Measure the host time spent in the parts of the emulation" },
+    { "+instrument", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "Instrumentation", (resource_value_t)0,
+      NULL, "Do not measure the host time spent in the parts of the emulation" },
+    CMDLINE_LIST_END
+};
+
+int instrument_cmdline_options_init(void)
+{
+    return cmdline_register_options(cmdline_options);
+}
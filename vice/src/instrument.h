@@ -0,0 +1,130 @@
+/*
+ * instrument.h - Host time instrumentation of the emulation.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_INSTRUMENT_H
+#define VICE_INSTRUMENT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "types.h"
+
+/*
+ * The instrumentation measures where the host time of the emulation thread
+ * goes. The time is split between named scopes, which nest: the time spent
+ * in a scope is charged to the innermost open scope only, so the scopes of
+ * a second add up to the wall clock time of that second. Everything outside
+ * of any other scope is charged to INSTRUMENT_CPU, the CPU loop.
+ *
+ * The alarm scope is further split by the name of the dispatched alarm and
+ * the drive scope by the drive unit. The counters are collected per second
+ * of host time into a ring which keeps the last INSTRUMENT_HISTORY seconds.
+ *
+ * When the instrumentation is disabled the hooks cost a single test of
+ * instrument_enabled.
+ */
+
+typedef enum instrument_scope_e {
+    INSTRUMENT_CPU = 0,     /* CPU loop, everything not in another scope */
+    INSTRUMENT_ALARMS,      /* alarm callbacks, per alarm name */
+    INSTRUMENT_VIDEO,       /* cycle based video chip emulation */
+    INSTRUMENT_SOUND,       /* sound chip emulation and sound output */
+    INSTRUMENT_DRIVES,      /* drive CPUs, per drive unit */
+    INSTRUMENT_RENDER,      /* rendering of the video output */
+    INSTRUMENT_SLEEP,       /* vsync sleep */
+    INSTRUMENT_UILOCK,      /* waiting while the UI holds the main lock */
+    INSTRUMENT_NUM_SCOPES
+} instrument_scope_t;
+
+/* number of distinct alarm names that are measured separately, the alarms
+   beyond that share the last slot */
+#define INSTRUMENT_ALARM_SLOTS  48
+
+#define INSTRUMENT_DRIVE_UNITS  4
+
+/* number of seconds kept in the ring */
+#define INSTRUMENT_HISTORY      60
+
+typedef struct instrument_second_s {
+    uint64_t wall_ns;                               /* host time of the second */
+    uint64_t scope_ns[INSTRUMENT_NUM_SCOPES];       /* host time per scope */
+    uint64_t alarm_ns[INSTRUMENT_ALARM_SLOTS];      /* host time per alarm name */
+    uint32_t alarm_calls[INSTRUMENT_ALARM_SLOTS];   /* dispatches per alarm name */
+    uint64_t drive_ns[INSTRUMENT_DRIVE_UNITS];      /* host time per drive unit */
+    CLOCK maincpu_cycles;                           /* emulated cycles of the computer */
+    CLOCK drive_cycles[INSTRUMENT_DRIVE_UNITS];     /* emulated cycles per drive unit */
+    unsigned int frames;                            /* emulated frames */
+} instrument_second_t;
+
+struct alarm_s;
+
+/* set while the instrumentation is collecting, checked by the hooks */
+extern int instrument_enabled;
+
+void instrument_enter(instrument_scope_t scope);
+void instrument_enter_drive(unsigned int unit);
+void instrument_leave(void);
+void instrument_alarm_dispatch(struct alarm_s *alarm, CLOCK offset);
+void instrument_add_drive_cycles(unsigned int unit, CLOCK cycles);
+void instrument_vsync(void);
+
+/* render time of each band of the last frame rendered for \a chip_name, in
+   ticks, see video_render_get_band_times(). May be called from the render
+   thread. */
+void instrument_render_bands(const char *chip_name, unsigned int count,
+                             const unsigned int *last, const unsigned int *average);
+
+#define INSTRUMENT_ENTER(scope) \
+    do {                                \
+        if (instrument_enabled) {       \
+            instrument_enter(scope);    \
+        }                               \
+    } while (0)
+
+#define INSTRUMENT_LEAVE()              \
+    do {                                \
+        if (instrument_enabled) {       \
+            instrument_leave();         \
+        }                               \
+    } while (0)
+
+const char *instrument_scope_name(instrument_scope_t scope);
+const char *instrument_alarm_name(int slot);
+
+/* copy the last complete second, returns false if there is none yet */
+bool instrument_get_last_second(instrument_second_t *second);
+
+/* number of seconds completed so far, changes when a new second is in */
+unsigned int instrument_get_generation(void);
+
+/* one line per scope of the last complete second, followed by the render
+   time of each band of the last frame, returns false if there is none yet */
+bool instrument_format_summary(char *buffer, size_t size);
+
+/* write the ring of seconds as JSON */
+int instrument_export_json(const char *filename);
+
+int instrument_resources_init(void);
+int instrument_cmdline_options_init(void);
+
+#endif
@@ -35,6 +35,7 @@
 #include "archdep.h"
 #include "attach.h"
 #include "autostart.h"
+#include "blockio.h"
 #include "cmdline.h"
 #include "console.h"
 #include "diskimage.h"
@@ -43,6 +44,7 @@
 #include "fliplist.h"
 #include "fsdevice.h"
 #include "gfxoutput.h"
+#include "imagecontents.h"
 #include "initcmdline.h"
 #include "interrupt.h"
 #include "joystick.h"
@@ -423,6 +425,8 @@ void machine_shutdown(void)
 
     palette_shutdown();
 
+    image_contents_cache_shutdown();
+
     sysfile_shutdown();
 
     log_close_all();
@@ -524,6 +528,9 @@ int machine_common_resources_init(void)
             return -1;
             }
         }
+        if (blockio_resources_init() < 0) {
+            return -1;
+        }
     }
     return resources_register_int(resources_int);
 }
@@ -569,6 +576,11 @@ static const cmdline_option_t cmdline_options_vsid[] =
 
 int machine_common_cmdline_options_init(void)
 {
+    if (machine_class != VICE_MACHINE_VSID) {
+        if (blockio_cmdline_options_init() < 0) {
+            return -1;
+        }
+    }
     if (machine_class == VICE_MACHINE_C128) {
         return cmdline_register_options(cmdline_options_c128);
     } else if (machine_class == VICE_MACHINE_VSID) {
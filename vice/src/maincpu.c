@@ -633,16 +633,22 @@ void maincpu_mainloop(void)
 
 #define GLOBAL_REGS maincpu_regs
 
-#include "6510core.c"
-
-        maincpu_int_status->num_dma_per_opcode = 0;
+/* condition of the loop above, for the threaded dispatch in 6510core.c */
+#define CPU_LOOP_CONDITION() 1
+
+/* run after every instruction */
+#define CPU_INSTRUCTION_DONE                                      \
+    maincpu_int_status->num_dma_per_opcode = 0;                   \
+                                                                  \
+    if (maincpu_clk_limit && (maincpu_clk > maincpu_clk_limit)) { \
+        log_error(LOG_DEFAULT, "cycle limit reached.");           \
+        archdep_vice_exit(1);                                     \
+    }                                                             \
+                                                                  \
+    autostart_advance();
 
-        if (maincpu_clk_limit && (maincpu_clk > maincpu_clk_limit)) {
-            log_error(LOG_DEFAULT, "cycle limit reached.");
-            archdep_vice_exit(1);
-        }
+#include "6510core.c"
 
-        autostart_advance();
 #if 0
         if (CLK > 246171754) {
             debug.maincpu_traceflg = 1;
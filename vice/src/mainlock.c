@@ -43,6 +43,7 @@
 
 #include "archdep.h"
 #include "debug.h"
+#include "instrument.h"
 #include "log.h"
 #include "machine.h"
 #include "mainlock.h"
@@ -152,8 +153,10 @@ void mainlock_initiate_shutdown(void)
  */
 void mainlock_yield(void)
 {
+    INSTRUMENT_ENTER(INSTRUMENT_UILOCK);
     mainlock_yield_begin();
     mainlock_yield_end();
+    INSTRUMENT_LEAVE();
 }
 
 
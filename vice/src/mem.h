@@ -83,6 +83,10 @@ extern store_func_t mem_store;
 extern read_func_t mem_dma_read;
 extern store_func_t mem_dma_store;
 
+/* RAM that mem_dma_store() writes the page of addr to, with no side effects
+   (base[addr] is the byte), or NULL if the page needs the store functions */
+uint8_t *mem_dma_write_base(uint16_t addr);
+
 /* ------------------------------------------------------------------------- */
 
 /* Memory access functions for the monitor.  */
@@ -33,10 +33,12 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "archdep.h"
 #include "interrupt.h"
 #include "lib.h"
 #include "log.h"
 #include "mon_breakpoint.h"
+#include "mon_condition.h"
 #include "mon_disassemble.h"
 #include "mon_util.h"
 #include "montypes.h"
@@ -206,6 +208,7 @@ static void remove_checkpoint(mon_checkpoint_t *cp)
     mem = addr_memspace(cp->start_addr);
 
     mon_delete_conditional(cp->condition);
+    mon_cond_free(cp->compiled_condition);
     lib_free(cp->command);
     cp->command = NULL;
 
@@ -369,7 +372,10 @@ void mon_breakpoint_set_checkpoint_condition(int cp_num,
         if (!cp) {
             mon_out("#%d not a valid checkpoint\n", cp_num);
         } else {
+            mon_delete_conditional(cp->condition);
+            mon_cond_free(cp->compiled_condition);
             cp->condition = cnode;
+            cp->compiled_condition = mon_cond_compile(cnode);
 
             mon_out("Setting checkpoint %d condition to: ", cp_num);
             mon_print_conditional(cnode);
@@ -378,6 +384,60 @@ void mon_breakpoint_set_checkpoint_condition(int cp_num,
     }
 }
 
+/* default number of evaluations of the condition benchmark */
+#define CONDITION_BENCHMARK_COUNT 1000000
+
+/* Time the evaluation of a checkpoint condition, as tree and compiled. */
+void mon_breakpoint_benchmark_condition(int cp_num, int count)
+{
+    mon_checkpoint_t *cp;
+    uint64_t start, tree_ns, compiled_ns;
+    int tree_result = 0, compiled_result = 0;
+    int i;
+
+    cp = mon_breakpoint_find_checkpoint(cp_num);
+    if (!cp) {
+        mon_out("#%d not a valid checkpoint\n", cp_num);
+        return;
+    }
+    if (!cp->condition) {
+        mon_out("Checkpoint %d has no condition.\n", cp_num);
+        return;
+    }
+    if (count <= 0) {
+        count = CONDITION_BENCHMARK_COUNT;
+    }
+
+    start = tick_now_nano();
+    for (i = 0; i < count; i++) {
+        tree_result = mon_evaluate_conditional(cp->condition);
+    }
+    tree_ns = tick_now_nano() - start;
+    mon_out("tree:     %10.0f evaluations/s, result %d\n",
+            tree_ns ? count * 1e9 / tree_ns : 0.0, tree_result);
+
+    if (!cp->compiled_condition) {
+        mon_out("The condition could not be compiled.\n");
+        return;
+    }
+
+    start = tick_now_nano();
+    for (i = 0; i < count; i++) {
+        compiled_result = mon_cond_run(cp->compiled_condition);
+    }
+    compiled_ns = tick_now_nano() - start;
+    mon_out("compiled: %10.0f evaluations/s, result %d",
+            compiled_ns ? count * 1e9 / compiled_ns : 0.0, compiled_result);
+    if (compiled_ns) {
+        mon_out(", %.1f times faster", (double)tree_ns / compiled_ns);
+    }
+    mon_out("\n");
+
+    if (compiled_result != tree_result) {
+        mon_out("Warning: the compiled condition gives a different result.\n");
+    }
+}
+
 
 void mon_breakpoint_set_checkpoint_command(int cp_num, char *cmd)
 {
@@ -519,7 +579,9 @@ bool mon_breakpoint_check_checkpoint(MEMSPACE mem, unsigned int addr, unsigned i
         if (cp && cp->enabled == e_ON) {
             /* If condition test fails, skip this checkpoint */
             if (cp->condition) {
-                if (!mon_evaluate_conditional(cp->condition)) {
+                if (cp->compiled_condition
+                    ? !mon_cond_run(cp->compiled_condition)
+                    : !mon_evaluate_conditional(cp->condition)) {
                     continue;
                 }
             }
@@ -638,6 +700,7 @@ int breakpoint_add_checkpoint(MON_ADDR start_addr, MON_ADDR end_addr,
     new_cp->hit_count = 0;
     new_cp->ignore_count = 0;
     new_cp->condition = NULL;
+    new_cp->compiled_condition = NULL;
     new_cp->command = NULL;
     new_cp->check_load = memory_op & e_load;
     new_cp->check_store = memory_op & e_store;
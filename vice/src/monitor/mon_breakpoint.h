@@ -42,6 +42,7 @@ struct mon_checkpoint_s {
     int hit_count;
     int ignore_count;
     cond_node_t *condition;
+    struct mon_cond_program_s *compiled_condition; /* NULL: evaluate the tree */
     char *command;
     bool stop;
     bool enabled;
@@ -59,6 +60,7 @@ void mon_breakpoint_set_ignore_count(int breakpt_num, int count);
 void mon_breakpoint_print_checkpoints(void);
 void mon_breakpoint_delete_checkpoint(int brknum);
 void mon_breakpoint_set_checkpoint_condition(int brk_num, struct cond_node_s *cnode);
+void mon_breakpoint_benchmark_condition(int brk_num, int count);
 void mon_breakpoint_set_checkpoint_command(int brk_num, char *cmd);
 bool mon_breakpoint_check_checkpoint(MEMSPACE mem, unsigned int addr,
                                      unsigned int lastpc, MEMORY_OP op);
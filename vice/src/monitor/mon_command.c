@@ -207,6 +207,21 @@ static const mon_cmds_t mon_cmd_array[] = {
       NO_FILENAME_ARG
     },
 
+    { "cputrace", "",
+      "[on|off|toggle]",
+      "Record every instruction executed by the computer and drive CPUs,"
+      " with registers and the memory accesses of the computer CPU, to a"
+      " compressed trace file. Without argument, show the current state."
+      " Use the tracedump tool to decode the file.",
+      NO_FILENAME_ARG
+    },
+
+    { "cputracename", "",
+      "\"<filename>\"",
+      "Sets the filename of the instruction trace.",
+      FILENAME_ARG
+    },
+
     { "registers", "r",
       "[<reg_name> = <number> [, <reg_name> = <number>]*]",
       "Assign respective registers (use FL for status flags).  With no"
@@ -250,10 +265,15 @@ static const mon_cmds_t mon_cmd_array[] = {
 
 
     { "profile", "prof",
-      "[on|off]|[flat [num]]|[graph [context] [depth]]|[func <function>]",
-      "Main CPU profiling functions. Commands:\n"
-      "prof on - Start profiling and flush old profiling data.\n"
-      "prof off - Stop profiling.\n"
+      "[on|off [<memspace>]]|[sample [cycles] [<memspace>]]|[flat [num]]|[graph [context] [depth]]|[func <function>]|[export <format> \"<filename>\"]",
+      "CPU profiling functions. The computer and the drive CPUs are profiled separately,"
+      " the commands work on the CPU of the default memspace (see 'device') unless"
+      " a memspace is given. Commands:\n"
+      "prof - Show the profiling state of all CPUs.\n"
+      "prof on [<memspace>] - Start profiling and flush old profiling data.\n"
+      "prof off [<memspace>] - Stop profiling.\n"
+      "prof sample [<cycles=1000>] [<memspace>] - Start sampling the call stack every 'cycles' cycles and flush old profiling data."
+      " Much faster than 'prof on', cycle counts are estimates and calls are not counted.\n"
       "prof flat [<num=20>] - Show flat summary of 'num' top functions sorted by self time.\n"
       "prof graph [<ctx>] [depth <d>] Show callgraph up to 'd' levels deep. If 'ctx' is given, zoom on that subtree.\n"
       "prof func <function> - Show aggregate statistics for a function including callers and callees.\n"
@@ -261,7 +281,19 @@ static const mon_cmds_t mon_cmd_array[] = {
       "prof context <ctx> - Detailed context information including "
       " per-instruction profiling for function"
       " in a call graph context.\n"
-      "prof clear <function> - Clears all profiling stats for function.\n",
+      "prof clear <function> - Clears all profiling stats for function.\n"
+      "prof export folded|callgrind \"<filename>\" - Save the profiling data of all CPUs as folded stacks"
+      " (for flame graphs) or in callgrind format (for KCachegrind).\n",
+      NO_FILENAME_ARG
+    },
+
+    { "instrument", "",
+      "[on|off|toggle]|[export \"<filename>\"]",
+      "Measure the host time spent in the parts of the emulation: the CPU"
+      " loop, alarms by name, video, sound, drives, rendering, vsync sleep and"
+      " waiting for the UI. Without argument, show the last second.\n"
+      "instrument export \"<filename>\" - Save the last minute, second by"
+      " second, as JSON.",
       NO_FILENAME_ARG
     },
 
@@ -531,7 +563,7 @@ static const mon_cmds_t mon_cmd_array[] = {
     },
 
     { "condition", "cond",
-      "<checknum> if <cond_expr>",
+      "<checknum> if <cond_expr>|bench [<count>]",
     /* 12345678901234567890123456789012345678901234567890123456789012345678901234567890 */
       "Each time the specified checkpoint is examined, the condition is evaluated. If"
       " it evalutes to true, the checkpoint is activated. Otherwise, it is ignored. If"
@@ -551,7 +583,9 @@ static const mon_cmds_t mon_cmd_array[] = {
       " i.e you can break only if the vic register $d020 is $f0."
       " use the form @[bankname]:[$<address>] | [.label].\n"
       " Note this is for the C : memspace only.\n"
-      " Examples : if @io:$d020 == $f0, if @io:.vicBorder == $f0",
+      " Examples : if @io:$d020 == $f0, if @io:.vicBorder == $f0\n"
+      "'cond <checknum> bench [<count>]' evaluates the condition <count> times"
+      " (default 1000000) and shows how fast it is evaluated.",
       NO_FILENAME_ARG
     },
 
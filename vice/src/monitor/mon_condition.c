@@ -0,0 +1,389 @@
+/*
+ * mon_condition.c - The VICE built-in monitor, checkpoint condition compiler.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "lib.h"
+#include "log.h"
+#include "mon_condition.h"
+#include "montypes.h"
+#include "monitor.h"
+
+/* deepest evaluation stack a program may need */
+#define COND_STACK_SIZE 32
+
+enum cond_opcode_e {
+    COND_CONST,         /* push value */
+    COND_REG,           /* push register regid of memspace mem */
+    COND_RASTERLINE,    /* push the current raster line */
+    COND_CYCLE,         /* push the current raster cycle */
+    COND_PEEK,          /* push byte at value, through the peek function */
+    COND_PEEK_TOP,      /* replace top with the byte at top, ditto */
+    COND_READ,          /* push byte at value, no peek function available */
+    COND_READ_TOP,      /* replace top with the byte at top, ditto */
+    COND_AND_JUMP,      /* if top is 0 jump to value, else pop */
+    COND_OR_JUMP,       /* if top is not 0 make it 1 and jump, else pop */
+    COND_BOOL,          /* make top 0 or 1 */
+    COND_EQU,           /* binary operators, pop b (or take the immediate
+                           operand), replace a with a op b */
+    COND_NEQ,
+    COND_GT,
+    COND_LT,
+    COND_GTE,
+    COND_LTE,
+    COND_ADD,
+    COND_SUB,
+    COND_MUL,
+    COND_DIV,
+    COND_BINARY_AND,
+    COND_BINARY_OR
+};
+
+typedef struct cond_insn_s {
+    int opcode;
+    int value;          /* constant, address, jump target or immediate */
+    int immediate;      /* binary operator with a constant right operand */
+    int bank;           /* memory bank of the peeks */
+    MEMSPACE mem;       /* memspace of COND_REG */
+    int regid;          /* register of COND_REG */
+} cond_insn_t;
+
+struct mon_cond_program_s {
+    cond_insn_t *insns;
+    int num_insns;
+    int max_insns;
+    int depth;          /* stack depth at the end of the code so far */
+    int max_depth;
+
+    /* resolved once for all memory and raster operands, which always
+       refer to the computer */
+    uint8_t (*peek)(int bank, uint16_t addr, void *context);
+    void *peek_context;
+    void (*get_line_cycle)(unsigned int *line, unsigned int *cycle, int *half_cycle);
+};
+
+/* binary operators of the tree, in the order of enum t_conditional */
+static const int binary_opcodes[] = {
+    -1,                 /* e_INV */
+    COND_EQU,
+    COND_NEQ,
+    COND_GT,
+    COND_LT,
+    COND_GTE,
+    COND_LTE,
+    -1,                 /* e_LOGICAL_AND, compiled to jumps */
+    -1,                 /* e_LOGICAL_OR, ditto */
+    COND_ADD,
+    COND_SUB,
+    COND_MUL,
+    COND_DIV,
+    COND_BINARY_AND,
+    COND_BINARY_OR
+};
+
+/* ------------------------------------------------------------------------- */
+
+static cond_insn_t *emit(mon_cond_program_t *program, int opcode, int value, int stack_change)
+{
+    cond_insn_t *insn;
+
+    if (program->num_insns == program->max_insns) {
+        program->max_insns *= 2;
+        program->insns = lib_realloc(program->insns, program->max_insns * sizeof(cond_insn_t));
+    }
+    insn = &program->insns[program->num_insns++];
+    memset(insn, 0, sizeof(cond_insn_t));
+    insn->opcode = opcode;
+    insn->value = value;
+
+    program->depth += stack_change;
+    if (program->depth > program->max_depth) {
+        program->max_depth = program->depth;
+    }
+    return insn;
+}
+
+static int apply_binary(int opcode, int value_1, int value_2)
+{
+    switch (opcode) {
+        case COND_EQU:
+            return value_1 == value_2;
+        case COND_NEQ:
+            return value_1 != value_2;
+        case COND_GT:
+            return value_1 > value_2;
+        case COND_LT:
+            return value_1 < value_2;
+        case COND_GTE:
+            return value_1 >= value_2;
+        case COND_LTE:
+            return value_1 <= value_2;
+        case COND_ADD:
+            return value_1 + value_2;
+        case COND_SUB:
+            return value_1 - value_2;
+        case COND_MUL:
+            return value_1 * value_2;
+        case COND_DIV:
+            if (value_2 == 0) {
+                log_error(LOG_DEFAULT, "Division by zero in conditional\n");
+                return 0;
+            }
+            return value_1 / value_2;
+        case COND_BINARY_AND:
+            return value_1 & value_2;
+        case COND_BINARY_OR:
+            return value_1 | value_2;
+        default:
+            return 0;
+    }
+}
+
+static int compile_node(mon_cond_program_t *program, cond_node_t *cnode)
+{
+    if (cnode->operation != e_INV) {
+        int start = program->num_insns;
+        int opcode;
+
+        if (!(cnode->child1 && cnode->child2)
+            || cnode->operation < 0
+            || cnode->operation >= (int)(sizeof(binary_opcodes) / sizeof(binary_opcodes[0]))) {
+            return -1;
+        }
+
+        if (cnode->operation == e_LOGICAL_AND || cnode->operation == e_LOGICAL_OR) {
+            int jump;
+
+            if (compile_node(program, cnode->child1) < 0) {
+                return -1;
+            }
+            jump = program->num_insns;
+            emit(program, cnode->operation == e_LOGICAL_AND ? COND_AND_JUMP : COND_OR_JUMP, 0, -1);
+            if (compile_node(program, cnode->child2) < 0) {
+                return -1;
+            }
+            emit(program, COND_BOOL, 0, 0);
+            program->insns[jump].value = program->num_insns;
+            return 0;
+        }
+
+        opcode = binary_opcodes[cnode->operation];
+        if (compile_node(program, cnode->child1) < 0
+            || compile_node(program, cnode->child2) < 0) {
+            return -1;
+        }
+
+        /* fold operations on two constants, except a division by zero
+           which has to complain every time it is evaluated */
+        if (program->num_insns == start + 2
+            && program->insns[start].opcode == COND_CONST
+            && program->insns[start + 1].opcode == COND_CONST
+            && !(opcode == COND_DIV && program->insns[start + 1].value == 0)) {
+            program->insns[start].value = apply_binary(opcode,
+                                                       program->insns[start].value,
+                                                       program->insns[start + 1].value);
+            program->num_insns--;
+            program->depth--;
+            return 0;
+        }
+
+        /* a constant right operand becomes part of the operator */
+        if (program->insns[program->num_insns - 1].opcode == COND_CONST
+            && program->num_insns - 1 > start) {
+            cond_insn_t *insn = &program->insns[program->num_insns - 1];
+
+            insn->opcode = opcode;
+            insn->immediate = 1;
+            program->depth--;
+            return 0;
+        }
+
+        emit(program, opcode, 0, -1);
+        return 0;
+    }
+
+    if (cnode->is_reg) {
+        MEMSPACE mem = reg_memspace(cnode->reg_num);
+        int regid = reg_regid(cnode->reg_num);
+        cond_insn_t *insn;
+
+        if (regid == e_Rasterline || regid == e_Cycle) {
+            if (program->get_line_cycle == NULL) {
+                return -1;
+            }
+            emit(program, regid == e_Rasterline ? COND_RASTERLINE : COND_CYCLE, 0, 1);
+            return 0;
+        }
+        if (mem < FIRST_SPACE || mem > LAST_SPACE) {
+            return -1;
+        }
+        insn = emit(program, COND_REG, 0, 1);
+        insn->mem = mem;
+        insn->regid = regid;
+        return 0;
+    }
+
+    if (cnode->banknum >= 0) {
+        cond_insn_t *insn;
+
+        if (cnode->child1 != NULL) {
+            if (compile_node(program, cnode->child1) < 0) {
+                return -1;
+            }
+            insn = emit(program, program->peek ? COND_PEEK_TOP : COND_READ_TOP, 0, 0);
+        } else {
+            insn = emit(program, program->peek ? COND_PEEK : COND_READ,
+                        addr_location(cnode->value), 1);
+        }
+        insn->bank = cnode->banknum;
+        return 0;
+    }
+
+    emit(program, COND_CONST, cnode->value, 1);
+    return 0;
+}
+
+mon_cond_program_t *mon_cond_compile(cond_node_t *cnode)
+{
+    mon_cond_program_t *program;
+    monitor_interface_t *iface = mon_interfaces[e_comp_space];
+
+    if (cnode == NULL || iface == NULL) {
+        return NULL;
+    }
+
+    program = lib_calloc(1, sizeof(mon_cond_program_t));
+    program->max_insns = 16;
+    program->insns = lib_malloc(program->max_insns * sizeof(cond_insn_t));
+    program->peek = iface->mem_bank_peek;
+    program->peek_context = iface->context;
+    program->get_line_cycle = iface->get_line_cycle;
+
+    if (compile_node(program, cnode) < 0 || program->max_depth > COND_STACK_SIZE) {
+        mon_cond_free(program);
+        return NULL;
+    }
+    return program;
+}
+
+void mon_cond_free(mon_cond_program_t *program)
+{
+    if (program != NULL) {
+        lib_free(program->insns);
+        lib_free(program);
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* like the memory operands of the tree, without the peek function */
+static uint8_t read_mem(int bank, uint16_t addr)
+{
+    uint8_t value;
+    int old_sidefx = sidefx;
+
+    sidefx = 0;
+    value = mon_get_mem_val_ex(e_comp_space, bank, addr);
+    sidefx = old_sidefx;
+
+    return value;
+}
+
+int mon_cond_run(const mon_cond_program_t *program)
+{
+    int stack[COND_STACK_SIZE];
+    int sp = -1;
+    const cond_insn_t *insn = program->insns;
+    const cond_insn_t *end = program->insns + program->num_insns;
+    unsigned int line, cycle;
+    int half_cycle;
+    int operand;
+
+    while (insn < end) {
+        switch (insn->opcode) {
+            case COND_CONST:
+                stack[++sp] = insn->value;
+                break;
+            case COND_REG:
+                stack[++sp] = (int)(monitor_cpu_for_memspace[insn->mem]->mon_register_get_val)
+                                        (insn->mem, insn->regid);
+                break;
+            case COND_RASTERLINE:
+                program->get_line_cycle(&line, &cycle, &half_cycle);
+                stack[++sp] = (int)line;
+                break;
+            case COND_CYCLE:
+                program->get_line_cycle(&line, &cycle, &half_cycle);
+                stack[++sp] = (int)cycle;
+                break;
+            case COND_PEEK:
+                stack[++sp] = program->peek(insn->bank, (uint16_t)insn->value, program->peek_context);
+                break;
+            case COND_PEEK_TOP:
+                stack[sp] = program->peek(insn->bank, (uint16_t)stack[sp], program->peek_context);
+                break;
+            case COND_READ:
+                stack[++sp] = read_mem(insn->bank, (uint16_t)insn->value);
+                break;
+            case COND_READ_TOP:
+                stack[sp] = read_mem(insn->bank, (uint16_t)stack[sp]);
+                break;
+            case COND_AND_JUMP:
+                if (stack[sp] == 0) {
+                    insn = program->insns + insn->value;
+                    continue;
+                }
+                sp--;
+                break;
+            case COND_OR_JUMP:
+                if (stack[sp] != 0) {
+                    stack[sp] = 1;
+                    insn = program->insns + insn->value;
+                    continue;
+                }
+                sp--;
+                break;
+            case COND_BOOL:
+                stack[sp] = (stack[sp] != 0);
+                break;
+            case COND_EQU:
+                operand = insn->immediate ? insn->value : stack[sp--];
+                stack[sp] = (stack[sp] == operand);
+                break;
+            case COND_NEQ:
+                operand = insn->immediate ? insn->value : stack[sp--];
+                stack[sp] = (stack[sp] != operand);
+                break;
+            default:
+                operand = insn->immediate ? insn->value : stack[sp--];
+                stack[sp] = apply_binary(insn->opcode, stack[sp], operand);
+                break;
+        }
+        insn++;
+    }
+
+    return stack[0];
+}
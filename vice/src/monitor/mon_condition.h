@@ -0,0 +1,43 @@
+/*
+ * mon_condition.h - The VICE built-in monitor, checkpoint condition compiler.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_MON_CONDITION_H
+#define VICE_MON_CONDITION_H
+
+#include "montypes.h"
+
+/* A checkpoint condition compiled to a flat program for a small stack
+   machine. Register and memory operands are resolved when compiling, and
+   && and || skip their right operand when the left one decides. */
+typedef struct mon_cond_program_s mon_cond_program_t;
+
+/* Returns NULL if the condition can't be compiled, the caller then has to
+   use mon_evaluate_conditional() on the tree. */
+mon_cond_program_t *mon_cond_compile(cond_node_t *cnode);
+void mon_cond_free(mon_cond_program_t *program);
+
+/* Same result as mon_evaluate_conditional() on the tree it was compiled
+   from. */
+int mon_cond_run(const mon_cond_program_t *program);
+
+#endif
@@ -40,6 +40,7 @@
 #include "machine.h"
 #include "mon_disassemble.h"
 #include "mon_memmap.h"
+#include "mon_trace.h"
 #include "monitor.h"
 #include "montypes.h"
 #include "screenshot.h"
@@ -144,6 +145,10 @@ void monitor_cpuhistory_store(CLOCK cycle, unsigned int addr, unsigned int op,
         return;
     }
 
+    if (mon_trace_enabled) {
+        mon_trace_store_insn(cycle, addr, op, p1, p2, reg_a, reg_x, reg_y, reg_sp, reg_st, origin);
+    }
+
     ++cpuhistory_i;
     if (cpuhistory_i == cpuhistory_buffer_lines) {
         cpuhistory_i = 0;
@@ -164,6 +169,9 @@ void monitor_cpuhistory_store(CLOCK cycle, unsigned int addr, unsigned int op,
 void monitor_cpuhistory_fix_p2(unsigned int p2)
 {
     cpuhistory[cpuhistory_i].p2 = p2;
+    if (mon_trace_enabled) {
+        mon_trace_fix_p2(p2);
+    }
 }
 
 cpuhistory_t *mon_cpuhistory_seek(int count, MEMSPACE filter1, MEMSPACE filter2,
@@ -371,6 +379,9 @@ void monitor_memmap_store(unsigned int addr, unsigned int type)
     if (memmap_state & MEMMAP_STATE_IN_MONITOR) {
         return;
     }
+    if (mon_trace_enabled) {
+        mon_trace_store_mem(addr, type);
+    }
 #if 0 /* FIXME: why would we do this? */
     /* Ignore reg_pc+2 reads on branches & JSR
        and return address read on RTS */
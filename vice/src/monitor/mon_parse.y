@@ -61,6 +61,7 @@ char *alloca();
 #include "mon_memmap.h"
 #include "mon_memory.h"
 #include "mon_register.h"
+#include "mon_trace.h"
 #include "mon_util.h"
 #include "montypes.h"
 #include "tapeport.h"
@@ -136,6 +137,7 @@ void set_yydebug(int val);
 %token<i> H_NUMBER D_NUMBER O_NUMBER B_NUMBER CONVERT_OP B_DATA
 %token<str> H_RANGE_GUESS D_NUMBER_GUESS O_NUMBER_GUESS B_NUMBER_GUESS
 %token<i> BAD_CMD MEM_OP IF MEM_COMP MEM_DISK8 MEM_DISK9 MEM_DISK10 MEM_DISK11 EQUALS
+%token<i> PROFILE_EXPORT_FORMAT
 %token TRAIL CMD_SEP LABEL_ASGN_COMMENT
 %token CMD_LOG CMD_LOGNAME CMD_SIDEFX CMD_DUMMY CMD_RETURN CMD_BLOCK_READ CMD_BLOCK_WRITE CMD_UP CMD_DOWN
 %token CMD_LOAD CMD_BASICLOAD CMD_SAVE CMD_VERIFY CMD_BVERIFY CMD_IGNORE CMD_HUNT CMD_FILL CMD_MOVE
@@ -152,10 +154,12 @@ void set_yydebug(int val);
 %token CMD_RESOURCE_GET CMD_RESOURCE_SET CMD_LOAD_RESOURCES CMD_SAVE_RESOURCES
 %token CMD_ATTACH CMD_DETACH CMD_MON_RESET CMD_TAPECTRL CMD_TAPEOFFS CMD_CARTFREEZE CMD_UPDB CMD_JPDB
 %token CMD_CPUHISTORY CMD_MEMMAPZAP CMD_MEMMAPSHOW CMD_MEMMAPSAVE
+%token CMD_CPUTRACE CMD_CPUTRACENAME
 %token CMD_COMMENT CMD_LIST CMD_STOPWATCH RESET
 %token CMD_EXPORT CMD_AUTOSTART CMD_AUTOLOAD CMD_MAINCPU_TRACE
 %token CMD_WARP
-%token CMD_PROFILE FLAT GRAPH FUNC DEPTH DISASS PROFILE_CONTEXT CLEAR
+%token CMD_INSTRUMENT BENCH
+%token CMD_PROFILE FLAT GRAPH FUNC DEPTH DISASS PROFILE_CONTEXT CLEAR SAMPLE EXPORT
 %token<str> CMD_LABEL_ASGN
 %token<i> L_PAREN R_PAREN ARG_IMMEDIATE REG_A REG_X REG_Y COMMA INST_SEP
 %token<i> L_BRACKET R_BRACKET LESS_THAN REG_U REG_S REG_PC REG_PCR
@@ -393,6 +397,12 @@ memory_rules: CMD_MOVE address_range opt_sep address end_cmd
               { mon_memmap_show($3,$4[0],$4[1]); }
             | CMD_MEMMAPSAVE filename opt_sep expression end_cmd
               { mon_memmap_save($2,$4); }
+            | CMD_CPUTRACE end_cmd
+              { mon_trace_show(); }
+            | CMD_CPUTRACE TOGGLE end_cmd
+              { mon_trace_action($2); }
+            | CMD_CPUTRACENAME filename end_cmd
+              { mon_trace_set_filename($2); }
             ;
 
 checkpoint_rules: CMD_BREAK opt_mem_op address_opt_range opt_if_cond_expr end_cmd
@@ -458,6 +468,8 @@ checkpoint_control_rules: CMD_CHECKPT_ON checkpt_num end_cmd
                           { mon_breakpoint_delete_checkpoint(-1); }
                         | CMD_CONDITION checkpt_num IF cond_expr end_cmd
                           { mon_breakpoint_set_checkpoint_condition($2, $4); }
+                        | CMD_CONDITION checkpt_num BENCH opt_d_number end_cmd
+                          { mon_breakpoint_benchmark_condition($2, $4); }
                         | CMD_COMMAND checkpt_num opt_sep STRING end_cmd
                           { mon_breakpoint_set_checkpoint_command($2, $4); }
                         | CMD_COMMAND checkpt_num error end_cmd
@@ -604,9 +616,17 @@ monitor_misc_rules: CMD_DISK rest_of_line end_cmd
                   | CMD_STOPWATCH end_cmd
                      { mon_stopwatch_show("Stopwatch: ", "\n"); }
                   | CMD_PROFILE TOGGLE end_cmd
-                     { mon_profile_action($2); }
+                     { mon_profile_action(e_default_space, $2); }
+                  | CMD_PROFILE TOGGLE memspace end_cmd
+                     { mon_profile_action($3, $2); }
                   | CMD_PROFILE end_cmd
                      { mon_profile(); }
+                  | CMD_PROFILE SAMPLE opt_d_number end_cmd
+                     { mon_profile_sample(e_default_space, $3); }
+                  | CMD_PROFILE SAMPLE opt_d_number memspace end_cmd
+                     { mon_profile_sample($4, $3); }
+                  | CMD_PROFILE EXPORT PROFILE_EXPORT_FORMAT STRING end_cmd
+                     { mon_profile_export((PROFILE_FORMAT)$3, $4); }
                   | CMD_PROFILE FLAT opt_d_number end_cmd
                      { mon_profile_flat($3); }
                   | CMD_PROFILE GRAPH opt_context_num end_cmd
@@ -621,6 +641,12 @@ monitor_misc_rules: CMD_DISK rest_of_line end_cmd
                      { mon_profile_clear($3); }
                   | CMD_PROFILE PROFILE_CONTEXT d_number end_cmd
                      { mon_profile_disass_context($3); }
+                  | CMD_INSTRUMENT end_cmd
+                     { mon_instrument_show(); }
+                  | CMD_INSTRUMENT TOGGLE end_cmd
+                     { mon_instrument_action($2); }
+                  | CMD_INSTRUMENT EXPORT STRING end_cmd
+                     { mon_instrument_export($3); }
                   ;
 
 disk_rules: CMD_LOAD filename device_num opt_address end_cmd
@@ -29,12 +29,15 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "archdep.h"
+#include "instrument.h"
 #include "lib.h"
 #include "machine.h"
 #include "maincpu.h"
 #include "mon_profile.h"
 #include "profiler.h"
 #include "profiler_data.h"
+#include "resources.h"
 
 const int min_label_width = 15;
 static void print_disass_context(profiling_context_t *context, bool print_subcontexts);
@@ -54,57 +57,113 @@ static bool is_merged(profiling_context_t *context) {
 }
 
 
+/* the CPU the profile commands work on, the default memspace */
+static MEMSPACE profile_mem = e_comp_space;
+
+static const char *profile_cpu_name(MEMSPACE mem)
+{
+    static char name[16];
+
+    if (mem == e_comp_space) {
+        return machine_name;
+    }
+    snprintf(name, sizeof(name), "Drive%s", mon_memspace_string[mem]);
+    return name;
+}
+
 void mon_profile(void)
 {
-    if (maincpu_profiling) {
-        mon_out("Profiling running.\n");
-    } else if (!root_context) {
+    int mem;
+    bool any = false;
+
+    for (mem = FIRST_SPACE; mem <= LAST_SPACE; mem++) {
+        profiling_context_t *root = profile_get_root_context((MEMSPACE)mem);
+
+        if (!root) {
+            continue;
+        }
+        compute_aggregate_stats(root);
+        mon_out("%s:%-8s", mon_memspace_string[mem], profile_cpu_name((MEMSPACE)mem));
+        if (profile_is_sampled((MEMSPACE)mem)) {
+            mon_out(" sampling every %"PRIu64" cycles,", profile_get_sample_interval((MEMSPACE)mem));
+        } else if (profile_is_running((MEMSPACE)mem)) {
+            mon_out(" running,");
+        } else {
+            mon_out(" stopped,");
+        }
+        mon_out(" %'u cycles profiled.\n", (unsigned int)root->total_cycles);
+        any = true;
+    }
+    if (!any) {
         mon_out("Profiling not started.\n");
-    } else {
-        mon_out("Profiling data available.\n");
     }
     mon_out("Use \"help prof\" for more information.\n");
 }
 
-void mon_profile_action(ACTION action)
+void mon_profile_action(MEMSPACE mem, ACTION action)
 {
+    if (mem == e_default_space) {
+        mem = default_memspace;
+    }
+
     switch(action) {
     case e_OFF: {
-        if (maincpu_profiling) {
-            profile_stop();
-            mon_out("Profiling stopped.\n");
+        if (profile_is_running(mem)) {
+            profile_stop(mem);
+            mon_out("Profiling %s stopped.\n", profile_cpu_name(mem));
         } else {
-            mon_out("Profiling not started.\n");
+            mon_out("Profiling %s not started.\n", profile_cpu_name(mem));
         }
         return;
     }
     case e_ON: {
-        profile_start();
-        if (maincpu_profiling) {
-            mon_out("Profiling restarted.\n");
+        if (profile_is_running(mem)) {
+            mon_out("Profiling %s restarted.\n", profile_cpu_name(mem));
         } else {
-            mon_out("Profiling started.\n");
+            mon_out("Profiling %s started.\n", profile_cpu_name(mem));
         }
+        profile_start(mem);
         return;
     }
     case e_TOGGLE: {
-        if (maincpu_profiling) {
-            mon_profile_action(e_OFF);
+        if (profile_is_running(mem)) {
+            mon_profile_action(mem, e_OFF);
         } else {
-            mon_profile_action(e_ON);
+            mon_profile_action(mem, e_ON);
         }
         return;
     }
     }
 }
 
+void mon_profile_sample(MEMSPACE mem, int interval)
+{
+    if (mem == e_default_space) {
+        mem = default_memspace;
+    }
+
+    if (profile_is_running(mem)) {
+        mon_out("Profiling %s restarted", profile_cpu_name(mem));
+    } else {
+        mon_out("Profiling %s started", profile_cpu_name(mem));
+    }
+    profile_start_sampling(mem, interval > 0 ? (CLOCK)interval : 0);
+    mon_out(", one sample every %"PRIu64" cycles.\n", profile_get_sample_interval(mem));
+}
+
 static bool init_profiling_data(void) {
-    if (!root_context) {
-        mon_out("No profiling data available. Start profiling with \"prof on\".\n");
+    profiling_context_t *root;
+
+    profile_mem = default_memspace;
+    root = profile_get_root_context(profile_mem);
+
+    if (!root) {
+        mon_out("No profiling data available for %s. Start profiling with \"prof on\".\n",
+                profile_cpu_name(profile_mem));
         return false;
     }
 
-    compute_aggregate_stats(root_context);
+    compute_aggregate_stats(root);
 
     return true;
 }
@@ -153,7 +212,7 @@ static bool are_aggregates_compatible(profiling_context_t *a,
     }
 
     int i;
-    MEMSPACE mem = e_comp_space;
+    MEMSPACE mem = profile_mem;
     uint16_t loc;
 
     /* loop over all memory configs within each context */
@@ -462,7 +521,7 @@ void mon_profile_flat(int num)
     all_functions.capacity = 0;
     all_functions.data = NULL;
 
-    recursively_aggregate_all_functions(root_context, &all_functions);
+    recursively_aggregate_all_functions(profile_get_root_context(profile_mem), &all_functions);
     mark_aliases(&all_functions);
 
     /* sort based on self time */
@@ -473,7 +532,7 @@ void mon_profile_flat(int num)
 
     if (num > all_functions.size) num = all_functions.size;
     for (i = 0; i < num; i++) {
-        print_function_line(all_functions.data[i], 0 /* indent */, root_context->total_cycles);
+        print_function_line(all_functions.data[i], 0 /* indent */, profile_get_root_context(profile_mem)->total_cycles);
         free_profiling_context(all_functions.data[i]);
     }
     for (i = num; i < all_functions.size; i++) {
@@ -493,9 +552,9 @@ void mon_profile_graph(int context_id, int depth)
 
     if (!init_profiling_data()) return;
 
-    context = profile_context_by_id(context_id);
+    context = profile_context_by_id(profile_mem, context_id);
     if (!context) {
-        context = root_context;
+        context = profile_get_root_context(profile_mem);
     }
 
     if (depth <= 0) depth = 4;
@@ -524,7 +583,7 @@ void mon_profile_func(MON_ADDR function)
         return;
     }
 
-    recursively_aggregate_matching_functions(root_context, addr, &func_stats);
+    recursively_aggregate_matching_functions(profile_get_root_context(profile_mem), addr, &func_stats);
     c = func_stats;
     while(c) {
         context_array_t callers_merged = {NULL, 0, 0};
@@ -588,7 +647,7 @@ static void print_src(uint16_t src) {
 
 /* memory_config -2 will print "{*}" */
 static void print_dst(uint16_t dst, int max_width, int memory_config) {
-    char *name = mon_symbol_table_lookup_name(default_memspace, dst);
+    char *name = mon_symbol_table_lookup_name(profile_mem, dst);
     char buf[32];
     char *full_name = NULL;
     size_t l;
@@ -638,7 +697,7 @@ static int context_memory_config(profiling_context_t *context) {
 
 static void print_context_id(profiling_context_t *context, int max_width) {
     char idstr[16];
-    snprintf(idstr, 16, "[%d]", get_context_id(context));
+    snprintf(idstr, 16, "[%d]", get_context_id(profile_mem, context));
     mon_out("%*s", max_width, idstr);
 }
 
@@ -674,7 +733,7 @@ static void print_context_line(profiling_context_t *context, int indent, int max
 
 static void print_context_graph(profiling_context_t *context, int depth, int max_depth, profiling_counter_t total_cycles)
 {
-    if (context == current_context) {
+    if (context == profile_get_current_context(profile_mem)) {
         mon_out(">");
     } else {
         mon_out(" ");
@@ -691,7 +750,7 @@ static void print_context_graph(profiling_context_t *context, int depth, int max
             } while (c != context->child);
         } else {
             /* check if we are a child to the current_context */
-            profiling_context_t *c = current_context;
+            profiling_context_t *c = profile_get_current_context(profile_mem);
             do {
                 c = c->parent;
                 if (c == context) {
@@ -713,7 +772,7 @@ static void print_context_graph(profiling_context_t *context, int depth, int max
 static void print_all_contexts(context_array_t *context_list)
 {
     for (int i = 0; i < context_list->size; i++) {
-        mon_out("[%d]", get_context_id(context_list->data[i]));
+        mon_out("[%d]", get_context_id(profile_mem, context_list->data[i]));
     }
 }
 
@@ -733,7 +792,7 @@ void mon_profile_disass(MON_ADDR function)
         return;
     }
 
-    recursively_aggregate_matching_functions(root_context, addr, &func_stats);
+    recursively_aggregate_matching_functions(profile_get_root_context(profile_mem), addr, &func_stats);
 
     c = func_stats;
     while(c) {
@@ -830,7 +889,7 @@ static void merge_all_memory_configs(profiling_context_t *context) {
 static bool is_branch_instruction(uint16_t mem_config, uint16_t addr, unsigned *opc_size, uint16_t *dest_addr) {
     /* on 6502, an instruction is a conditional branch if the opcode is
      * $x0, where x is odd */
-    uint8_t opc  = mon_get_mem_val_nosfx(e_comp_space, mem_config, addr);
+    uint8_t opc  = mon_get_mem_val_nosfx(profile_mem, mem_config, addr);
     int8_t  offset;
 
     if ((opc & 0x1f) != 0x10) {
@@ -839,7 +898,7 @@ static bool is_branch_instruction(uint16_t mem_config, uint16_t addr, unsigned *
 
     *opc_size = 2;
 
-    offset = mon_get_mem_val_nosfx(e_comp_space, mem_config, addr+1);
+    offset = mon_get_mem_val_nosfx(profile_mem, mem_config, addr+1);
 
     *dest_addr = (uint16_t)(addr + *opc_size + offset);
     return true;
@@ -1050,7 +1109,7 @@ static void print_disass_context(profiling_context_t *context, bool print_contex
                             print_src(addr);
                             mon_out("\n");
                         } else {
-                            opc_size = mon_disassemble_oneline(e_comp_space, c->memory_bank_config, addr);
+                            opc_size = mon_disassemble_oneline(profile_mem, c->memory_bank_config, addr);
                             next_addr = addr + opc_size;
                         }
                     }
@@ -1068,7 +1127,7 @@ void mon_profile_disass_context(int context_id)
 
     if (!init_profiling_data()) return;
 
-    context = profile_context_by_id(context_id);
+    context = profile_context_by_id(profile_mem, context_id);
 
     if (!context) {
         mon_out("Invalid context. Use \"prof graph\" to list contexts.\n");
@@ -1136,6 +1195,237 @@ void mon_profile_clear(MON_ADDR function)
         return;
     }
 
-    clear_recursively(root_context, addr);
+    clear_recursively(profile_get_root_context(profile_mem), addr);
+}
+
+
+/* Name of a call stack frame in the exported profiles. Interrupt entries get
+ * the vector as a prefix so they stand out in a flame graph. */
+static char *export_frame_name(profiling_context_t *context)
+{
+    char *name;
+    const char *vector = NULL;
+
+    if (context->parent == NULL) {
+        /* the root frame tells the CPUs apart */
+        return lib_strdup(profile_cpu_name(profile_mem));
+    }
+
+    switch (context->pc_src) {
+    case 0xfffa: vector = "NMI"; break;
+    case 0xfffc: vector = "RST"; break;
+    case 0xfffe: vector = "IRQ"; break;
+    default: break;
+    }
+
+    name = mon_symbol_table_lookup_name(profile_mem, context->pc_dst);
+    if (name) {
+        return vector ? lib_msprintf("%s:%s", vector, name) : lib_strdup(name);
+    }
+    return vector ? lib_msprintf("%s:%04x", vector, context->pc_dst)
+                  : lib_msprintf("%04x", context->pc_dst);
+}
+
+/* sum of the samples of a context, including its children if `inclusive` */
+static profiling_counter_t export_samples(profiling_context_t *context, bool inclusive)
+{
+    profiling_counter_t samples = 0;
+    profiling_context_t *c;
+    int i, j;
+
+    for (c = context; c; c = c->next_mem_config) {
+        for (i = 0; i < 256; i++) {
+            if (c->page[i]) {
+                for (j = 0; j < 256; j++) {
+                    samples += c->page[i]->data[j].num_samples;
+                }
+            }
+        }
+    }
+
+    if (inclusive && context->child) {
+        c = context->child;
+        do {
+            samples += export_samples(c, true);
+            c = c->next;
+        } while (c != context->child);
+    }
+
+    return samples;
+}
+
+/* one "frame;frame;frame cycles" line per context with self time, the input
+ * format of flamegraph.pl and compatible tools */
+static void export_folded(FILE *fp, profiling_context_t *context, const char *stack)
+{
+    char *name = export_frame_name(context);
+    char *path = stack ? lib_msprintf("%s;%s", stack, name) : lib_strdup(name);
+
+    lib_free(name);
+
+    if (context->total_cycles_self > 0) {
+        fprintf(fp, "%s %u\n", path, (unsigned int)context->total_cycles_self);
+    }
+
+    if (context->child) {
+        profiling_context_t *c = context->child;
+        do {
+            export_folded(fp, c, path);
+            c = c->next;
+        } while (c != context->child);
+    }
+
+    lib_free(path);
 }
 
+/* callgrind profile data, for KCachegrind and compatible tools. Every
+ * context becomes a cost block of its function, the tools merge the blocks
+ * of the same function from different call paths. */
+static void export_callgrind(FILE *fp, profiling_context_t *context)
+{
+    profiling_context_t *c;
+    char *name = export_frame_name(context);
+    int i, j;
+
+    fprintf(fp, "fn=%s\n", name);
+    lib_free(name);
+
+    for (c = context; c; c = c->next_mem_config) {
+        for (i = 0; i < 256; i++) {
+            if (c->page[i]) {
+                for (j = 0; j < 256; j++) {
+                    profiling_data_t *data = &c->page[i]->data[j];
+                    if (data->num_samples > 0) {
+                        fprintf(fp, "0x%04x %u %u\n", (unsigned int)((i << 8) | j),
+                                (unsigned int)data->num_cycles,
+                                (unsigned int)data->num_samples);
+                    }
+                }
+            }
+        }
+    }
+
+    if (context->child) {
+        c = context->child;
+        do {
+            /* the call site is the JSR, or the vector for interrupts */
+            uint16_t src = is_interrupt(c->pc_src) ? c->pc_src : (uint16_t)(c->pc_src - 2);
+
+            name = export_frame_name(c);
+            fprintf(fp, "cfn=%s\n", name);
+            fprintf(fp, "calls=%u 0x%04x\n", (unsigned int)c->num_enters, c->pc_dst);
+            fprintf(fp, "0x%04x %u %u\n", src, (unsigned int)c->total_cycles,
+                    (unsigned int)export_samples(c, true));
+            lib_free(name);
+            c = c->next;
+        } while (c != context->child);
+    }
+    fprintf(fp, "\n");
+
+    if (context->child) {
+        c = context->child;
+        do {
+            export_callgrind(fp, c);
+            c = c->next;
+        } while (c != context->child);
+    }
+}
+
+/* writes the data of every CPU that has been profiled, so the hot spots of
+ * the computer and the drives show up side by side */
+void mon_profile_export(PROFILE_FORMAT format, const char *filename)
+{
+    FILE *fp;
+    int mem;
+    profiling_counter_t total_cycles = 0;
+    profiling_counter_t total_samples = 0;
+
+    if (!init_profiling_data()) return;
+
+    fp = fopen(filename, MODE_WRITE_TEXT);
+    if (fp == NULL) {
+        mon_out("Cannot open %s.\n", filename);
+        return;
+    }
+
+    if (format == e_PROFILE_CALLGRIND) {
+        for (mem = FIRST_SPACE; mem <= LAST_SPACE; mem++) {
+            profiling_context_t *root = profile_get_root_context((MEMSPACE)mem);
+            if (root) {
+                compute_aggregate_stats(root);
+                total_cycles += root->total_cycles;
+                total_samples += export_samples(root, true);
+            }
+        }
+        fprintf(fp, "# callgrind format\n");
+        fprintf(fp, "version: 1\n");
+        fprintf(fp, "creator: VICE %s\n", VERSION);
+        fprintf(fp, "cmd: %s\n", machine_name);
+        fprintf(fp, "positions: instr\n");
+        fprintf(fp, "events: Cycles Samples\n");
+        fprintf(fp, "summary: %u %u\n\n", (unsigned int)total_cycles, (unsigned int)total_samples);
+    }
+
+    for (mem = FIRST_SPACE; mem <= LAST_SPACE; mem++) {
+        profiling_context_t *root = profile_get_root_context((MEMSPACE)mem);
+
+        if (!root) {
+            continue;
+        }
+
+        /* names are looked up in the memspace of the CPU */
+        profile_mem = (MEMSPACE)mem;
+        compute_aggregate_stats(root);
+
+        switch (format) {
+        case e_PROFILE_FOLDED:
+            export_folded(fp, root, NULL);
+            break;
+        case e_PROFILE_CALLGRIND:
+            fprintf(fp, "ob=%s\n", profile_cpu_name(profile_mem));
+            export_callgrind(fp, root);
+            break;
+        }
+    }
+
+    fclose(fp);
+    mon_out("Profile written to %s.\n", filename);
+}
+
+/* host time instrumentation, see instrument.h */
+
+void mon_instrument_show(void)
+{
+    char buffer[4096];
+    int enabled = 0;
+
+    resources_get_int("Instrumentation", &enabled);
+    if (!enabled) {
+        mon_out("Instrumentation is off.\n");
+        return;
+    }
+    if (!instrument_format_summary(buffer, sizeof(buffer))) {
+        mon_out("Instrumentation is on, no complete second yet.\n");
+        return;
+    }
+    mon_out("Host time of the last second: %s\n", buffer);
+}
+
+void mon_instrument_action(ACTION action)
+{
+    int enabled = 0;
+
+    resources_get_int("Instrumentation", &enabled);
+    enabled = (action == e_TOGGLE) ? (enabled ^ 1) : (action == e_ON);
+    resources_set_int("Instrumentation", enabled);
+    mon_out("Instrumentation %s.\n", enabled ? "on" : "off");
+}
+
+void mon_instrument_export(const char *filename)
+{
+    if (instrument_export_json(filename) < 0) {
+        mon_out("Cannot write %s.\n", filename);
+        return;
+    }
+    mon_out("Instrumentation written to %s.\n", filename);
+}
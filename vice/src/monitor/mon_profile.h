@@ -30,7 +30,9 @@
 
 /* monitor commands */
 void mon_profile(void);
-void mon_profile_action(ACTION action); /* on|off|toggle */
+void mon_profile_action(MEMSPACE mem, ACTION action); /* on|off|toggle */
+void mon_profile_sample(MEMSPACE mem, int interval);
+void mon_profile_export(PROFILE_FORMAT format, const char *filename);
 void mon_profile_flat(int num);
 void mon_profile_graph(int context_id, int depth);
 void mon_profile_func(MON_ADDR function);
@@ -38,4 +40,8 @@ void mon_profile_disass(MON_ADDR function);
 void mon_profile_clear(MON_ADDR function);
 void mon_profile_disass_context(int context_id);
 
+void mon_instrument_show(void);
+void mon_instrument_action(ACTION action); /* on|off|toggle */
+void mon_instrument_export(const char *filename);
+
 #endif /* VICE_MON_PROFILE_H */
@@ -0,0 +1,560 @@
+/*
+ * mon_trace.c - The VICE built-in monitor, instruction trace recorder.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/*
+ * The recorder is fed from the CPU history hooks, so it sees every
+ * instruction of the main and drive CPUs and every memory access of the
+ * main CPU. Records are delta encoded into a block buffer on the emulation
+ * thread; full blocks are compressed and written by a writer thread, so the
+ * emulation only stalls if the disk can't keep up at all. See mon_trace.h
+ * for the file format and src/tools/tracedump for a reader.
+ */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <zlib.h>
+
+#ifdef USE_VICE_THREAD
+#include <pthread.h>
+#endif
+
+#include "archdep.h"
+#include "cmdline.h"
+#include "lib.h"
+#include "log.h"
+#include "mon_trace.h"
+#include "monitor.h"
+#include "montypes.h"
+#include "resources.h"
+#include "types.h"
+#include "util.h"
+
+/* uncompressed size of a block */
+#define MON_TRACE_BLOCK_SIZE    (256 * 1024)
+/* largest possible record, a block is submitted when less room is left */
+#define MON_TRACE_RECORD_MAX    32
+/* room kept after an instruction record for the memory records of the
+   instruction, so the block is not submitted before a JSR gets its p2 fixed */
+#define MON_TRACE_INSN_SLACK    1024
+/* blocks waiting for the writer before the emulation has to wait */
+#define MON_TRACE_QUEUE_MAX     8
+/* favour speed, the records are very repetitive anyway */
+#define MON_TRACE_ZLIB_LEVEL    1
+
+typedef struct trace_state_s {
+    CLOCK clk;
+    unsigned int pc;
+    unsigned int st;
+    uint8_t a;
+    uint8_t x;
+    uint8_t y;
+    uint8_t sp;
+    int valid;
+} trace_state_t;
+
+int mon_trace_enabled = 0;
+
+static FILE *trace_fp = NULL;
+static int trace_write_error = 0;
+
+/* the block being filled by the emulation thread */
+static uint8_t *trace_block = NULL;
+static size_t trace_pos = 0;
+/* offset of the p2 byte of the last instruction record, 0 if none */
+static size_t trace_p2_pos = 0;
+
+static trace_state_t trace_state[MON_TRACE_MEMSPACE_MASK + 1];
+
+/* compression buffer, only used by the writer */
+static uint8_t *trace_out = NULL;
+static uLongf trace_out_size = 0;
+
+#ifdef USE_VICE_THREAD
+typedef struct trace_block_s {
+    uint8_t *data;
+    size_t size;
+    struct trace_block_s *next;
+} trace_block_t;
+
+static pthread_t trace_thread;
+static int trace_thread_running = 0;
+static int trace_thread_stop = 0;
+
+/* protects the queue and trace_thread_stop */
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t trace_work_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t trace_room_cond = PTHREAD_COND_INITIALIZER;
+static trace_block_t *trace_queue_head = NULL;
+static trace_block_t *trace_queue_tail = NULL;
+static int trace_queued = 0;
+#endif
+
+/* ------------------------------------------------------------------------- */
+
+/* Compress and write one block, runs on the writer thread if there is one. */
+static void trace_write_block(const uint8_t *data, size_t size)
+{
+    uint8_t *out;
+    uLongf stored;
+    uLongf bound = compressBound((uLong)size);
+
+    if (trace_out_size < bound) {
+        trace_out = lib_realloc(trace_out, MON_TRACE_BLOCK_HEADER_SIZE + bound);
+        trace_out_size = bound;
+    }
+    out = trace_out;
+
+    stored = bound;
+    if (compress2(out + MON_TRACE_BLOCK_HEADER_SIZE, &stored, data, (uLong)size,
+                  MON_TRACE_ZLIB_LEVEL) != Z_OK || stored >= size) {
+        memcpy(out + MON_TRACE_BLOCK_HEADER_SIZE, data, size);
+        stored = (uLongf)size;
+    }
+
+    out[0] = (uint8_t)size;
+    out[1] = (uint8_t)(size >> 8);
+    out[2] = (uint8_t)(size >> 16);
+    out[3] = (uint8_t)(size >> 24);
+    out[4] = (uint8_t)stored;
+    out[5] = (uint8_t)(stored >> 8);
+    out[6] = (uint8_t)(stored >> 16);
+    out[7] = (uint8_t)(stored >> 24);
+
+    if (fwrite(out, 1, MON_TRACE_BLOCK_HEADER_SIZE + stored, trace_fp)
+            != MON_TRACE_BLOCK_HEADER_SIZE + stored) {
+        if (!trace_write_error) {
+            log_error(LOG_DEFAULT, "Trace recorder: write error, the trace is incomplete.");
+        }
+        trace_write_error = 1;
+    }
+}
+
+#ifdef USE_VICE_THREAD
+static void *trace_writer_thread(void *unused)
+{
+    trace_block_t *block;
+
+    pthread_mutex_lock(&trace_lock);
+    while (1) {
+        while (trace_queue_head == NULL && !trace_thread_stop) {
+            pthread_cond_wait(&trace_work_cond, &trace_lock);
+        }
+        block = trace_queue_head;
+        if (block == NULL) {
+            /* stopped and nothing left */
+            break;
+        }
+        trace_queue_head = block->next;
+        if (trace_queue_head == NULL) {
+            trace_queue_tail = NULL;
+        }
+        trace_queued--;
+        pthread_cond_signal(&trace_room_cond);
+        pthread_mutex_unlock(&trace_lock);
+
+        trace_write_block(block->data, block->size);
+        lib_free(block->data);
+        lib_free(block);
+
+        pthread_mutex_lock(&trace_lock);
+    }
+    pthread_mutex_unlock(&trace_lock);
+
+    return NULL;
+}
+#endif
+
+/* Hand the current block over for writing and start a new one. */
+static void trace_submit_block(void)
+{
+    if (trace_pos > 0) {
+#ifdef USE_VICE_THREAD
+        if (trace_thread_running) {
+            trace_block_t *block = lib_malloc(sizeof(trace_block_t));
+
+            block->data = trace_block;
+            block->size = trace_pos;
+            block->next = NULL;
+
+            pthread_mutex_lock(&trace_lock);
+            while (trace_queued >= MON_TRACE_QUEUE_MAX) {
+                pthread_cond_wait(&trace_room_cond, &trace_lock);
+            }
+            if (trace_queue_tail != NULL) {
+                trace_queue_tail->next = block;
+            } else {
+                trace_queue_head = block;
+            }
+            trace_queue_tail = block;
+            trace_queued++;
+            pthread_cond_signal(&trace_work_cond);
+            pthread_mutex_unlock(&trace_lock);
+
+            trace_block = lib_malloc(MON_TRACE_BLOCK_SIZE);
+        } else
+#endif
+        {
+            trace_write_block(trace_block, trace_pos);
+        }
+    }
+
+    trace_pos = 0;
+    trace_p2_pos = 0;
+    memset(trace_state, 0, sizeof(trace_state));
+}
+
+/* ------------------------------------------------------------------------- */
+
+static inline uint8_t *trace_put_varint(uint8_t *p, uint64_t value)
+{
+    while (value >= 0x80) {
+        *p++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *p++ = (uint8_t)value;
+
+    return p;
+}
+
+static inline uint64_t trace_zigzag(int64_t value)
+{
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+void mon_trace_store_insn(CLOCK cycle, unsigned int addr, unsigned int op,
+                          unsigned int p1, unsigned int p2,
+                          uint8_t reg_a, uint8_t reg_x, uint8_t reg_y,
+                          uint8_t reg_sp, unsigned int reg_st, unsigned int origin)
+{
+    trace_state_t *state = &trace_state[origin & MON_TRACE_MEMSPACE_MASK];
+    uint8_t *p;
+    uint8_t mask;
+
+    if (trace_pos > MON_TRACE_BLOCK_SIZE - MON_TRACE_RECORD_MAX - MON_TRACE_INSN_SLACK) {
+        trace_submit_block();
+    }
+
+    p = trace_block + trace_pos;
+
+    *p++ = (uint8_t)(MON_TRACE_REC_INSN | (origin & MON_TRACE_MEMSPACE_MASK));
+    p = trace_put_varint(p, trace_zigzag((int64_t)(cycle - state->clk)));
+    p = trace_put_varint(p, trace_zigzag((int64_t)addr - (int64_t)state->pc));
+    *p++ = (uint8_t)op;
+    *p++ = (uint8_t)p1;
+    trace_p2_pos = (size_t)(p - trace_block);
+    *p++ = (uint8_t)p2;
+
+    if (state->valid) {
+        mask = 0;
+        if (reg_a != state->a) {
+            mask |= MON_TRACE_REG_A;
+        }
+        if (reg_x != state->x) {
+            mask |= MON_TRACE_REG_X;
+        }
+        if (reg_y != state->y) {
+            mask |= MON_TRACE_REG_Y;
+        }
+        if (reg_sp != state->sp) {
+            mask |= MON_TRACE_REG_SP;
+        }
+        if (reg_st != state->st) {
+            mask |= MON_TRACE_REG_ST;
+        }
+    } else {
+        mask = MON_TRACE_REG_ALL;
+    }
+
+    *p++ = mask;
+    if (mask & MON_TRACE_REG_A) {
+        *p++ = reg_a;
+    }
+    if (mask & MON_TRACE_REG_X) {
+        *p++ = reg_x;
+    }
+    if (mask & MON_TRACE_REG_Y) {
+        *p++ = reg_y;
+    }
+    if (mask & MON_TRACE_REG_SP) {
+        *p++ = reg_sp;
+    }
+    if (mask & MON_TRACE_REG_ST) {
+        *p++ = (uint8_t)reg_st;
+        *p++ = (uint8_t)(reg_st >> 8);
+    }
+
+    state->clk = cycle;
+    state->pc = addr;
+    state->a = reg_a;
+    state->x = reg_x;
+    state->y = reg_y;
+    state->sp = reg_sp;
+    state->st = reg_st;
+    state->valid = 1;
+
+    trace_pos = (size_t)(p - trace_block);
+}
+
+/* JSR only knows its high address byte after the history entry was made,
+   a no-op if the block with the record was submitted in between */
+void mon_trace_fix_p2(unsigned int p2)
+{
+    if (trace_p2_pos != 0) {
+        trace_block[trace_p2_pos] = (uint8_t)p2;
+    }
+}
+
+void mon_trace_store_mem(unsigned int addr, unsigned int type)
+{
+    uint8_t *p;
+
+    if (trace_pos > MON_TRACE_BLOCK_SIZE - MON_TRACE_RECORD_MAX) {
+        trace_submit_block();
+    }
+
+    p = trace_block + trace_pos;
+
+    /* only the computer CPUs report their accesses */
+    *p++ = MON_TRACE_REC_MEM | 1;
+    *p++ = (uint8_t)addr;
+    *p++ = (uint8_t)(addr >> 8);
+    *p++ = (uint8_t)type;
+    *p++ = (uint8_t)(type >> 8);
+
+    trace_pos = (size_t)(p - trace_block);
+}
+
+/* ------------------------------------------------------------------------- */
+
+int mon_trace_open(const char *filename)
+{
+    uint8_t header[MON_TRACE_HEADER_SIZE];
+
+    mon_trace_close();
+
+    trace_fp = fopen(filename, MODE_WRITE);
+    if (trace_fp == NULL) {
+        log_error(LOG_DEFAULT, "Trace recorder: could not open '%s'.", filename);
+        return -1;
+    }
+
+    memset(header, 0, sizeof(header));
+    memcpy(header, MON_TRACE_MAGIC, MON_TRACE_MAGIC_SIZE);
+    header[MON_TRACE_MAGIC_SIZE] = MON_TRACE_VERSION;
+    if (fwrite(header, 1, sizeof(header), trace_fp) != sizeof(header)) {
+        log_error(LOG_DEFAULT, "Trace recorder: could not write '%s'.", filename);
+        fclose(trace_fp);
+        trace_fp = NULL;
+        return -1;
+    }
+
+    trace_write_error = 0;
+    trace_block = lib_malloc(MON_TRACE_BLOCK_SIZE);
+    trace_pos = 0;
+    trace_p2_pos = 0;
+    memset(trace_state, 0, sizeof(trace_state));
+
+#ifdef USE_VICE_THREAD
+    trace_thread_stop = 0;
+    if (pthread_create(&trace_thread, NULL, trace_writer_thread, NULL) == 0) {
+        trace_thread_running = 1;
+    } else {
+        log_warning(LOG_DEFAULT, "Trace recorder: could not create writer thread, writing synchronously.");
+    }
+#endif
+
+    log_message(LOG_DEFAULT, "Trace recorder: recording to '%s'.", filename);
+    mon_trace_enabled = 1;
+
+    return 0;
+}
+
+void mon_trace_close(void)
+{
+    if (trace_fp == NULL) {
+        return;
+    }
+
+    mon_trace_enabled = 0;
+    trace_submit_block();
+
+#ifdef USE_VICE_THREAD
+    if (trace_thread_running) {
+        pthread_mutex_lock(&trace_lock);
+        trace_thread_stop = 1;
+        pthread_cond_signal(&trace_work_cond);
+        pthread_mutex_unlock(&trace_lock);
+        pthread_join(trace_thread, NULL);
+        trace_thread_running = 0;
+    }
+#endif
+
+    lib_free(trace_block);
+    trace_block = NULL;
+    lib_free(trace_out);
+    trace_out = NULL;
+    trace_out_size = 0;
+
+    fclose(trace_fp);
+    trace_fp = NULL;
+
+    log_message(LOG_DEFAULT, "Trace recorder: stopped.");
+}
+
+/* ------------------------------------------------------------------------- */
+
+#ifdef FEATURE_CPUMEMHISTORY
+
+static char *trace_filename = NULL;
+static int trace_resource_enabled = 0;
+
+static int set_trace_filename(const char *val, void *param)
+{
+    util_string_set(&trace_filename, val);
+    if (trace_resource_enabled) {
+        return mon_trace_open(trace_filename);
+    }
+    return 0;
+}
+
+static int set_trace_enabled(int val, void *param)
+{
+    val = val ? 1 : 0;
+
+    if (val && !trace_resource_enabled) {
+        if (mon_trace_open(trace_filename) < 0) {
+            return -1;
+        }
+    }
+    if (!val) {
+        mon_trace_close();
+    }
+    trace_resource_enabled = val;
+    return 0;
+}
+
+static const resource_string_t resources_string[] = {
+    { "MonitorTraceFileName", "vice.trace", RES_EVENT_NO, NULL,
+      &trace_filename, set_trace_filename, NULL },
+    RESOURCE_STRING_LIST_END
+};
+
+static const resource_int_t resources_int[] = {
+    { "MonitorTraceEnabled", 0, RES_EVENT_NO, NULL,
+      &trace_resource_enabled, set_trace_enabled, NULL },
+    RESOURCE_INT_LIST_END
+};
+
+int mon_trace_resources_init(void)
+{
+    if (resources_register_string(resources_string) < 0) {
+        return -1;
+    }
+    return resources_register_int(resources_int);
+}
+
+void mon_trace_resources_shutdown(void)
+{
+    mon_trace_close();
+    if (trace_filename != NULL) {
+        lib_free(trace_filename);
+        trace_filename = NULL;
+    }
+}
+
+static const cmdline_option_t cmdline_options[] =
+{
+    { "-montracename", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
+      NULL, NULL, "MonitorTraceFileName", NULL,
+      "<Name>", "Set name of the instruction trace file" },
+    { "-montrace", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "MonitorTraceEnabled", (resource_value_t)1,
+      NULL, "Record an instruction trace of all CPUs to a file" },
+    { "+montrace", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "MonitorTraceEnabled", (resource_value_t)0,
+      NULL, "Do not record an instruction trace" },
+    CMDLINE_LIST_END
+};
+
+int mon_trace_cmdline_options_init(void)
+{
+    return cmdline_register_options(cmdline_options);
+}
+
+void mon_trace_show(void)
+{
+    if (mon_trace_enabled) {
+        mon_out("Recording instruction trace to '%s'.\n", trace_filename);
+    } else {
+        mon_out("Instruction trace recording is off.\n");
+    }
+}
+
+void mon_trace_action(int action)
+{
+    int enabled = trace_resource_enabled;
+
+    enabled = (action == e_TOGGLE) ? (enabled ^ 1) : (action == e_ON);
+    resources_set_int("MonitorTraceEnabled", enabled);
+    mon_trace_show();
+}
+
+void mon_trace_set_filename(const char *filename)
+{
+    resources_set_string("MonitorTraceFileName", filename);
+}
+
+#else /* !FEATURE_CPUMEMHISTORY */
+
+int mon_trace_resources_init(void)
+{
+    return 0;
+}
+
+void mon_trace_resources_shutdown(void)
+{
+}
+
+int mon_trace_cmdline_options_init(void)
+{
+    return 0;
+}
+
+void mon_trace_show(void)
+{
+    mon_out("Disabled. configure with --enable-cpuhistory and recompile.\n");
+}
+
+void mon_trace_action(int action)
+{
+    mon_trace_show();
+}
+
+void mon_trace_set_filename(const char *filename)
+{
+    mon_trace_show();
+}
+
+#endif
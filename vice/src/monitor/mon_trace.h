@@ -0,0 +1,102 @@
+/*
+ * mon_trace.h - The VICE built-in monitor, instruction trace recorder.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_MON_TRACE_H
+#define VICE_MON_TRACE_H
+
+#include "types.h"
+
+/*
+ * Trace file format, all values little endian:
+ *
+ * file header:
+ *   8 bytes  MON_TRACE_MAGIC
+ *   1 byte   MON_TRACE_VERSION
+ *   3 bytes  reserved, 0
+ *
+ * followed by blocks until the end of the file:
+ *   4 bytes  uncompressed size of the records
+ *   4 bytes  stored size, equal to the uncompressed size if the block is
+ *            stored as is, else the block is zlib compressed
+ *   stored size bytes of data
+ *
+ * A block holds whole records. The delta state starts from zero in every
+ * block, so blocks can be decoded on their own.
+ *
+ * instruction record:
+ *   1 byte   MON_TRACE_REC_INSN | memspace (1 = computer, 2-5 = drive 8-11)
+ *   varint   zigzag encoded clock delta to the previous record of the memspace
+ *   varint   zigzag encoded PC delta to the previous record of the memspace
+ *   3 bytes  opcode and the two bytes after it
+ *   1 byte   mask of the registers that follow (MON_TRACE_REG_*)
+ *   A, X, Y, SP one byte each, ST two bytes, only those set in the mask
+ *
+ * memory access record, for the accesses of the computer CPU:
+ *   1 byte   MON_TRACE_REC_MEM | memspace
+ *   2 bytes  address
+ *   2 bytes  access type, the MEMMAP_* bits from monitor.h
+ *
+ * A varint holds 7 bits per byte, lowest first, bit 7 set if more follow.
+ */
+
+#define MON_TRACE_MAGIC         "VICETRCE"
+#define MON_TRACE_MAGIC_SIZE    8
+#define MON_TRACE_VERSION       1
+#define MON_TRACE_HEADER_SIZE   12
+#define MON_TRACE_BLOCK_HEADER_SIZE 8
+
+#define MON_TRACE_REC_MASK      0xf0
+#define MON_TRACE_REC_INSN      0x00
+#define MON_TRACE_REC_MEM       0x10
+#define MON_TRACE_MEMSPACE_MASK 0x0f
+
+#define MON_TRACE_REG_A         0x01
+#define MON_TRACE_REG_X         0x02
+#define MON_TRACE_REG_Y         0x04
+#define MON_TRACE_REG_SP        0x08
+#define MON_TRACE_REG_ST        0x10
+#define MON_TRACE_REG_ALL       0x1f
+
+/* set while a trace is recorded, checked by the CPU history hooks */
+extern int mon_trace_enabled;
+
+int mon_trace_open(const char *filename);
+void mon_trace_close(void);
+
+void mon_trace_store_insn(CLOCK cycle, unsigned int addr, unsigned int op,
+                          unsigned int p1, unsigned int p2,
+                          uint8_t reg_a, uint8_t reg_x, uint8_t reg_y,
+                          uint8_t reg_sp, unsigned int reg_st, unsigned int origin);
+void mon_trace_fix_p2(unsigned int p2);
+void mon_trace_store_mem(unsigned int addr, unsigned int type);
+
+int mon_trace_resources_init(void);
+void mon_trace_resources_shutdown(void);
+int mon_trace_cmdline_options_init(void);
+
+/* monitor commands */
+void mon_trace_show(void);
+void mon_trace_action(int action); /* on|off|toggle */
+void mon_trace_set_filename(const char *filename);
+
+#endif
@@ -508,7 +508,8 @@ char *uimon_in(const char *prompt)
 
         if (!monitor_is_binary()) {
             monitor_check_binary();
-        } else {
+        } else if (monitor_binary_get_connected_socket() != NULL) {
+            /* polled here, there is no I/O thread */
             sockfd[sockfd_index] = monitor_binary_get_connected_socket();
             sockfd_index++;
         }
@@ -517,7 +518,18 @@ char *uimon_in(const char *prompt)
 
         if (monitor_is_remote() || monitor_is_binary()) {
 
-            vice_network_select_multiple(sockfd);
+            if (monitor_is_binary() && monitor_binary_get_connected_socket() == NULL) {
+                /* the binary monitor commands come from its I/O thread, which
+                   owns the socket: only wait for it to queue one, and just
+                   peek at the remote monitor socket meanwhile */
+                if (!monitor_is_remote()) {
+                    monitor_binary_wait_command(tick_per_second() / 4);
+                } else if (vice_network_select_poll_one(monitor_get_connected_socket()) <= 0) {
+                    monitor_binary_wait_command(tick_per_second() / 100);
+                }
+            } else {
+                vice_network_select_multiple(sockfd);
+            }
 
             if (monitor_is_binary()) {
                 if (!monitor_binary_get_command_line()) {
@@ -65,6 +65,7 @@
 #include "mon_breakpoint.h"
 #include "mon_disassemble.h"
 #include "mon_memmap.h"
+#include "mon_trace.h"
 #include "mon_memory.h"
 #include "asm.h"
 
@@ -75,6 +76,7 @@
 #include "monitor_network.h"
 #include "monitor_binary.h"
 #include "montypes.h"
+#include "profiler.h"
 
 #include "userport_io_sim.h"
 #include "joyport_io_sim.h"
@@ -124,8 +126,6 @@ static int init_break_address = -1;
 
 #define MAX_LABEL_LEN 255
 #define MAX_MEMSPACE_NAME_LEN 10
-#define HASH_ARRAY_SIZE 256
-#define HASH_ADDR(x) ((x) % 0xff)
 #define OP_JSR 0x20
 #define OP_RTI 0x40
 #define OP_RTS 0x60
@@ -146,17 +146,37 @@ monitor_cartridge_commands_t mon_cart_cmd;
 
 struct symbol_entry {
     uint16_t addr;
-    char *name;
-    struct symbol_entry *next;
+    char *name;                 /* NULL for a free entry */
+    int next;                   /* older label at the same address, or the
+                                   next free entry, -1 for none */
 };
 typedef struct symbol_entry symbol_entry_t;
 
+/* The labels of a memspace live in one array. A name hash (open
+   addressing, indices into the array) finds a label by name, and a table
+   with one slot per address holds the newest label of that address, older
+   ones are chained through 'next'. An index sorted by address is built
+   when the labels are listed. */
 struct symbol_table {
-    symbol_entry_t *name_list;
-    symbol_entry_t *addr_hash_table[HASH_ARRAY_SIZE];
+    symbol_entry_t *entries;
+    int num_entries;            /* entries in use, including free ones */
+    int max_entries;
+    int free_entry;             /* first free entry, -1 for none */
+    int count;                  /* number of labels */
+
+    int *name_hash;             /* SYMBOL_HASH_EMPTY, _DELETED or an index */
+    unsigned int name_hash_size;    /* power of two */
+    unsigned int name_hash_used;    /* slots not empty, including deleted */
+
+    int *addr_first;            /* 0x10000 slots, newest label per address */
+
+    int *sorted;                /* indices sorted by address, NULL if stale */
 };
 typedef struct symbol_table symbol_table_t;
 
+#define SYMBOL_HASH_EMPTY   -1
+#define SYMBOL_HASH_DELETED -2
+
 /* Global variables */
 
 /* Defined in file generated by bison. */
@@ -1174,36 +1194,30 @@ unsigned mon_disassemble_oneline(MEMSPACE memspace, uint16_t mem_config, uint16_
 void mon_backtrace(void)
 {
     uint16_t sp, i, pc, addr;
-
-    extern uint16_t callstack_pc_dst[];
-    extern uint16_t callstack_pc_src[];
-    extern uint16_t callstack_memory_bank_config[];
-    extern uint8_t  callstack_sp[];
-    extern unsigned callstack_size;
+    profiling_callstack_t *callstack;
     /* FIXME: memspace should be passed as an argument to this function */
     MEMSPACE mem = default_memspace;
-    if (mem == e_default_space) {
-        mem = default_memspace;
-    }
-    /* FIXME: only computer memspace can work right now */
-    if (mem != e_comp_space) {
-        mon_out("Sorry, backtrace is only implemented for computer memspace.\n");
+
+    /* the drive CPUs only track their call stack while they are profiled */
+    if (mem != e_comp_space && !profile_is_running(mem)) {
+        mon_out("Backtrace of a drive needs a running profiler, start it with \"prof on\".\n");
         return;
     }
+    callstack = profile_get_callstack(mem);
 
-    pc = (monitor_cpu_for_memspace[default_memspace]->mon_register_get_val)(default_memspace, e_PC);
-    sp = (monitor_cpu_for_memspace[default_memspace]->mon_register_get_val)(default_memspace, e_SP);
+    pc = (monitor_cpu_for_memspace[mem]->mon_register_get_val)(mem, e_PC);
+    sp = (monitor_cpu_for_memspace[mem]->mon_register_get_val)(mem, e_SP);
 
     mon_out("             PC        ");
-    mon_disassemble_oneline(default_memspace, mem_get_current_bank_config(), pc);
+    mon_disassemble_oneline(mem, mem == e_comp_space ? mem_get_current_bank_config() : 0, pc);
 
-    for (i = callstack_size-1; (int16_t)i >= 0; i--) {
-        uint16_t addr_src = callstack_pc_src[i];
-        uint16_t addr_dst = callstack_pc_dst[i];
+    for (i = callstack->size-1; (int16_t)i >= 0; i--) {
+        uint16_t addr_src = callstack->pc_src[i];
+        uint16_t addr_dst = callstack->pc_dst[i];
 
         /* get current stack value */
-        addr =   mon_get_mem_val_nosfx(default_memspace, callstack_memory_bank_config[i], callstack_sp[i] + 0x100 + 1)
-               | mon_get_mem_val_nosfx(default_memspace, callstack_memory_bank_config[i], callstack_sp[i] + 0x100 + 2) << 8;
+        addr =   mon_get_mem_val_nosfx(mem, callstack->memory_bank_config[i], callstack->sp[i] + 0x100 + 1)
+               | mon_get_mem_val_nosfx(mem, callstack->memory_bank_config[i], callstack->sp[i] + 0x100 + 2) << 8;
 
         if (addr_src >= 0xfffa && !(addr_src & 1)) {
             switch(addr_src) {
@@ -1216,9 +1230,9 @@ void mon_backtrace(void)
             addr -= 2; /* print the JSR instruction */
         }
         mon_out(" -> %04x", addr_dst);
-        mon_out(" [SP +%3d] ", callstack_sp[i] - sp + 1);
+        mon_out(" [SP +%3d] ", callstack->sp[i] - sp + 1);
 
-        mon_disassemble_oneline(default_memspace, callstack_memory_bank_config[i], addr);
+        mon_disassemble_oneline(mem, callstack->memory_bank_config[i], addr);
     }
 }
 
@@ -1543,7 +1557,7 @@ void monitor_init(monitor_interface_t *maincpu_interface_init,
                   monitor_interface_t *drive_interface_init[],
                   monitor_cpu_type_t **asmarray)
 {
-    int i, j;
+    int i;
     unsigned int dnr;
     monitor_cpu_type_list_t *monitor_cpu_type_list_ptr;
 
@@ -1607,10 +1621,8 @@ void monitor_init(monitor_interface_t *maincpu_interface_init,
         watch_load_count[i] = 0;
         watch_store_count[i] = 0;
         monitor_mask[i] = MI_NONE;
-        monitor_labels[i].name_list = NULL;
-        for (j = 0; j < HASH_ARRAY_SIZE; j++) {
-            monitor_labels[i].addr_hash_table[j] = NULL;
-        }
+        memset(&monitor_labels[i], 0, sizeof(symbol_table_t));
+        monitor_labels[i].free_entry = -1;
     }
 
     default_memspace = e_comp_space;
@@ -1832,6 +1844,9 @@ int monitor_resources_init(void)
     if (resources_register_string(resources_string) < 0) {
         return -1;
     }
+    if (mon_trace_resources_init() < 0) {
+        return -1;
+    }
     return resources_register_int(resources_int);
 }
 
@@ -1842,6 +1857,7 @@ void monitor_resources_shutdown(void)
         lib_free(monitorlogfilename);
         monitorlogfilename = NULL;
     }
+    mon_trace_resources_shutdown();
 }
 
 
@@ -1894,6 +1910,9 @@ int monitor_cmdline_options_init(void)
     mon_cart_cmd.cartridge_trigger_freeze = NULL;
     mon_cart_cmd.cartridge_trigger_freeze_nmi_only = NULL;
 
+    if (mon_trace_cmdline_options_init() < 0) {
+        return -1;
+    }
     return cmdline_register_options(cmdline_options);
 }
 
@@ -2128,10 +2147,13 @@ void mon_remove_dir(const char *path)
 
 
 
+static const int *symbol_table_sorted(MEMSPACE mem);
+
 void mon_save_symbols(MEMSPACE mem, const char *filename)
 {
     FILE *fp;
-    symbol_entry_t *sym_ptr;
+    const int *sorted;
+    int i;
 
     if (NULL == (fp = fopen(filename, MODE_WRITE))) {
         mon_out("Saving for `%s' failed.\n", filename);
@@ -2145,12 +2167,13 @@ void mon_save_symbols(MEMSPACE mem, const char *filename)
         mem = default_memspace;
     }
 
-    sym_ptr = monitor_labels[mem].name_list;
+    sorted = symbol_table_sorted(mem);
+
+    for (i = 0; i < monitor_labels[mem].count; i++) {
+        symbol_entry_t *sym = &monitor_labels[mem].entries[sorted[i]];
 
-    while (sym_ptr) {
-        fprintf(fp, "al %s:%04x %s\n", mon_memspace_string[mem], sym_ptr->addr,
-                sym_ptr->name);
-        sym_ptr = sym_ptr->next;
+        fprintf(fp, "al %s:%04x %s\n", mon_memspace_string[mem], sym->addr,
+                sym->name);
     }
 
     fclose(fp);
@@ -2337,53 +2360,161 @@ static void playback_next_command(void)
 
 static void free_symbol_table(MEMSPACE mem)
 {
-    symbol_entry_t *sym_ptr, *temp;
+    symbol_table_t *table = &monitor_labels[mem];
     int i;
 
-    /* Remove name list */
-    sym_ptr = monitor_labels[mem].name_list;
-    while (sym_ptr) {
-        /* Name memory is freed below. */
-        temp = sym_ptr;
-        sym_ptr = sym_ptr->next;
-        lib_free(temp);
+    for (i = 0; i < table->num_entries; i++) {
+        if (table->entries[i].name) {
+            lib_free(table->entries[i].name);
+        }
     }
+    lib_free(table->entries);
+    lib_free(table->name_hash);
+    lib_free(table->addr_first);
+    lib_free(table->sorted);
 
-    /* Remove address hash table */
-    for (i = 0; i < HASH_ARRAY_SIZE; i++) {
-        sym_ptr = monitor_labels[mem].addr_hash_table[i];
-        while (sym_ptr) {
-            lib_free (sym_ptr->name);
-            temp = sym_ptr;
-            sym_ptr = sym_ptr->next;
-            lib_free(temp);
+    memset(table, 0, sizeof(symbol_table_t));
+    table->free_entry = -1;
+}
+
+static unsigned int symbol_name_hash(const char *name)
+{
+    unsigned int hash = 2166136261u;
+
+    while (*name) {
+        hash = (hash ^ (uint8_t)*name++) * 16777619u;
+    }
+    return hash;
+}
+
+/* slot of the name in the name hash, or -1 */
+static int symbol_hash_find(const symbol_table_t *table, const char *name)
+{
+    unsigned int mask = table->name_hash_size - 1;
+    unsigned int slot;
+    int idx;
+
+    if (table->name_hash == NULL) {
+        return -1;
+    }
+
+    for (slot = symbol_name_hash(name) & mask;
+         (idx = table->name_hash[slot]) != SYMBOL_HASH_EMPTY;
+         slot = (slot + 1) & mask) {
+        if (idx >= 0 && strcmp(table->entries[idx].name, name) == 0) {
+            return (int)slot;
         }
     }
+    return -1;
+}
+
+static void symbol_hash_insert(symbol_table_t *table, int idx)
+{
+    unsigned int mask = table->name_hash_size - 1;
+    unsigned int slot = symbol_name_hash(table->entries[idx].name) & mask;
+
+    while (table->name_hash[slot] >= 0) {
+        slot = (slot + 1) & mask;
+    }
+    if (table->name_hash[slot] == SYMBOL_HASH_EMPTY) {
+        table->name_hash_used++;
+    }
+    table->name_hash[slot] = idx;
+}
+
+/* keep the name hash at most half full, dropping the deleted slots */
+static void symbol_hash_reserve(symbol_table_t *table)
+{
+    unsigned int size = table->name_hash_size;
+    unsigned int i;
+
+    if (table->name_hash != NULL && (table->name_hash_used + 1) * 2 <= size) {
+        return;
+    }
+
+    size = size ? size : 64;
+    while ((unsigned int)(table->count + 1) * 2 > size / 2) {
+        size *= 2;
+    }
+
+    lib_free(table->name_hash);
+    table->name_hash = lib_malloc(size * sizeof(int));
+    table->name_hash_size = size;
+    table->name_hash_used = 0;
+    for (i = 0; i < size; i++) {
+        table->name_hash[i] = SYMBOL_HASH_EMPTY;
+    }
+    for (i = 0; i < (unsigned int)table->num_entries; i++) {
+        if (table->entries[i].name) {
+            symbol_hash_insert(table, (int)i);
+        }
+    }
+}
+
+/* entries of the table being sorted, for symbol_sort_compare() */
+static const symbol_entry_t *sort_entries;
+
+/* by address, then by name */
+static int symbol_sort_compare(const void *a, const void *b)
+{
+    const symbol_entry_t *sym_a = &sort_entries[*(const int *)a];
+    const symbol_entry_t *sym_b = &sort_entries[*(const int *)b];
+
+    if (sym_a->addr != sym_b->addr) {
+        return sym_a->addr < sym_b->addr ? -1 : 1;
+    }
+    return strcmp(sym_a->name, sym_b->name);
+}
+
+static const int *symbol_table_sorted(MEMSPACE mem)
+{
+    symbol_table_t *table = &monitor_labels[mem];
+    int i, n = 0;
+
+    if (table->sorted == NULL) {
+        table->sorted = lib_malloc((table->count + 1) * sizeof(int));
+        for (i = 0; i < table->num_entries; i++) {
+            if (table->entries[i].name) {
+                table->sorted[n++] = i;
+            }
+        }
+        sort_entries = table->entries;
+        qsort(table->sorted, (size_t)n, sizeof(int), symbol_sort_compare);
+    }
+    return table->sorted;
+}
+
+static void symbol_table_changed(symbol_table_t *table)
+{
+    if (table->sorted) {
+        lib_free(table->sorted);
+        table->sorted = NULL;
+    }
 }
 
 char *mon_symbol_table_lookup_name(MEMSPACE mem, uint16_t addr)
 {
-    symbol_entry_t *sym_ptr;
+    symbol_table_t *table;
+    int idx;
 
     if (mem == e_default_space) {
         mem = default_memspace;
     }
 
-    sym_ptr = monitor_labels[mem].addr_hash_table[HASH_ADDR(addr)];
-    while (sym_ptr) {
-        if (addr == sym_ptr->addr) {
-            return sym_ptr->name;
-        }
-        sym_ptr = sym_ptr->next;
+    table = &monitor_labels[mem];
+    if (table->addr_first == NULL) {
+        return NULL;
     }
 
-    return NULL;
+    idx = table->addr_first[addr];
+    return (idx >= 0) ? table->entries[idx].name : NULL;
 }
 
 /* look up a symbol in the given memspace, returns address or -1 on error */
 int mon_symbol_table_lookup_addr(MEMSPACE mem, char *name)
 {
-    symbol_entry_t *sym_ptr;
+    symbol_table_t *table;
+    int slot;
 
     if (mem == e_default_space) {
         mem = default_memspace;
@@ -2395,15 +2526,13 @@ int mon_symbol_table_lookup_addr(MEMSPACE mem, char *name)
         return mon_register_name_to_value(mem, &name[1]);
     }
 
-    sym_ptr = monitor_labels[mem].name_list;
-    while (sym_ptr) {
-        if (strcmp(sym_ptr->name, name) == 0) {
-            return sym_ptr->addr;
-        }
-        sym_ptr = sym_ptr->next;
+    table = &monitor_labels[mem];
+    slot = symbol_hash_find(table, name);
+    if (slot < 0) {
+        return -1;
     }
 
-    return -1;
+    return table->entries[table->name_hash[slot]].addr;
 }
 
 char * mon_prepend_dot_to_name(char *name)
@@ -2417,7 +2546,8 @@ char * mon_prepend_dot_to_name(char *name)
 
 void mon_add_name_to_symbol_table(MON_ADDR addr, char *name)
 {
-    symbol_entry_t *sym_ptr;
+    symbol_table_t *table;
+    int idx;
     char *old_name;
     int old_addr;
     MEMSPACE mem = addr_memspace(addr);
@@ -2448,27 +2578,47 @@ void mon_add_name_to_symbol_table(MON_ADDR addr, char *name)
         mon_remove_name_from_symbol_table(mem, name);
     }
 
-    /* Add name to name list */
-    sym_ptr = lib_malloc(sizeof(symbol_entry_t));
-    sym_ptr->name = name;
-    sym_ptr->addr = loc;
+    table = &monitor_labels[mem];
+    symbol_hash_reserve(table);
 
-    sym_ptr->next = monitor_labels[mem].name_list;
-    monitor_labels[mem].name_list = sym_ptr;
+    /* Add the label to the array */
+    if (table->free_entry >= 0) {
+        idx = table->free_entry;
+        table->free_entry = table->entries[idx].next;
+    } else {
+        if (table->num_entries == table->max_entries) {
+            table->max_entries = table->max_entries ? table->max_entries * 2 : 256;
+            table->entries = lib_realloc(table->entries,
+                                         table->max_entries * sizeof(symbol_entry_t));
+        }
+        idx = table->num_entries++;
+    }
+    table->entries[idx].name = name;
+    table->entries[idx].addr = loc;
+    table->count++;
 
-    /* Add address to hash table */
-    sym_ptr = lib_malloc(sizeof(symbol_entry_t));
-    sym_ptr->name = name;
-    sym_ptr->addr = addr;
+    /* Add the name to the name hash */
+    symbol_hash_insert(table, idx);
+
+    /* Make it the newest label of the address */
+    if (table->addr_first == NULL) {
+        int i;
+
+        table->addr_first = lib_malloc(0x10000 * sizeof(int));
+        for (i = 0; i < 0x10000; i++) {
+            table->addr_first[i] = -1;
+        }
+    }
+    table->entries[idx].next = table->addr_first[loc];
+    table->addr_first[loc] = idx;
 
-    sym_ptr->next = monitor_labels[mem].addr_hash_table[HASH_ADDR(loc)];
-    monitor_labels[mem].addr_hash_table[HASH_ADDR(loc)] = sym_ptr;
+    symbol_table_changed(table);
 }
 
 void mon_remove_name_from_symbol_table(MEMSPACE mem, char *name)
 {
-    int addr;
-    symbol_entry_t *sym_ptr, *prev_ptr;
+    symbol_table_t *table;
+    int slot, idx, *link;
 
     if (mem == e_default_space) {
         mem = default_memspace;
@@ -2480,78 +2630,58 @@ void mon_remove_name_from_symbol_table(MEMSPACE mem, char *name)
         return;
     }
 
-    if ((addr = mon_symbol_table_lookup_addr(mem, name)) < 0) {
+    table = &monitor_labels[mem];
+    slot = symbol_hash_find(table, name);
+    if (slot < 0) {
         mon_out("Symbol %s not found.\n", name);
         return;
     }
+    idx = table->name_hash[slot];
 
-    /* Remove entry in name list */
-    sym_ptr = monitor_labels[mem].name_list;
-    prev_ptr = NULL;
-    while (sym_ptr) {
-        if (strcmp(sym_ptr->name, name) == 0) {
-            /* Name memory is freed below. */
-            addr = sym_ptr->addr;
-            if (prev_ptr) {
-                prev_ptr->next = sym_ptr->next;
-            } else {
-                monitor_labels[mem].name_list = sym_ptr->next;
-            }
-            lib_free(sym_ptr);
-            break;
-        }
-        prev_ptr = sym_ptr;
-        sym_ptr = sym_ptr->next;
-    }
+    /* Remove it from the name hash */
+    table->name_hash[slot] = SYMBOL_HASH_DELETED;
 
-    /* Remove entry in address hash table */
-    sym_ptr = monitor_labels[mem].addr_hash_table[HASH_ADDR(addr)];
-    prev_ptr = NULL;
-    while (sym_ptr) {
-        if ((addr == sym_ptr->addr) && !strcmp(sym_ptr->name, name)) {
-            lib_free(sym_ptr->name);
-            if (prev_ptr) {
-                prev_ptr->next = sym_ptr->next;
-            } else {
-                monitor_labels[mem].addr_hash_table[HASH_ADDR(addr)] = sym_ptr->next;
-            }
-            lib_free(sym_ptr);
-            return;
-        }
-        prev_ptr = sym_ptr;
-        sym_ptr = sym_ptr->next;
+    /* Remove it from the labels of its address */
+    for (link = &table->addr_first[table->entries[idx].addr];
+         *link != idx;
+         link = &table->entries[*link].next) {
     }
+    *link = table->entries[idx].next;
+
+    /* Free the entry */
+    lib_free(table->entries[idx].name);
+    table->entries[idx].name = NULL;
+    table->entries[idx].next = table->free_entry;
+    table->free_entry = idx;
+    table->count--;
+
+    symbol_table_changed(table);
 }
 
 void mon_print_symbol_table(MEMSPACE mem)
 {
-    symbol_entry_t *sym_ptr;
+    const int *sorted;
+    int i;
 
     if (mem == e_default_space) {
         mem = default_memspace;
     }
 
-    sym_ptr = monitor_labels[mem].name_list;
-    while (sym_ptr) {
-        mon_out("$%04x %s\n", sym_ptr->addr, sym_ptr->name);
-        sym_ptr = sym_ptr->next;
+    sorted = symbol_table_sorted(mem);
+    for (i = 0; i < monitor_labels[mem].count; i++) {
+        symbol_entry_t *sym = &monitor_labels[mem].entries[sorted[i]];
+
+        mon_out("$%04x %s\n", sym->addr, sym->name);
     }
 }
 
 void mon_clear_symbol_table(MEMSPACE mem)
 {
-    int i;
-
     if (mem == e_default_space) {
         mem = default_memspace;
     }
 
     free_symbol_table(mem);
-    monitor_labels[mem].name_list = NULL;
-
-    for (i = 0; i < HASH_ARRAY_SIZE; i++) {
-        monitor_labels[mem].addr_hash_table[i] = NULL;
-    }
 }
 
 
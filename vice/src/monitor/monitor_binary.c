@@ -33,6 +33,11 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef USE_VICE_THREAD
+#include <pthread.h>
+#endif
+
+#include "alarm.h"
 #include "archdep_defs.h"
 #include "cmdline.h"
 #include "drive.h"
@@ -75,6 +80,100 @@
 
 static vice_network_socket_t * listen_socket = NULL;
 static vice_network_socket_t * connected_socket = NULL;
+/* number of the current connection, 0 if there is none */
+static unsigned int connection_serial = 0;
+static unsigned int connection_count = 0;
+
+/* subscription updates are dropped rather than queued beyond this */
+#define BINARY_OUTPUT_MAX (1024 * 1024)
+
+/* data the client did not take yet, sent as soon as it can take more */
+static unsigned char *output_buffer = NULL;
+static size_t output_start = 0;
+static size_t output_length = 0;
+static size_t output_size = 0;
+
+/* lives in maincpu.c, maincpu.h can't be included here as its reg_pc clashes */
+extern struct alarm_context_s *maincpu_alarm_context;
+
+#ifdef USE_VICE_THREAD
+/*
+ * With threads, a dedicated I/O thread accepts the connection, receives and
+ * parses the commands and queues them. The emulation thread only runs the
+ * commands and hands the responses to the output buffer without ever
+ * blocking; the I/O thread sends what the client did not take at once.
+ * While the emulation is running, a cycle alarm checks the queue, so a
+ * command is picked up at the next instruction boundary within
+ * BINARY_POLL_CYCLES instead of at the next vsync.
+ *
+ * Only the I/O thread opens and closes the connection.
+ */
+
+/* check for queued commands about every millisecond of emulated time */
+#define BINARY_POLL_CYCLES 1000
+
+/* how long the I/O thread waits on the socket before checking for stop, in ms */
+#define BINARY_IO_WAIT_MS 10
+
+typedef struct binary_request_s {
+    unsigned char *buffer;
+    struct binary_request_s *next;
+} binary_request_t;
+
+static pthread_t io_thread;
+static int io_thread_running = 0;
+static volatile int io_thread_stop = 0;
+
+/* protects the queue */
+static pthread_mutex_t queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_cond = PTHREAD_COND_INITIALIZER;
+static binary_request_t *queue_head = NULL;
+static binary_request_t *queue_tail = NULL;
+
+/* protects connected_socket, connection_serial and the output buffer */
+static pthread_mutex_t socket_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static alarm_t *binary_alarm = NULL;
+static int binary_alarm_pending = 0;
+
+static void *monitor_binary_io_thread(void *unused);
+#endif
+
+static void monitor_binary_socket_lock(void)
+{
+#ifdef USE_VICE_THREAD
+    pthread_mutex_lock(&socket_lock);
+#endif
+}
+
+static void monitor_binary_socket_unlock(void)
+{
+#ifdef USE_VICE_THREAD
+    pthread_mutex_unlock(&socket_lock);
+#endif
+}
+
+/*! \internal \brief Check if the I/O thread does the receiving and sending */
+static int monitor_binary_threaded(void)
+{
+#ifdef USE_VICE_THREAD
+    return io_thread_running;
+#else
+    return 0;
+#endif
+}
+
+/*! \internal \brief Get the number of the current connection, 0 if there is none */
+static unsigned int monitor_binary_connection(void)
+{
+    unsigned int serial;
+
+    monitor_binary_socket_lock();
+    serial = connection_serial;
+    monitor_binary_socket_unlock();
+
+    return serial;
+}
 
 static char *monitor_binary_server_address = NULL;
 static int monitor_binary_enabled = 0;
@@ -84,6 +183,8 @@ enum t_binary_command {
 
     e_MON_CMD_MEM_GET = 0x01,
     e_MON_CMD_MEM_SET = 0x02,
+    e_MON_CMD_SUBSCRIPTION_SET = 0x03,
+    e_MON_CMD_SUBSCRIPTION_DELETE = 0x04,
 
     e_MON_CMD_CHECKPOINT_GET = 0x11,
     e_MON_CMD_CHECKPOINT_SET = 0x12,
@@ -130,6 +231,8 @@ enum t_binary_response {
     e_MON_RESPONSE_INVALID = 0x00,
     e_MON_RESPONSE_MEM_GET = 0x01,
     e_MON_RESPONSE_MEM_SET = 0x02,
+    e_MON_RESPONSE_SUBSCRIPTION_SET = 0x03,
+    e_MON_RESPONSE_SUBSCRIPTION_DELETE = 0x04,
 
     e_MON_RESPONSE_CHECKPOINT_INFO = 0x11,
 
@@ -150,6 +253,7 @@ enum t_binary_response {
     e_MON_RESPONSE_JAM = 0x61,
     e_MON_RESPONSE_STOPPED = 0x62,
     e_MON_RESPONSE_RESUMED = 0x63,
+    e_MON_RESPONSE_SUBSCRIPTION_UPDATE = 0x64,
 
     e_MON_RESPONSE_ADVANCE_INSTRUCTIONS = 0x71,
     e_MON_RESPONSE_KEYBOARD_FEED = 0x72,
@@ -207,27 +311,196 @@ struct binary_command_s {
 };
 typedef struct binary_command_s binary_command_t;
 
-int monitor_binary_transmit(const unsigned char *buffer, size_t buffer_length)
+enum t_subscription_mode {
+    e_SUBSCRIPTION_MODE_FRAME = 0x00,
+    e_SUBSCRIPTION_MODE_CYCLES = 0x01,
+    e_SUBSCRIPTION_MODE_CHANGE = 0x02,
+};
+typedef enum t_subscription_mode SUBSCRIPTION_MODE;
+
+#define SUBSCRIPTION_FLAG_MEMORY    0x01
+#define SUBSCRIPTION_FLAG_REGISTERS 0x02
+
+/*
+ * A subscription samples a memory range and/or the registers of a memspace
+ * while the emulation keeps running, and pushes the difference to what the
+ * client received last as a SUBSCRIPTION_UPDATE event. Sampling happens in a
+ * CPU trap, so the registers are exported and nothing is read mid-instruction.
+ */
+typedef struct binary_subscription_s {
+    uint32_t id;
+    SUBSCRIPTION_MODE mode;
+    uint32_t cycles;            /* period for e_SUBSCRIPTION_MODE_CYCLES */
+    CLOCK next_clk;             /* next sample for e_SUBSCRIPTION_MODE_CYCLES */
+    uint8_t flags;
+    MEMSPACE memspace;
+    int banknum;
+    uint16_t start;
+    uint32_t length;
+    uint8_t *last_mem;          /* memory as last sent to the client */
+    uint8_t *last_regs;         /* registers as last sent to the client */
+    uint32_t last_regs_size;
+    int sent;                   /* client holds a full copy */
+    struct binary_subscription_s *next;
+} binary_subscription_t;
+
+static binary_subscription_t *subscriptions = NULL;
+static uint32_t subscription_next_id = 0;
+/* the connection the subscriptions belong to */
+static unsigned int subscription_connection = 0;
+static alarm_t *subscription_alarm = NULL;
+static int subscription_trap_pending = 0;
+static int subscription_frame_due = 0;
+
+static void monitor_binary_subscription_frame(void);
+
+/*! \internal \brief Send as much of the output buffer as the client takes
+
+ Must be called with the socket lock held.
+
+ \return
+   0 on success, -1 on a send error, in which case the output is dropped
+*/
+static int monitor_binary_flush_output(void)
 {
-    int error = 0;
+    while (output_length > 0) {
+        ssize_t sent = vice_network_send_nonblocking(connected_socket,
+                                                     &output_buffer[output_start],
+                                                     output_length);
+
+        if (sent < 0) {
+            output_start = 0;
+            output_length = 0;
+            return -1;
+        }
+        if (sent == 0) {
+            break;
+        }
+        output_start += (size_t)sent;
+        output_length -= (size_t)sent;
+    }
+    if (output_length == 0) {
+        output_start = 0;
+    }
+
+    return 0;
+}
 
-    if (connected_socket) {
-        size_t len = (size_t)vice_network_send(connected_socket, buffer, buffer_length, 0);
+/*! \internal \brief Append data to the output buffer
 
-        if (len != buffer_length) {
-            error = -1;
-        } else {
-            error = (int)len;
+ Must be called with the socket lock held.
+*/
+static void monitor_binary_queue_output(const unsigned char *buffer, size_t buffer_length)
+{
+    if (output_start + output_length + buffer_length > output_size) {
+        if (output_length > 0) {
+            memmove(output_buffer, &output_buffer[output_start], output_length);
+        }
+        output_start = 0;
+        if (output_length + buffer_length > output_size) {
+            output_size = output_length + buffer_length;
+            output_buffer = lib_realloc(output_buffer, output_size);
+        }
+    }
+    memcpy(&output_buffer[output_start + output_length], buffer, buffer_length);
+    output_length += buffer_length;
+}
+
+/*! \internal \brief Send data to the client
+
+ Must be called with the socket lock held.
+
+ \param blocking
+   if non-zero, wait until the client took all of the data. Else send what
+   the client takes right now and leave the rest in the output buffer.
+
+ \return
+   buffer_length on success, 0 if there is no connection, -1 on error
+*/
+static int monitor_binary_write(const unsigned char *buffer, size_t buffer_length, int blocking)
+{
+    ssize_t sent;
+
+    if (connected_socket == NULL) {
+        return 0;
+    }
+
+    if (blocking) {
+        /* the older data has to go first */
+        if (output_length > 0) {
+            sent = vice_network_send(connected_socket, &output_buffer[output_start], output_length, 0);
+            output_start = 0;
+            output_length = 0;
+            if (sent < 0) {
+                return -1;
+            }
         }
+        sent = vice_network_send(connected_socket, buffer, buffer_length, 0);
+        return (sent == (ssize_t)buffer_length) ? (int)buffer_length : -1;
     }
 
+    if (monitor_binary_flush_output() < 0) {
+        return -1;
+    }
+    sent = 0;
+    if (output_length == 0) {
+        sent = vice_network_send_nonblocking(connected_socket, buffer, buffer_length);
+        if (sent < 0) {
+            return -1;
+        }
+    }
+    if ((size_t)sent < buffer_length) {
+        monitor_binary_queue_output(buffer + sent, buffer_length - (size_t)sent);
+    }
+
+    return (int)buffer_length;
+}
+
+int monitor_binary_transmit(const unsigned char *buffer, size_t buffer_length)
+{
+    int error;
+
+    monitor_binary_socket_lock();
+    error = monitor_binary_write(buffer, buffer_length, !monitor_binary_threaded());
+    monitor_binary_socket_unlock();
+
     return error;
 }
 
+/*! \internal \brief Close the connection
+
+ With threads, only the I/O thread may call this, or the emulation thread
+ once the I/O thread is gone.
+*/
 static void monitor_binary_quit(void)
 {
-    vice_network_socket_close(connected_socket);
-    connected_socket = NULL;
+    monitor_binary_socket_lock();
+    if (connected_socket != NULL) {
+        vice_network_socket_close(connected_socket);
+        connected_socket = NULL;
+    }
+    connection_serial = 0;
+    output_start = 0;
+    output_length = 0;
+    monitor_binary_socket_unlock();
+}
+
+/*! \internal \brief Accept a new connection on the listening socket */
+static void monitor_binary_accept(void)
+{
+    vice_network_socket_t *sock = vice_network_accept(listen_socket);
+
+    if (sock == NULL) {
+        return;
+    }
+
+    monitor_binary_socket_lock();
+    connected_socket = sock;
+    if (++connection_count == 0) {
+        connection_count = 1;
+    }
+    connection_serial = connection_count;
+    monitor_binary_socket_unlock();
 }
 
 ssize_t monitor_binary_receive(unsigned char *buffer, size_t buffer_length)
@@ -235,6 +508,7 @@ ssize_t monitor_binary_receive(unsigned char *buffer, size_t buffer_length)
     ssize_t bytes_received = 0;
     ssize_t total_bytes_received = 0;
 
+    /* connected_socket is only changed by the caller's thread, no lock needed */
     while (buffer_length && connected_socket) {
         bytes_received = vice_network_receive(connected_socket, buffer, buffer_length, 0);
 
@@ -270,7 +544,7 @@ static int monitor_binary_data_available(void)
         /* we have no connection yet, allow for connection */
 
         if (vice_network_select_poll_one(listen_socket)) {
-            connected_socket = vice_network_accept(listen_socket);
+            monitor_binary_accept();
         }
     }
 
@@ -278,8 +552,60 @@ static int monitor_binary_data_available(void)
     return available;
 }
 
+#ifdef USE_VICE_THREAD
+static int monitor_binary_queue_empty(void)
+{
+    int empty;
+
+    pthread_mutex_lock(&queue_lock);
+    empty = (queue_head == NULL);
+    pthread_mutex_unlock(&queue_lock);
+
+    return empty;
+}
+
+static void monitor_binary_alarm_handler(CLOCK offset, void *data)
+{
+    alarm_unset(binary_alarm);
+    binary_alarm_pending = 0;
+
+    if (!monitor_binary_queue_empty()) {
+        monitor_startup_trap();
+    }
+    if (monitor_binary_connection() != 0) {
+        alarm_set(binary_alarm, maincpu_clk + BINARY_POLL_CYCLES);
+        binary_alarm_pending = 1;
+    }
+}
+#endif
+
 void monitor_check_binary(void)
 {
+    monitor_binary_subscription_frame();
+
+#ifdef USE_VICE_THREAD
+    if (io_thread_running) {
+        /* (re)arm the poll alarm once a client is connected */
+        if (monitor_binary_connection() != 0 && !binary_alarm_pending) {
+            if (binary_alarm == NULL) {
+                binary_alarm = alarm_new(maincpu_alarm_context, "BinaryMonitor",
+                                         monitor_binary_alarm_handler, NULL);
+            }
+            alarm_set(binary_alarm, maincpu_clk + BINARY_POLL_CYCLES);
+            binary_alarm_pending = 1;
+        }
+        if (!monitor_binary_queue_empty()) {
+            monitor_startup_trap();
+        }
+        return;
+    }
+#endif
+    /* send what the client could not take at the last update */
+    monitor_binary_socket_lock();
+    if (output_length > 0) {
+        monitor_binary_flush_output();
+    }
+    monitor_binary_socket_unlock();
     if (monitor_binary_data_available()) {
         monitor_startup_trap();
     }
@@ -336,9 +662,24 @@ static uint16_t little_endian_to_uint16(unsigned char *input) {
     return (input[1] << 8) + input[0];
 }
 
-static void monitor_binary_response(uint32_t length, BINARY_RESPONSE response_type, BINARY_ERROR errorcode, uint32_t request_id, unsigned char *body)
+/* size of the header in front of every response */
+#define MON_RESPONSE_HEADER_SIZE 12
+
+/*! \internal \brief Send a response
+
+ \param update
+   if non-zero, the response is a subscription update: it is never sent
+   blocking, and it is dropped if the output buffer has no room left.
+
+ \return
+   0 on success, -1 if the response was dropped or could not be sent
+*/
+static int monitor_binary_send_response(uint32_t length, BINARY_RESPONSE response_type, BINARY_ERROR errorcode,
+                                        uint32_t request_id, unsigned char *body, int update)
 {
-    unsigned char response[12];
+    unsigned char response[MON_RESPONSE_HEADER_SIZE];
+    int blocking = !update && !monitor_binary_threaded();
+    int error = 0;
 
     response[0] = ASC_STX;
     response[1] = MON_BINARY_API_VERSION;
@@ -347,11 +688,22 @@ static void monitor_binary_response(uint32_t length, BINARY_RESPONSE response_ty
     response[7] = (uint8_t)errorcode;
     write_uint32(request_id, &response[8]);
 
-    monitor_binary_transmit(response, sizeof response);
-
-    if (body != NULL) {
-        monitor_binary_transmit(body, length);
+    monitor_binary_socket_lock();
+    if (update && output_length + sizeof response + length > BINARY_OUTPUT_MAX) {
+        error = -1;
+    } else if (monitor_binary_write(response, sizeof response, blocking) <= 0) {
+        error = -1;
+    } else if (body != NULL && monitor_binary_write(body, length, blocking) < 0) {
+        error = -1;
     }
+    monitor_binary_socket_unlock();
+
+    return error;
+}
+
+static void monitor_binary_response(uint32_t length, BINARY_RESPONSE response_type, BINARY_ERROR errorcode, uint32_t request_id, unsigned char *body)
+{
+    monitor_binary_send_response(length, response_type, errorcode, request_id, body, 0);
 }
 
 static void monitor_binary_error(BINARY_ERROR errorcode, uint32_t request_id)
@@ -1743,6 +2095,415 @@ static void monitor_binary_process_mem_set(binary_command_t *command)
     monitor_binary_response(0, e_MON_RESPONSE_MEM_SET, e_MON_ERR_OK, command->request_id, NULL);
 }
 
+/* ------------------------------------------------------------------------- */
+
+/* a run header (offset, length) costs 4 bytes, so merge across shorter gaps */
+#define SUBSCRIPTION_RUN_HEADER_SIZE 4
+#define SUBSCRIPTION_RUN_MAX_LENGTH  0xffff
+
+static void monitor_binary_subscription_free(binary_subscription_t *sub)
+{
+    lib_free(sub->last_mem);
+    lib_free(sub->last_regs);
+    lib_free(sub);
+}
+
+static void monitor_binary_subscription_clear(void)
+{
+    while (subscriptions != NULL) {
+        binary_subscription_t *next = subscriptions->next;
+
+        monitor_binary_subscription_free(subscriptions);
+        subscriptions = next;
+    }
+    subscription_connection = 0;
+    subscription_frame_due = 0;
+    /* a still armed alarm finds nothing to do and is not re-armed */
+}
+
+/*! \internal \brief Drop the subscriptions if their connection is gone
+
+ \return
+   1 if there are subscriptions left, else 0
+*/
+static int monitor_binary_subscription_active(void)
+{
+    if (subscriptions != NULL && monitor_binary_connection() != subscription_connection) {
+        monitor_binary_subscription_clear();
+    }
+
+    return subscriptions != NULL;
+}
+
+/*! \internal \brief Find the next run of changed bytes
+
+ \param pos
+   start of the search, updated to the end of the run
+
+ \param run_length
+   receives the length of the run
+
+ \return
+   the offset of the run, or sub->length if there is none
+*/
+static uint32_t monitor_binary_subscription_next_run(binary_subscription_t *sub, const uint8_t *mem,
+                                                     uint32_t *pos, uint32_t *run_length)
+{
+    uint32_t offset = *pos;
+    uint32_t end;
+    uint32_t gap;
+
+    if (!sub->sent) {
+        /* first update: everything, in runs of at most 64k - 1 */
+        end = offset + SUBSCRIPTION_RUN_MAX_LENGTH;
+        if (end > sub->length) {
+            end = sub->length;
+        }
+        *pos = end;
+        *run_length = end - offset;
+        return offset;
+    }
+
+    while (offset < sub->length && mem[offset] == sub->last_mem[offset]) {
+        offset++;
+    }
+    if (offset == sub->length) {
+        *pos = offset;
+        *run_length = 0;
+        return offset;
+    }
+
+    end = offset + 1;
+    gap = 0;
+    while (end + gap < sub->length
+           && gap < SUBSCRIPTION_RUN_HEADER_SIZE
+           && end + gap - offset < SUBSCRIPTION_RUN_MAX_LENGTH) {
+        if (mem[end + gap] != sub->last_mem[end + gap]) {
+            end += gap + 1;
+            gap = 0;
+        } else {
+            gap++;
+        }
+    }
+
+    *pos = end;
+    *run_length = end - offset;
+    return offset;
+}
+
+/*! \internal \brief Sample one subscription and send the update
+
+ \param force
+   send the update even if nothing changed
+*/
+static void monitor_binary_subscription_update(binary_subscription_t *sub, int force)
+{
+    uint8_t *mem = NULL;
+    uint8_t *regs_data = NULL;
+    uint32_t regs_size = 0;
+    int regs_changed = 0;
+    uint16_t run_count = 0;
+    uint32_t runs_size = 0;
+    uint32_t pos, offset, run_length;
+    uint32_t response_size;
+    unsigned char *response;
+    unsigned char *response_cursor;
+
+    if (sub->memspace != e_comp_space) {
+        drive_cpu_execute_all(maincpu_clk);
+    }
+
+    if (sub->flags & SUBSCRIPTION_FLAG_MEMORY) {
+        int old_sidefx = sidefx;
+
+        mem = lib_malloc(sub->length);
+        sidefx = 0;
+        mon_get_mem_block_ex(sub->memspace, sub->banknum, sub->start, sub->length - 1, mem);
+        sidefx = old_sidefx;
+
+        pos = 0;
+        while ((offset = monitor_binary_subscription_next_run(sub, mem, &pos, &run_length)) < sub->length) {
+            run_count++;
+            runs_size += SUBSCRIPTION_RUN_HEADER_SIZE + run_length;
+        }
+    }
+
+    if (sub->flags & SUBSCRIPTION_FLAG_REGISTERS) {
+        mon_reg_list_t *regs = mon_register_list_get(sub->memspace);
+        uint16_t count = count_registers(regs);
+
+        regs_size = 2 + count * (MON_REGISTER_ITEM_SIZE + 1);
+        regs_data = lib_malloc(regs_size);
+        write_registers(regs, count, regs_data);
+        lib_free(regs);
+
+        regs_changed = !sub->sent
+                       || regs_size != sub->last_regs_size
+                       || memcmp(regs_data, sub->last_regs, regs_size) != 0;
+    }
+
+    if (!force && sub->sent && run_count == 0 && !regs_changed) {
+        lib_free(mem);
+        lib_free(regs_data);
+        return;
+    }
+
+    response_size = 4 + 8 + 2 + runs_size + (regs_changed ? regs_size : 2);
+    response = lib_malloc(response_size);
+    response_cursor = response;
+
+    response_cursor = write_uint32(sub->id, response_cursor);
+    response_cursor = write_uint64(maincpu_clk, response_cursor);
+    response_cursor = write_uint16(run_count, response_cursor);
+
+    if (mem != NULL) {
+        pos = 0;
+        while ((offset = monitor_binary_subscription_next_run(sub, mem, &pos, &run_length)) < sub->length) {
+            response_cursor = write_uint16((uint16_t)offset, response_cursor);
+            response_cursor = write_uint16((uint16_t)run_length, response_cursor);
+            memcpy(response_cursor, &mem[offset], run_length);
+            response_cursor += run_length;
+        }
+    }
+
+    if (regs_changed) {
+        memcpy(response_cursor, regs_data, regs_size);
+    } else {
+        write_uint16(0, response_cursor);
+    }
+
+    if (monitor_binary_send_response(response_size, e_MON_RESPONSE_SUBSCRIPTION_UPDATE, e_MON_ERR_OK,
+                                     MON_EVENT_ID, response, 1) < 0) {
+        /* the client is not keeping up: keep the old snapshot, so the
+           next update carries all changes since the last one sent */
+        lib_free(mem);
+        lib_free(regs_data);
+        lib_free(response);
+        return;
+    }
+
+    if (mem != NULL) {
+        lib_free(sub->last_mem);
+        sub->last_mem = mem;
+    }
+    if (regs_changed) {
+        lib_free(sub->last_regs);
+        sub->last_regs = regs_data;
+        sub->last_regs_size = regs_size;
+    } else {
+        lib_free(regs_data);
+    }
+    sub->sent = 1;
+
+    lib_free(response);
+}
+
+static void monitor_binary_subscription_schedule(void);
+
+/*! \internal \brief Trap handler: send the updates that are due */
+static void monitor_binary_subscription_trap(uint16_t addr, void *data)
+{
+    binary_subscription_t *sub;
+    int frame_due = subscription_frame_due;
+
+    subscription_trap_pending = 0;
+    subscription_frame_due = 0;
+
+    monitor_binary_subscription_active();
+
+    for (sub = subscriptions; sub != NULL; sub = sub->next) {
+        if (sub->mode == e_SUBSCRIPTION_MODE_CYCLES) {
+            if (maincpu_clk >= sub->next_clk) {
+                monitor_binary_subscription_update(sub, 1);
+                sub->next_clk = maincpu_clk + sub->cycles;
+            }
+        } else if (frame_due) {
+            monitor_binary_subscription_update(sub, sub->mode == e_SUBSCRIPTION_MODE_FRAME);
+        }
+    }
+
+    monitor_binary_subscription_schedule();
+}
+
+static void monitor_binary_subscription_trigger(void)
+{
+    if (!subscription_trap_pending) {
+        subscription_trap_pending = 1;
+        interrupt_maincpu_trigger_trap(monitor_binary_subscription_trap, NULL);
+    }
+}
+
+static void monitor_binary_subscription_alarm_handler(CLOCK offset, void *data)
+{
+    alarm_unset(subscription_alarm);
+    monitor_binary_subscription_trigger();
+}
+
+/*! \internal \brief Arm the alarm for the earliest cycle based subscription */
+static void monitor_binary_subscription_schedule(void)
+{
+    binary_subscription_t *sub;
+    CLOCK next_clk = CLOCK_MAX;
+
+    for (sub = subscriptions; sub != NULL; sub = sub->next) {
+        if (sub->mode == e_SUBSCRIPTION_MODE_CYCLES && sub->next_clk < next_clk) {
+            next_clk = sub->next_clk;
+        }
+    }
+
+    if (next_clk == CLOCK_MAX) {
+        if (subscription_alarm != NULL) {
+            alarm_unset(subscription_alarm);
+        }
+        return;
+    }
+
+    if (subscription_alarm == NULL) {
+        subscription_alarm = alarm_new(maincpu_alarm_context, "BinaryMonitorSubscription",
+                                       monitor_binary_subscription_alarm_handler, NULL);
+    }
+    if (next_clk <= maincpu_clk) {
+        next_clk = maincpu_clk + 1;
+    }
+    alarm_set(subscription_alarm, next_clk);
+}
+
+/*! \internal \brief Called once per frame from monitor_check_binary() */
+static void monitor_binary_subscription_frame(void)
+{
+    binary_subscription_t *sub;
+
+    if (!monitor_binary_subscription_active()) {
+        return;
+    }
+
+    for (sub = subscriptions; sub != NULL; sub = sub->next) {
+        if (sub->mode != e_SUBSCRIPTION_MODE_CYCLES) {
+            subscription_frame_due = 1;
+            monitor_binary_subscription_trigger();
+            break;
+        }
+    }
+}
+
+static void monitor_binary_process_subscription_set(binary_command_t *command)
+{
+    unsigned char response[4];
+    binary_subscription_t *sub;
+    MEMSPACE memspace;
+
+    unsigned char *body = command->body;
+
+    uint8_t mode;
+    uint32_t cycles;
+    uint8_t flags;
+    uint8_t requested_memspace;
+    uint16_t requested_banknum;
+    uint16_t startaddress;
+    uint16_t endaddress;
+
+    if (command->length < 13) {
+        monitor_binary_error(e_MON_ERR_CMD_INVALID_LENGTH, command->request_id);
+        return;
+    }
+
+    mode = body[0];
+    cycles = little_endian_to_uint32(&body[1]);
+    flags = body[5];
+    requested_memspace = body[6];
+    requested_banknum = little_endian_to_uint16(&body[7]);
+    startaddress = little_endian_to_uint16(&body[9]);
+    endaddress = little_endian_to_uint16(&body[11]);
+
+    if (mode > e_SUBSCRIPTION_MODE_CHANGE
+        || (mode == e_SUBSCRIPTION_MODE_CYCLES && cycles == 0)
+        || (flags & (SUBSCRIPTION_FLAG_MEMORY | SUBSCRIPTION_FLAG_REGISTERS)) == 0) {
+        monitor_binary_error(e_MON_ERR_INVALID_PARAMETER, command->request_id);
+        log_message(LOG_DEFAULT, "monitor binary subscription: invalid mode %u, cycles %u or flags %02x",
+                    mode, cycles, flags);
+        return;
+    }
+
+    if (startaddress > endaddress) {
+        monitor_binary_error(e_MON_ERR_INVALID_PARAMETER, command->request_id);
+        log_message(LOG_DEFAULT, "monitor binary subscription: wrong start and/or end address %04x - %04x",
+                    startaddress, endaddress);
+        return;
+    }
+
+    memspace = get_requested_memspace(requested_memspace);
+
+    if (memspace == e_invalid_space) {
+        monitor_binary_error(e_MON_ERR_INVALID_MEMSPACE, command->request_id);
+        log_message(LOG_DEFAULT, "monitor binary subscription: Unknown memspace %u", requested_memspace);
+        return;
+    }
+
+    if (mon_banknum_validate(memspace, requested_banknum) == 0) {
+        monitor_binary_error(e_MON_ERR_INVALID_PARAMETER, command->request_id);
+        log_message(LOG_DEFAULT, "monitor binary subscription: Unknown bank %u", requested_banknum);
+        return;
+    }
+
+    /* subscriptions of an earlier connection are gone by now */
+    monitor_binary_subscription_active();
+    subscription_connection = monitor_binary_connection();
+
+    sub = lib_calloc(1, sizeof(binary_subscription_t));
+    sub->id = subscription_next_id++;
+    sub->mode = mode;
+    sub->cycles = cycles;
+    sub->next_clk = maincpu_clk + cycles;
+    sub->flags = flags;
+    sub->memspace = memspace;
+    sub->banknum = requested_banknum;
+    sub->start = startaddress;
+    sub->length = (endaddress + 1) - startaddress;
+    sub->next = subscriptions;
+    subscriptions = sub;
+
+    monitor_binary_subscription_schedule();
+
+    write_uint32(sub->id, response);
+
+    monitor_binary_response(sizeof response, e_MON_RESPONSE_SUBSCRIPTION_SET, e_MON_ERR_OK, command->request_id, response);
+}
+
+static void monitor_binary_process_subscription_delete(binary_command_t *command)
+{
+    binary_subscription_t **link;
+    uint32_t id;
+
+    if (command->length < 4) {
+        monitor_binary_error(e_MON_ERR_CMD_INVALID_LENGTH, command->request_id);
+        return;
+    }
+
+    id = little_endian_to_uint32(command->body);
+
+    for (link = &subscriptions; *link != NULL; link = &(*link)->next) {
+        if ((*link)->id == id) {
+            break;
+        }
+    }
+
+    if (*link == NULL) {
+        monitor_binary_error(e_MON_ERR_OBJECT_MISSING, command->request_id);
+        return;
+    }
+
+    {
+        binary_subscription_t *sub = *link;
+
+        *link = sub->next;
+        monitor_binary_subscription_free(sub);
+    }
+
+    monitor_binary_subscription_schedule();
+
+    monitor_binary_response(0, e_MON_RESPONSE_SUBSCRIPTION_DELETE, e_MON_ERR_OK, command->request_id, NULL);
+}
+
 
 static void monitor_binary_process_command(unsigned char * pbuffer)
 {
@@ -1775,6 +2536,10 @@ static void monitor_binary_process_command(unsigned char * pbuffer)
         monitor_binary_process_mem_get(&command);
     } else if (command_type == e_MON_CMD_MEM_SET) {
         monitor_binary_process_mem_set(&command);
+    } else if (command_type == e_MON_CMD_SUBSCRIPTION_SET) {
+        monitor_binary_process_subscription_set(&command);
+    } else if (command_type == e_MON_CMD_SUBSCRIPTION_DELETE) {
+        monitor_binary_process_subscription_delete(&command);
 
     } else if (command_type == e_MON_CMD_CHECKPOINT_GET) {
         monitor_binary_process_checkpoint_get(&command);
@@ -1881,76 +2646,354 @@ static int monitor_binary_activate(void)
         vice_network_address_close(server_addr);
     }
 
+#ifdef USE_VICE_THREAD
+    if (!error) {
+        io_thread_stop = 0;
+        if (pthread_create(&io_thread, NULL, monitor_binary_io_thread, NULL) == 0) {
+            io_thread_running = 1;
+        } else {
+            log_error(LOG_DEFAULT,
+                "monitor_binary_activate(): could not create I/O thread, polling instead");
+        }
+    }
+#endif
+
     return error;
 }
 
-int monitor_binary_get_command_line(void)
+/*! \internal \brief Receive one command from the connected socket
+
+ \param buffer
+   pointer to the receive buffer, grown as needed
+
+ \param buffer_size
+   pointer to the size of the receive buffer
+
+ \return
+   1 if a complete command is in the buffer, 0 if the connection was
+   closed, -1 if the received data was skipped.
+*/
+static int monitor_binary_receive_command(unsigned char **buffer, size_t *buffer_size)
 {
-    static size_t buffer_size = 0;
-    static unsigned char *buffer;
+    uint32_t body_length;
+    uint8_t api_version;
+    unsigned int remaining_header_size = 5;
+    unsigned int command_size;
+    ssize_t n;
 
-    while (monitor_binary_data_available()) {
-        uint32_t body_length;
-        uint8_t api_version;
-        unsigned int remaining_header_size = 5;
-        unsigned int command_size;
-        ssize_t n;
+    if (!*buffer) {
+        *buffer = lib_malloc(300);
+        *buffer_size = 300;
+    }
 
-        if (!buffer) {
-            buffer = lib_malloc(300);
-            buffer_size = 300;
-        }
+    n = monitor_binary_receive(*buffer, 1);
+    if (n <= 0) {
+        return 0;
+    }
 
-        n = monitor_binary_receive(buffer, 1);
-        if (n == 0) {
-            monitor_binary_quit();
+    if ((*buffer)[0] != ASC_STX) {
+        return -1;
+    }
+
+    n = 0;
+
+    while (n < sizeof(api_version) + sizeof(body_length)) {
+        ssize_t o = monitor_binary_receive(&(*buffer)[1 + n], (sizeof(api_version) + sizeof(body_length)) - n);
+        if (o <= 0) {
             return 0;
-        } else if (n < 0) {
-            monitor_binary_quit();
+        }
+
+        n += o;
+    }
+
+    api_version = (*buffer)[1];
+    body_length = little_endian_to_uint32(&(*buffer)[2]);
+
+    if (api_version >= 0x01 && api_version <= 0x02) {
+        remaining_header_size = 5;
+    } else {
+        return -1;
+    }
+
+    command_size = sizeof(api_version) + sizeof(body_length) + remaining_header_size + body_length + 1;
+    if (*buffer_size < command_size + 1) {
+        *buffer = lib_realloc(*buffer, command_size + 1);
+        *buffer_size = command_size + 1;
+    }
+
+    n = 0;
+
+    while (n < remaining_header_size + body_length) {
+        ssize_t o = monitor_binary_receive(&(*buffer)[6 + n], remaining_header_size + body_length - n);
+        if (o <= 0) {
             return 0;
         }
 
-        if (buffer[0] != ASC_STX) {
-            continue;
+        n += o;
+    }
+
+    return 1;
+}
+
+#ifdef USE_VICE_THREAD
+/*! \internal \brief Take the next queued command, NULL if there is none */
+static unsigned char *monitor_binary_dequeue(void)
+{
+    binary_request_t *request;
+    unsigned char *buffer = NULL;
+
+    pthread_mutex_lock(&queue_lock);
+    request = queue_head;
+    if (request != NULL) {
+        queue_head = request->next;
+        if (queue_head == NULL) {
+            queue_tail = NULL;
         }
+    }
+    pthread_mutex_unlock(&queue_lock);
 
-        n = 0;
+    if (request != NULL) {
+        buffer = request->buffer;
+        lib_free(request);
+    }
 
-        while (n < sizeof(api_version) + sizeof(body_length)) {
-            ssize_t o = monitor_binary_receive(&buffer[1 + n], (sizeof(api_version) + sizeof(body_length)) - n);
-            if (o <= 0) {
-                monitor_binary_quit();
-                return 0;
+    return buffer;
+}
+
+/* a command being received by the I/O thread */
+typedef struct binary_receive_s {
+    unsigned char *buffer;
+    size_t size;
+    size_t length;      /* bytes received so far */
+} binary_receive_t;
+
+/*! \internal \brief Receive more of the current command without blocking
+
+ Only called when the socket is readable, so the single receive returns
+ at once with what has arrived. A command that arrives in pieces is
+ gathered over several calls, so the I/O thread keeps checking for stop
+ and keeps sending output while it waits for the rest.
+
+ \return
+   1 if a complete command is in the buffer, 0 if the connection was
+   closed, -1 if more data is needed or the received data was skipped.
+*/
+static int monitor_binary_receive_partial(binary_receive_t *rx)
+{
+    size_t needed;
+    ssize_t n;
+
+    if (rx->buffer == NULL) {
+        rx->buffer = lib_malloc(300);
+        rx->size = 300;
+        rx->length = 0;
+    }
+
+    /* STX, then the API version and the body length, then the rest */
+    if (rx->length < 6) {
+        needed = (rx->length == 0) ? 1 : 6;
+    } else {
+        needed = 11 + little_endian_to_uint32(&rx->buffer[2]);
+    }
+
+    n = vice_network_receive(connected_socket, rx->buffer + rx->length, needed - rx->length, 0);
+    if (n <= 0) {
+        log_message(LOG_DEFAULT,
+                    "monitor_binary_receive_partial(): vice_network_receive() returned %"PRI_SSIZE_T", breaking connection",
+                    n);
+        rx->length = 0;
+        return 0;
+    }
+    rx->length += (size_t)n;
+
+    if (rx->length < needed) {
+        return -1;
+    }
+
+    if (rx->length == 1) {
+        if (rx->buffer[0] != ASC_STX) {
+            rx->length = 0;
+        }
+        return -1;
+    }
+
+    if (rx->length == 6) {
+        uint8_t api_version = rx->buffer[1];
+        uint32_t body_length = little_endian_to_uint32(&rx->buffer[2]);
+
+        if (api_version < 0x01 || api_version > 0x02) {
+            rx->length = 0;
+            return -1;
+        }
+        if (rx->size < 11 + (size_t)body_length + 1) {
+            rx->size = 11 + (size_t)body_length + 1;
+            rx->buffer = lib_realloc(rx->buffer, rx->size);
+        }
+        return -1;
+    }
+
+    return 1;
+}
+
+static void monitor_binary_queue_clear(void)
+{
+    unsigned char *buffer;
+
+    while ((buffer = monitor_binary_dequeue()) != NULL) {
+        lib_free(buffer);
+    }
+}
+
+/*! \internal \brief The I/O thread: accept, receive and queue commands, send the output
+
+ This thread is the only one changing connected_socket, so it reads it
+ without taking the socket lock.
+*/
+static void *monitor_binary_io_thread(void *unused)
+{
+    binary_receive_t rx = { NULL, 0, 0 };
+    vice_network_socket_t *sockfd[2];
+
+    while (!io_thread_stop) {
+        int pending;
+        int ready;
+
+        if (connected_socket == NULL) {
+            /* drop what was received of a command on the last connection */
+            rx.length = 0;
+
+            /* wait for a connection, with a timeout to check for stop */
+            if (listen_socket == NULL) {
+                tick_sleep(tick_per_second() / 10);
+                continue;
+            }
+            sockfd[0] = listen_socket;
+            sockfd[1] = NULL;
+            if (vice_network_select_multiple(sockfd) > 0) {
+                monitor_binary_accept();
             }
+            continue;
+        }
 
-            n += o;
+        pthread_mutex_lock(&socket_lock);
+        pending = (output_length > 0);
+        pthread_mutex_unlock(&socket_lock);
+
+        ready = vice_network_select_read_write(connected_socket, pending, BINARY_IO_WAIT_MS);
+        if (ready <= 0) {
+            continue;
         }
 
-        api_version = buffer[1];
-        body_length = little_endian_to_uint32(&buffer[2]);
+        if (ready & VICE_NETWORK_WRITABLE) {
+            pthread_mutex_lock(&socket_lock);
+            monitor_binary_flush_output();
+            pthread_mutex_unlock(&socket_lock);
+        }
 
-        if (api_version >= 0x01 && api_version <= 0x02) {
-            remaining_header_size = 5;
-        } else {
+        if (!(ready & VICE_NETWORK_READABLE)) {
             continue;
         }
 
-        command_size = sizeof(api_version) + sizeof(body_length) + remaining_header_size + body_length + 1;
-        if (!buffer || buffer_size < command_size + 1) {
-            buffer = lib_realloc(buffer, command_size + 1);
-            buffer_size = command_size + 1;
+        switch (monitor_binary_receive_partial(&rx)) {
+            case 1:
+                {
+                    binary_request_t *request = lib_malloc(sizeof(binary_request_t));
+
+                    /* hand the buffer over to the queue */
+                    request->buffer = rx.buffer;
+                    request->next = NULL;
+                    rx.buffer = NULL;
+                    rx.size = 0;
+                    rx.length = 0;
+
+                    pthread_mutex_lock(&queue_lock);
+                    if (queue_tail != NULL) {
+                        queue_tail->next = request;
+                    } else {
+                        queue_head = request;
+                    }
+                    queue_tail = request;
+                    pthread_cond_signal(&queue_cond);
+                    pthread_mutex_unlock(&queue_lock);
+                }
+                break;
+            case 0:
+                if (connected_socket != NULL) {
+                    monitor_binary_quit();
+                }
+                break;
+            default:
+                break;
         }
+    }
+
+    lib_free(rx.buffer);
+
+    return NULL;
+}
+
+/*! \brief Wait for a queued command while the monitor is open
+
+ \param timeout
+   maximum time to wait, in ticks
+*/
+void monitor_binary_wait_command(tick_t timeout)
+{
+    struct timespec deadline;
+    unsigned long ns;
+
+    if (!io_thread_running) {
+        return;
+    }
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    ns = (unsigned long)deadline.tv_nsec
+         + (unsigned long)((uint64_t)timeout * 1000000000 / tick_per_second());
+    deadline.tv_sec += ns / 1000000000;
+    deadline.tv_nsec = ns % 1000000000;
+
+    pthread_mutex_lock(&queue_lock);
+    if (queue_head == NULL) {
+        pthread_cond_timedwait(&queue_cond, &queue_lock, &deadline);
+    }
+    pthread_mutex_unlock(&queue_lock);
+}
+#else
+void monitor_binary_wait_command(tick_t timeout)
+{
+}
+#endif
+
+int monitor_binary_get_command_line(void)
+{
+    static size_t buffer_size = 0;
+    static unsigned char *buffer;
+
+#ifdef USE_VICE_THREAD
+    if (io_thread_running) {
+        unsigned char *command;
 
-        n = 0;
+        while ((command = monitor_binary_dequeue()) != NULL) {
+            monitor_binary_process_command(command);
+            lib_free(command);
 
-        while (n < remaining_header_size + body_length) {
-            ssize_t o = monitor_binary_receive(&buffer[6 + n], remaining_header_size + body_length - n);
-            if (o <= 0) {
-                monitor_binary_quit();
+            if (exit_mon) {
                 return 0;
             }
+        }
+
+        return 1;
+    }
+#endif
+
+    while (monitor_binary_data_available()) {
+        int result = monitor_binary_receive_command(&buffer, &buffer_size);
 
-            n += o;
+        if (result == 0) {
+            monitor_binary_quit();
+            return 0;
+        } else if (result < 0) {
+            continue;
         }
 
         monitor_binary_process_command(buffer);
@@ -1965,6 +3008,16 @@ int monitor_binary_get_command_line(void)
 
 static int monitor_binary_deactivate(void)
 {
+    monitor_binary_subscription_clear();
+
+#ifdef USE_VICE_THREAD
+    if (io_thread_running) {
+        io_thread_stop = 1;
+        pthread_join(io_thread, NULL);
+        io_thread_running = 0;
+        monitor_binary_queue_clear();
+    }
+#endif
     if (listen_socket) {
         vice_network_socket_close(listen_socket);
         listen_socket = NULL;
@@ -2076,6 +3129,9 @@ void monitor_binary_resources_shutdown(void)
     monitor_binary_deactivate();
     monitor_binary_quit();
 
+    lib_free(output_buffer);
+    output_buffer = NULL;
+    output_size = 0;
     lib_free(monitor_binary_server_address);
 }
 
@@ -2109,10 +3165,21 @@ int monitor_binary_cmdline_options_init(void)
 
 int monitor_is_binary(void)
 {
-    return connected_socket != NULL;
+    return monitor_binary_connection() != 0;
 }
 
+/*! \brief Get the socket to wait on for incoming commands
+
+ \return
+   the connected socket, or NULL if there is none or if the I/O thread
+   receives the commands, see monitor_binary_wait_command()
+*/
 vice_network_socket_t *monitor_binary_get_connected_socket(void) {
+#ifdef USE_VICE_THREAD
+    if (io_thread_running) {
+        return NULL;
+    }
+#endif
     return connected_socket;
 }
 
@@ -2146,6 +3213,10 @@ int monitor_binary_get_command_line(void)
     return 0;
 }
 
+void monitor_binary_wait_command(tick_t timeout)
+{
+}
+
 int monitor_is_binary(void)
 {
     return 0;
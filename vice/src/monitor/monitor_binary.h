@@ -29,6 +29,7 @@
 #ifndef VICE_MONITOR_BINARY_H
 #define VICE_MONITOR_BINARY_H
 
+#include "archdep.h"
 #include "types.h"
 #include "uiapi.h"
 #include "mon_breakpoint.h"
@@ -47,6 +48,7 @@ void monitor_check_binary(void);
 ssize_t monitor_binary_receive(unsigned char *buffer, size_t buffer_length);
 int monitor_binary_transmit(const unsigned char *buffer, size_t buffer_length);
 int monitor_binary_get_command_line(void);
+void monitor_binary_wait_command(tick_t timeout);
 
 int monitor_is_binary(void);
 vice_network_socket_t *monitor_binary_get_connected_socket(void);
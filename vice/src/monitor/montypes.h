@@ -156,6 +156,12 @@ enum t_action {
 };
 typedef enum t_action ACTION;
 
+enum t_profile_format {
+    e_PROFILE_FOLDED = 0,
+    e_PROFILE_CALLGRIND = 1
+};
+typedef enum t_profile_format PROFILE_FORMAT;
+
 enum t_io_sim_result {
     e_IO_SIM_RESULT_OK = 0,
     e_IO_SIM_RESULT_GENERAL_FAILURE = -1,
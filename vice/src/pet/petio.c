@@ -65,22 +65,22 @@ static unsigned int order = 0;
 
 /* ---------------------------------------------------------------------------------------------------------- */
 
-static io_source_list_t petio_8800_head = { NULL, NULL, NULL };
-static io_source_list_t petio_8900_head = { NULL, NULL, NULL };
-static io_source_list_t petio_8a00_head = { NULL, NULL, NULL };
-static io_source_list_t petio_8b00_head = { NULL, NULL, NULL };
-static io_source_list_t petio_8c00_head = { NULL, NULL, NULL };
-static io_source_list_t petio_8d00_head = { NULL, NULL, NULL };
-static io_source_list_t petio_8e00_head = { NULL, NULL, NULL };
-static io_source_list_t petio_8f00_head = { NULL, NULL, NULL };
-
-static io_source_list_t petio_e900_head = { NULL, NULL, NULL };
-static io_source_list_t petio_ea00_head = { NULL, NULL, NULL };
-static io_source_list_t petio_eb00_head = { NULL, NULL, NULL };
-static io_source_list_t petio_ec00_head = { NULL, NULL, NULL };
-static io_source_list_t petio_ed00_head = { NULL, NULL, NULL };
-static io_source_list_t petio_ee00_head = { NULL, NULL, NULL };
-static io_source_list_t petio_ef00_head = { NULL, NULL, NULL };
+static io_source_list_t petio_8800_head = { NULL, NULL, NULL, NULL };
+static io_source_list_t petio_8900_head = { NULL, NULL, NULL, NULL };
+static io_source_list_t petio_8a00_head = { NULL, NULL, NULL, NULL };
+static io_source_list_t petio_8b00_head = { NULL, NULL, NULL, NULL };
+static io_source_list_t petio_8c00_head = { NULL, NULL, NULL, NULL };
+static io_source_list_t petio_8d00_head = { NULL, NULL, NULL, NULL };
+static io_source_list_t petio_8e00_head = { NULL, NULL, NULL, NULL };
+static io_source_list_t petio_8f00_head = { NULL, NULL, NULL, NULL };
+
+static io_source_list_t petio_e900_head = { NULL, NULL, NULL, NULL };
+static io_source_list_t petio_ea00_head = { NULL, NULL, NULL, NULL };
+static io_source_list_t petio_eb00_head = { NULL, NULL, NULL, NULL };
+static io_source_list_t petio_ec00_head = { NULL, NULL, NULL, NULL };
+static io_source_list_t petio_ed00_head = { NULL, NULL, NULL, NULL };
+static io_source_list_t petio_ee00_head = { NULL, NULL, NULL, NULL };
+static io_source_list_t petio_ef00_head = { NULL, NULL, NULL, NULL };
 
 static void io_source_detach(io_source_detach_t *source)
 {
@@ -479,6 +479,7 @@ io_source_list_t *io_source_register(io_source_t *device)
     retval->previous = current;
     retval->device = device;
     retval->next = NULL;
+    retval->page = NULL;
     retval->device->order = order++;
 
     return retval;
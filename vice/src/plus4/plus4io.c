@@ -67,8 +67,8 @@ static unsigned int order = 0;
 
 /* ---------------------------------------------------------------------------------------------------------- */
 
-static io_source_list_t plus4io_fd00_head = { NULL, NULL, NULL };
-static io_source_list_t plus4io_fe00_head = { NULL, NULL, NULL };
+static io_source_list_t plus4io_fd00_head = { NULL, NULL, NULL, NULL };
+static io_source_list_t plus4io_fe00_head = { NULL, NULL, NULL, NULL };
 
 static void io_source_detach(io_source_detach_t *source)
 {
@@ -442,6 +442,7 @@ io_source_list_t *io_source_register(io_source_t *device)
     retval->previous = current;
     retval->device = device;
     retval->next = NULL;
+    retval->page = NULL;
     retval->device->order = order++;
 
     return retval;
@@ -31,93 +31,136 @@
 #include <stddef.h>
 #include <string.h>
 
+#include "alarm.h"
+#include "interrupt.h"
 #include "lib.h"
+#include "maincpu.h"
 #include "mem.h"
+#include "monitor.h"
 #include "profiler.h"
 #include "profiler_data.h"
 
 
-#define MAX_CALLSTACK_SIZE 129
-
-/* Store the PC address for JSR calls and the SP where PC is stored
- * this allows us to differentiate between fake RTS/RTI-calls used as indirect
- * JMPs
+/* Every CPU that can be profiled (the computer CPU and the drive CPUs) has
+ * its own call stack and context tree, indexed by the memspace of the CPU.
+ *
+ * The call stack stores the PC address for JSR calls and the SP where PC is
+ * stored; this allows us to differentiate between fake RTS/RTI-calls used as
+ * indirect JMPs.
  *
  * for interrupts, we use "magic" PC_SRC values corresponding to the 6502
  * interrupt vectors */
 
-uint16_t callstack_pc_dst[MAX_CALLSTACK_SIZE];
-uint16_t callstack_pc_src[MAX_CALLSTACK_SIZE];
-uint8_t  callstack_sp[MAX_CALLSTACK_SIZE];
-uint16_t callstack_memory_bank_config[MAX_CALLSTACK_SIZE];
-unsigned callstack_size = 0;
-bool     context_dirty = true;
-bool     maincpu_profiling = false;
-
-/* (fragile) flags if the current command is a JSR/INT or RTS/RTI */
-bool     entered_context = false;
-bool     exited_context = false;
-
-profiling_context_t  *root_context = NULL;
-profiling_context_t  *current_context = NULL;
-uint16_t              current_pc;
-int                   num_context_ids = 0;
-int                   context_id_capacity = 0;
-profiling_context_t **id_to_context = NULL;
-
-profiling_context_t  *profile_context_by_id(int id) {
-    if (id > 0 && id <= num_context_ids) {
-        return id_to_context[id-1];
+typedef struct profiler_cpu_s {
+    profiling_callstack_t callstack;
+    bool                  context_dirty;
+
+    /* (fragile) flags if the current command is a JSR/INT or RTS/RTI */
+    bool                  entered_context;
+    bool                  exited_context;
+
+    profiling_context_t  *root_context;
+    profiling_context_t  *current_context;
+    uint16_t              current_pc;
+    int                   num_context_ids;
+    int                   context_id_capacity;
+    profiling_context_t **id_to_context;
+
+    /* sampling mode: every sample_interval cycles the cycles since the
+     * previous sample are attributed to the current PC in the current call
+     * stack context */
+    bool                  sampled;
+    CLOCK                 sample_interval;
+    CLOCK                 sample_cycles;
+} profiler_cpu_t;
+
+static profiler_cpu_t profiler_cpus[NUM_MEMSPACES];
+
+bool cpu_profiling[NUM_MEMSPACES];
+
+/* the computer CPU takes its samples from an alarm and a trap, so it does
+ * not call the instruction hooks at all while sampling */
+static alarm_t *sample_alarm = NULL;
+static CLOCK    sample_last_clk = 0;
+static bool     sample_trap_pending = false;
+
+static uint16_t get_bank_config(MEMSPACE mem)
+{
+    /* the drives have no banking */
+    return mem == e_comp_space ? mem_get_current_bank_config() : 0;
+}
+
+profiling_context_t *profile_get_root_context(MEMSPACE mem)
+{
+    return profiler_cpus[mem].root_context;
+}
+
+profiling_context_t *profile_get_current_context(MEMSPACE mem)
+{
+    return profiler_cpus[mem].current_context;
+}
+
+profiling_callstack_t *profile_get_callstack(MEMSPACE mem)
+{
+    return &profiler_cpus[mem].callstack;
+}
+
+profiling_context_t *profile_context_by_id(MEMSPACE mem, int id) {
+    profiler_cpu_t *cpu = &profiler_cpus[mem];
+
+    if (id > 0 && id <= cpu->num_context_ids) {
+        return cpu->id_to_context[id-1];
     }
     return NULL;
 }
 
-int get_context_id(profiling_context_t *context) {
+int get_context_id(MEMSPACE mem, profiling_context_t *context) {
+    profiler_cpu_t *cpu = &profiler_cpus[mem];
+
     if (context->id == 0) {
-        context->id = num_context_ids + 1;
-        num_context_ids++;
-
-        if (context->id > context_id_capacity) {
-            context_id_capacity *= 2;
-            if (context_id_capacity < 100) context_id_capacity = 100;
-            id_to_context = lib_realloc(id_to_context,
-                                        context_id_capacity
-                                            * sizeof(*id_to_context));
+        context->id = cpu->num_context_ids + 1;
+        cpu->num_context_ids++;
+
+        if (context->id > cpu->context_id_capacity) {
+            cpu->context_id_capacity *= 2;
+            if (cpu->context_id_capacity < 100) cpu->context_id_capacity = 100;
+            cpu->id_to_context = lib_realloc(cpu->id_to_context,
+                                             cpu->context_id_capacity
+                                                 * sizeof(*cpu->id_to_context));
         }
-        id_to_context[context->id - 1] = context;
+        cpu->id_to_context[context->id - 1] = context;
     }
     return context->id;
 }
 
-#if 0 /* unused */
-static void callstack_reset(void) {
-    callstack_size = 0;
-    context_dirty = true;
-}
-#endif
-
 /* push pc to callstack (triggered by interrupt or JSR) */
-static void callstack_push(uint16_t pc_dst, uint16_t pc_src, uint8_t sp) {
-    if (callstack_size >= MAX_CALLSTACK_SIZE) {
+static void callstack_push(MEMSPACE mem, uint16_t pc_dst, uint16_t pc_src, uint8_t sp) {
+    profiler_cpu_t *cpu = &profiler_cpus[mem];
+    profiling_callstack_t *callstack = &cpu->callstack;
+
+    if (callstack->size >= PROFILING_MAX_CALLSTACK_SIZE) {
         /* stack overflow; do nothing */
         return;
     }
-    callstack_pc_dst[callstack_size] = pc_dst;
-    callstack_pc_src[callstack_size] = pc_src;
-    callstack_sp[callstack_size] = sp;
-    callstack_memory_bank_config[callstack_size] = mem_get_current_bank_config(); /* TODO: move out to interface? */
-    callstack_size++;
-    context_dirty = true;
+    callstack->pc_dst[callstack->size] = pc_dst;
+    callstack->pc_src[callstack->size] = pc_src;
+    callstack->sp[callstack->size] = sp;
+    callstack->memory_bank_config[callstack->size] = get_bank_config(mem);
+    callstack->size++;
+    cpu->context_dirty = true;
 }
 
 /* check if we should pop the callstack */
-static void callstack_pop_check(uint8_t sp) {
-    while (callstack_size != 0 && sp >= callstack_sp[callstack_size-1]
-           && callstack_sp[callstack_size-1] > 0x01) {
-        callstack_size--;
+static void callstack_pop_check(MEMSPACE mem, uint8_t sp) {
+    profiler_cpu_t *cpu = &profiler_cpus[mem];
+    profiling_callstack_t *callstack = &cpu->callstack;
+
+    while (callstack->size != 0 && sp >= callstack->sp[callstack->size-1]
+           && callstack->sp[callstack->size-1] > 0x01) {
+        callstack->size--;
     }
 
-    context_dirty = true;
+    cpu->context_dirty = true;
 }
 
 static profiling_page_t *alloc_profiling_page(void) {
@@ -215,73 +258,111 @@ static profiling_context_t *get_child_context(profiling_context_t *parent,
 }
 
 /* store profiling samples */
-static void initialize_context(void) {
+static void initialize_context(MEMSPACE mem) {
+    profiler_cpu_t *cpu = &profiler_cpus[mem];
+    profiling_callstack_t *callstack = &cpu->callstack;
     int callstack_head;
 
     /* find head of context (>0 if interrupt) */
-    for (callstack_head = callstack_size-1;
+    for (callstack_head = callstack->size-1;
          callstack_head > 0;
          callstack_head--) {
-        if (callstack_pc_src[callstack_head] >= 0xfffa) break;
+        if (callstack->pc_src[callstack_head] >= 0xfffa) break;
     }
 
-    current_context = root_context;
-    while (callstack_head < callstack_size) {
-        current_context = get_child_context(current_context,
-                                            callstack_pc_dst[callstack_head],
-                                            callstack_pc_src[callstack_head],
-                                            callstack_memory_bank_config[callstack_head]);
+    cpu->current_context = cpu->root_context;
+    while (callstack_head < (int)callstack->size) {
+        cpu->current_context = get_child_context(cpu->current_context,
+                                                 callstack->pc_dst[callstack_head],
+                                                 callstack->pc_src[callstack_head],
+                                                 callstack->memory_bank_config[callstack_head]);
         callstack_head++;
     }
 
-    current_context = get_mem_config_context(current_context, mem_get_current_bank_config());
+    cpu->current_context = get_mem_config_context(cpu->current_context, get_bank_config(mem));
 }
 
-void profile_sample_start(uint16_t pc)
+/* charge `cycles` cycles and one sample to `pc` in the current context */
+static void profile_take_sample(MEMSPACE mem, uint16_t pc, CLOCK cycles)
 {
-    if (exited_context) {
-        current_context->num_exits++;
-        exited_context = false;
+    profiler_cpu_t *cpu = &profiler_cpus[mem];
+    profiling_data_t *sample;
+
+    if (cpu->context_dirty || get_bank_config(mem) != cpu->current_context->memory_bank_config) {
+        initialize_context(mem);
+        cpu->context_dirty = false;
     }
 
-    if (context_dirty || mem_get_current_bank_config() != current_context->memory_bank_config) {
-        initialize_context();
-        context_dirty = false;
+    sample = &profiling_get_page(cpu->current_context, pc >> 8)->data[pc & 0xff];
+    sample->num_cycles += (profiling_counter_t)cycles;
+    sample->num_samples++;
+}
+
+void profile_sample_start(MEMSPACE mem, uint16_t pc)
+{
+    profiler_cpu_t *cpu = &profiler_cpus[mem];
+
+    cpu->current_pc = pc;
+
+    if (cpu->sampled) {
+        /* the sample is taken in profile_sample_finish() */
+        return;
+    }
+
+    if (cpu->exited_context) {
+        cpu->current_context->num_exits++;
+        cpu->exited_context = false;
+    }
+
+    if (cpu->context_dirty || get_bank_config(mem) != cpu->current_context->memory_bank_config) {
+        initialize_context(mem);
+        cpu->context_dirty = false;
     }
-    current_pc = pc;
 
-    if (entered_context) {
-        current_context->num_enters++;
-        entered_context = false;
+    if (cpu->entered_context) {
+        cpu->current_context->num_enters++;
+        cpu->entered_context = false;
     }
 }
 
-void profile_sample_finish(uint16_t cycle_time, uint16_t stolen_cycles)
+void profile_sample_finish(MEMSPACE mem, uint16_t cycle_time, uint16_t stolen_cycles)
 {
-    profiling_data_t * data = &profiling_get_page(current_context,
-                                                 current_pc >> 8)
-                                  ->data[current_pc & 0xff];
+    profiler_cpu_t *cpu = &profiler_cpus[mem];
+    profiling_data_t *data;
+
+    if (cpu->sampled) {
+        cpu->sample_cycles += cycle_time;
+        if (cpu->sample_cycles >= cpu->sample_interval) {
+            profile_take_sample(mem, cpu->current_pc, cpu->sample_cycles);
+            cpu->sample_cycles = 0;
+        }
+        return;
+    }
+
+    data = &profiling_get_page(cpu->current_context, cpu->current_pc >> 8)
+               ->data[cpu->current_pc & 0xff];
     data->num_cycles += cycle_time;
     data->num_samples++;
-    current_context->total_stolen_cycles_self   += stolen_cycles;
+    cpu->current_context->total_stolen_cycles_self += stolen_cycles;
 }
 
-void profile_jsr(uint16_t pc_dst, uint16_t pc_src, uint8_t sp)
+void profile_jsr(MEMSPACE mem, uint16_t pc_dst, uint16_t pc_src, uint8_t sp)
 {
-    callstack_push(pc_dst, pc_src, sp);
-    entered_context = true;
+    callstack_push(mem, pc_dst, pc_src, sp);
+    profiler_cpus[mem].entered_context = true;
 }
 
-void profile_int(uint16_t pc_dst,
+void profile_int(MEMSPACE mem,
+                 uint16_t pc_dst,
                  uint16_t handler,
                  uint8_t sp,
                  uint16_t cycle_time)
 {
-    callstack_push(pc_dst, handler, sp);
-    entered_context = true;
-    if (maincpu_profiling) {
-        profile_sample_start(handler);
-        profile_sample_finish(cycle_time, 0 /* stolen_cycles */);
+    callstack_push(mem, pc_dst, handler, sp);
+    profiler_cpus[mem].entered_context = true;
+    if (cpu_profiling[mem]) {
+        profile_sample_start(mem, handler);
+        profile_sample_finish(mem, cycle_time, 0 /* stolen_cycles */);
     }
 }
 
@@ -290,22 +371,105 @@ void profile_int(uint16_t pc_dst,
  * actually returning and clearing the return address on the stack.
  * For the purpose of call stack tracking, we simply ignore rts/rti if sp is
  * not at (or below) the stored earlier call stack value */
-void profile_rtx(uint8_t sp)
+void profile_rtx(MEMSPACE mem, uint8_t sp)
+{
+    callstack_pop_check(mem, sp);
+    profiler_cpus[mem].exited_context = true;
+}
+
+static void profile_sample_trap(uint16_t pc, void *data)
+{
+    CLOCK elapsed;
+
+    sample_trap_pending = false;
+
+    if (!profiler_cpus[e_comp_space].sampled) {
+        return;
+    }
+
+    elapsed = maincpu_clk - sample_last_clk;
+    sample_last_clk = maincpu_clk;
+
+    profile_take_sample(e_comp_space, pc, elapsed);
+}
+
+static void profile_sample_alarm_handler(CLOCK offset, void *data)
 {
-    callstack_pop_check(sp);
-    exited_context = true;
+    alarm_set(sample_alarm, maincpu_clk + profiler_cpus[e_comp_space].sample_interval - offset);
+
+    if (!sample_trap_pending) {
+        sample_trap_pending = true;
+        interrupt_maincpu_trigger_trap(profile_sample_trap, NULL);
+    }
+}
+
+static void profile_reset_data(MEMSPACE mem)
+{
+    profiler_cpu_t *cpu = &profiler_cpus[mem];
+
+    if (cpu->root_context) free_profiling_context(cpu->root_context);
+    cpu->root_context    = alloc_profiling_context();
+    cpu->num_context_ids = 0;
+    cpu->current_context = cpu->root_context;
+    cpu->entered_context = false;
+    cpu->exited_context  = false;
+    cpu->context_dirty   = true;
+
+    if (mem != e_comp_space) {
+        /* the drive CPUs only track their call stack while profiled */
+        cpu->callstack.size = 0;
+    }
 }
 
-void profile_start(void)
+void profile_start(MEMSPACE mem)
 {
-    if (root_context) free_profiling_context(root_context);
-    root_context    = alloc_profiling_context();
-    num_context_ids = 0;
-    current_context = root_context;
-    maincpu_profiling = true;
-    entered_context = false;
-    exited_context  = false;
-    context_dirty   = true;
+    profile_stop(mem);
+    profile_reset_data(mem);
+    cpu_profiling[mem] = true;
+}
+
+void profile_start_sampling(MEMSPACE mem, CLOCK interval)
+{
+    profiler_cpu_t *cpu = &profiler_cpus[mem];
+
+    profile_stop(mem);
+    profile_reset_data(mem);
+
+    if (interval > 0) {
+        cpu->sample_interval = interval;
+    } else if (cpu->sample_interval == 0) {
+        cpu->sample_interval = PROFILE_SAMPLE_INTERVAL_DEFAULT;
+    }
+    cpu->sample_cycles = 0;
+    cpu->sampled = true;
+
+    if (mem == e_comp_space) {
+        if (sample_alarm == NULL) {
+            sample_alarm = alarm_new(maincpu_alarm_context, "ProfilerSample",
+                                     profile_sample_alarm_handler, NULL);
+        }
+        sample_last_clk = maincpu_clk;
+        alarm_set(sample_alarm, maincpu_clk + cpu->sample_interval);
+    } else {
+        /* the drive CPUs count the cycles in the instruction hooks */
+        cpu_profiling[mem] = true;
+    }
+}
+
+CLOCK profile_get_sample_interval(MEMSPACE mem)
+{
+    return profiler_cpus[mem].sample_interval ? profiler_cpus[mem].sample_interval
+                                              : PROFILE_SAMPLE_INTERVAL_DEFAULT;
+}
+
+bool profile_is_running(MEMSPACE mem)
+{
+    return cpu_profiling[mem] || profiler_cpus[mem].sampled;
+}
+
+bool profile_is_sampled(MEMSPACE mem)
+{
+    return profiler_cpus[mem].sampled;
 }
 
 void compute_aggregate_stats(profiling_context_t *context) {
@@ -356,23 +520,42 @@ void compute_aggregate_stats(profiling_context_t *context) {
 }
 
 
-void profile_stop(void)
+void profile_stop(MEMSPACE mem)
 {
-    maincpu_profiling = false;
+    profiler_cpu_t *cpu = &profiler_cpus[mem];
+
+    cpu_profiling[mem] = false;
+    if (cpu->sampled) {
+        if (mem == e_comp_space) {
+            alarm_unset(sample_alarm);
+        }
+        cpu->sampled = false;
+    }
 }
 
-static void profile_reset(void) {
-    free_profiling_context(root_context);
-    root_context = NULL;
-    current_context = NULL;
-    lib_free(id_to_context);
-    id_to_context = NULL;
-    num_context_ids = 0;
-    context_id_capacity = 0;
+static void profile_reset(MEMSPACE mem) {
+    profiler_cpu_t *cpu = &profiler_cpus[mem];
+
+    free_profiling_context(cpu->root_context);
+    cpu->root_context = NULL;
+    cpu->current_context = NULL;
+    lib_free(cpu->id_to_context);
+    cpu->id_to_context = NULL;
+    cpu->num_context_ids = 0;
+    cpu->context_id_capacity = 0;
 }
 
 
 void profile_shutdown(void)
 {
-    profile_reset();
+    int mem;
+
+    /* the alarm itself went away with the main CPU alarm context */
+    sample_alarm = NULL;
+
+    for (mem = FIRST_SPACE; mem <= LAST_SPACE; mem++) {
+        cpu_profiling[mem] = false;
+        profiler_cpus[mem].sampled = false;
+        profile_reset((MEMSPACE)mem);
+    }
 }
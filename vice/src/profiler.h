@@ -27,33 +27,65 @@
 #ifndef VICE_PROFILER_H
 #define VICE_PROFILER_H
 
+#include "monitor.h"
 #include "types.h"
 
-extern bool maincpu_profiling;
+/* Profiling works per CPU, selected by the memspace of the CPU: the computer
+ * CPU and the drive CPUs. */
+
+/* set while the CPU of a memspace has to call the instruction hooks
+ * profile_sample_start() and profile_sample_finish(), and for drive CPUs
+ * also the call stack hooks (the computer CPU always tracks its call stack) */
+extern bool cpu_profiling[NUM_MEMSPACES];
+
+/* call stack of a CPU, as tracked by the JSR/RTS/interrupt hooks below */
+#define PROFILING_MAX_CALLSTACK_SIZE 129
+
+typedef struct profiling_callstack_s {
+    uint16_t pc_dst[PROFILING_MAX_CALLSTACK_SIZE];
+    uint16_t pc_src[PROFILING_MAX_CALLSTACK_SIZE];
+    uint8_t  sp[PROFILING_MAX_CALLSTACK_SIZE];
+    uint16_t memory_bank_config[PROFILING_MAX_CALLSTACK_SIZE];
+    unsigned size;
+} profiling_callstack_t;
+
+profiling_callstack_t *profile_get_callstack(MEMSPACE mem);
+
+/* default number of cycles between two samples in sampling mode */
+#define PROFILE_SAMPLE_INTERVAL_DEFAULT 1000
 
 /* resets sample statistics and starts profiling sample collection */
-void profile_start(void);
+void profile_start(MEMSPACE mem);
+
+/* resets sample statistics and starts statistical profiling, which only
+ * looks at the CPU once every `interval` cycles (0 keeps the last interval) */
+void profile_start_sampling(MEMSPACE mem, CLOCK interval);
+CLOCK profile_get_sample_interval(MEMSPACE mem);
+
+/* stops profiling, the collected data is kept */
+void profile_stop(MEMSPACE mem);
 
-/* stops profiling and writes profiling log to disk */
-void profile_stop(void);
+bool profile_is_running(MEMSPACE mem);
+bool profile_is_sampled(MEMSPACE mem);
 
 /* called by the CPU for each instruction */
-void profile_sample_start(uint16_t pc);
-void profile_sample_finish(uint16_t cycle_time, uint16_t stolen_cycles);
+void profile_sample_start(MEMSPACE mem, uint16_t pc);
+void profile_sample_finish(MEMSPACE mem, uint16_t cycle_time, uint16_t stolen_cycles);
 
 /* called whenever a JSR is encountered */
-void profile_jsr(uint16_t pc_dst, uint16_t pc_src, uint8_t sp);
+void profile_jsr(MEMSPACE mem, uint16_t pc_dst, uint16_t pc_src, uint8_t sp);
 
 /* interrupts are handled like JSRs with PC as one of the
  * interrupt handler addresses (0xfffa-0xffff)
  * for interrupts sp = sp+1 to accommodate the pushed status register */
-void profile_int(uint16_t pc_dst,
+void profile_int(MEMSPACE mem,
+                 uint16_t pc_dst,
                  uint16_t handler,
                  uint8_t sp,
                  uint16_t cycle_time);
 
 /* called whenever an RTS/RI is called */
-void profile_rtx(uint8_t sp);
+void profile_rtx(MEMSPACE mem, uint8_t sp);
 
 void profile_shutdown(void);
 
@@ -27,6 +27,7 @@
 #ifndef VICE_PROFILER_DATA_H
 #define VICE_PROFILER_DATA_H
 
+#include "monitor.h"
 #include "types.h"
 
 enum CallstackMagic {
@@ -69,11 +70,11 @@ typedef struct profiling_context_s {
     int id;
 } profiling_context_t;
 
-extern profiling_context_t  *root_context;
-extern profiling_context_t  *current_context;
+profiling_context_t *profile_get_root_context(MEMSPACE mem);
+profiling_context_t *profile_get_current_context(MEMSPACE mem);
 
-profiling_context_t *profile_context_by_id(int id);
-int                  get_context_id(profiling_context_t *context);
+profiling_context_t *profile_context_by_id(MEMSPACE mem, int id);
+int                  get_context_id(MEMSPACE mem, profiling_context_t *context);
 void                 compute_aggregate_stats(profiling_context_t *context);
 profiling_page_t    *profiling_get_page(profiling_context_t *ctx, uint8_t page);
 profiling_context_t *alloc_profiling_context(void);
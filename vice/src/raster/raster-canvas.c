@@ -28,9 +28,11 @@
 #include "vice.h"
 
 #include <stdio.h>
+#include <string.h>
 
 #include "videoarch.h"
 
+#include "instrument.h"
 #include "lib.h"
 #include "machine.h"
 #include "raster-canvas.h"
@@ -97,14 +99,48 @@ inline static void refresh_canvas(raster_t *raster)
 
     if ((int)(raster->canvas->draw_buffer->canvas_height) >= yy
         && (int)(raster->canvas->draw_buffer->canvas_width) >= xx) {
+        INSTRUMENT_ENTER(INSTRUMENT_RENDER);
         video_canvas_refresh(raster->canvas, x, y, xx, yy,
                              MIN(w, (int)(raster->canvas->draw_buffer->canvas_width - xx)),
                              MIN(h, (int)(raster->canvas->draw_buffer->canvas_height - yy)));
+        INSTRUMENT_LEAVE();
     }
 
     update_area->is_null = 1;
 }
 
+/* Check if the frame must be passed on to the video layer.  A frame that is
+   identical to the previous one doesn't need to be rendered and uploaded
+   again, unless something else changed the way it looks: a new palette or
+   new render settings reset the color tables, and forced repaints (mode
+   changes, resizes) invalidate the copy of the last frame.  Interlaced
+   frames alternate between two draw buffers and are always refreshed.
+   The frames are compared in full, a hash could miss a change.  */
+static int frame_changed(raster_t *raster)
+{
+    video_canvas_t *canvas = raster->canvas;
+    draw_buffer_t *draw_buffer = canvas->draw_buffer;
+    size_t size = (size_t)draw_buffer->draw_buffer_width * draw_buffer->draw_buffer_height;
+
+    if (canvas->videoconfig->interlaced || !canvas->videoconfig->color_tables.updated) {
+        raster->last_frame_valid = 0;
+        return 1;
+    }
+
+    if (raster->last_frame_valid && raster->last_frame_size == size
+        && memcmp(raster->last_frame, draw_buffer->draw_buffer, size) == 0) {
+        return 0;
+    }
+
+    if (raster->last_frame_size != size) {
+        raster->last_frame = lib_realloc(raster->last_frame, size);
+        raster->last_frame_size = size;
+    }
+    memcpy(raster->last_frame, draw_buffer->draw_buffer, size);
+    raster->last_frame_valid = 1;
+    return 1;
+}
+
 void raster_canvas_handle_end_of_frame(raster_t *raster)
 {
     if (video_disabled_mode) {
@@ -120,8 +156,11 @@ void raster_canvas_handle_end_of_frame(raster_t *raster)
     }
 
     if (raster->dont_cache) {
-        video_canvas_refresh_all(raster->canvas);
+        if (frame_changed(raster)) {
+            video_canvas_refresh_all(raster->canvas);
+        }
     } else {
+        raster->last_frame_valid = 0;
         refresh_canvas(raster);
     }
 
@@ -143,4 +182,8 @@ void raster_canvas_init(raster_t *raster)
 void raster_canvas_shutdown(raster_t *raster)
 {
     lib_free(raster->update_area);
+    lib_free(raster->last_frame);
+    raster->last_frame = NULL;
+    raster->last_frame_size = 0;
+    raster->last_frame_valid = 0;
 }
@@ -73,8 +73,8 @@ static int raster_calc_frame_buffer_width(raster_t *raster)
 void raster_calculate_padding_size(unsigned int fb_width, unsigned int fb_height,
                                    unsigned int *padded_size, unsigned int *unpadded_offset)
 {
-    *padded_size = fb_width * (fb_height + 4);
-    *unpadded_offset = fb_width * 2;
+    *padded_size = fb_width * (fb_height + DRAW_BUFFER_PADDING_LINES * 2);
+    *unpadded_offset = fb_width * DRAW_BUFFER_PADDING_LINES;
 }
 
 static int raster_draw_buffer_alloc(video_canvas_t *canvas,
@@ -275,6 +275,9 @@ int raster_init(raster_t *raster,
     raster->dont_cache = 1;
     raster->dont_cache_all = 1;
     raster->num_cached_lines = 0;
+    raster->last_frame = NULL;
+    raster->last_frame_size = 0;
+    raster->last_frame_valid = 0;
 
     raster->fake_draw_buffer_line = NULL;
 
@@ -513,6 +516,7 @@ void raster_force_repaint(raster_t *raster)
 {
     raster->dont_cache = 1;
     raster->num_cached_lines = 0;
+    raster->last_frame_valid = 0;
 }
 
 void raster_enable_cache(raster_t *raster, int enable)
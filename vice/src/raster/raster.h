@@ -161,6 +161,13 @@ struct raster_s {
     /* Area to update.  */
     struct raster_canvas_area_s *update_area;
 
+    /* Copy of the draw buffer contents of the last refreshed frame, used to
+       skip the refresh when nothing changed.  Only valid if
+       `last_frame_valid' is set.  */
+    uint8_t *last_frame;
+    size_t last_frame_size;
+    int last_frame_valid;
+
     /* This is a bit mask representing each pixel on the screen (1 =
        foreground, 0 = background) and is used both for sprite-background
        collision checking and background sprite drawing.  When cache is
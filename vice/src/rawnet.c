@@ -32,10 +32,19 @@
 #include <assert.h>
 #include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include "lib.h"
+#include "log.h"
 #include "rawnet.h"
 #include "rawnetarch.h"
 
+#ifdef USE_VICE_THREAD
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#endif
+
 int rawnet_resources_init(void)
 {
     return rawnet_arch_resources_init();
@@ -112,4 +121,363 @@ char *rawnet_get_standard_driver(void)
 {
     return rawnet_arch_get_standard_driver();
 }
+
+/* ------------------------------------------------------------------------- */
+/*    packet I/O, through the packet thread if there is one                  */
+
+#ifdef USE_VICE_THREAD
+
+/* room for the longest ethernet frame, rounded up */
+#define RAWNET_FRAME_MAX    1536
+
+/* queue sizes, powers of two */
+#define RAWNET_RX_FRAMES    64
+#define RAWNET_TX_FRAMES    32
+
+/* most frames taken from the driver before looking at the TX queue again */
+#define RAWNET_RX_BATCH     16
+
+/* how long the packet thread sleeps when the driver has nothing, in ns */
+#define RAWNET_IDLE_NS      1000000
+
+typedef struct rawnet_frame_s {
+    int len;
+    /* receive status */
+    int hashed, hash_index, rx_ok, correct_mac, broadcast, crc_error;
+    /* transmit flags */
+    int force, onecoll, inhibit_crc, tx_pad_dis;
+    uint8_t data[RAWNET_FRAME_MAX];
+} rawnet_frame_t;
+
+/* Single producer, single consumer queue. Only the producer advances tail
+   and only the consumer advances head. */
+typedef struct rawnet_queue_s {
+    rawnet_frame_t *frames;
+    unsigned int mask;
+    atomic_uint head;
+    atomic_uint tail;
+} rawnet_queue_t;
+
+static rawnet_queue_t rx_queue;     /* packet thread -> emulation */
+static rawnet_queue_t tx_queue;     /* emulation -> packet thread */
+
+static pthread_t rawnet_thread;
+static int rawnet_thread_running = 0;
+static atomic_int rawnet_thread_stop;
+
+/* serializes the calls into the driver */
+static pthread_mutex_t rawnet_driver_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* wakes the idle packet thread when a frame is queued for transmission */
+static pthread_mutex_t rawnet_wake_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t rawnet_wake_cond = PTHREAD_COND_INITIALIZER;
+
+static atomic_ulong rawnet_rx_batches;
+static atomic_ulong rawnet_tx_frames;
+
+#define DRIVER_LOCK()   pthread_mutex_lock(&rawnet_driver_lock)
+#define DRIVER_UNLOCK() pthread_mutex_unlock(&rawnet_driver_lock)
+#define COUNT_TX()      atomic_fetch_add_explicit(&rawnet_tx_frames, 1, memory_order_relaxed)
+#else
+static unsigned long rawnet_tx_frames = 0;
+
+#define DRIVER_LOCK()
+#define DRIVER_UNLOCK()
+#define COUNT_TX()      rawnet_tx_frames++
+#endif
+
+static unsigned long rawnet_rx_frames = 0;
+static unsigned long rawnet_tx_dropped = 0;
+
+#ifdef USE_VICE_THREAD
+static void queue_init(rawnet_queue_t *queue, unsigned int size)
+{
+    queue->frames = lib_malloc(size * sizeof(rawnet_frame_t));
+    queue->mask = size - 1;
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+}
+
+/* Producer side: the free frame at the end of the queue, or NULL if full. */
+static rawnet_frame_t *queue_back(rawnet_queue_t *queue)
+{
+    unsigned int tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    unsigned int head = atomic_load_explicit(&queue->head, memory_order_acquire);
+
+    if (tail - head > queue->mask) {
+        return NULL;
+    }
+    return &queue->frames[tail & queue->mask];
+}
+
+static void queue_push(rawnet_queue_t *queue)
+{
+    unsigned int tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+}
+
+/* Consumer side: the oldest frame, or NULL if empty. */
+static rawnet_frame_t *queue_front(rawnet_queue_t *queue)
+{
+    unsigned int head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    unsigned int tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+
+    if (head == tail) {
+        return NULL;
+    }
+    return &queue->frames[head & queue->mask];
+}
+
+static void queue_pop(rawnet_queue_t *queue)
+{
+    unsigned int head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+}
+
+/* Consumer side: throw away everything queued so far. */
+static void queue_drain(rawnet_queue_t *queue)
+{
+    atomic_store_explicit(&queue->head,
+                          atomic_load_explicit(&queue->tail, memory_order_acquire),
+                          memory_order_release);
+}
+
+static void *rawnet_thread_main(void *unused)
+{
+    while (!atomic_load(&rawnet_thread_stop)) {
+        rawnet_frame_t *frame;
+        int moved = 0;
+        int n;
+
+        while ((frame = queue_front(&tx_queue)) != NULL) {
+            DRIVER_LOCK();
+            rawnet_arch_transmit(frame->force, frame->onecoll, frame->inhibit_crc,
+                                 frame->tx_pad_dis, frame->len, frame->data);
+            DRIVER_UNLOCK();
+            queue_pop(&tx_queue);
+            COUNT_TX();
+            moved = 1;
+        }
+
+        for (n = 0; n < RAWNET_RX_BATCH; n++) {
+            int received;
+
+            frame = queue_back(&rx_queue);
+            if (frame == NULL) {
+                /* the emulation is behind, leave the frames to the driver */
+                break;
+            }
+            frame->len = RAWNET_FRAME_MAX;
+            DRIVER_LOCK();
+            received = rawnet_arch_receive(frame->data, &frame->len, &frame->hashed,
+                                           &frame->hash_index, &frame->rx_ok,
+                                           &frame->correct_mac, &frame->broadcast,
+                                           &frame->crc_error);
+            DRIVER_UNLOCK();
+            if (!received) {
+                break;
+            }
+            queue_push(&rx_queue);
+        }
+        if (n > 0) {
+            atomic_fetch_add_explicit(&rawnet_rx_batches, 1, memory_order_relaxed);
+            moved = 1;
+        }
+
+        if (!moved) {
+            struct timespec until;
+
+            clock_gettime(CLOCK_REALTIME, &until);
+            until.tv_nsec += RAWNET_IDLE_NS;
+            if (until.tv_nsec >= 1000000000) {
+                until.tv_nsec -= 1000000000;
+                until.tv_sec++;
+            }
+            pthread_mutex_lock(&rawnet_wake_lock);
+            if (queue_front(&tx_queue) == NULL && !atomic_load(&rawnet_thread_stop)) {
+                pthread_cond_timedwait(&rawnet_wake_cond, &rawnet_wake_lock, &until);
+            }
+            pthread_mutex_unlock(&rawnet_wake_lock);
+        }
+    }
+
+    return NULL;
+}
+
+static void rawnet_wake(void)
+{
+    pthread_mutex_lock(&rawnet_wake_lock);
+    pthread_cond_signal(&rawnet_wake_cond);
+    pthread_mutex_unlock(&rawnet_wake_lock);
+}
+#endif
+
+int rawnet_activate(const char *interface_name)
+{
+    if (!rawnet_arch_activate(interface_name)) {
+        return 0;
+    }
+
+#ifdef USE_VICE_THREAD
+    queue_init(&rx_queue, RAWNET_RX_FRAMES);
+    queue_init(&tx_queue, RAWNET_TX_FRAMES);
+    atomic_store(&rawnet_thread_stop, 0);
+    if (pthread_create(&rawnet_thread, NULL, rawnet_thread_main, NULL) == 0) {
+        rawnet_thread_running = 1;
+    } else {
+        log_warning(LOG_DEFAULT, "rawnet: could not create packet thread, polling the driver directly.");
+        lib_free(rx_queue.frames);
+        lib_free(tx_queue.frames);
+    }
+#endif
+    return 1;
+}
+
+void rawnet_deactivate(void)
+{
+#ifdef USE_VICE_THREAD
+    if (rawnet_thread_running) {
+        atomic_store(&rawnet_thread_stop, 1);
+        rawnet_wake();
+        pthread_join(rawnet_thread, NULL);
+        rawnet_thread_running = 0;
+        lib_free(rx_queue.frames);
+        lib_free(tx_queue.frames);
+    }
+#endif
+    rawnet_arch_deactivate();
+}
+
+void rawnet_pre_reset(void)
+{
+#ifdef USE_VICE_THREAD
+    if (rawnet_thread_running) {
+        queue_drain(&rx_queue);
+    }
+#endif
+    DRIVER_LOCK();
+    rawnet_arch_pre_reset();
+    DRIVER_UNLOCK();
+}
+
+void rawnet_post_reset(void)
+{
+    DRIVER_LOCK();
+    rawnet_arch_post_reset();
+    DRIVER_UNLOCK();
+}
+
+void rawnet_set_mac(const uint8_t mac[6])
+{
+    DRIVER_LOCK();
+    rawnet_arch_set_mac(mac);
+    DRIVER_UNLOCK();
+}
+
+void rawnet_set_hashfilter(const uint32_t hash_mask[2])
+{
+    DRIVER_LOCK();
+    rawnet_arch_set_hashfilter(hash_mask);
+    DRIVER_UNLOCK();
+}
+
+void rawnet_recv_ctl(int bBroadcast, int bIA, int bMulticast, int bCorrect, int bPromiscuous, int bIAHash)
+{
+    DRIVER_LOCK();
+    rawnet_arch_recv_ctl(bBroadcast, bIA, bMulticast, bCorrect, bPromiscuous, bIAHash);
+    DRIVER_UNLOCK();
+}
+
+void rawnet_line_ctl(int bEnableTransmitter, int bEnableReceiver)
+{
+#ifdef USE_VICE_THREAD
+    /* frames which came in while the receiver was off are gone */
+    if (rawnet_thread_running && !bEnableReceiver) {
+        queue_drain(&rx_queue);
+    }
+#endif
+    DRIVER_LOCK();
+    rawnet_arch_line_ctl(bEnableTransmitter, bEnableReceiver);
+    DRIVER_UNLOCK();
+}
+
+void rawnet_transmit(int force, int onecoll, int inhibit_crc, int tx_pad_dis, int txlength, uint8_t *txframe)
+{
+#ifdef USE_VICE_THREAD
+    if (rawnet_thread_running) {
+        rawnet_frame_t *frame = queue_back(&tx_queue);
+
+        if (frame == NULL) {
+            rawnet_tx_dropped++;
+            return;
+        }
+        if (txlength > RAWNET_FRAME_MAX) {
+            txlength = RAWNET_FRAME_MAX;
+        }
+        frame->force = force;
+        frame->onecoll = onecoll;
+        frame->inhibit_crc = inhibit_crc;
+        frame->tx_pad_dis = tx_pad_dis;
+        frame->len = txlength;
+        memcpy(frame->data, txframe, txlength);
+        queue_push(&tx_queue);
+        rawnet_wake();
+        return;
+    }
+#endif
+    rawnet_arch_transmit(force, onecoll, inhibit_crc, tx_pad_dis, txlength, txframe);
+    COUNT_TX();
+}
+
+int rawnet_receive(uint8_t *pbuffer, int *plen, int *phashed, int *phash_index, int *prx_ok, int *pcorrect_mac, int *pbroadcast, int *pcrc_error)
+{
+#ifdef USE_VICE_THREAD
+    if (rawnet_thread_running) {
+        rawnet_frame_t *frame = queue_front(&rx_queue);
+        int len;
+
+        if (frame == NULL) {
+            return 0;
+        }
+        len = frame->len;
+        if (len > RAWNET_FRAME_MAX) {
+            len = RAWNET_FRAME_MAX;
+        }
+        if (len > *plen) {
+            len = *plen;
+        }
+        memcpy(pbuffer, frame->data, len);
+        *plen = frame->len;
+        *phashed = frame->hashed;
+        *phash_index = frame->hash_index;
+        *prx_ok = frame->rx_ok;
+        *pcorrect_mac = frame->correct_mac;
+        *pbroadcast = frame->broadcast;
+        *pcrc_error = frame->crc_error;
+        queue_pop(&rx_queue);
+        rawnet_rx_frames++;
+        return 1;
+    }
+#endif
+    if (rawnet_arch_receive(pbuffer, plen, phashed, phash_index, prx_ok, pcorrect_mac, pbroadcast, pcrc_error)) {
+        rawnet_rx_frames++;
+        return 1;
+    }
+    return 0;
+}
+
+void rawnet_get_stats(rawnet_stats_t *stats)
+{
+    stats->rx_frames = rawnet_rx_frames;
+    stats->tx_dropped = rawnet_tx_dropped;
+#ifdef USE_VICE_THREAD
+    stats->rx_batches = atomic_load_explicit(&rawnet_rx_batches, memory_order_relaxed);
+    stats->tx_frames = atomic_load_explicit(&rawnet_tx_frames, memory_order_relaxed);
+#else
+    stats->rx_batches = stats->rx_frames;
+    stats->tx_frames = rawnet_tx_frames;
+#endif
+}
 #endif /* #ifdef HAVE_RAWNET */
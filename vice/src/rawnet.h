@@ -32,6 +32,8 @@
 #ifndef VICE_RAWNET_H
 #define VICE_RAWNET_H
 
+#include "types.h"
+
 int rawnet_resources_init(void);
 int rawnet_cmdline_options_init(void);
 void rawnet_resources_shutdown(void);
@@ -81,4 +83,33 @@ int rawnet_enumdriver(char **ppname, char **ppdescription);
 int rawnet_enumdriver_close(void);
 char *rawnet_get_standard_driver(void);
 
+/*
+ Packet I/O of the emulated ethernet chip, with the same meaning as the
+ rawnet_arch_ functions of the same name.
+
+ If VICE is built with threads, rawnet_activate() starts a packet thread
+ which moves the frames between the driver and two lock free queues, so the
+ emulation polling for new frames doesn't make a system call each time.
+ Received frames are taken from the driver in batches.
+*/
+int rawnet_activate(const char *interface_name);
+void rawnet_deactivate(void);
+void rawnet_pre_reset(void);
+void rawnet_post_reset(void);
+void rawnet_set_mac(const uint8_t mac[6]);
+void rawnet_set_hashfilter(const uint32_t hash_mask[2]);
+void rawnet_recv_ctl(int bBroadcast, int bIA, int bMulticast, int bCorrect, int bPromiscuous, int bIAHash);
+void rawnet_line_ctl(int bEnableTransmitter, int bEnableReceiver);
+void rawnet_transmit(int force, int onecoll, int inhibit_crc, int tx_pad_dis, int txlength, uint8_t *txframe);
+int rawnet_receive(uint8_t *pbuffer, int *plen, int *phashed, int *phash_index, int *prx_ok, int *pcorrect_mac, int *pbroadcast, int *pcrc_error);
+
+typedef struct rawnet_stats_s {
+    unsigned long rx_frames;    /* frames handed to the emulation */
+    unsigned long rx_batches;   /* times the packet thread found new frames */
+    unsigned long tx_frames;    /* frames handed to the driver */
+    unsigned long tx_dropped;   /* frames lost because the queue was full */
+} rawnet_stats_t;
+
+void rawnet_get_stats(rawnet_stats_t *stats);
+
 #endif
@@ -456,6 +456,12 @@ uint8_t mem_dma_read(uint16_t addr)
     return retval;
 }
 
+/* the RAM stores check BA and the mirrored RAM */
+uint8_t *mem_dma_write_base(uint16_t addr)
+{
+    return NULL;
+}
+
 
 /* ------------------------------------------------------------------------- */
 
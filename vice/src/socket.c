@@ -1080,6 +1080,132 @@ int vice_network_select_poll_one(vice_network_socket_t * readsockfd)
     return select( readsockfd->sockfd + 1, &fdsockset, NULL, NULL, &timeout);
 }
 
+/*! \brief Check if a socket can accept data without blocking
+
+  This function is called in order to determine if data can be
+  sent on a socket without blocking, i.e. if the peer keeps up
+  with receiving.
+
+  \param writesockfd
+     The connected socket to test
+
+  \return
+     1 if the specified socket can take data; 0 if sending
+     would block, and -1 in case of an error.
+*/
+int vice_network_select_poll_write_one(vice_network_socket_t * writesockfd)
+{
+    TIMEVAL timeout = { 0, 0 };
+
+    fd_set fdsockset;
+
+    FD_ZERO(&fdsockset);
+    FD_SET(writesockfd->sockfd, &fdsockset);
+
+    return select( writesockfd->sockfd + 1, NULL, &fdsockset, NULL, &timeout);
+}
+
+/*! \brief Send data on a connected socket without blocking
+
+  This function sends as much of the data as the socket can take
+  right now, so a peer which does not keep up with receiving can
+  never block the caller.
+
+  \param sockfd
+     The connected socket to send to
+
+  \param buffer
+     Pointer to the buffer holding the data to send
+
+  \param buffer_length
+     The length of the data in buffer
+
+  \return
+     the number of bytes sent, which can be anything from 0 to
+     buffer_length, or -1 in case of an error.
+
+  \remark
+     Without MSG_DONTWAIT, at most VICE_NETWORK_SEND_CHUNK bytes are
+     sent at once, and only after select() reported the socket as
+     writable.
+*/
+ssize_t vice_network_send_nonblocking(vice_network_socket_t *sockfd,
+                                      const void            *buffer,
+                                      size_t                 buffer_length)
+{
+#ifdef MSG_DONTWAIT
+    ssize_t ret;
+
+# ifdef MSG_NOSIGNAL
+    /* no need to touch the SIGPIPE handler, which other threads may change */
+    ret = send(sockfd->sockfd, buffer, buffer_length, MSG_DONTWAIT | MSG_NOSIGNAL);
+# else
+    signals_pipe_set();
+    ret = send(sockfd->sockfd, buffer, buffer_length, MSG_DONTWAIT);
+    signals_pipe_unset();
+# endif
+    if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        ret = 0;
+    }
+    return ret;
+#else
+    if (vice_network_select_poll_write_one(sockfd) <= 0) {
+        return 0;
+    }
+    if (buffer_length > VICE_NETWORK_SEND_CHUNK) {
+        buffer_length = VICE_NETWORK_SEND_CHUNK;
+    }
+    return vice_network_send(sockfd, buffer, buffer_length, 0);
+#endif
+}
+
+/*! \brief Wait until a socket has data or can take data
+
+  \param sockfd
+     The connected socket to wait for
+
+  \param want_write
+     if non-zero, also return when the socket can take data
+
+  \param timeout_ms
+     maximum time to wait, in milliseconds
+
+  \return
+     VICE_NETWORK_READABLE and/or VICE_NETWORK_WRITABLE, 0 on
+     timeout, and -1 in case of an error.
+*/
+int vice_network_select_read_write(vice_network_socket_t *sockfd, int want_write, unsigned int timeout_ms)
+{
+    fd_set readset;
+    fd_set writeset;
+    TIMEVAL timeout;
+    int ret;
+
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_usec = (timeout_ms % 1000) * 1000;
+
+    FD_ZERO(&readset);
+    FD_ZERO(&writeset);
+    FD_SET(sockfd->sockfd, &readset);
+    if (want_write) {
+        FD_SET(sockfd->sockfd, &writeset);
+    }
+
+    ret = select(sockfd->sockfd + 1, &readset, want_write ? &writeset : NULL, NULL, &timeout);
+    if (ret <= 0) {
+        return ret;
+    }
+
+    ret = 0;
+    if (FD_ISSET(sockfd->sockfd, &readset)) {
+        ret |= VICE_NETWORK_READABLE;
+    }
+    if (want_write && FD_ISSET(sockfd->sockfd, &writeset)) {
+        ret |= VICE_NETWORK_WRITABLE;
+    }
+    return ret;
+}
+
 /*! \brief Monitor multiple sockets
 
   This function blocks for many different connections and returns when any
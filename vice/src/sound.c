@@ -44,6 +44,7 @@
 #include "cmdline.h"
 #include "debug.h"
 #include "fixpoint.h"
+#include "instrument.h"
 #include "lib.h"
 #include "log.h"
 #include "machine.h"
@@ -1396,12 +1397,14 @@ static int sound_run_sound(void)
     if (cycle_based) {
         delta_t = maincpu_clk - snddata.lastclk;
         bufferptr = snddata.buffer + snddata.bufptr * snddata.sound_output_channels;
+        INSTRUMENT_ENTER(INSTRUMENT_SOUND);
         nr = sound_machine_calculate_samples(snddata.psid,
                                              bufferptr,
                                              snddata.bufsize - snddata.bufptr,
                                              snddata.sound_output_channels,
                                              snddata.sound_chip_channels,
                                              &delta_t);
+        INSTRUMENT_LEAVE();
         if (delta_t && !archdep_is_exiting()) {
 #if 0
             sound_error_log_only("Sound buffer overflow (cycle based)");
@@ -1429,12 +1432,14 @@ static int sound_run_sound(void)
              nr = snddata.bufsize - snddata.bufptr;
          }
          bufferptr = snddata.buffer + snddata.bufptr * snddata.sound_output_channels;
+         INSTRUMENT_ENTER(INSTRUMENT_SOUND);
          sound_machine_calculate_samples(snddata.psid,
                                          bufferptr,
                                          nr,
                                          snddata.sound_output_channels,
                                          snddata.sound_chip_channels,
                                          &delta_t);
+         INSTRUMENT_LEAVE();
          snddata.fclk += nr * snddata.clkstep;
      }
 
@@ -1475,6 +1480,9 @@ bool sound_flush(void)
 {
     int c, i, nr, space;
 
+    /* includes the time the sound device blocks when it paces the emulation */
+    INSTRUMENT_ENTER(INSTRUMENT_SOUND);
+
     /*
      * It's possible when changing settings via UI to end up
      * flushing sound on the ui thread, which is a problem
@@ -1631,6 +1639,8 @@ bool sound_flush(void)
 
 done:
 
+    INSTRUMENT_LEAVE();
+
     /*
      * If the sound device is not a timing source, then we need
      * the host to sleep to sync time with the emulator.
@@ -0,0 +1,67 @@
+#!/bin/sh
+#
+# cpubench.sh - time the 6510 core of an emulator binary
+#
+# Usage: cpubench.sh <emulator> [cycles] [runs]
+#
+# Runs a fixed program that keeps the CPU busy with indexed loads, stores
+# and ALU operations for <cycles> cycles (default 200000000, -limitcycles)
+# in warp mode with sound off, and prints the best wall clock time out of
+# <runs> runs (default 5). This is done twice: once with true drive
+# emulation off, which times the computer CPU, and once with a 1541 that
+# never idles, which adds the drive CPU.
+#
+# To see what a change to the CPU core buys, run it on two builds, for
+# example a normal one and one with -DCPU_NO_THREADED_DISPATCH in CFLAGS.
+# The emulator must find its ROMs, so use an installed binary or one from
+# a build tree with the data directories next to it.
+
+if [ $# -lt 1 ]; then
+    echo "usage: $(basename "$0") <emulator> [cycles] [runs]" >&2
+    exit 1
+fi
+
+EMU="$1"
+CYCLES="${2:-200000000}"
+RUNS="${3:-5}"
+
+PRG="$(mktemp "${TMPDIR:-/tmp}/cpubench.XXXXXX")"
+trap 'rm -f "$PRG"' EXIT
+
+# 10 SYS2061
+#
+# 080d  a2 00     loop  ldx #$00
+# 080f  bd 00 10  next  lda $1000,x
+# 0812  69 01           adc #$01
+# 0814  9d 00 11        sta $1100,x
+# 0817  5d 00 12        eor $1200,x
+# 081a  e8              inx
+# 081b  d0 f2           bne next
+# 081d  c8              iny
+# 081e  4c 0d 08        jmp loop
+printf '\001\010\013\010\012\000\236\062\060\066\061\000\000\000' > "$PRG"
+printf '\242\000\275\000\020\151\001\235\000\021\135\000\022\350\320\362\310\114\015\010' >> "$PRG"
+
+# best time of $RUNS runs in milliseconds, the options are passed on
+bench()
+{
+    best=""
+    run=0
+    while [ $run -lt "$RUNS" ]; do
+        start=$(date +%s%N)
+        "$EMU" -default -logfile /dev/null +sound -warp \
+            -autostartprgmode 1 -autostart "$PRG" \
+            -limitcycles "$CYCLES" "$@" > /dev/null 2>&1
+        end=$(date +%s%N)
+        ms=$(( (end - start) / 1000000 ))
+        if [ -z "$best" ] || [ $ms -lt "$best" ]; then
+            best=$ms
+        fi
+        run=$((run + 1))
+    done
+    echo "$best"
+}
+
+echo "$EMU, $CYCLES cycles, best of $RUNS runs"
+echo "computer CPU:         $(bench -drive8type 0) ms"
+echo "computer + 1541 CPU:  $(bench -drive8type 1541 -drive8truedrive -drive8idle 0) ms"
@@ -0,0 +1,233 @@
+/*
+ * test_mon_trace.c - Unit test for the monitor trace recorder.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/*
+ * Records a stream of JSRs, each followed by the stack accesses that the
+ * CPU reports before it fixes the high byte of the target, and checks
+ * that every JSR reads back with the fixed byte. The stream is long enough
+ * for the block boundaries to fall at every point of the JSR sequence.
+ */
+
+#include "../monitor/mon_trace.c"
+
+#include <stdlib.h>
+
+#define TEST_FILENAME   "test_mon_trace.trace"
+#define TEST_JSRS       100000
+#define TEST_JSR_OP     0x20
+#define TEST_FIXED_P2   0xc0
+
+/* stubs for what the recorder uses besides lib and log */
+int mon_out(const char *format, ...)
+{
+    return 0;
+}
+
+int resources_register_int(const resource_int_t *r)
+{
+    return 0;
+}
+
+int resources_register_string(const resource_string_t *r)
+{
+    return 0;
+}
+
+int resources_set_int(const char *name, int value)
+{
+    return 0;
+}
+
+int resources_set_string(const char *name, const char *value)
+{
+    return 0;
+}
+
+int cmdline_register_options(const cmdline_option_t *c)
+{
+    return 0;
+}
+
+int util_string_set(char **str, const char *new_value)
+{
+    *str = lib_strdup(new_value);
+    return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void record(void)
+{
+    unsigned int i, j;
+    CLOCK clk = 0;
+
+    for (i = 0; i < TEST_JSRS; i++) {
+        /* JSR records the low byte of the target only */
+        clk += 6;
+        mon_trace_store_insn(clk, 0x1000 + (i & 0xff), TEST_JSR_OP, i & 0xff, 0,
+                             (uint8_t)i, 0, 0, 0xf0, 0x20, e_comp_space);
+        /* the stack accesses, a varying number to walk through the block end */
+        for (j = 0; j < 2 + (i % 5); j++) {
+            mon_trace_store_mem(0x01f0 - j, 1 << 1);
+        }
+        mon_trace_fix_p2(TEST_FIXED_P2);
+
+        /* something else in between */
+        clk += 2;
+        mon_trace_store_insn(clk, 0x2000 + (i & 0x3ff), 0xea, 0, 0,
+                             (uint8_t)i, (uint8_t)(i >> 3), 0, 0xf2, 0x20, e_comp_space);
+    }
+}
+
+static int get_varint(const uint8_t **p, const uint8_t *end)
+{
+    do {
+        if (*p >= end) {
+            return -1;
+        }
+    } while (*(*p)++ & 0x80);
+    return 0;
+}
+
+/* returns the number of JSRs read back with the fixed byte, -1 on error */
+static long check(unsigned int *blocks)
+{
+    FILE *fp;
+    uint8_t header[MON_TRACE_HEADER_SIZE];
+    uint8_t block_header[MON_TRACE_BLOCK_HEADER_SIZE];
+    uint8_t *stored = lib_malloc(2 * MON_TRACE_BLOCK_SIZE);
+    uint8_t *data = lib_malloc(MON_TRACE_BLOCK_SIZE);
+    long jsrs = 0;
+
+    *blocks = 0;
+
+    fp = fopen(TEST_FILENAME, "rb");
+    if (fp == NULL || fread(header, 1, sizeof(header), fp) != sizeof(header)
+            || memcmp(header, MON_TRACE_MAGIC, MON_TRACE_MAGIC_SIZE) != 0) {
+        printf("FAIL: could not read the trace header\n");
+        jsrs = -1;
+    }
+
+    while (jsrs >= 0 && fread(block_header, 1, sizeof(block_header), fp) == sizeof(block_header)) {
+        uLongf size = block_header[0] | (block_header[1] << 8)
+                      | ((uLongf)block_header[2] << 16) | ((uLongf)block_header[3] << 24);
+        uLongf stored_size = block_header[4] | (block_header[5] << 8)
+                             | ((uLongf)block_header[6] << 16) | ((uLongf)block_header[7] << 24);
+        uLongf unpacked = MON_TRACE_BLOCK_SIZE;
+        const uint8_t *p;
+        const uint8_t *end;
+
+        if (size > MON_TRACE_BLOCK_SIZE || stored_size > 2 * MON_TRACE_BLOCK_SIZE
+                || fread(stored, 1, stored_size, fp) != stored_size) {
+            printf("FAIL: block %u is truncated\n", *blocks);
+            jsrs = -1;
+            break;
+        }
+        if (stored_size == size) {
+            memcpy(data, stored, size);
+        } else if (uncompress(data, &unpacked, stored, stored_size) != Z_OK || unpacked != size) {
+            printf("FAIL: block %u does not uncompress\n", *blocks);
+            jsrs = -1;
+            break;
+        }
+
+        p = data;
+        end = data + size;
+        while (p < end) {
+            uint8_t tag = *p++;
+
+            if ((tag & MON_TRACE_REC_MASK) == MON_TRACE_REC_MEM) {
+                p += 4;
+            } else {
+                uint8_t op;
+                uint8_t p2;
+                uint8_t mask;
+
+                if (get_varint(&p, end) < 0 || get_varint(&p, end) < 0 || p + 4 > end) {
+                    break;
+                }
+                op = p[0];
+                p2 = p[2];
+                mask = p[3];
+                p += 4;
+                p += ((mask & MON_TRACE_REG_A) ? 1 : 0) + ((mask & MON_TRACE_REG_X) ? 1 : 0)
+                     + ((mask & MON_TRACE_REG_Y) ? 1 : 0) + ((mask & MON_TRACE_REG_SP) ? 1 : 0)
+                     + ((mask & MON_TRACE_REG_ST) ? 2 : 0);
+
+                if (op == TEST_JSR_OP) {
+                    if (p2 != TEST_FIXED_P2) {
+                        printf("FAIL: JSR %ld in block %u has p2 $%02x, expected $%02x\n",
+                               jsrs, *blocks, (unsigned int)p2, (unsigned int)TEST_FIXED_P2);
+                        jsrs = -1;
+                        break;
+                    }
+                    jsrs++;
+                }
+            }
+        }
+        if (p != end && jsrs >= 0) {
+            printf("FAIL: block %u has a truncated record\n", *blocks);
+            jsrs = -1;
+        }
+        (*blocks)++;
+    }
+
+    if (fp != NULL) {
+        fclose(fp);
+    }
+    lib_free(stored);
+    lib_free(data);
+
+    return jsrs;
+}
+
+int main(void)
+{
+    unsigned int blocks;
+    long jsrs;
+
+    if (mon_trace_open(TEST_FILENAME) < 0) {
+        printf("FAIL: could not open %s\n", TEST_FILENAME);
+        return EXIT_FAILURE;
+    }
+    record();
+    mon_trace_close();
+
+    jsrs = check(&blocks);
+    remove(TEST_FILENAME);
+
+    if (jsrs < 0) {
+        return EXIT_FAILURE;
+    }
+    if (jsrs != TEST_JSRS) {
+        printf("FAIL: read back %ld JSRs, recorded %d\n", jsrs, TEST_JSRS);
+        return EXIT_FAILURE;
+    }
+    if (blocks < 2) {
+        printf("FAIL: the trace has %u block(s), the test needs a block boundary\n", blocks);
+        return EXIT_FAILURE;
+    }
+
+    printf("PASS: %ld JSRs in %u blocks\n", jsrs, blocks);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,174 @@
+/*
+ * test_render1x1.c - Golden image test for the 1x1 PAL and NTSC renderers.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/*
+ * Renders a fixed frame with fixed color tables at a number of offsets
+ * and sizes and compares a hash of each target image with the hash the
+ * original renderers, which summed the four chroma pixels anew for every
+ * pixel, produced for it. Any change of the output, even of one pixel,
+ * fails the test.
+ */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lib.h"
+#include "render1x1ntsc.h"
+#include "render1x1pal.h"
+#include "types.h"
+#include "video.h"
+
+#define SRC_PITCH   416
+#define SRC_HEIGHT  300
+#define TRG_PITCH   (SRC_PITCH * 4)
+#define TRG_HEIGHT  SRC_HEIGHT
+
+typedef struct render_case_s {
+    unsigned int xs, ys;
+    unsigned int xt, yt;
+    unsigned int width, height;
+    int oddlines_offset;
+    uint32_t pal_hash;      /* golden image hashes */
+    uint32_t ntsc_hash;
+} render_case_t;
+
+static const render_case_t render_cases[] = {
+    {  32, 16,  0,  0, 384, 272, 1000, 0xec4e9aad, 0xfe753f8c },
+    {   8,  1,  0,  0, 400, 284, 1250, 0x96e0bd79, 0x96ae9238 },
+    {  13,  2,  7,  3, 321, 201,  750, 0x8cb6c836, 0xd56da918 },
+    {   3,  0,  1,  0, 100,  50, 2000, 0xcf3f57af, 0x2abb1bc1 },
+    { 100, 99, 10, 20,   2,   1,    0, 0x44da4181, 0x5b20f925 },
+    {   2,  5,  3,  1, 407, 290, 1500, 0x97d94f7f, 0x96501aa4 },
+};
+
+#define NUM_RENDER_CASES (sizeof(render_cases) / sizeof(render_cases[0]))
+
+static uint32_t seed = 1;
+
+static uint32_t next_random(void)
+{
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+}
+
+static void setup_color_tables(video_render_color_tables_t *color_tab)
+{
+    int i;
+
+    seed = 1;
+    for (i = 0; i < 256; i++) {
+        color_tab->ytableh[i] = (int32_t)(next_random() % (200 << 16));
+        color_tab->ytablel[i] = (int32_t)(next_random() % (50 << 16));
+        color_tab->cbtable[i] = (int32_t)(next_random() % 20000) - 10000;
+        color_tab->crtable[i] = (int32_t)(next_random() % 20000) - 10000;
+        color_tab->cbtable_odd[i] = (int32_t)(next_random() % 20000) - 10000;
+        color_tab->crtable_odd[i] = (int32_t)(next_random() % 20000) - 10000;
+    }
+    for (i = 0; i < 768; i++) {
+        color_tab->gamma_red[i] = next_random();
+        color_tab->gamma_grn[i] = next_random();
+        color_tab->gamma_blu[i] = next_random();
+    }
+    color_tab->alpha = 0xff000000u;
+}
+
+static void setup_frame(uint8_t *src)
+{
+    int x, y;
+
+    /* a border, some bars and noise, in the 16 colors */
+    for (y = 0; y < SRC_HEIGHT; y++) {
+        for (x = 0; x < SRC_PITCH; x++) {
+            uint8_t color;
+
+            if (y < 16 || y >= SRC_HEIGHT - 16 || x < 32 || x >= SRC_PITCH - 32) {
+                color = 14;
+            } else if (y < 100) {
+                color = (uint8_t)((x / 8) & 15);
+            } else {
+                color = (uint8_t)(next_random() & 15);
+            }
+            src[y * SRC_PITCH + x] = color;
+        }
+    }
+}
+
+static uint32_t hash_image(const uint8_t *image, size_t size)
+{
+    uint32_t h = 2166136261u;
+
+    while (size--) {
+        h = (h ^ *image++) * 16777619u;
+    }
+    return h;
+}
+
+int main(void)
+{
+    static video_render_config_t config;
+    static video_render_scratch_t scratch;
+    uint8_t *src = lib_malloc(SRC_PITCH * SRC_HEIGHT);
+    uint8_t *trg = lib_malloc(TRG_PITCH * TRG_HEIGHT);
+    unsigned int i;
+    int failed = 0;
+
+    setup_color_tables(&config.color_tables);
+    setup_frame(src);
+
+    for (i = 0; i < NUM_RENDER_CASES; i++) {
+        const render_case_t *rc = &render_cases[i];
+        uint32_t hash;
+
+        config.video_resources.pal_oddlines_offset = rc->oddlines_offset;
+
+        memset(trg, 0, TRG_PITCH * TRG_HEIGHT);
+        render_32_1x1_pal(&config.color_tables, &scratch, src, trg, rc->width, rc->height,
+                          rc->xs, rc->ys, rc->xt, rc->yt, SRC_PITCH, TRG_PITCH, &config);
+        hash = hash_image(trg, TRG_PITCH * TRG_HEIGHT);
+        if (hash != rc->pal_hash) {
+            printf("FAIL: PAL case %u, image hash 0x%08x, expected 0x%08x\n", i, hash, rc->pal_hash);
+            failed = 1;
+        }
+
+        memset(trg, 0, TRG_PITCH * TRG_HEIGHT);
+        render_32_1x1_ntsc(&config.color_tables, src, trg, rc->width, rc->height,
+                           rc->xs, rc->ys, rc->xt, rc->yt, SRC_PITCH, TRG_PITCH);
+        hash = hash_image(trg, TRG_PITCH * TRG_HEIGHT);
+        if (hash != rc->ntsc_hash) {
+            printf("FAIL: NTSC case %u, image hash 0x%08x, expected 0x%08x\n", i, hash, rc->ntsc_hash);
+            failed = 1;
+        }
+    }
+
+    lib_free(src);
+    lib_free(trg);
+
+    if (failed) {
+        return EXIT_FAILURE;
+    }
+    printf("PASS: %u PAL and NTSC images match\n", (unsigned int)NUM_RENDER_CASES);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,559 @@
+/*
+ * test_reu_dma.c - Unit test for the REU DMA fast paths.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/*
+ * Runs every kind of DMA operation twice from the same state, once with
+ * the memory model offering no direct access, so every byte goes through
+ * mem_dma_read() and mem_dma_store(), and once with the RAM pages offered
+ * for the span paths. The host and REU memory, the clock, the registers,
+ * the I/O accesses and what the alarms see when they fire must be the
+ * same for both. The time both take for a full 64k transfer is printed.
+ */
+
+#include "../c64/cart/reu.c"
+
+#include <stdlib.h>
+#include <time.h>
+
+#define TEST_REU_KB     256
+
+/* host memory model: RAM, a ROM at $a000-$bfff that writes go through to
+   RAM under it, and I/O at $d000-$dfff */
+static uint8_t host_ram[0x10000];
+static uint8_t host_rom[0x10000];
+static int spans_offered = 0;
+
+/* the I/O accesses in order */
+#define MAX_IO_LOG  0x30000
+static struct {
+    CLOCK clk;
+    uint16_t addr;
+    uint8_t value;
+    uint8_t write;
+} io_log[MAX_IO_LOG];
+static int io_log_len;
+
+/* what the alarms saw */
+#define MAX_ALARM_LOG 4096
+static struct {
+    CLOCK clk;
+    uint32_t hash;
+} alarm_log[MAX_ALARM_LOG];
+static int alarm_log_len;
+static CLOCK alarm_period;
+
+static unsigned long slow_accesses;
+
+static int is_io(uint16_t addr)
+{
+    return addr >= 0xd000 && addr < 0xe000;
+}
+
+static int is_rom(uint16_t addr)
+{
+    return addr >= 0xa000 && addr < 0xc000;
+}
+
+static void log_io(uint16_t addr, uint8_t value, int write)
+{
+    if (io_log_len < MAX_IO_LOG) {
+        io_log[io_log_len].clk = maincpu_clk;
+        io_log[io_log_len].addr = addr;
+        io_log[io_log_len].value = value;
+        io_log[io_log_len].write = (uint8_t)write;
+    }
+    io_log_len++;
+}
+
+uint8_t mem_dma_read(uint16_t addr)
+{
+    slow_accesses++;
+    if (is_io(addr)) {
+        uint8_t value = (uint8_t)(addr ^ maincpu_clk);
+
+        log_io(addr, value, 0);
+        return value;
+    }
+    return is_rom(addr) ? host_rom[addr] : host_ram[addr];
+}
+
+void mem_dma_store(uint16_t addr, uint8_t value)
+{
+    slow_accesses++;
+    if (is_io(addr)) {
+        log_io(addr, value, 1);
+        return;
+    }
+    host_ram[addr] = value;
+}
+
+void mem_mmu_translate(unsigned int addr, uint8_t **base, int *start, int *limit)
+{
+    *base = NULL;
+    *start = 0;
+    *limit = 0;
+    if (!spans_offered || is_io((uint16_t)addr)) {
+        return;
+    }
+    if (is_rom((uint16_t)addr)) {
+        *base = host_rom;
+        *start = 0xa000;
+        *limit = 0xbffd;
+    } else if (addr < 0xa000) {
+        *base = host_ram;
+        *start = 0x0002;
+        *limit = 0x9ffd;
+    } else if (addr < 0xd000) {
+        *base = host_ram;
+        *start = 0xc000;
+        *limit = 0xcffd;
+    } else {
+        *base = host_ram;
+        *start = 0xe000;
+        *limit = 0xfffd;
+    }
+}
+
+uint8_t *mem_dma_write_base(uint16_t addr)
+{
+    if (!spans_offered || is_io(addr) || is_rom(addr) || addr < 0x100) {
+        return NULL;
+    }
+    return host_ram;
+}
+
+static uint32_t test_hash(void)
+{
+    uint32_t h = 2166136261u;
+    unsigned int i;
+
+    for (i = 0; i < sizeof(host_ram); i++) {
+        h = (h ^ host_ram[i]) * 16777619u;
+    }
+    for (i = 0; i < reu_size; i++) {
+        h = (h ^ reu_ram[i]) * 16777619u;
+    }
+    return h;
+}
+
+void machine_handle_pending_alarms(CLOCK num_write_cycles)
+{
+    while (maincpu_clk >= maincpu_alarm_context->next_pending_alarm_clk) {
+        if (alarm_log_len < MAX_ALARM_LOG) {
+            alarm_log[alarm_log_len].clk = maincpu_clk;
+            alarm_log[alarm_log_len].hash = test_hash();
+        }
+        alarm_log_len++;
+        maincpu_alarm_context->next_pending_alarm_clk += alarm_period;
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* stubs for the rest of the emulator */
+static alarm_context_t test_alarm_context;
+static interrupt_cpu_status_t test_int_status;
+
+CLOCK maincpu_clk = 0;
+alarm_context_t *maincpu_alarm_context = &test_alarm_context;
+interrupt_cpu_status_t *maincpu_int_status = &test_int_status;
+unsigned monitor_mask[NUM_MEMSPACES];
+
+off_t archdep_file_size(FILE *stream)
+{
+    return 0;
+}
+
+int cmdline_register_options(const cmdline_option_t *c)
+{
+    return 0;
+}
+
+int export_add(const export_resource_t *export_res)
+{
+    return 0;
+}
+
+int export_remove(const export_resource_t *export_res)
+{
+    return 0;
+}
+
+unsigned int interrupt_cpu_status_int_new(interrupt_cpu_status_t *cs, const char *name)
+{
+    return 0;
+}
+
+void interrupt_fixup_int_clk(interrupt_cpu_status_t *cs, CLOCK cpu_clk, CLOCK *int_clk)
+{
+}
+
+void interrupt_log_wrong_nirq(void)
+{
+}
+
+void interrupt_restore_irq(interrupt_cpu_status_t *cs, int int_num, int value)
+{
+}
+
+io_source_list_t *io_source_register(io_source_t *device)
+{
+    return NULL;
+}
+
+void io_source_unregister(io_source_list_t *device)
+{
+}
+
+log_t log_open(const char *id)
+{
+    return LOG_DEFAULT;
+}
+
+void ram_init_with_pattern(uint8_t *memram, unsigned int ramsize, RAMINITPARAM *ramparam)
+{
+    memset(memram, 0, ramsize);
+}
+
+int resources_register_int(const resource_int_t *r)
+{
+    return 0;
+}
+
+int resources_register_string(const resource_string_t *r)
+{
+    return 0;
+}
+
+snapshot_module_t *snapshot_module_create(snapshot_t *s, const char *name, uint8_t major_version, uint8_t minor_version)
+{
+    return NULL;
+}
+
+snapshot_module_t *snapshot_module_open(snapshot_t *s, const char *name, uint8_t *major_version_return, uint8_t *minor_version_return)
+{
+    return NULL;
+}
+
+int snapshot_module_close(snapshot_module_t *m)
+{
+    return 0;
+}
+
+int snapshot_module_read_byte_array(snapshot_module_t *m, uint8_t *b_return, unsigned int num)
+{
+    return -1;
+}
+
+int snapshot_module_read_dword(snapshot_module_t *m, uint32_t *dw_return)
+{
+    return -1;
+}
+
+int snapshot_module_write_byte_array(snapshot_module_t *m, const uint8_t *data, unsigned int num)
+{
+    return -1;
+}
+
+int snapshot_module_write_dword(snapshot_module_t *m, uint32_t data)
+{
+    return -1;
+}
+
+void snapshot_set_error(int error)
+{
+}
+
+int snapshot_version_is_bigger(uint8_t major_version, uint8_t minor_version, uint8_t major_version_required, uint8_t minor_version_required)
+{
+    return 0;
+}
+
+int util_check_filename_access(const char *filename)
+{
+    return 0;
+}
+
+int util_check_null_string(const char *string)
+{
+    return string == NULL || *string == '\0';
+}
+
+int util_file_exists(const char *name)
+{
+    return 0;
+}
+
+int util_file_load(const char *name, uint8_t *dest, size_t size, unsigned int load_flag)
+{
+    return -1;
+}
+
+int util_file_save(const char *name, uint8_t *src, int size)
+{
+    return -1;
+}
+
+int util_string_set(char **str, const char *new_value)
+{
+    return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+enum {
+    OP_REU_TO_HOST,
+    OP_HOST_TO_REU,
+    OP_SWAP,
+    OP_COMPARE
+};
+
+static const char *op_names[] = {
+    "REU to host", "host to REU", "swap", "compare"
+};
+
+typedef struct test_case_s {
+    uint16_t host_addr;
+    unsigned int reu_addr;
+    int host_step;
+    int reu_step;
+    int len;
+} test_case_t;
+
+static const test_case_t test_cases[] = {
+    { 0x0800, 0x00000, 1, 1, 0x1000 },  /* plain RAM */
+    { 0x0000, 0x01000, 1, 1, 0x0400 },  /* starting in pages 0 and 1 */
+    { 0x9f00, 0x02000, 1, 1, 0x4000 },  /* across the ROM and the I/O */
+    { 0xff00, 0x03000, 1, 1, 0x0300 },  /* wrapping around the host */
+    { 0x2000, 0x3ff00, 1, 1, 0x0200 },  /* wrapping around the REU */
+    { 0x3000, 0x04000, 0, 1, 0x0400 },  /* fixed host address */
+    { 0x4000, 0x05000, 1, 0, 0x0400 },  /* fixed REU address */
+    { 0xd020, 0x06000, 0, 1, 0x0100 },  /* fixed I/O address */
+    { 0x0200, 0x00000, 1, 1, 0x0000 },  /* 64k, len 0 */
+};
+
+#define NUM_TEST_CASES  (sizeof(test_cases) / sizeof(test_cases[0]))
+
+/* the state after an operation */
+typedef struct test_result_s {
+    uint8_t host_ram[0x10000];
+    uint8_t *reu_ram;
+    struct rec_s rec;
+    CLOCK clk;
+    int floating_bus_value;
+    int io_log_len;
+    int alarm_log_len;
+    uint32_t io_hash;
+    uint32_t alarm_hash;
+    unsigned long slow_accesses;
+} test_result_t;
+
+static void setup(int op, CLOCK alarm_phase)
+{
+    unsigned int i;
+    uint32_t seed = 12345;
+
+    for (i = 0; i < sizeof(host_ram); i++) {
+        seed = seed * 1103515245u + 12345u;
+        host_ram[i] = (uint8_t)(seed >> 16);
+        host_rom[i] = (uint8_t)(seed >> 24);
+    }
+    for (i = 0; i < reu_size; i++) {
+        seed = seed * 1103515245u + 12345u;
+        reu_ram[i] = (uint8_t)(seed >> 16);
+    }
+    if (op == OP_COMPARE) {
+        /* make the compare run a while before the first difference */
+        memcpy(reu_ram, host_ram + 0x0800, 0x0800);
+        memcpy(reu_ram + 0x1000, host_ram, 0x0400);
+        memcpy(reu_ram + 0x2000, host_ram + 0x9f00, 0x0100);
+    }
+
+    memset(&rec, 0, sizeof(rec));
+    floating_bus_value = 0xff;
+    maincpu_clk = 1000;
+    maincpu_alarm_context->next_pending_alarm_clk = alarm_period ? maincpu_clk + alarm_phase : CLOCK_MAX;
+    io_log_len = 0;
+    alarm_log_len = 0;
+    slow_accesses = 0;
+}
+
+static uint32_t hash_bytes(const void *data, size_t size)
+{
+    const uint8_t *p = data;
+    uint32_t h = 2166136261u;
+
+    while (size--) {
+        h = (h ^ *p++) * 16777619u;
+    }
+    return h;
+}
+
+static void run(int op, const test_case_t *tc)
+{
+    switch (op) {
+        case OP_REU_TO_HOST:
+            reu_dma_reu_to_host(tc->host_addr, tc->reu_addr, tc->host_step, tc->reu_step, tc->len ? tc->len : 0x10000);
+            break;
+        case OP_HOST_TO_REU:
+            reu_dma_host_to_reu(tc->host_addr, tc->reu_addr, tc->host_step, tc->reu_step, tc->len ? tc->len : 0x10000);
+            break;
+        case OP_SWAP:
+            reu_dma_swap(tc->host_addr, tc->reu_addr, tc->host_step, tc->reu_step, tc->len ? tc->len : 0x10000);
+            break;
+        default:
+            reu_dma_compare(tc->host_addr, tc->reu_addr, tc->host_step, tc->reu_step, tc->len ? tc->len : 0x10000);
+            break;
+    }
+}
+
+static void collect(test_result_t *result)
+{
+    memcpy(result->host_ram, host_ram, sizeof(host_ram));
+    memcpy(result->reu_ram, reu_ram, reu_size);
+    result->rec = rec;
+    result->clk = maincpu_clk;
+    result->floating_bus_value = floating_bus_value;
+    result->io_log_len = io_log_len;
+    result->alarm_log_len = alarm_log_len;
+    result->io_hash = hash_bytes(io_log, sizeof(io_log[0]) * (size_t)(io_log_len < MAX_IO_LOG ? io_log_len : MAX_IO_LOG));
+    result->alarm_hash = hash_bytes(alarm_log, sizeof(alarm_log[0]) * (size_t)(alarm_log_len < MAX_ALARM_LOG ? alarm_log_len : MAX_ALARM_LOG));
+    result->slow_accesses = slow_accesses;
+}
+
+static int compare_results(const test_result_t *slow, const test_result_t *fast)
+{
+    if (memcmp(slow->host_ram, fast->host_ram, sizeof(slow->host_ram)) != 0) {
+        return printf("host memory differs"), -1;
+    }
+    if (memcmp(slow->reu_ram, fast->reu_ram, reu_size) != 0) {
+        return printf("REU memory differs"), -1;
+    }
+    if (memcmp(&slow->rec, &fast->rec, sizeof(slow->rec)) != 0) {
+        return printf("REU registers differ"), -1;
+    }
+    if (slow->clk != fast->clk) {
+        return printf("clock differs, %lu vs %lu", (unsigned long)slow->clk, (unsigned long)fast->clk), -1;
+    }
+    if (slow->floating_bus_value != fast->floating_bus_value) {
+        return printf("floating bus value differs"), -1;
+    }
+    if (slow->io_log_len != fast->io_log_len || slow->io_hash != fast->io_hash) {
+        return printf("I/O accesses differ"), -1;
+    }
+    if (slow->alarm_log_len != fast->alarm_log_len || slow->alarm_hash != fast->alarm_hash) {
+        return printf("alarms differ, %d vs %d", slow->alarm_log_len, fast->alarm_log_len), -1;
+    }
+    return 0;
+}
+
+static const CLOCK alarm_periods[] = { 0, 63, 1000 };
+
+#define NUM_ALARM_PERIODS   (sizeof(alarm_periods) / sizeof(alarm_periods[0]))
+
+static double time_transfer(int offered)
+{
+    static const test_case_t big = { 0x0000, 0x00000, 1, 1, 0 };
+    clock_t start;
+    int i;
+
+    alarm_period = 0;
+    spans_offered = offered;
+    start = clock();
+    for (i = 0; i < 200; i++) {
+        maincpu_clk = 1000;
+        maincpu_alarm_context->next_pending_alarm_clk = CLOCK_MAX;
+        run(OP_REU_TO_HOST, &big);
+    }
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(void)
+{
+    static test_result_t slow;
+    static test_result_t fast;
+    unsigned int i, p;
+    int op;
+    int failed = 0;
+    unsigned long slow_total = 0;
+    unsigned long fast_total = 0;
+    double slow_time;
+    double fast_time;
+
+    set_reu_size(TEST_REU_KB, NULL);
+    reu_ram = lib_calloc(1, reu_size);
+    slow.reu_ram = lib_malloc(reu_size);
+    fast.reu_ram = lib_malloc(reu_size);
+
+    for (op = OP_REU_TO_HOST; op <= OP_COMPARE; op++) {
+        for (i = 0; i < NUM_TEST_CASES; i++) {
+            for (p = 0; p < NUM_ALARM_PERIODS; p++) {
+                CLOCK phase;
+
+                alarm_period = alarm_periods[p];
+                for (phase = 1; phase <= (alarm_period ? 3 : 1); phase++) {
+                    spans_offered = 0;
+                    setup(op, phase * 17);
+                    run(op, &test_cases[i]);
+                    collect(&slow);
+
+                    spans_offered = 1;
+                    setup(op, phase * 17);
+                    run(op, &test_cases[i]);
+                    collect(&fast);
+
+                    slow_total += slow.slow_accesses;
+                    fast_total += fast.slow_accesses;
+
+                    if (compare_results(&slow, &fast) < 0) {
+                        printf(": %s, host $%04x reu $%05x step %d/%d len $%04x, alarms every %lu\n",
+                               op_names[op], (unsigned int)test_cases[i].host_addr, test_cases[i].reu_addr,
+                               test_cases[i].host_step, test_cases[i].reu_step, (unsigned int)test_cases[i].len,
+                               (unsigned long)alarm_period);
+                        failed = 1;
+                    }
+                }
+            }
+        }
+    }
+
+    if (!failed && fast_total * 2 > slow_total) {
+        printf("FAIL: the span paths were hardly used, %lu of %lu accesses still went through the store and read functions\n",
+               fast_total, slow_total);
+        failed = 1;
+    }
+
+    slow_time = time_transfer(0);
+    fast_time = time_transfer(1);
+    printf("200 x 64k REU to host: %.3f s byte by byte, %.3f s in spans\n", slow_time, fast_time);
+
+    lib_free(reu_ram);
+    lib_free(slow.reu_ram);
+    lib_free(fast.reu_ram);
+
+    if (failed) {
+        return EXIT_FAILURE;
+    }
+    printf("PASS: span and byte by byte DMA match\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,134 @@
+/*
+ * teststubs.c - Minimal lib and log functions for the unit tests.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/*
+ * The tests build the unit under test on its own, these replace lib.c and
+ * log.c so they don't pull in the rest of the emulator.
+ */
+
+#define COMPILING_LIB_DOT_C
+
+#include "vice.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lib.h"
+#include "log.h"
+
+#ifdef LIB_DEBUG_PINPOINT
+void *lib_malloc_pinpoint(size_t size, const char *name, unsigned int line)
+{
+    return malloc(size ? size : 1);
+}
+
+void *lib_calloc_pinpoint(size_t nmemb, size_t size, const char *name, unsigned int line)
+{
+    return calloc(nmemb ? nmemb : 1, size ? size : 1);
+}
+
+void *lib_realloc_pinpoint(void *p, size_t size, const char *name, unsigned int line)
+{
+    return realloc(p, size ? size : 1);
+}
+
+void lib_free_pinpoint(void *p, const char *name, unsigned int line)
+{
+    free(p);
+}
+
+char *lib_strdup_pinpoint(const char *str, const char *name, unsigned int line)
+{
+    return strdup(str);
+}
+#else
+void *lib_malloc(size_t size)
+{
+    return malloc(size ? size : 1);
+}
+
+void *lib_calloc(size_t nmemb, size_t size)
+{
+    return calloc(nmemb ? nmemb : 1, size ? size : 1);
+}
+
+void *lib_realloc(void *p, size_t size)
+{
+    return realloc(p, size ? size : 1);
+}
+
+void lib_free(void *ptr)
+{
+    free(ptr);
+}
+
+char *lib_strdup(const char *str)
+{
+    return strdup(str);
+}
+#endif
+
+static int test_log(const char *prefix, const char *format, va_list ap)
+{
+    if (getenv("VICE_TEST_VERBOSE") != NULL) {
+        fputs(prefix, stderr);
+        vfprintf(stderr, format, ap);
+        fputc('\n', stderr);
+    }
+    return 0;
+}
+
+int log_message(log_t log, const char *format, ...)
+{
+    va_list ap;
+    int rc;
+
+    va_start(ap, format);
+    rc = test_log("", format, ap);
+    va_end(ap);
+    return rc;
+}
+
+int log_warning(log_t log, const char *format, ...)
+{
+    va_list ap;
+    int rc;
+
+    va_start(ap, format);
+    rc = test_log("Warning - ", format, ap);
+    va_end(ap);
+    return rc;
+}
+
+int log_error(log_t log, const char *format, ...)
+{
+    va_list ap;
+    int rc;
+
+    va_start(ap, format);
+    rc = test_log("Error - ", format, ap);
+    va_end(ap);
+    return rc;
+}
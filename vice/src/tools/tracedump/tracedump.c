@@ -0,0 +1,387 @@
+/*
+ * tracedump.c - Decode instruction traces recorded by the monitor.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/*
+ * Reads a trace written by the monitor `cputrace' command (or -montrace)
+ * and prints it in the style of the `chis' command, optionally filtered by
+ * memspace, clock and PC range. See src/monitor/mon_trace.h for the format.
+ */
+
+#include "vice.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "mon_trace.h"
+#include "version.h"
+
+#ifdef USE_SVN_REVISION
+#include "svnversion.h"
+#endif
+
+/* memory access bits, see MEMMAP_* in src/monitor.h */
+#define ACCESS_REGULAR_READ (1 << 9)
+#define ACCESS_IO_R         (1 << 8)
+#define ACCESS_IO_W         (1 << 7)
+#define ACCESS_IO_X         (1 << 6)
+#define ACCESS_ROM_R        (1 << 5)
+#define ACCESS_ROM_W        (1 << 4)
+#define ACCESS_ROM_X        (1 << 3)
+#define ACCESS_RAM_R        (1 << 2)
+#define ACCESS_RAM_W        (1 << 1)
+#define ACCESS_RAM_X        (1 << 0)
+
+#define NUM_SPACES (MON_TRACE_MEMSPACE_MASK + 1)
+
+typedef struct state_s {
+    uint64_t clk;
+    unsigned int pc;
+    unsigned int st;
+    uint8_t a;
+    uint8_t x;
+    uint8_t y;
+    uint8_t sp;
+} state_t;
+
+static const char *space_names[NUM_SPACES] = {
+    "?", "C", "8", "9", "10", "11"
+};
+
+/* filters */
+static int space_filter[NUM_SPACES];
+static int space_filter_set = 0;
+static uint64_t clk_from = 0;
+static uint64_t clk_to = UINT64_MAX;
+static unsigned int pc_from = 0;
+static unsigned int pc_to = 0xffff;
+static int show_accesses = 1;
+
+/* was the last computer instruction shown, its accesses may be in the next block */
+static int last_shown = 0;
+
+static int get_u8(const uint8_t **p, const uint8_t *end, unsigned int *value)
+{
+    if (*p >= end) {
+        return -1;
+    }
+    *value = *(*p)++;
+    return 0;
+}
+
+static int get_u16(const uint8_t **p, const uint8_t *end, unsigned int *value)
+{
+    if (*p + 2 > end) {
+        return -1;
+    }
+    *value = (*p)[0] | ((*p)[1] << 8);
+    *p += 2;
+    return 0;
+}
+
+static int get_zigzag(const uint8_t **p, const uint8_t *end, int64_t *value)
+{
+    uint64_t v = 0;
+    int shift = 0;
+    uint8_t b;
+
+    do {
+        if (*p >= end || shift > 63) {
+            return -1;
+        }
+        b = *(*p)++;
+        v |= (uint64_t)(b & 0x7f) << shift;
+        shift += 7;
+    } while (b & 0x80);
+
+    *value = (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+    return 0;
+}
+
+static const char *access_string(unsigned int type, char *buf)
+{
+    const char *kind;
+    char op;
+
+    if (type & (ACCESS_IO_R | ACCESS_IO_W | ACCESS_IO_X)) {
+        kind = "io";
+    } else if (type & (ACCESS_ROM_R | ACCESS_ROM_W | ACCESS_ROM_X)) {
+        kind = "rom";
+    } else {
+        kind = "ram";
+    }
+
+    if (type & (ACCESS_IO_W | ACCESS_ROM_W | ACCESS_RAM_W)) {
+        op = 'w';
+    } else if (type & (ACCESS_IO_X | ACCESS_ROM_X | ACCESS_RAM_X)) {
+        op = 'x';
+    } else {
+        op = 'r';
+    }
+
+    sprintf(buf, "%c %-3s%s", op, kind,
+            (op == 'r' && !(type & ACCESS_REGULAR_READ)) ? " (dummy)" : "");
+    return buf;
+}
+
+/* Decode and print the records of one block, returns -1 if it is corrupt. */
+static int dump_block(const uint8_t *p, const uint8_t *end)
+{
+    state_t state[NUM_SPACES];
+    char buf[32];
+
+    memset(state, 0, sizeof(state));
+
+    while (p < end) {
+        unsigned int tag = *p++;
+        unsigned int space = tag & MON_TRACE_MEMSPACE_MASK;
+        state_t *s = &state[space];
+
+        if ((tag & MON_TRACE_REC_MASK) == MON_TRACE_REC_INSN) {
+            int64_t delta;
+            unsigned int op, p1, p2, mask, value;
+            int show;
+
+            if (get_zigzag(&p, end, &delta) < 0) {
+                return -1;
+            }
+            s->clk += (uint64_t)delta;
+            if (get_zigzag(&p, end, &delta) < 0) {
+                return -1;
+            }
+            s->pc = (unsigned int)((int64_t)s->pc + delta);
+            if (get_u8(&p, end, &op) < 0
+                || get_u8(&p, end, &p1) < 0
+                || get_u8(&p, end, &p2) < 0
+                || get_u8(&p, end, &mask) < 0) {
+                return -1;
+            }
+            if (mask & MON_TRACE_REG_A) {
+                if (get_u8(&p, end, &value) < 0) {
+                    return -1;
+                }
+                s->a = (uint8_t)value;
+            }
+            if (mask & MON_TRACE_REG_X) {
+                if (get_u8(&p, end, &value) < 0) {
+                    return -1;
+                }
+                s->x = (uint8_t)value;
+            }
+            if (mask & MON_TRACE_REG_Y) {
+                if (get_u8(&p, end, &value) < 0) {
+                    return -1;
+                }
+                s->y = (uint8_t)value;
+            }
+            if (mask & MON_TRACE_REG_SP) {
+                if (get_u8(&p, end, &value) < 0) {
+                    return -1;
+                }
+                s->sp = (uint8_t)value;
+            }
+            if (mask & MON_TRACE_REG_ST) {
+                if (get_u16(&p, end, &s->st) < 0) {
+                    return -1;
+                }
+            }
+
+            show = (!space_filter_set || space_filter[space])
+                   && s->clk >= clk_from && s->clk <= clk_to
+                   && s->pc >= pc_from && s->pc <= pc_to;
+            if (space == 1) {
+                last_shown = show;
+            }
+            if (show) {
+                printf(".%s:%04x  %02x %02x %02x  A:%02x X:%02x Y:%02x SP:%02x %c%c-%c%c%c%c%c %12"PRIu64"\n",
+                       space_names[space] ? space_names[space] : "?",
+                       s->pc, op, p1, p2, s->a, s->x, s->y, s->sp,
+                       (s->st & (1 << 7)) ? 'N' : '.',
+                       (s->st & (1 << 6)) ? 'V' : '.',
+                       (s->st & (1 << 4)) ? 'B' : '.',
+                       (s->st & (1 << 3)) ? 'D' : '.',
+                       (s->st & (1 << 2)) ? 'I' : '.',
+                       (s->st & (1 << 1)) ? 'Z' : '.',
+                       (s->st & (1 << 0)) ? 'C' : '.',
+                       s->clk);
+            }
+        } else if ((tag & MON_TRACE_REC_MASK) == MON_TRACE_REC_MEM) {
+            unsigned int addr, type;
+
+            if (get_u16(&p, end, &addr) < 0 || get_u16(&p, end, &type) < 0) {
+                return -1;
+            }
+            /* accesses belong to the computer instruction before them */
+            if (show_accesses && last_shown) {
+                printf("           %s $%04x\n", access_string(type, buf), addr);
+            }
+        } else {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int dump_file(const char *filename)
+{
+    FILE *fp;
+    uint8_t header[MON_TRACE_HEADER_SIZE];
+    uint8_t block_header[MON_TRACE_BLOCK_HEADER_SIZE];
+    uint8_t *stored = NULL;
+    uint8_t *raw = NULL;
+    int result = 0;
+
+    fp = fopen(filename, "rb");
+    if (fp == NULL) {
+        fprintf(stderr, "cannot open '%s'\n", filename);
+        return -1;
+    }
+
+    if (fread(header, 1, sizeof(header), fp) != sizeof(header)
+        || memcmp(header, MON_TRACE_MAGIC, MON_TRACE_MAGIC_SIZE) != 0) {
+        fprintf(stderr, "'%s' is not a VICE trace file\n", filename);
+        fclose(fp);
+        return -1;
+    }
+    if (header[MON_TRACE_MAGIC_SIZE] != MON_TRACE_VERSION) {
+        fprintf(stderr, "'%s' has unsupported version %d\n", filename, header[MON_TRACE_MAGIC_SIZE]);
+        fclose(fp);
+        return -1;
+    }
+
+    while (fread(block_header, 1, sizeof(block_header), fp) == sizeof(block_header)) {
+        uLongf raw_size = block_header[0] | (block_header[1] << 8)
+                          | (block_header[2] << 16) | ((uLongf)block_header[3] << 24);
+        uLongf stored_size = block_header[4] | (block_header[5] << 8)
+                             | (block_header[6] << 16) | ((uLongf)block_header[7] << 24);
+        uLongf out_size = raw_size;
+
+        stored = realloc(stored, stored_size ? stored_size : 1);
+        raw = realloc(raw, raw_size ? raw_size : 1);
+        if (stored == NULL || raw == NULL) {
+            fprintf(stderr, "out of memory\n");
+            result = -1;
+            break;
+        }
+        if (fread(stored, 1, stored_size, fp) != stored_size) {
+            fprintf(stderr, "'%s' is truncated\n", filename);
+            result = -1;
+            break;
+        }
+
+        if (stored_size == raw_size) {
+            memcpy(raw, stored, raw_size);
+        } else if (uncompress(raw, &out_size, stored, stored_size) != Z_OK || out_size != raw_size) {
+            fprintf(stderr, "'%s' has a corrupt block\n", filename);
+            result = -1;
+            break;
+        }
+
+        if (dump_block(raw, raw + raw_size) < 0) {
+            fprintf(stderr, "'%s' has a corrupt record\n", filename);
+            result = -1;
+            break;
+        }
+    }
+
+    free(stored);
+    free(raw);
+    fclose(fp);
+
+    return result;
+}
+
+static void usage(const char *progname)
+{
+#ifdef USE_SVN_REVISION
+    printf("\n\t%s (VICE %s SVN r%d) -- Instruction trace decoder.\n",
+           progname, VERSION, VICE_SVN_REV_NUMBER);
+#else
+    printf("\n\t%s (VICE %s) -- Instruction trace decoder.\n",
+           progname, VERSION);
+#endif
+    printf("\nUsage: %s [options] <tracefile>\n"
+           "\n"
+           "  -m <space>       only show memspace c, 8, 9, 10 or 11 (can be repeated)\n"
+           "  -s <clock>       only show instructions from this clock on\n"
+           "  -e <clock>       only show instructions up to this clock\n"
+           "  -p <from>-<to>   only show instructions with the PC in this hex range\n"
+           "  -n               don't show memory accesses\n"
+           "  -h               show this help\n",
+           progname);
+}
+
+int main(int argc, char **argv)
+{
+    const char *progname = argv[0];
+    int i;
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+        const char *arg = argv[i];
+
+        if (!strcmp(arg, "-n")) {
+            show_accesses = 0;
+        } else if (!strcmp(arg, "-h")) {
+            usage(progname);
+            return EXIT_SUCCESS;
+        } else if (i + 1 < argc && !strcmp(arg, "-m")) {
+            const char *name = argv[++i];
+            int space;
+
+            for (space = 1; space < NUM_SPACES && space_names[space]; space++) {
+                if (!strcmp(name, space_names[space])
+                    || (space == 1 && !strcmp(name, "c"))) {
+                    break;
+                }
+            }
+            if (space == NUM_SPACES || space_names[space] == NULL) {
+                fprintf(stderr, "unknown memspace '%s'\n", name);
+                return EXIT_FAILURE;
+            }
+            space_filter[space] = 1;
+            space_filter_set = 1;
+        } else if (i + 1 < argc && !strcmp(arg, "-s")) {
+            clk_from = strtoull(argv[++i], NULL, 0);
+        } else if (i + 1 < argc && !strcmp(arg, "-e")) {
+            clk_to = strtoull(argv[++i], NULL, 0);
+        } else if (i + 1 < argc && !strcmp(arg, "-p")) {
+            if (sscanf(argv[++i], "%x-%x", &pc_from, &pc_to) != 2) {
+                fprintf(stderr, "invalid PC range '%s'\n", argv[i]);
+                return EXIT_FAILURE;
+            }
+        } else {
+            usage(progname);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (i != argc - 1) {
+        usage(progname);
+        return EXIT_FAILURE;
+    }
+
+    return dump_file(argv[i]) < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -966,6 +966,31 @@ int vdrive_read_sector(vdrive_t *vdrive, uint8_t *buf, unsigned int track, unsig
     return ret;
 }
 
+/* Read `count` consecutive logical sectors of `track` with a single access to
+   the image. Returns non-zero if the range can't be read in one go, in which
+   case the caller should fall back to vdrive_read_sector(). */
+int vdrive_read_sectors(vdrive_t *vdrive, uint8_t *buf, unsigned int track, unsigned int sector, unsigned int count)
+{
+    disk_addr_t first, last;
+
+    if (vdrive->image) {
+        vdrive->image_mode = vdrive->image->read_only;
+    }
+    if (vdrive->image_mode < 0 || count == 0) {
+        return CBMDOS_IPE_NOT_READY;
+    }
+    if (vdrive_log_to_phy(vdrive, &first, track, sector) < 0
+        || vdrive_log_to_phy(vdrive, &last, track, sector + count - 1) < 0) {
+        return CBMDOS_IPE_NOT_READY;
+    }
+    /* the logical range must map to a single physical run */
+    if (first.track != last.track || last.sector - first.sector != count - 1) {
+        return CBMDOS_IPE_NOT_READY;
+    }
+
+    return disk_image_read_sectors(vdrive->image, buf, &first, count);
+}
+
 int vdrive_write_sector(vdrive_t *vdrive, const uint8_t *buf, unsigned int track, unsigned int sector)
 {
     disk_addr_t dadr;
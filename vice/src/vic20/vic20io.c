@@ -65,9 +65,9 @@ static unsigned int order = 0;
 
 /* ---------------------------------------------------------------------------------------------------------- */
 
-static io_source_list_t vic20io0_head = { NULL, NULL, NULL };
-static io_source_list_t vic20io2_head = { NULL, NULL, NULL };
-static io_source_list_t vic20io3_head = { NULL, NULL, NULL };
+static io_source_list_t vic20io0_head = { NULL, NULL, NULL, NULL };
+static io_source_list_t vic20io2_head = { NULL, NULL, NULL, NULL };
+static io_source_list_t vic20io3_head = { NULL, NULL, NULL, NULL };
 
 static void io_source_detach(io_source_detach_t *source)
 {
@@ -286,6 +286,14 @@ static inline uint8_t io_read(io_source_list_t *list, uint16_t addr)
     uint8_t firstval = 0;
     unsigned int lowest_order = 0xffffffff;
 
+    /* a single device which is a window into its memory */
+    if (current != NULL && current->next == NULL && current->page != NULL
+        && addr >= current->device->start_address && addr <= current->device->end_address) {
+        vic20_cpu_last_data = current->page[addr & (current->device->address_mask & 0x3ff)];
+        vic20_mem_v_bus_read(addr);
+        return vic20_cpu_last_data;
+    }
+
     while (current) {
         if (current->device->read != NULL) {
             if ((addr >= current->device->start_address) && (addr <= current->device->end_address)) {
@@ -384,6 +392,13 @@ static inline void io_store(io_source_list_t *list, uint16_t addr, uint8_t value
 
     vic20_cpu_last_data = value;
 
+    if (current != NULL && current->next == NULL && current->page != NULL
+        && addr >= current->device->start_address && addr <= current->device->end_address) {
+        current->page[addr & (current->device->address_mask & 0x3ff)] = value;
+        vic20_mem_v_bus_store(addr);
+        return;
+    }
+
     while (current) {
         if (current->device->store != NULL) {
             if (addr >= current->device->start_address && addr <= current->device->end_address) {
@@ -431,6 +446,7 @@ io_source_list_t *io_source_register(io_source_t *device)
     retval->previous = current;
     retval->device = device;
     retval->next = NULL;
+    retval->page = NULL;
     retval->device->order = order++;
 
     return retval;
@@ -459,6 +475,14 @@ void io_source_unregister(io_source_list_t *device)
     lib_free(device);
 }
 
+void io_source_set_page(io_source_list_t *device, uint8_t *page)
+{
+    assert(device != NULL);
+    assert(page == NULL || device->device->io_source_prio != IO_PRIO_LOW);
+
+    device->page = page;
+}
+
 void cartio_shutdown(void)
 {
     io_source_list_t *current;
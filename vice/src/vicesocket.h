@@ -49,9 +49,22 @@ int vice_network_socket_close(vice_network_socket_t * sockfd);
 ssize_t vice_network_send(vice_network_socket_t * sockfd, const void * buffer, size_t buffer_length, int flags);
 ssize_t vice_network_receive(vice_network_socket_t * sockfd, void * buffer, size_t buffer_length, int flags);
 
+/* most bytes vice_network_send_nonblocking() sends at once if the system has
+   no MSG_DONTWAIT */
+#define VICE_NETWORK_SEND_CHUNK 1024
+
+ssize_t vice_network_send_nonblocking(vice_network_socket_t *sockfd, const void *buffer, size_t buffer_length);
+
 int vice_network_select_poll_one(vice_network_socket_t * readsockfd);
+int vice_network_select_poll_write_one(vice_network_socket_t * writesockfd);
 int vice_network_select_multiple(vice_network_socket_t ** readsockfd);
 
+/* results of vice_network_select_read_write() */
+#define VICE_NETWORK_READABLE   0x01
+#define VICE_NETWORK_WRITABLE   0x02
+
+int vice_network_select_read_write(vice_network_socket_t *sockfd, int want_write, unsigned int timeout_ms);
+
 int vice_network_get_errorcode(void);
 
 #endif /* VICE_SOCKET_H */
@@ -68,6 +68,13 @@ void vicii_chip_model_init(void);
 #define UPDATE_VC_M       0x01000000
 #define UPDATE_RC_M       0x00800000
 
+/*
+ * Cycles that need any of the sprite or VcRc line logic, on all other
+ * cycles vicii_cycle() skips it.
+ */
+#define LINE_LOGIC_SPR_M  (CHECK_SPR_EXP_M | CHECK_SPR_M)
+#define LINE_LOGIC_VCRC_M (UPDATE_VC_M | UPDATE_RC_M)
+
 /*
  * 22    Visible
  */
@@ -166,6 +173,16 @@ static inline int cycle_get_xpos(unsigned int flags)
     return ((flags & XPOS_M) >> XPOS_B) << 3;
 }
 
+static inline int cycle_has_sprite_logic(unsigned int flags)
+{
+    return (flags & LINE_LOGIC_SPR_M) ? 1 : 0;
+}
+
+static inline int cycle_has_vcrc_logic(unsigned int flags)
+{
+    return (flags & LINE_LOGIC_VCRC_M) ? 1 : 0;
+}
+
 static inline int cycle_is_update_vc(unsigned int flags)
 {
     return (flags & UPDATE_VC_M) ? 1 : 0;
@@ -380,7 +380,10 @@ int vicii_cycle(void)
     /*VICII_DEBUG_CYCLE(("cycle: line %i, clk %i", vicii.raster_line, vicii.raster_cycle));*/
 
     /* perform phi2 fetch after the cpu has executed */
-    vicii_fetch_sprites(vicii.cycle_flags);
+    if (cycle_is_sprite_ptr_dma0(vicii.cycle_flags)
+        || cycle_is_sprite_dma1_dma2(vicii.cycle_flags)) {
+        vicii_fetch_sprites(vicii.cycle_flags);
+    }
 
     /*
      *
@@ -487,29 +490,32 @@ int vicii_cycle(void)
      *
      */
 
-    /* Update sprite mcbase (Cycle 16 on PAL) */
-    /* if (vicii.raster_cycle == VICII_PAL_CYCLE(16)) { */
-    if (cycle_is_update_mcbase(vicii.cycle_flags)) {
-        sprite_mcbase_update();
-    }
+    /* most cycles have none of the sprite line events */
+    if (cycle_has_sprite_logic(vicii.cycle_flags)) {
+        /* Update sprite mcbase (Cycle 16 on PAL) */
+        /* if (vicii.raster_cycle == VICII_PAL_CYCLE(16)) { */
+        if (cycle_is_update_mcbase(vicii.cycle_flags)) {
+            sprite_mcbase_update();
+        }
 
-    /* Check sprite DMA (Cycles 55 & 56 on PAL) */
-    /* if (vicii.raster_cycle == VICII_PAL_CYCLE(55)
-       || vicii.raster_cycle == VICII_PAL_CYCLE(56) ) { */
-    if (cycle_is_check_spr_dma(vicii.cycle_flags)) {
-        check_sprite_dma();
-    }
+        /* Check sprite DMA (Cycles 55 & 56 on PAL) */
+        /* if (vicii.raster_cycle == VICII_PAL_CYCLE(55)
+           || vicii.raster_cycle == VICII_PAL_CYCLE(56) ) { */
+        if (cycle_is_check_spr_dma(vicii.cycle_flags)) {
+            check_sprite_dma();
+        }
 
-    /* Check sprite expansion flags (Cycle 56 on PAL) */
-    /* if (vicii.raster_cycle == VICII_PAL_CYCLE(56)) { */
-    if (cycle_is_check_spr_exp(vicii.cycle_flags)) {
-        check_exp();
-    }
+        /* Check sprite expansion flags (Cycle 56 on PAL) */
+        /* if (vicii.raster_cycle == VICII_PAL_CYCLE(56)) { */
+        if (cycle_is_check_spr_exp(vicii.cycle_flags)) {
+            check_exp();
+        }
 
-    /* Check sprite display (Cycle 58 on PAL) */
-    /* if (vicii.raster_cycle == VICII_PAL_CYCLE(58)) { */
-    if (cycle_is_check_spr_disp(vicii.cycle_flags)) {
-        check_sprite_display();
+        /* Check sprite display (Cycle 58 on PAL) */
+        /* if (vicii.raster_cycle == VICII_PAL_CYCLE(58)) { */
+        if (cycle_is_check_spr_disp(vicii.cycle_flags)) {
+            check_sprite_display();
+        }
     }
 
     /******
@@ -538,28 +544,30 @@ int vicii_cycle(void)
     }
     vsp_ysmoothold = vicii.ysmooth;
 
-    /* Update VC (Cycle 14 on PAL) */
-    /*  if (vicii.raster_cycle == VICII_PAL_CYCLE(14)) { */
-    if (cycle_is_update_vc(vicii.cycle_flags)) {
-        vicii.vc = vicii.vcbase;
-        vicii.vmli = 0;
-        if (vicii.bad_line) {
-            vicii.rc = 0;
+    if (cycle_has_vcrc_logic(vicii.cycle_flags)) {
+        /* Update VC (Cycle 14 on PAL) */
+        /*  if (vicii.raster_cycle == VICII_PAL_CYCLE(14)) { */
+        if (cycle_is_update_vc(vicii.cycle_flags)) {
+            vicii.vc = vicii.vcbase;
+            vicii.vmli = 0;
+            if (vicii.bad_line) {
+                vicii.rc = 0;
+            }
         }
-    }
 
-    /* Update RC (Cycle 58 on PAL) */
-    /* if (vicii.raster_cycle == VICII_PAL_CYCLE(58)) { */
-    if (cycle_is_update_rc(vicii.cycle_flags)) {
-        /* `rc' makes the chip go to idle state when it reaches the
-           maximum value.  */
-        if (vicii.rc == 7) {
-            vicii.idle_state = 1;
-            vicii.vcbase = vicii.vc;
-        }
-        if (!vicii.idle_state || vicii.bad_line) {
-            vicii.rc = (vicii.rc + 1) & 0x7;
-            vicii.idle_state = 0;
+        /* Update RC (Cycle 58 on PAL) */
+        /* if (vicii.raster_cycle == VICII_PAL_CYCLE(58)) { */
+        if (cycle_is_update_rc(vicii.cycle_flags)) {
+            /* `rc' makes the chip go to idle state when it reaches the
+               maximum value.  */
+            if (vicii.rc == 7) {
+                vicii.idle_state = 1;
+                vicii.vcbase = vicii.vc;
+            }
+            if (!vicii.idle_state || vicii.bad_line) {
+                vicii.rc = (vicii.rc + 1) & 0x7;
+                vicii.idle_state = 0;
+            }
         }
     }
 
@@ -575,7 +583,9 @@ int vicii_cycle(void)
     }
 
     /* Check BA for Sprite Phi2 fetch */
-    ba_low |= vicii_check_sprite_ba(vicii.cycle_flags);
+    if (cycle_get_sprite_ba_mask(vicii.cycle_flags)) {
+        ba_low |= vicii_check_sprite_ba(vicii.cycle_flags);
+    }
 
     /* if ba_low transitioning from non-active to active, always count
        3 cycles before allowing any Phi2 accesses. */
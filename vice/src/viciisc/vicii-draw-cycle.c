@@ -141,6 +141,34 @@ static const uint8_t colors[] = {
     COL_NONE, COL_NONE, COL_NONE, COL_NONE          /* ECM=1 BMM=1 MCM=1 */
 };
 
+/* resolve the colors that come from the vbuf and cbuf registers */
+static DRAW_INLINE uint8_t resolve_color(uint8_t cc)
+{
+    switch (cc) {
+        case COL_NONE:
+            cc = 0;
+            break;
+        case COL_VBUF_L:
+            cc = vbuf_reg & 0x0f;
+            break;
+        case COL_VBUF_H:
+            cc = vbuf_reg >> 4;
+            break;
+        case COL_CBUF:
+            cc = cbuf_reg;
+            break;
+        case COL_CBUF_MC:
+            cc = cbuf_reg & 0x07;
+            break;
+        case COL_D02X_EXT:
+            cc = COL_D021 + (vbuf_reg >> 6);
+            break;
+        default:
+            break;
+    }
+    return cc;
+}
+
 static DRAW_INLINE void draw_graphics(int i)
 {
     uint8_t px;
@@ -197,69 +225,105 @@ static DRAW_INLINE void draw_graphics(int i)
     cc = colors[vmode | px];
 
     /* lookup colors and render pixel */
-    switch (cc) {
-        case COL_NONE:
-            cc = 0;
-            break;
-        case COL_VBUF_L:
-            cc = vbuf_reg & 0x0f;
-            break;
-        case COL_VBUF_H:
-            cc = vbuf_reg >> 4;
-            break;
-        case COL_CBUF:
-            cc = cbuf_reg;
-            break;
-        case COL_CBUF_MC:
-            cc = cbuf_reg & 0x07;
-            break;
-        case COL_D02X_EXT:
-            cc = COL_D021 + (vbuf_reg >> 6);
-            break;
-        default:
-            break;
-    }
+    cc = resolve_color(cc);
 
     render_buffer[i] = cc;
     pri_buffer[i] = pixel_pri;
 }
 
+/*
+ * Render the pixels from..to-1 of an idle cycle as one span.
+ *
+ * While the gbuf shift register, its pipe and the pixel register are all
+ * zero every pixel is background (px = 0), so the color can only change
+ * when vbuf/cbuf are latched at xscroll or when the video mode changes.
+ * The latter happens only between spans.  If the border covers the whole
+ * cycle the colors are skipped, draw_border8() overwrites them anyway.
+ */
+static DRAW_INLINE void draw_graphics_span(int from, int to, int covered)
+{
+    if (xscroll_pipe >= from && xscroll_pipe < to) {
+        if (!covered && xscroll_pipe > from) {
+            memset(&render_buffer[from], resolve_color(colors[vmode11_pipe | vmode16_pipe]),
+                   (size_t)(xscroll_pipe - from));
+        }
+        /* latch values at time xs (gbuf_pipe1_reg is 0 here) */
+        vbuf_reg = vbuf_pipe1_reg;
+        cbuf_reg = cbuf_pipe1_reg;
+        gbuf_mc_flop = 1;
+        from = xscroll_pipe;
+    }
+    if (!covered) {
+        memset(&render_buffer[from], resolve_color(colors[vmode11_pipe | vmode16_pipe]),
+               (size_t)(to - from));
+    }
+    gbuf_mc_flop ^= (to - from) & 1;
+}
+
 static DRAW_INLINE void draw_graphics8(unsigned int cycle_flags)
 {
     int vis_en;
 
     vis_en = cycle_is_visible(cycle_flags);
 
-    /* render pixels */
-    /* pixel 0 */
-    draw_graphics(0);
-    /* pixel 1 */
-    draw_graphics(1);
-    /* pixel 2 */
-    draw_graphics(2);
-    /* pixel 3 */
-    draw_graphics(3);
-    /* pixel 4 */
-    vmode16_pipe = ( vicii.regs[0x16] & 0x10 ) >> 2;
-    if (vicii.color_latency) {
-        /* handle rising edge of internal signal */
-        vmode11_pipe |= ( vicii.regs[0x11] & 0x60 ) >> 2;
-    }
-    draw_graphics(4);
-    /* pixel 5 */
-    draw_graphics(5);
-    /* pixel 6 */
-    if (vicii.color_latency) {
-        /* handle falling edge of internal signal */
-        vmode11_pipe &= ( vicii.regs[0x11] & 0x60 ) >> 2;
-    }
-    draw_graphics(6);
-    /* pixel 7 */
-    if (vmode16_pipe && !vmode16_pipe2) {
-        gbuf_mc_flop = 0;
+    if ((gbuf_reg | gbuf_pipe1_reg | gbuf_pixel_reg) == 0) {
+        /* idle cycle, render spans between the video mode changes */
+        int covered = border_state && vicii.main_border;
+
+        memset(pri_buffer, 0, sizeof(pri_buffer));
+        /* pixel 0-3 */
+        draw_graphics_span(0, 4, covered);
+        /* pixel 4-5 */
+        vmode16_pipe = ( vicii.regs[0x16] & 0x10 ) >> 2;
+        if (vicii.color_latency) {
+            /* handle rising edge of internal signal */
+            vmode11_pipe |= ( vicii.regs[0x11] & 0x60 ) >> 2;
+        }
+        draw_graphics_span(4, 6, covered);
+        /* pixel 6 */
+        if (vicii.color_latency) {
+            /* handle falling edge of internal signal */
+            vmode11_pipe &= ( vicii.regs[0x11] & 0x60 ) >> 2;
+        }
+        draw_graphics_span(6, 7, covered);
+        /* pixel 7 */
+        if (vmode16_pipe && !vmode16_pipe2) {
+            gbuf_mc_flop = 0;
+        }
+        vmode16_pipe2 = vmode16_pipe;
+        draw_graphics_span(7, 8, covered);
+    } else {
+        /* render pixels */
+        /* pixel 0 */
+        draw_graphics(0);
+        /* pixel 1 */
+        draw_graphics(1);
+        /* pixel 2 */
+        draw_graphics(2);
+        /* pixel 3 */
+        draw_graphics(3);
+        /* pixel 4 */
+        vmode16_pipe = ( vicii.regs[0x16] & 0x10 ) >> 2;
+        if (vicii.color_latency) {
+            /* handle rising edge of internal signal */
+            vmode11_pipe |= ( vicii.regs[0x11] & 0x60 ) >> 2;
+        }
+        draw_graphics(4);
+        /* pixel 5 */
+        draw_graphics(5);
+        /* pixel 6 */
+        if (vicii.color_latency) {
+            /* handle falling edge of internal signal */
+            vmode11_pipe &= ( vicii.regs[0x11] & 0x60 ) >> 2;
+        }
+        draw_graphics(6);
+        /* pixel 7 */
+        if (vmode16_pipe && !vmode16_pipe2) {
+            gbuf_mc_flop = 0;
+        }
+        vmode16_pipe2 = vmode16_pipe;
+        draw_graphics(7);
     }
-    vmode16_pipe2 = vmode16_pipe;
-    draw_graphics(7);
 
     if (!vicii.color_latency) {
         vmode11_pipe = ( vicii.regs[0x11] & 0x60 ) >> 2;
@@ -484,7 +548,12 @@ static DRAW_INLINE void draw_sprites8(unsigned int cycle_flags)
     if (cycle_is_sprite_dma1_dma2(cycle_flags)) {
         dma_cycle_2 = 1 << cycle_get_sprite_num(cycle_flags);
     }
-    candidate_bits = get_trigger_candidates(xpos);
+    /* the candidates only matter if a sprite is or may become pending */
+    if (sprite_pending_bits || (spr_en && vicii.sprite_display_bits)) {
+        candidate_bits = get_trigger_candidates(xpos);
+    } else {
+        candidate_bits = 0;
+    }
 
     /* process and render sprites */
     /* pixel 0 */
@@ -75,6 +75,7 @@
 struct video_canvas_s;
 struct video_cbm_palette_s;
 struct viewport_s;
+struct video_render_snapshot_s;
 struct geometry_s;
 struct palette_s;
 
@@ -86,6 +87,9 @@ struct canvas_refresh_s {
 };
 typedef struct canvas_refresh_s canvas_refresh_t;
 
+/* Number of lines of padding above and below the draw buffer, see draw_buffer_padded_allocations */
+#define DRAW_BUFFER_PADDING_LINES   2
+
 struct draw_buffer_s {
     /* The real drawing buffers, with padding bytes on either side to workaround CRT and Scale2x bugs */
     uint8_t *draw_buffer_padded_allocations[2];
@@ -151,8 +155,13 @@ typedef struct video_chip_cap_s video_chip_cap_t;
 
 #define VIDEO_MAX_OUTPUT_WIDTH  2048
 
+/* Maximum number of horizontal bands a frame is split into for rendering,
+   see the VideoRenderThreads resource */
+#define VIDEO_RENDER_BANDS_MAX  16
+
 struct video_render_color_tables_s {
     int updated;                /* tables here are up to date */
+    unsigned int generation;    /* incremented each time the tables are recalculated */
     uint32_t physical_colors[256];
     int32_t ytableh[256];        /* y for current pixel */
     int32_t ytablel[256];        /* y for neighbouring pixels */
@@ -168,9 +177,6 @@ struct video_render_color_tables_s {
     /* YUV table for hardware rendering: (Y << 16) | (U << 8) | V */
     int yuv_updated;            /* yuv table updated for packed mode */
     uint32_t yuv_table[512];
-    int32_t line_yuv_0[VIDEO_MAX_OUTPUT_WIDTH * 3];
-    int16_t prevrgbline[VIDEO_MAX_OUTPUT_WIDTH * 3];
-    uint8_t rgbscratchbuffer[VIDEO_MAX_OUTPUT_WIDTH * 4];
 
     /*
      * All values below here formerly were globals in video-color.h.
@@ -193,6 +199,15 @@ struct video_render_color_tables_s {
 };
 typedef struct video_render_color_tables_s video_render_color_tables_t;
 
+/* Lines the CRT emulation renderers work in. The color tables are only read
+   while rendering, so renders running at the same time can share them, but
+   each needs its own scratch lines. */
+typedef struct video_render_scratch_s {
+    int32_t line_yuv_0[VIDEO_MAX_OUTPUT_WIDTH * 3];
+    int16_t prevrgbline[VIDEO_MAX_OUTPUT_WIDTH * 3];
+    uint8_t rgbscratchbuffer[VIDEO_MAX_OUTPUT_WIDTH * 4];
+} video_render_scratch_t;
+
 /* options for the color generator and crt emulation */
 typedef struct video_resources_s {
     /* parameters for color generation */
@@ -244,10 +259,24 @@ struct video_render_config_s {
     int fullscreen_mode[FULLSCREEN_MAXDEV];
     int fullscreen_custom_width; /* currently used only in the SDL port */
     int fullscreen_custom_height; /* currently used only in the SDL port */
+    /* scratch lines of each band, allocated on first use, see video_render_main() */
+    video_render_scratch_t *band_scratch[VIDEO_RENDER_BANDS_MAX];
+    /* render time of each band, not copied by video_render_copyconfig() */
+    unsigned int band_count;       /* number of bands the last frame was split into */
+    unsigned int band_time_last[VIDEO_RENDER_BANDS_MAX];  /* render time of each band in the last frame, in ticks */
+    uint64_t band_time_total[VIDEO_RENDER_BANDS_MAX];     /* accumulated render time of each band, in ticks */
+    unsigned int band_frames;      /* number of frames accumulated in band_time_total */
 };
 typedef struct video_render_config_s video_render_config_t;
 
+/* copy of a render config taken with the draw buffer, see video_canvas_draw_buffer_copy() */
+typedef struct video_render_snapshot_s video_render_snapshot_t;
+
 void video_render_initconfig(video_render_config_t *config);
+void video_render_shutdownconfig(video_render_config_t *config);
+void video_render_copyconfig(video_render_config_t *dst, const video_render_config_t *src);
+void video_render_set_threads(int threads);
+unsigned int video_render_get_band_times(video_render_config_t *config, unsigned int *last, unsigned int *average, unsigned int max);
 void video_render_setphysicalcolor(video_render_config_t *config, int index, uint32_t color, int depth);
 void video_render_setrawrgb(video_render_color_tables_t *color_tab, unsigned int index, uint32_t r, uint32_t g, uint32_t b);
 void video_render_setrawalpha(video_render_color_tables_t *color_tab, uint32_t a);
@@ -278,6 +307,11 @@ void video_canvas_map(struct video_canvas_s *canvas);
 void video_canvas_unmap(struct video_canvas_s *canvas);
 void video_canvas_resize(struct video_canvas_s *canvas, char resize_canvas);
 void video_canvas_render(struct video_canvas_s *canvas, uint8_t *trg, int width, int height, int xs, int ys, int xt, int yt, int pitcht);
+unsigned int video_canvas_draw_buffer_copy_size(struct video_canvas_s *canvas);
+struct video_render_snapshot_s *video_canvas_render_snapshot_new(void);
+void video_canvas_render_snapshot_free(struct video_render_snapshot_s *snapshot);
+void video_canvas_draw_buffer_copy(struct video_canvas_s *canvas, uint8_t *dst, unsigned int *pitch, struct video_render_snapshot_s *snapshot, int width, int height, int xs, int ys);
+void video_canvas_render_copy(struct video_render_snapshot_s *snapshot, const uint8_t *src, unsigned int pitchs, uint8_t *trg, int width, int height, int xs, int ys, int xt, int yt, int pitcht);
 void video_canvas_refresh_all(struct video_canvas_s *canvas);
 char video_canvas_can_resize(struct video_canvas_s *canvas);
 void video_viewport_get(struct video_canvas_s *canvas, struct viewport_s **viewport, struct geometry_s **geometry);
@@ -91,7 +91,7 @@ render_generic_1x1_ntsc(video_render_color_tables_t *color_tab, const uint8_t *s
     uint8_t *tmptrg;
     unsigned int x, y;
     int32_t l1, l2, u1, u2, v1, v2, unew, vnew;
-    uint8_t cl0, cl1, cl2, cl3;
+    uint8_t cl1, cl2, cl3;
     int off_flip;
 
     /* ensure starting on even coords */
@@ -115,29 +115,36 @@ render_generic_1x1_ntsc(video_render_color_tables_t *color_tab, const uint8_t *s
         cbtable = yuvtarget ? color_tab->cutable : color_tab->cbtable;
         crtable = yuvtarget ? color_tab->cvtable : color_tab->crtable;
 
+        /* the chroma of each pixel is the sum over a window of four source
+           pixels, which is kept as a running sum */
+        unew = cbtable[tmpsrc[0]] + cbtable[tmpsrc[1]] + cbtable[tmpsrc[2]];
+        vnew = crtable[tmpsrc[0]] + crtable[tmpsrc[1]] + crtable[tmpsrc[2]];
+
         /* one scanline */
         for (x = 0; x < width; x++) {
-            cl0 = tmpsrc[0];
             cl1 = tmpsrc[1];
             cl2 = tmpsrc[2];
             cl3 = tmpsrc[3];
-            tmpsrc += 1;
             l1 = ytablel[cl1] + ytableh[cl2] + ytablel[cl3];
-            unew = cbtable[cl0] + cbtable[cl1] + cbtable[cl2] + cbtable[cl3];
-            vnew = crtable[cl0] + crtable[cl1] + crtable[cl2] + crtable[cl3];
+            unew += cbtable[cl3];
+            vnew += crtable[cl3];
             u1 = (unew) * off_flip;
             v1 = (vnew) * off_flip;
+            unew -= cbtable[tmpsrc[0]];
+            vnew -= crtable[tmpsrc[0]];
+            tmpsrc += 1;
 
-            cl0 = tmpsrc[0];
             cl1 = tmpsrc[1];
             cl2 = tmpsrc[2];
             cl3 = tmpsrc[3];
-            tmpsrc += 1;
             l2 = ytablel[cl1] + ytableh[cl2] + ytablel[cl3];
-            unew = cbtable[cl0] + cbtable[cl1] + cbtable[cl2] + cbtable[cl3];
-            vnew = crtable[cl0] + crtable[cl1] + crtable[cl2] + crtable[cl3];
+            unew += cbtable[cl3];
+            vnew += crtable[cl3];
             u2 = (unew) * off_flip;
             v2 = (vnew) * off_flip;
+            unew -= cbtable[tmpsrc[0]];
+            vnew -= crtable[tmpsrc[0]];
+            tmpsrc += 1;
 
             store_pixel_4(color_tab, tmptrg, l1, u1, v1, l2, u2, v2);
             tmptrg += pixelstride;
@@ -70,7 +70,8 @@ void store_pixel_4(video_render_color_tables_t *color_tab, uint8_t *trg, int32_t
 
 /* PAL 1x1 renderers */
 static inline void
-render_generic_1x1_pal(video_render_color_tables_t *color_tab, const uint8_t *src, uint8_t *trg,
+render_generic_1x1_pal(video_render_color_tables_t *color_tab, video_render_scratch_t *scratch,
+                       const uint8_t *src, uint8_t *trg,
                        unsigned int width, const unsigned int height,
                        unsigned int xs, const unsigned int ys,
                        unsigned int xt, const unsigned int yt,
@@ -86,7 +87,7 @@ render_generic_1x1_pal(video_render_color_tables_t *color_tab, const uint8_t *sr
     uint8_t *tmptrg;
     unsigned int x, y;
     int32_t *line, l1, l2, u1, u2, v1, v2, unew, vnew;
-    uint8_t cl0, cl1, cl2, cl3;
+    uint8_t cl1, cl2, cl3;
     int off, off_flip;
 
     /* ensure starting on even coords */
@@ -99,7 +100,7 @@ render_generic_1x1_pal(video_render_color_tables_t *color_tab, const uint8_t *sr
     src = src + pitchs * ys + xs - 2;
     trg = trg + pitcht * yt + (xt >> 1) * pixelstride;
 
-    line = color_tab->line_yuv_0;
+    line = scratch->line_yuv_0;
     tmpsrc = ys > 0 ? src - pitchs : src;
 
     /* is the previous line odd or even? (inverted condition!) */
@@ -111,15 +112,18 @@ render_generic_1x1_pal(video_render_color_tables_t *color_tab, const uint8_t *sr
         crtable = yuvtarget ? color_tab->cvtable_odd : color_tab->crtable_odd;
     }
 
-    /* prepare previous (delay-)line */
+    /* prepare previous (delay-)line, the chroma of each pixel is the sum over
+       a window of four source pixels, which is kept as a running sum */
+    unew = cbtable[tmpsrc[0]] + cbtable[tmpsrc[1]] + cbtable[tmpsrc[2]];
+    vnew = crtable[tmpsrc[0]] + crtable[tmpsrc[1]] + crtable[tmpsrc[2]];
     for (x = 0; x < width; x++) {
-        cl0 = tmpsrc[0];
-        cl1 = tmpsrc[1];
-        cl2 = tmpsrc[2];
-        cl3 = tmpsrc[3];
-        tmpsrc += 1;
-        line[0] = (cbtable[cl0] + cbtable[cl1] + cbtable[cl2] + cbtable[cl3]);
-        line[1] = (crtable[cl0] + crtable[cl1] + crtable[cl2] + crtable[cl3]);
+        unew += cbtable[tmpsrc[3]];
+        vnew += crtable[tmpsrc[3]];
+        line[0] = unew;
+        line[1] = vnew;
+        unew -= cbtable[tmpsrc[0]];
+        vnew -= crtable[tmpsrc[0]];
+        tmpsrc++;
         line += 2;
     }
 
@@ -132,7 +136,7 @@ render_generic_1x1_pal(video_render_color_tables_t *color_tab, const uint8_t *sr
         tmpsrc = src;
         tmptrg = trg;
 
-        line = color_tab->line_yuv_0;
+        line = scratch->line_yuv_0;
 
         if (y & 1) { /* odd sourceline */
             off_flip = off;
@@ -144,35 +148,42 @@ render_generic_1x1_pal(video_render_color_tables_t *color_tab, const uint8_t *sr
             crtable = yuvtarget ? color_tab->cvtable : color_tab->crtable;
         }
 
-        /* one scanline */
+        unew = cbtable[tmpsrc[0]] + cbtable[tmpsrc[1]] + cbtable[tmpsrc[2]];
+        vnew = crtable[tmpsrc[0]] + crtable[tmpsrc[1]] + crtable[tmpsrc[2]];
+
+        /* one scanline, kept scalar: the chroma sums carry from pixel to
+           pixel, and every pixel gathers from the y, chroma and gamma
+           tables */
         for (x = 0; x < width; x++) {
-            cl0 = tmpsrc[0];
             cl1 = tmpsrc[1];
             cl2 = tmpsrc[2];
             cl3 = tmpsrc[3];
-            tmpsrc += 1;
             l1 = ytablel[cl1] + ytableh[cl2] + ytablel[cl3];
-            unew = cbtable[cl0] + cbtable[cl1] + cbtable[cl2] + cbtable[cl3];
-            vnew = crtable[cl0] + crtable[cl1] + crtable[cl2] + crtable[cl3];
+            unew += cbtable[cl3];
+            vnew += crtable[cl3];
             u1 = (unew + line[0]) * off_flip;
             v1 = (vnew + line[1]) * off_flip;
             line[0] = unew;
             line[1] = vnew;
             line += 2;
+            unew -= cbtable[tmpsrc[0]];
+            vnew -= crtable[tmpsrc[0]];
+            tmpsrc += 1;
 
-            cl0 = tmpsrc[0];
             cl1 = tmpsrc[1];
             cl2 = tmpsrc[2];
             cl3 = tmpsrc[3];
-            tmpsrc += 1;
             l2 = ytablel[cl1] + ytableh[cl2] + ytablel[cl3];
-            unew = cbtable[cl0] + cbtable[cl1] + cbtable[cl2] + cbtable[cl3];
-            vnew = crtable[cl0] + crtable[cl1] + crtable[cl2] + crtable[cl3];
+            unew += cbtable[cl3];
+            vnew += crtable[cl3];
             u2 = (unew + line[0]) * off_flip;
             v2 = (vnew + line[1]) * off_flip;
             line[0] = unew;
             line[1] = vnew;
             line += 2;
+            unew -= cbtable[tmpsrc[0]];
+            vnew -= crtable[tmpsrc[0]];
+            tmpsrc += 1;
 
             store_pixel_4(color_tab, tmptrg, l1, u1, v1, l2, u2, v2);
             tmptrg += pixelstride;
@@ -185,13 +196,14 @@ render_generic_1x1_pal(video_render_color_tables_t *color_tab, const uint8_t *sr
 
 void
 render_32_1x1_pal(video_render_color_tables_t *color_tab,
+                  video_render_scratch_t *scratch,
                   const uint8_t *src, uint8_t *trg,
                   const unsigned int width, const unsigned int height,
                   const unsigned int xs, const unsigned int ys,
                   const unsigned int xt, const unsigned int yt,
                   const unsigned int pitchs, const unsigned int pitcht, video_render_config_t *config)
 {
-    render_generic_1x1_pal(color_tab, src, trg, width, height, xs, ys, xt, yt,
+    render_generic_1x1_pal(color_tab, scratch, src, trg, width, height, xs, ys, xt, yt,
                            pitchs, pitcht,
                            8, 0, config);
 }
@@ -102,6 +102,7 @@ void get_yuv_from_video(
 
 static inline
 void render_generic_1x2_rgbi(video_render_color_tables_t *color_tab,
+                            video_render_scratch_t *scratch,
                             const uint8_t *src, uint8_t *trg,
                             unsigned int width, const unsigned int height,
                             unsigned int xs, const unsigned int ys,
@@ -155,7 +156,7 @@ void render_generic_1x2_rgbi(video_render_color_tables_t *color_tab,
             if (y == yys || y <= (unsigned int)first_line || y > (unsigned int)(last_line + 1)) {
                 break;
             }
-            tmptrg = &color_tab->rgbscratchbuffer[0];
+            tmptrg = &scratch->rgbscratchbuffer[0];
             tmptrgscanline = trg - pitcht;
             if (y == (unsigned int)(last_line + 1)) {
                 /* src would point after the source area, so rewind one line */
@@ -170,7 +171,7 @@ void render_generic_1x2_rgbi(video_render_color_tables_t *color_tab,
              * yet initialized and scanline data would be bogus! */
             tmptrgscanline = y != yys && y > (unsigned int)first_line && y <= (unsigned int)last_line
                              ? trg - pitcht
-                             : &color_tab->rgbscratchbuffer[0];
+                             : &scratch->rgbscratchbuffer[0];
         }
 
         /* current source image for YUV xform */
@@ -188,7 +189,7 @@ void render_generic_1x2_rgbi(video_render_color_tables_t *color_tab,
         tmpsrc += 1;
 
         /* actual line */
-        prevrgblineptr = &color_tab->prevrgbline[0];
+        prevrgblineptr = &scratch->prevrgbline[0];
         if (wfirst) {
             l2 = ytablel[tmpsrc[1]] + ytableh[tmpsrc[2]] + ytablel[tmpsrc[3]];
             unew += cbtable[tmpsrc[3]];
@@ -263,6 +264,7 @@ void render_generic_1x2_rgbi(video_render_color_tables_t *color_tab,
 }
 
 void render_32_1x2_rgbi(video_render_color_tables_t *color_tab,
+                       video_render_scratch_t *scratch,
                        const uint8_t *src, uint8_t *trg,
                        unsigned int width, const unsigned int height,
                        const unsigned int xs, const unsigned int ys,
@@ -280,7 +282,7 @@ void render_32_1x2_rgbi(video_render_color_tables_t *color_tab,
         render_32_1x2_interlaced(color_tab, src, trg, width, height, xs, ys,
                                  xt, yt, pitchs, pitcht, config, (color_tab->physical_colors[0] & 0x00ffffff) | 0x7f000000);
     } else {
-        render_generic_1x2_rgbi(color_tab, src, trg, width, height, xs, ys,
+        render_generic_1x2_rgbi(color_tab, scratch, src, trg, width, height, xs, ys,
                                xt, yt, pitchs, pitcht, viewport_first_line, viewport_last_line,
                                4, 1, config);
     }
@@ -32,6 +32,7 @@
 #include "viewport.h"
 
 void render_32_2x2_pal_u(video_render_color_tables_t *colortab,
+                         video_render_scratch_t *scratch,
                          const uint8_t *src, uint8_t *trg,
                          unsigned int width, const unsigned int height,
                          const unsigned int xs, const unsigned int ys,
@@ -87,6 +87,7 @@ void get_yuv_from_video(
 
 static inline
 void render_generic_2x4_rgbi(video_render_color_tables_t *color_tab,
+                            video_render_scratch_t *scratch,
                             const uint8_t *src, uint8_t *trg,
                             unsigned int width, const unsigned int height,
                             unsigned int xs, const unsigned int ys,
@@ -136,7 +137,7 @@ void render_generic_2x4_rgbi(video_render_color_tables_t *color_tab,
             if ((y + 1) == yys || (y + 1) <= (viewport_first_line * 4) || (y + 1) > (viewport_last_line * 4)) {
                 break;
             }
-            tmptrg2 = &color_tab->rgbscratchbuffer[0];
+            tmptrg2 = &scratch->rgbscratchbuffer[0];
             tmptrgscanline2 = trg - pitcht;
         } else {
             /* pixel data to surface */
@@ -147,7 +148,7 @@ void render_generic_2x4_rgbi(video_render_color_tables_t *color_tab,
              * yet initialized and scanline data would be bogus! */
             tmptrgscanline2 = ((y + 0) != yys) && ((y + 0) > viewport_first_line * 4) && ((y + 0) <= viewport_last_line * 4)
                               ? trg - pitcht
-                              : &color_tab->rgbscratchbuffer[0];
+                              : &scratch->rgbscratchbuffer[0];
         }
         if (y == yys + height) {
             /* no place to put scanline in: we are outside viewport or still
@@ -155,7 +156,7 @@ void render_generic_2x4_rgbi(video_render_color_tables_t *color_tab,
             if (y == yys || y <= viewport_first_line * 4 || y > viewport_last_line * 4) {
                 break;
             }
-            tmptrg1 = &color_tab->rgbscratchbuffer[0];
+            tmptrg1 = &scratch->rgbscratchbuffer[0];
             tmptrgscanline1 = trg - (pitcht * 2);
         } else {
             /* pixel data to surface */
@@ -166,7 +167,7 @@ void render_generic_2x4_rgbi(video_render_color_tables_t *color_tab,
              * yet initialized and scanline data would be bogus! */
             tmptrgscanline1 = (y != yys) && (y > viewport_first_line * 4) && (y <= viewport_last_line * 4)
                               ? trg - (pitcht * 2)
-                              : &color_tab->rgbscratchbuffer[0];
+                              : &scratch->rgbscratchbuffer[0];
         }
 
         /* current source image for YUV xform */
@@ -184,7 +185,7 @@ void render_generic_2x4_rgbi(video_render_color_tables_t *color_tab,
         tmpsrc += 1;
 
         /* actual line */
-        prevrgblineptr = &color_tab->prevrgbline[0];
+        prevrgblineptr = &scratch->prevrgbline[0];
         if (wfirst) {
             l2 = ytablel[tmpsrc[1]] + ytableh[tmpsrc[2]] + ytablel[tmpsrc[3]];
             unew += cbtable[tmpsrc[3]];
@@ -250,6 +251,7 @@ void render_generic_2x4_rgbi(video_render_color_tables_t *color_tab,
 }
 
 void render_32_2x4_rgbi(video_render_color_tables_t *color_tab,
+                       video_render_scratch_t *scratch,
                        const uint8_t *src, uint8_t *trg,
                        unsigned int width, const unsigned int height,
                        const unsigned int xs, const unsigned int ys,
@@ -267,7 +269,7 @@ void render_32_2x4_rgbi(video_render_color_tables_t *color_tab,
         render_32_2x4_interlaced(color_tab, src, trg, width, height, xs, ys,
                                  xt, yt, pitchs, pitcht, config, (color_tab->physical_colors[0] & 0x00ffffff) | 0x7f000000);
     } else {
-        render_generic_2x4_rgbi(color_tab, src, trg, width, height, xs, ys,
+        render_generic_2x4_rgbi(color_tab, scratch, src, trg, width, height, xs, ys,
                                xt, yt, pitchs, pitcht, viewport_first_line, viewport_last_line,
                                4, 1, config);
     }
@@ -38,6 +38,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "lib.h"
 #include "log.h"
@@ -46,6 +47,7 @@
 #include "video-canvas.h"
 #include "video-color.h"
 #include "video-render.h"
+#include "video-sound.h"
 #include "video.h"
 #include "viewport.h"
 
@@ -103,6 +105,7 @@ void video_canvas_shutdown(video_canvas_t *canvas)
             }
         }
 
+        video_render_shutdownconfig(canvas->videoconfig);
         lib_free(canvas->videoconfig);
         lib_free(canvas->draw_buffer);
         lib_free(canvas->viewport);
@@ -111,15 +114,10 @@ void video_canvas_shutdown(video_canvas_t *canvas)
     }
 }
 
-void video_canvas_render(video_canvas_t *canvas, uint8_t *trg, int width,
-                         int height, int xs, int ys, int xt, int yt,
-                         int pitcht)
+/* Update the color tables if the palette or color encoding changed */
+static void video_canvas_update_colors(video_canvas_t *canvas)
 {
     viewport_t *viewport = canvas->viewport;
-#ifdef VIDEO_SCALE_SOURCE
-    xs /= canvas->videoconfig->scalex;
-    ys /= canvas->videoconfig->scaley;
-#endif
 
     /* when the color encoding changed, the palette must be recalculated */
     if (viewport->crt_type != canvas->crt_type) {
@@ -130,10 +128,143 @@ void video_canvas_render(video_canvas_t *canvas, uint8_t *trg, int width,
     if (!canvas->videoconfig->color_tables.updated) { /* update colors as necessary */
         video_color_update_palette(canvas);
     }
+}
+
+void video_canvas_render(video_canvas_t *canvas, uint8_t *trg, int width,
+                         int height, int xs, int ys, int xt, int yt,
+                         int pitcht)
+{
+#ifdef VIDEO_SCALE_SOURCE
+    xs /= canvas->videoconfig->scalex;
+    ys /= canvas->videoconfig->scaley;
+#endif
+
+    video_canvas_update_colors(canvas);
+
+    if (width > 0) {
+        video_sound_update(canvas->videoconfig, canvas->draw_buffer->draw_buffer,
+                           width, height, xs, ys,
+                           canvas->draw_buffer->draw_buffer_width, canvas->viewport);
+    }
+
     video_render_main(canvas->videoconfig, canvas->draw_buffer->draw_buffer,
                       trg, width, height, xs, ys, xt, yt,
                       canvas->draw_buffer->draw_buffer_width, pitcht,
-                      viewport);
+                      canvas->viewport);
+}
+
+/*
+ * Rendering from a copy of the draw buffer
+ *
+ * Renderers that want to do the color conversion and CRT emulation on
+ * another thread than the emulation take a copy of the draw buffer with
+ * video_canvas_draw_buffer_copy() on the emulation thread and later pass it
+ * to video_canvas_render_copy(). The copy includes the padding lines around
+ * the draw buffer, since the CRT filters read the lines above and below the
+ * rendered area.
+ *
+ * Together with the draw buffer, a snapshot of the render config, the color
+ * tables and the viewport is taken, so the render thread never looks at the
+ * canvas, whose config the emulation thread changes on palette updates and
+ * resizes. The snapshot also has its own scratch lines for the renderers.
+ */
+
+/* everything video_canvas_render_copy() needs from the canvas */
+struct video_render_snapshot_s {
+    video_render_config_t config;
+    viewport_t viewport;
+};
+
+/** \brief Allocate a snapshot for video_canvas_draw_buffer_copy() */
+video_render_snapshot_t *video_canvas_render_snapshot_new(void)
+{
+    video_render_snapshot_t *snapshot = lib_calloc(1, sizeof(video_render_snapshot_t));
+
+    video_render_initconfig(&snapshot->config);
+    return snapshot;
+}
+
+/** \brief Free a snapshot allocated by video_canvas_render_snapshot_new() */
+void video_canvas_render_snapshot_free(video_render_snapshot_t *snapshot)
+{
+    video_render_shutdownconfig(&snapshot->config);
+    lib_free(snapshot);
+}
+
+/** \brief Size in bytes needed for a copy of the draw buffer of \a canvas */
+unsigned int video_canvas_draw_buffer_copy_size(video_canvas_t *canvas)
+{
+    draw_buffer_t *draw_buffer = canvas->draw_buffer;
+
+    return draw_buffer->draw_buffer_width
+           * (draw_buffer->draw_buffer_height + DRAW_BUFFER_PADDING_LINES * 2);
+}
+
+/** \brief Copy the draw buffer and the render config of \a canvas
+ *
+ * Must be called on the emulation thread. Also brings the color tables up to
+ * date and does the video sound update for the area that is going to be
+ * rendered, so that video_canvas_render_copy() doesn't have to.
+ *
+ * \param[in]   canvas      canvas
+ * \param[out]  dst         buffer of at least video_canvas_draw_buffer_copy_size() bytes
+ * \param[out]  pitch       pitch of the copy in bytes
+ * \param[out]  snapshot    receives the render config, color tables and viewport
+ * \param[in]   width       width of the area that is going to be rendered
+ * \param[in]   height      height of the area that is going to be rendered
+ * \param[in]   xs          x offset of the area in the draw buffer
+ * \param[in]   ys          y offset of the area in the draw buffer
+ */
+void video_canvas_draw_buffer_copy(video_canvas_t *canvas, uint8_t *dst,
+                                   unsigned int *pitch, video_render_snapshot_t *snapshot,
+                                   int width, int height, int xs, int ys)
+{
+    draw_buffer_t *draw_buffer = canvas->draw_buffer;
+
+#ifdef VIDEO_SCALE_SOURCE
+    xs /= canvas->videoconfig->scalex;
+    ys /= canvas->videoconfig->scaley;
+#endif
+
+    video_canvas_update_colors(canvas);
+
+    if (width > 0) {
+        video_sound_update(canvas->videoconfig, draw_buffer->draw_buffer,
+                           width, height, xs, ys,
+                           draw_buffer->draw_buffer_width, canvas->viewport);
+    }
+
+    memcpy(dst,
+           draw_buffer->draw_buffer
+           - draw_buffer->draw_buffer_width * DRAW_BUFFER_PADDING_LINES,
+           video_canvas_draw_buffer_copy_size(canvas));
+    *pitch = draw_buffer->draw_buffer_width;
+
+    video_render_copyconfig(&snapshot->config, canvas->videoconfig);
+    snapshot->viewport = *canvas->viewport;
+}
+
+/** \brief Render a copy of the draw buffer made by video_canvas_draw_buffer_copy()
+ *
+ * Same as video_canvas_render(), except that the source buffer, the render
+ * config and the viewport all come from the copy. May be called from the
+ * render thread.
+ */
+void video_canvas_render_copy(video_render_snapshot_t *snapshot, const uint8_t *src,
+                              unsigned int pitchs, uint8_t *trg, int width,
+                              int height, int xs, int ys, int xt, int yt,
+                              int pitcht)
+{
+#ifdef VIDEO_SCALE_SOURCE
+    xs /= snapshot->config.scalex;
+    ys /= snapshot->config.scaley;
+#endif
+
+    video_render_main(&snapshot->config,
+                      /* video_render_main() wants a non-const pointer */
+                      (uint8_t *)src + pitchs * DRAW_BUFFER_PADDING_LINES,
+                      trg, width, height, xs, ys, xt, yt,
+                      pitchs, pitcht, &snapshot->viewport);
 }
 
 /** \brief Force refresh all tracked canvases.
@@ -36,8 +36,19 @@
 #include "util.h"
 #include "video.h"
 
+static const cmdline_option_t cmdline_options[] =
+{
+    { "-renderthreads", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
+      NULL, NULL, "VideoRenderThreads", NULL,
+      "<value>", "Set number of threads used to render a frame (1-16)" },
+    CMDLINE_LIST_END
+};
+
 int video_cmdline_options_init(void)
 {
+    if (cmdline_register_options(cmdline_options) < 0) {
+        return -1;
+    }
     return video_arch_cmdline_options_init();
 }
 
@@ -898,6 +898,7 @@ int video_color_update_palette(struct video_canvas_s *canvas)
         return 0;
     }
     canvas->videoconfig->color_tables.updated = 1;
+    canvas->videoconfig->color_tables.generation++;
 
     DBG(("video_color_update_palette cbm palette:%d extern: %d",
          canvas->videoconfig->cbm_palette ? 1 : 0, canvas->videoconfig->external_palette ? 1 : 0));
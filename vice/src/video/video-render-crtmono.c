@@ -51,6 +51,7 @@
 static int rendermode_error = -1;
 
 void video_render_crt_mono_main(video_render_config_t *config,
+                           video_render_scratch_t *scratch,
                            uint8_t *src, uint8_t *trg,
                            int width, int height, int xs, int ys, int xt,
                            int yt, int pitchs, int pitcht,
@@ -94,7 +95,7 @@ void video_render_crt_mono_main(video_render_config_t *config,
         case VIDEO_RENDER_CRT_MONO_1X2:
             if (crtemulation) {
                 /* FIXME: open end, this should use a dedicated monochrome CRT renderer */
-                render_32_1x2_rgbi(colortab, src, trg, width, height,
+                render_32_1x2_rgbi(colortab, scratch, src, trg, width, height,
                                   xs, ys, xt, yt, pitchs, pitcht,
                                   viewport_first_line, viewport_last_line,
                                   config);
@@ -112,7 +113,7 @@ void video_render_crt_mono_main(video_render_config_t *config,
                 return;
             } else if (crtemulation) {
                 /* FIXME: open end, this should use a dedicated monochrome CRT renderer */
-                render_32_2x2_rgbi(colortab, src, trg, width, height,
+                render_32_2x2_rgbi(colortab, scratch, src, trg, width, height,
                                   xs, ys, xt, yt, pitchs, pitcht,
                                   viewport_first_line, viewport_last_line, config);
                 return;
@@ -125,7 +126,7 @@ void video_render_crt_mono_main(video_render_config_t *config,
         case VIDEO_RENDER_CRT_MONO_2X4:
             if (crtemulation) {
                 /* FIXME: open end, this should use a dedicated monochrome CRT renderer */
-                render_32_2x4_rgbi(colortab, src, trg, width, height,
+                render_32_2x4_rgbi(colortab, scratch, src, trg, width, height,
                                   xs, ys, xt, yt, pitchs, pitcht,
                                   viewport_first_line, viewport_last_line, config);
                 return;
@@ -48,6 +48,7 @@
 
 
 void video_render_pal_ntsc_main(video_render_config_t *config,
+                           video_render_scratch_t *scratch,
                            uint8_t *src, uint8_t *trg,
                            int width, int height, int xs, int ys, int xt,
                            int yt, int pitchs, int pitcht,
@@ -89,7 +90,7 @@ void video_render_pal_ntsc_main(video_render_config_t *config,
                     default:
                         /* fall through */
                     case VIDEO_CRT_TYPE_PAL:
-                        render_32_1x1_pal(colortab, src, trg, width, height,
+                        render_32_1x1_pal(colortab, scratch, src, trg, width, height,
                                         xs, ys, xt, yt, pitchs, pitcht, config);
                         return;
                 }
@@ -103,7 +104,7 @@ void video_render_pal_ntsc_main(video_render_config_t *config,
             if (crtemulation) {
                 switch (crt_type) {
                     case VIDEO_CRT_TYPE_NTSC:
-                        render_32_2x2_ntsc(colortab, src, trg, width, height,
+                        render_32_2x2_ntsc(colortab, scratch, src, trg, width, height,
                                            xs, ys, xt, yt, pitchs, pitcht,
                                            viewport_first_line, viewport_last_line, config);
                         return;
@@ -112,12 +113,12 @@ void video_render_pal_ntsc_main(video_render_config_t *config,
                     case VIDEO_CRT_TYPE_PAL:
                         if (config->video_resources.delaylinetype == 1) {
                             /* delay U only (1084 style) */
-                            render_32_2x2_pal_u(colortab, src, trg, width, height,
+                            render_32_2x2_pal_u(colortab, scratch, src, trg, width, height,
                                                 xs, ys, xt, yt, pitchs, pitcht,
                                                 viewport_first_line, viewport_last_line, config);
                             return;
                         }
-                        render_32_2x2_pal(colortab, src, trg, width, height,
+                        render_32_2x2_pal(colortab, scratch, src, trg, width, height,
                                           xs, ys, xt, yt, pitchs, pitcht,
                                           viewport_first_line, viewport_last_line, config);
                         return;
@@ -51,6 +51,7 @@
 static int rendermode_error = -1;
 
 void video_render_rgbi_main(video_render_config_t *config,
+                           video_render_scratch_t *scratch,
                            uint8_t *src, uint8_t *trg,
                            int width, int height, int xs, int ys, int xt,
                            int yt, int pitchs, int pitcht,
@@ -92,7 +93,7 @@ void video_render_rgbi_main(video_render_config_t *config,
             break;
         case VIDEO_RENDER_RGBI_1X2:
             if (crtemulation) {
-                render_32_1x2_rgbi(colortab, src, trg, width, height,
+                render_32_1x2_rgbi(colortab, scratch, src, trg, width, height,
                                   xs, ys, xt, yt, pitchs, pitcht,
                                   viewport_first_line, viewport_last_line,
                                   config);
@@ -109,7 +110,7 @@ void video_render_rgbi_main(video_render_config_t *config,
                                   xs, ys, xt, yt, pitchs, pitcht);
                 return;
             } else if (crtemulation) {
-                render_32_2x2_rgbi(colortab, src, trg, width, height,
+                render_32_2x2_rgbi(colortab, scratch, src, trg, width, height,
                                   xs, ys, xt, yt, pitchs, pitcht,
                                   viewport_first_line, viewport_last_line, config);
                 return;
@@ -121,7 +122,7 @@ void video_render_rgbi_main(video_render_config_t *config,
             break;
         case VIDEO_RENDER_RGBI_2X4:
             if (crtemulation) {
-                render_32_2x4_rgbi(colortab, src, trg, width, height,
+                render_32_2x4_rgbi(colortab, scratch, src, trg, width, height,
                                   xs, ys, xt, yt, pitchs, pitcht,
                                   viewport_first_line, viewport_last_line, config);
                 return;
@@ -27,18 +27,28 @@
 
 #include "vice.h"
 
+#include <stddef.h>
 #include <stdio.h>
+#include <string.h>
 
+#include "archdep.h"
+#include "instrument.h"
+#include "lib.h"
 #include "log.h"
 #include "types.h"
 #include "video-render.h"
-#include "video-sound.h"
 #include "video.h"
 
 static render_pal_ntsc_func_t  render_pal_ntsc_func  = video_render_pal_ntsc_main;
 static render_rgbi_func_t render_rgbi_func = video_render_rgbi_main;
 static render_crt_mono_func_t render_crt_mono_func = video_render_crt_mono_main;
 
+/* Number of bands (and worker threads) a frame is split into */
+static int render_threads = 1;
+
+/* Bands are not made smaller than this number of source lines */
+#define RENDER_BAND_MIN_LINES   16
+
 void video_render_initconfig(video_render_config_t *config)
 {
     int i;
@@ -51,6 +61,26 @@ void video_render_initconfig(video_render_config_t *config)
     }
 }
 
+void video_render_shutdownconfig(video_render_config_t *config)
+{
+    int i;
+
+    for (i = 0; i < VIDEO_RENDER_BANDS_MAX; i++) {
+        lib_free(config->band_scratch[i]);
+        config->band_scratch[i] = NULL;
+    }
+}
+
+/** \brief Copy the render config and color tables of \a src to \a dst
+ *
+ * The scratch lines of \a dst are left alone, so \a dst can be rendered
+ * with independently of \a src.
+ */
+void video_render_copyconfig(video_render_config_t *dst, const video_render_config_t *src)
+{
+    memcpy(dst, src, offsetof(video_render_config_t, band_scratch));
+}
+
 /* called from archdep code */
 void video_render_setphysicalcolor(video_render_config_t *config, int index,
                                    uint32_t color, int depth)
@@ -71,23 +101,13 @@ void video_render_setphysicalcolor(video_render_config_t *config, int index,
 
 static int rendermode_error = -1;
 
-void video_render_main(video_render_config_t *config, uint8_t *src, uint8_t *trg,
-                       int width, int height, int xs, int ys, int xt, int yt,
-                       int pitchs, int pitcht, viewport_t *viewport)
+static void video_render_dispatch(video_render_config_t *config, video_render_scratch_t *scratch,
+                                  uint8_t *src, uint8_t *trg,
+                                  int width, int height, int xs, int ys, int xt, int yt,
+                                  int pitchs, int pitcht, viewport_t *viewport)
 {
     int rendermode;
 
-#if 0
-    log_debug(LOG_DEFAULT, "w:%i h:%i xs:%i ys:%i xt:%i yt:%i ps:%i pt:%i d%i",
-              width, height, xs, ys, xt, yt, pitchs, pitcht, depth);
-
-#endif
-    if (width <= 0) {
-        return; /* some render routines don't like invalid width */
-    }
-
-    video_sound_update(config, src, width, height, xs, ys, pitchs, viewport);
-
     rendermode = config->rendermode;
 
     switch (rendermode) {
@@ -97,7 +117,7 @@ void video_render_main(video_render_config_t *config, uint8_t *src, uint8_t *trg
 
         case VIDEO_RENDER_PAL_NTSC_1X1:
         case VIDEO_RENDER_PAL_NTSC_2X2:
-            render_pal_ntsc_func(config, src, trg, width, height, xs, ys, xt, yt, pitchs, pitcht,
+            render_pal_ntsc_func(config, scratch, src, trg, width, height, xs, ys, xt, yt, pitchs, pitcht,
                                  viewport->crt_type, viewport->first_line, viewport->last_line);
             return;
 
@@ -105,7 +125,7 @@ void video_render_main(video_render_config_t *config, uint8_t *src, uint8_t *trg
         case VIDEO_RENDER_CRT_MONO_1X2:
         case VIDEO_RENDER_CRT_MONO_2X2:
         case VIDEO_RENDER_CRT_MONO_2X4:
-            render_crt_mono_func(config, src, trg, width, height, xs, ys, xt, yt, pitchs, pitcht,
+            render_crt_mono_func(config, scratch, src, trg, width, height, xs, ys, xt, yt, pitchs, pitcht,
                                  viewport->first_line, viewport->last_line);
             return;
 
@@ -113,7 +133,7 @@ void video_render_main(video_render_config_t *config, uint8_t *src, uint8_t *trg
         case VIDEO_RENDER_RGBI_1X2:
         case VIDEO_RENDER_RGBI_2X2:
         case VIDEO_RENDER_RGBI_2X4:
-            render_rgbi_func(config, src, trg, width, height, xs, ys, xt, yt, pitchs, pitcht,
+            render_rgbi_func(config, scratch, src, trg, width, height, xs, ys, xt, yt, pitchs, pitcht,
                              viewport->first_line, viewport->last_line);
             return;
     }
@@ -123,6 +143,204 @@ void video_render_main(video_render_config_t *config, uint8_t *src, uint8_t *trg
     rendermode_error = rendermode;
 }
 
+/*
+ * Banded rendering
+ *
+ * The target is split into horizontal bands which are rendered in parallel.
+ * All bands read the same render config and color tables, but each band has
+ * its own scratch lines, as the renderers keep the PAL delay line, the
+ * previous RGB line for the scanlines and their scratch line there. Each band
+ * primes the delay line from the source line above it, just like when only a
+ * part of the screen is rendered, and the scanline between two bands is
+ * written by the upper one.
+ *
+ * The render time of each band is kept in the config that is rendered, for
+ * the render thread that is the snapshot taken with the draw buffer, and is
+ * handed to the instrumentation after each frame.
+ */
+
+/* Number of target lines of the smallest unit a frame can be split at for
+   the render modes that can be split into bands, 0 for the modes that can't.
+   \a src_lines is set to the number of source lines in that unit. */
+static int video_render_band_unit(int rendermode, int *src_lines)
+{
+    *src_lines = 1;
+
+    switch (rendermode) {
+        case VIDEO_RENDER_PAL_NTSC_1X1:
+        case VIDEO_RENDER_CRT_MONO_1X1:
+        case VIDEO_RENDER_RGBI_1X1:
+            return 1;
+        case VIDEO_RENDER_PAL_NTSC_2X2:
+        case VIDEO_RENDER_CRT_MONO_1X2:
+        case VIDEO_RENDER_CRT_MONO_2X2:
+        case VIDEO_RENDER_RGBI_1X2:
+        case VIDEO_RENDER_RGBI_2X2:
+            return 2;
+        case VIDEO_RENDER_CRT_MONO_2X4:
+        case VIDEO_RENDER_RGBI_2X4:
+            /* the interlace phase of the 2x4 renderers is derived from ys,
+               which only matches the line position every other source line */
+            *src_lines = 2;
+            return 8;
+    }
+    return 0;
+}
+
+/* Get the scratch lines of \a band, allocating them on first use */
+static video_render_scratch_t *video_render_band_scratch(video_render_config_t *config, int band)
+{
+    if (config->band_scratch[band] == NULL) {
+        config->band_scratch[band] = lib_malloc(sizeof(video_render_scratch_t));
+    }
+    return config->band_scratch[band];
+}
+
+static void video_render_bands(video_render_config_t *config, uint8_t *src, uint8_t *trg,
+                               int width, int height, int xs, int ys, int xt, int yt,
+                               int pitchs, int pitcht, viewport_t *viewport,
+                               int unit, int unit_src_lines, int bands)
+{
+    int band;
+    int units = height / unit;
+
+    /* allocate outside of the parallel section */
+    for (band = 0; band < bands; band++) {
+        video_render_band_scratch(config, band);
+    }
+
+#pragma omp parallel for num_threads(bands) schedule(static, 1)
+    for (band = 0; band < bands; band++) {
+        viewport_t band_viewport;
+        int first, last, band_height;
+        unsigned int shift;
+        tick_t start;
+
+        start = tick_now();
+
+        first = units * band / bands;
+        last = units * (band + 1) / bands;
+        band_height = (last - first) * unit;
+        if (band == bands - 1) {
+            band_height = height - first * unit;
+        }
+
+        /* The 2x4 renderers count lines from ys * 2 instead of ys * 4 when
+           comparing against the viewport, so shift the viewport to get the
+           same result as when the frame is rendered in one go. */
+        band_viewport = *viewport;
+        if (unit_src_lines > 1) {
+            shift = (unsigned int)(first * unit_src_lines / 2);
+            band_viewport.first_line = band_viewport.first_line > shift
+                                       ? band_viewport.first_line - shift : 0;
+            band_viewport.last_line = band_viewport.last_line > shift
+                                      ? band_viewport.last_line - shift : 0;
+        }
+
+        video_render_dispatch(config, config->band_scratch[band], src, trg, width, band_height,
+                              xs, ys + first * unit_src_lines, xt, yt + first * unit,
+                              pitchs, pitcht, &band_viewport);
+
+        config->band_time_last[band] = tick_now_delta(start);
+        config->band_time_total[band] += config->band_time_last[band];
+    }
+}
+
+void video_render_main(video_render_config_t *config, uint8_t *src, uint8_t *trg,
+                       int width, int height, int xs, int ys, int xt, int yt,
+                       int pitchs, int pitcht, viewport_t *viewport)
+{
+    int unit, unit_src_lines, bands;
+    tick_t start;
+
+#if 0
+    log_debug(LOG_DEFAULT, "w:%i h:%i xs:%i ys:%i xt:%i yt:%i ps:%i pt:%i d%i",
+              width, height, xs, ys, xt, yt, pitchs, pitcht, depth);
+
+#endif
+    if (width <= 0) {
+        return; /* some render routines don't like invalid width */
+    }
+
+    bands = 1;
+    unit = video_render_band_unit(config->rendermode, &unit_src_lines);
+#ifdef _OPENMP
+    if (unit > 0 && render_threads > 1) {
+        bands = height * unit_src_lines / (unit * RENDER_BAND_MIN_LINES);
+        if (bands > render_threads) {
+            bands = render_threads;
+        }
+        if (bands < 1) {
+            bands = 1;
+        }
+    }
+#endif
+
+    if (bands != (int)config->band_count) {
+        /* restart the statistics when the number of bands changes */
+        memset(config->band_time_total, 0, sizeof(config->band_time_total));
+        config->band_frames = 0;
+        config->band_count = (unsigned int)bands;
+    }
+    config->band_frames++;
+
+    if (bands > 1) {
+        video_render_bands(config, src, trg, width, height, xs, ys, xt, yt,
+                           pitchs, pitcht, viewport, unit, unit_src_lines, bands);
+    } else {
+        start = tick_now();
+        video_render_dispatch(config, video_render_band_scratch(config, 0), src, trg,
+                              width, height, xs, ys, xt, yt, pitchs, pitcht, viewport);
+        config->band_time_last[0] = tick_now_delta(start);
+        config->band_time_total[0] += config->band_time_last[0];
+    }
+
+    if (instrument_enabled && config->chip_name != NULL) {
+        unsigned int last[VIDEO_RENDER_BANDS_MAX];
+        unsigned int average[VIDEO_RENDER_BANDS_MAX];
+        unsigned int count;
+
+        count = video_render_get_band_times(config, last, average, VIDEO_RENDER_BANDS_MAX);
+        instrument_render_bands(config->chip_name, count, last, average);
+    }
+}
+
+/** \brief Get the render time of each band of \a config
+ *
+ * \param[in]   config  render config
+ * \param[out]  last    render time of each band in the last frame, in ticks
+ * \param[out]  average average render time of each band, in ticks
+ * \param[in]   max     size of \a last and \a average
+ *
+ * \return  number of bands, which may be larger than \a max
+ */
+unsigned int video_render_get_band_times(video_render_config_t *config,
+                                         unsigned int *last, unsigned int *average,
+                                         unsigned int max)
+{
+    unsigned int i;
+
+    for (i = 0; i < config->band_count && i < max; i++) {
+        last[i] = config->band_time_last[i];
+        average[i] = config->band_frames
+                     ? (unsigned int)(config->band_time_total[i] / config->band_frames)
+                     : 0;
+    }
+    return config->band_count;
+}
+
+/** \brief Set the number of bands (and threads) a frame is rendered with */
+void video_render_set_threads(int threads)
+{
+    if (threads < 1) {
+        threads = 1;
+    }
+    if (threads > VIDEO_RENDER_BANDS_MAX) {
+        threads = VIDEO_RENDER_BANDS_MAX;
+    }
+    render_threads = threads;
+}
+
 void video_render_palntscfunc_set(render_pal_ntsc_func_t func)
 {
     render_pal_ntsc_func = func;
@@ -35,18 +35,18 @@
 struct video_render_config_s;
 struct video_canvas_s;
 
-typedef void (*render_pal_ntsc_func_t)(video_render_config_t *, uint8_t *, uint8_t *,
+typedef void (*render_pal_ntsc_func_t)(video_render_config_t *, video_render_scratch_t *, uint8_t *, uint8_t *,
                                   int, int, int, int,
                                   int, int, int, int,
                                   int,
                                   unsigned int, unsigned int);
 
-typedef void (*render_rgbi_func_t)(video_render_config_t *, uint8_t *, uint8_t *,
+typedef void (*render_rgbi_func_t)(video_render_config_t *, video_render_scratch_t *, uint8_t *, uint8_t *,
                                   int, int, int, int,
                                   int, int, int, int,
                                   unsigned int, unsigned int);
 
-typedef void (*render_crt_mono_func_t)(video_render_config_t *, uint8_t *, uint8_t *,
+typedef void (*render_crt_mono_func_t)(video_render_config_t *, video_render_scratch_t *, uint8_t *, uint8_t *,
                                   int, int, int, int,
                                   int, int, int, int,
                                   unsigned int, unsigned int);
@@ -65,6 +65,7 @@ void video_render_rgbifunc_set(render_rgbi_func_t func);
 /* Default render functions */
 
 void video_render_pal_ntsc_main(video_render_config_t *config,
+                                video_render_scratch_t *scratch,
                                 uint8_t *src, uint8_t *trg,
                                 int width, int height, int xs, int ys, int xt,
                                 int yt, int pitchs, int pitcht,
@@ -72,12 +73,14 @@ void video_render_pal_ntsc_main(video_render_config_t *config,
                                 unsigned int viewport_first_line, unsigned int viewport_last_line);
 
 void video_render_rgbi_main(video_render_config_t *config,
+                            video_render_scratch_t *scratch,
                             uint8_t *src, uint8_t *trg,
                             int width, int height, int xs, int ys, int xt,
                             int yt, int pitchs, int pitcht,
                             unsigned int viewport_first_line, unsigned int viewport_last_line);
 
 void video_render_crt_mono_main(video_render_config_t *config,
+                                video_render_scratch_t *scratch,
                                 uint8_t *src, uint8_t *trg,
                                 int width, int height, int xs, int ys, int xt,
                                 int yt, int pitchs, int pitcht,
@@ -55,8 +55,36 @@
 /*-----------------------------------------------------------------------*/
 /* global resources.  */
 
+static int video_render_threads;
+
+/** \brief Setter for integer resource "VideoRenderThreads"
+ *
+ * \param[in]   val     number of bands (and threads) a frame is rendered with
+ * \param[in]   param   unused
+ *
+ * \return  0 on success, -1 on failure
+ */
+static int set_video_render_threads(int val, void *param)
+{
+    if (val < 1 || val > VIDEO_RENDER_BANDS_MAX) {
+        return -1;
+    }
+    video_render_threads = val;
+    video_render_set_threads(val);
+    return 0;
+}
+
+static const resource_int_t resources_int[] = {
+    { "VideoRenderThreads", 1, RES_EVENT_NO, NULL,
+      &video_render_threads, set_video_render_threads, NULL },
+    RESOURCE_INT_LIST_END
+};
+
 int video_resources_init(void)
 {
+    if (resources_register_int(resources_int) < 0) {
+        return -1;
+    }
     return video_arch_resources_init();
 }
 
@@ -665,6 +693,7 @@ static int set_delaylinetype(int val, void *param)
 {
     video_canvas_t *canvas = (video_canvas_t *)param;
     canvas->videoconfig->video_resources.delaylinetype = val ? 1 : 0;
+    canvas->videoconfig->color_tables.updated = 0;
     return 0;
 }
 
@@ -52,6 +52,7 @@
 #include "archdep.h"
 #include "cmdline.h"
 #include "debug.h"
+#include "instrument.h"
 #include "joystick.h"
 #include "kbdbuf.h"
 #include "lib.h"
@@ -580,7 +581,9 @@ void vsync_do_end_of_line(void)
 
                 /* If we can't rely on the audio device for timing, slow down here. */
                 if (tick_based_sync_timing) {
+                    INSTRUMENT_ENTER(INSTRUMENT_SLEEP);
                     mainlock_yield_and_sleep(ticks_until_target);
+                    INSTRUMENT_LEAVE();
                 }
             } else if ((tick_t)0 - ticks_until_target > tick_per_second()) {
                 /* We are more than a second behind, reset sync and accept that we're not running at full speed. */
@@ -670,6 +673,8 @@ void vsync_do_vsync(struct video_canvas_s *c)
 
     monitor_vsync_hook();
 
+    instrument_vsync();
+
     /*
      * process everything wich should be done before the synchronisation
      * e.g. OS/2: exit the programm if trigger_shutdown set